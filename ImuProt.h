@@ -383,4 +383,24 @@ static inline ImuProtError_t checkImuProtBuffer(const void * buffer) {
     }
 	return IMU_PROT_OK;
 }
+
+/**
+ * @brief Converts an ImuProtError_t error code to its corresponding string representation.
+ *
+ * @param error The ImuProtError_t error code.
+ * @return A string that describes the error.
+ */
+static inline const char* ImuProtErrorToString(ImuProtError_t error) {
+    switch (error) {
+        case IMU_PROT_OK:
+            return "OK.";
+        case IMU_PROT_BAD_HEADER:
+            return "Invalid header!";
+        case IMU_PROT_BAD_SEQUENCER:
+            return "Invalid sequencer!";
+        case IMU_PROT_BAD_CRC:
+            return "CRC validation failed!";
+    }
+	return "Unknown error.";
+}
 #endif
@@ -0,0 +1,493 @@
+/**
+ * IMU Protocol for C++17.
+ *
+ * Header-only companion of `ImuProt.h` for C++ consumers. It describes the
+ * same 40-byte packet without packed unions, bit-fields or zero-length
+ * arrays: field offsets, mux word positions, flag bits and scales are
+ * `constexpr`, packets are read from byte spans with `std::memcpy` (no
+ * casts, no alignment or aliasing issues), and the layout is checked with
+ * `static_assert`, against `ImuProt_t` too when `ImuProt.h` was included
+ * first (which C++ compilers only accept with -fpermissive).
+ *
+ * The CRC tables are built at compile time. The packet CRC uses one table
+ * per byte position like `imuPacketCrc32`, so its 36 lookups do not form a
+ * dependency chain and it is faster than the byte-wise `protCRC32`; all
+ * decoders are templates over the output floating-point type, inlined into
+ * the caller.
+ *
+ * `imuprot::ByteSpan` is `std::span<const std::byte>` when the standard
+ * library provides it (C++20) and a minimal compatible view in C++17.
+ */
+
+#ifndef ImuProt_hpp_included__
+#define ImuProt_hpp_included__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if __cplusplus > 201703L && __has_include(<span>)
+#include <span>
+#endif
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "ImuProt.hpp assumes a little-endian host, like the packet format"
+#endif
+
+namespace imuprot {
+
+#if __cplusplus > 201703L && __has_include(<span>)
+using ByteSpan = std::span<const std::byte>;
+#else
+/**
+ * Read-only view of contiguous bytes, the subset of `std::span<const std::byte>` used here.
+ */
+class ByteSpan {
+public:
+	constexpr ByteSpan() noexcept = default;
+	constexpr ByteSpan(const std::byte *data, std::size_t size) noexcept : data_(data), size_(size) {}
+	template <std::size_t N>
+	constexpr ByteSpan(const std::byte (&bytes)[N]) noexcept : data_(bytes), size_(N) {}
+	template <std::size_t N>
+	constexpr ByteSpan(const std::array<std::byte, N> &bytes) noexcept : data_(bytes.data()), size_(N) {}
+
+	constexpr const std::byte *data() const noexcept { return data_; }
+	constexpr std::size_t size() const noexcept { return size_; }
+	constexpr std::size_t size_bytes() const noexcept { return size_; }
+	constexpr bool empty() const noexcept { return size_ == 0; }
+	constexpr const std::byte &operator[](std::size_t i) const noexcept { return data_[i]; }
+	constexpr const std::byte *begin() const noexcept { return data_; }
+	constexpr const std::byte *end() const noexcept { return data_ + size_; }
+	constexpr ByteSpan first(std::size_t count) const noexcept { return ByteSpan(data_, count); }
+	constexpr ByteSpan subspan(std::size_t offset) const noexcept { return ByteSpan(data_ + offset, size_ - offset); }
+	constexpr ByteSpan subspan(std::size_t offset, std::size_t count) const noexcept
+	{
+		return ByteSpan(data_ + offset, count);
+	}
+
+private:
+	const std::byte *data_ = nullptr;
+	std::size_t size_ = 0;
+};
+#endif
+
+/**
+ * @brief Views a byte buffer, e.g. a `uint8_t` receive buffer, as a ByteSpan.
+ */
+inline ByteSpan asBytes(const void *data, std::size_t size) noexcept
+{
+	return ByteSpan(static_cast<const std::byte *>(data), size);
+}
+
+inline constexpr std::uint16_t kHeader = 0x9574;        // IMU_PROT_HEADER
+inline constexpr std::size_t kPacketSize = 40;          // sizeof(ImuProt_t)
+inline constexpr std::size_t kCrcBytes = 36;            // Bytes covered by the CRC
+inline constexpr std::uint32_t kCrcInitial = 0xFFFFFFFFu;
+inline constexpr std::uint32_t kCrcPolynom = 0xEDB88320u;
+inline constexpr double kScale = 1.0 / 65536;           // FP16.16 to units
+inline constexpr double kKelvin = 273.15;
+inline constexpr std::uint32_t kBaudRate = 1000000;     // IMO_PROT_BAUDRATE
+inline constexpr std::size_t kMuxWords = 32;            // Words of ImuDataMux_t
+
+/**
+ * Byte offsets of the packet fields.
+ */
+namespace offset {
+inline constexpr std::size_t header = 0;
+inline constexpr std::size_t sequencer = 2;
+inline constexpr std::size_t ffSequencer = 3;
+inline constexpr std::size_t mux = 4;
+inline constexpr std::size_t flags = 8;
+inline constexpr std::size_t temperature = 10;
+inline constexpr std::size_t gyro = 12;
+inline constexpr std::size_t accl = 24;
+inline constexpr std::size_t crc32 = 36;
+} // namespace offset
+
+/**
+ * Position of a value inside the multiplexed words of `ImuDataMux_t`.
+ *
+ * @field word  Mux word, equal to `sequencer % kMuxWords` of the carrying packet.
+ * @field shift First bit within the word.
+ * @field bits  Width in bits.
+ */
+struct MuxField {
+	std::size_t word;
+	unsigned shift;
+	unsigned bits;
+
+	constexpr std::uint32_t extract(std::uint32_t value) const noexcept
+	{
+		return bits >= 32 ? value >> shift : (value >> shift) & ((1u << bits) - 1);
+	}
+};
+
+namespace mux {
+inline constexpr MuxField serialNoHi{ 0, 0, 32 };
+inline constexpr MuxField rev{ 1, 0, 32 };
+inline constexpr MuxField tempExt{ 2, 0, 32 };
+inline constexpr MuxField tempInt{ 3, 0, 32 };
+inline constexpr MuxField presExt{ 4, 0, 32 };
+inline constexpr MuxField power{ 5, 0, 32 };
+inline constexpr MuxField serialId{ 6, 0, 32 };
+inline constexpr MuxField humanSerial{ 7, 0, 32 };
+inline constexpr MuxField current{ 8, 0, 32 };
+inline constexpr MuxField gitShort{ 9, 0, 32 };
+inline constexpr MuxField version{ 10, 0, 16 };
+inline constexpr MuxField revision{ 10, 16, 16 };
+inline constexpr MuxField buildDate{ 11, 0, 16 };
+inline constexpr MuxField hwType{ 11, 16, 16 };
+inline constexpr MuxField packetRate{ 12, 0, 16 };
+} // namespace mux
+
+/**
+ * Bits of the `flags` field.
+ */
+enum class Flag : std::uint16_t {
+	Error = 1u << 0,
+	ThermostatNotReady = 1u << 1,
+	GyroNotReady = 1u << 2,
+	OverVoltage = 1u << 3,
+	UnderVoltage = 1u << 4,
+	OverTemperature = 1u << 5,
+	UnderTemperature = 1u << 6,
+	PpsNotLocked = 1u << 7,
+	GyroXOutOfRange = 1u << 8,
+	GyroYOutOfRange = 1u << 9,
+	GyroZOutOfRange = 1u << 10,
+	AccelXOutOfRange = 1u << 11,
+	AccelYOutOfRange = 1u << 12,
+	AccelZOutOfRange = 1u << 13
+};
+
+constexpr bool hasFlag(std::uint16_t flags, Flag flag) noexcept
+{
+	return (flags & static_cast<std::uint16_t>(flag)) != 0;
+}
+
+/**
+ * Validation result, same values as ImuProtError_t.
+ */
+enum class Error : std::uint8_t {
+	Ok = 0,             // IMU_PROT_OK
+	BadHeader = 1,      // IMU_PROT_BAD_HEADER
+	BadSequencer = 2,   // IMU_PROT_BAD_SEQUENCER
+	BadCrc = 3,         // IMU_PROT_BAD_CRC
+	TooShort = 4        // Fewer than kPacketSize bytes.
+};
+
+constexpr const char *toString(Error error) noexcept
+{
+	switch (error) {
+	case Error::Ok:
+		return "OK.";
+	case Error::BadHeader:
+		return "Invalid header!";
+	case Error::BadSequencer:
+		return "Invalid sequencer!";
+	case Error::BadCrc:
+		return "CRC validation failed!";
+	case Error::TooShort:
+		return "Buffer too short!";
+	}
+	return "Unknown error.";
+}
+
+namespace detail {
+
+#pragma pack(push, 1)
+struct WirePacket {
+	std::uint16_t header;
+	std::uint8_t sequencer;
+	std::uint8_t ffSequencer;
+	std::uint32_t mux;
+	std::uint16_t flags;
+	std::uint16_t temperature;
+	std::int32_t gyro[3];
+	std::int32_t accl[3];
+	std::uint32_t crc32;
+};
+#pragma pack(pop)
+
+static_assert(std::is_trivially_copyable_v<WirePacket> && std::is_standard_layout_v<WirePacket>);
+static_assert(sizeof(WirePacket) == kPacketSize, "packet size");
+static_assert(offsetof(WirePacket, sequencer) == offset::sequencer, "sequencer offset");
+static_assert(offsetof(WirePacket, ffSequencer) == offset::ffSequencer, "ff_sequencer offset");
+static_assert(offsetof(WirePacket, mux) == offset::mux, "mux offset");
+static_assert(offsetof(WirePacket, flags) == offset::flags, "flags offset");
+static_assert(offsetof(WirePacket, temperature) == offset::temperature, "temperature offset");
+static_assert(offsetof(WirePacket, gyro) == offset::gyro, "gyro offset");
+static_assert(offsetof(WirePacket, accl) == offset::accl, "accl offset");
+static_assert(offsetof(WirePacket, crc32) == offset::crc32, "crc32 offset");
+static_assert(offset::crc32 == kCrcBytes && kCrcBytes + sizeof(std::uint32_t) == kPacketSize);
+
+#ifdef ImuProt_h_included__
+static_assert(sizeof(ImuProt_t) == kPacketSize, "ImuProt_t size");
+static_assert(sizeof(ImuDataMux_t) == kMuxWords * sizeof(std::uint32_t), "ImuDataMux_t size");
+static_assert(offsetof(ImuProt_t, data) + offsetof(ImuData_t, gyro) == offset::gyro, "ImuProt_t gyro offset");
+static_assert(offsetof(ImuProt_t, crc32) == offset::crc32, "ImuProt_t crc32 offset");
+static_assert(IMU_PROT_HEADER == kHeader && CRC32_POLYNOM == kCrcPolynom, "protocol constants");
+#endif
+
+constexpr std::array<std::uint32_t, 256> makeCrcTable() noexcept
+{
+	std::array<std::uint32_t, 256> table{};
+	for (std::uint32_t b = 0; b < 256; b++) {
+		std::uint32_t crc = b;
+		for (int j = 0; j < 8; j++)
+			crc = (crc & 1) ? (crc >> 1) ^ kCrcPolynom : crc >> 1;
+		table[b] = crc;
+	}
+	return table;
+}
+
+inline constexpr std::array<std::uint32_t, 256> kCrcTable = makeCrcTable();
+
+// kPacketCrcTable[i][b] is the contribution of byte b at offset i of a packet.
+constexpr std::array<std::array<std::uint32_t, 256>, kCrcBytes> makePacketCrcTable() noexcept
+{
+	std::array<std::array<std::uint32_t, 256>, kCrcBytes> table{};
+	for (std::uint32_t b = 0; b < 256; b++) {
+		std::uint32_t crc = kCrcTable[b];
+		for (std::size_t i = kCrcBytes; i-- > 0;) {
+			table[i][b] = crc;
+			crc = kCrcTable[crc & 0xff] ^ (crc >> 8);
+		}
+	}
+	return table;
+}
+
+inline constexpr std::array<std::array<std::uint32_t, 256>, kCrcBytes> kPacketCrcTable = makePacketCrcTable();
+
+constexpr std::uint32_t zeroCrc(std::size_t len) noexcept
+{
+	std::uint32_t crc = kCrcInitial;
+	for (std::size_t i = 0; i < len; i++)
+		crc = kCrcTable[crc & 0xff] ^ (crc >> 8);
+	return crc ^ kCrcInitial;
+}
+
+inline constexpr std::uint32_t kPacketCrcZero = zeroCrc(kCrcBytes);
+
+} // namespace detail
+
+/**
+ * @brief Reads a little-endian value of any trivially copyable type at any alignment.
+ */
+template <typename T>
+inline T load(const std::byte *p) noexcept
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	T value;
+	std::memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+/**
+ * @brief CRC32 of `Len` bytes, same result as `protCRC32`. Usable in constant expressions.
+ *
+ * For Len == kCrcBytes the position tables are used: independent lookups
+ * instead of a chain of dependent ones.
+ */
+template <std::size_t Len>
+constexpr std::uint32_t crc32(const std::byte *p) noexcept
+{
+	if constexpr (Len == kCrcBytes) {
+		std::uint32_t crc = detail::kPacketCrcTable[0][std::to_integer<std::uint8_t>(p[0])];
+		for (std::size_t i = 1; i < kCrcBytes; i++)
+			crc ^= detail::kPacketCrcTable[i][std::to_integer<std::uint8_t>(p[i])];
+		return crc ^ detail::kPacketCrcZero;
+	} else {
+		std::uint32_t crc = kCrcInitial;
+		for (std::size_t i = 0; i < Len; i++)
+			crc = detail::kCrcTable[(crc ^ std::to_integer<std::uint8_t>(p[i])) & 0xff] ^ (crc >> 8);
+		return crc ^ kCrcInitial;
+	}
+}
+
+/**
+ * @brief CRC32 of a buffer of any length, same result as `protCRC32`.
+ */
+constexpr std::uint32_t crc32(ByteSpan bytes) noexcept
+{
+	std::uint32_t crc = kCrcInitial;
+	for (std::byte b : bytes)
+		crc = detail::kCrcTable[(crc ^ std::to_integer<std::uint8_t>(b)) & 0xff] ^ (crc >> 8);
+	return crc ^ kCrcInitial;
+}
+
+/**
+ * @brief Converts a FP16.16 value, like `floatData`.
+ */
+template <typename Float = float>
+constexpr Float fromFixed(std::int32_t value) noexcept
+{
+	static_assert(std::is_floating_point_v<Float>);
+	return static_cast<Float>(kScale) * static_cast<Float>(value);
+}
+
+/**
+ * @brief Converts hundredths of Kelvin to Celsius, like `tempFromKelvin`.
+ */
+template <typename Float = float>
+constexpr Float celsius(std::uint16_t kelvin) noexcept
+{
+	static_assert(std::is_floating_point_v<Float>);
+	return static_cast<Float>(0.01) * static_cast<Float>(kelvin) - static_cast<Float>(kKelvin);
+}
+
+/**
+ * Packet fields, naturally aligned.
+ */
+struct Packet {
+	std::uint16_t header;
+	std::uint8_t sequencer;
+	std::uint8_t ffSequencer;
+	std::uint32_t mux;
+	std::uint16_t flags;
+	std::uint16_t temperature;
+	std::array<std::int32_t, 3> gyro;
+	std::array<std::int32_t, 3> accl;
+	std::uint32_t crc32;
+
+	/** Mux word carried by this packet. */
+	constexpr std::size_t muxWord() const noexcept { return sequencer % kMuxWords; }
+	constexpr bool hasFlag(Flag flag) const noexcept { return imuprot::hasFlag(flags, flag); }
+};
+
+/**
+ * Decoded sample, same content as `ImuSample_t`.
+ */
+template <typename Float = float>
+struct Sample {
+	std::array<Float, 3> gyro;
+	std::array<Float, 3> accl;
+	Float temperature;
+	std::uint16_t flags;
+	std::uint8_t sequencer;
+};
+
+/**
+ * @brief Validates a packet, like `checkImuProtBuffer`.
+ *
+ * @param bytes At least kPacketSize bytes starting with the packet.
+ */
+inline Error check(ByteSpan bytes) noexcept
+{
+	if (bytes.size() < kPacketSize)
+		return Error::TooShort;
+	const std::byte *p = bytes.data();
+	if (load<std::uint16_t>(p + offset::header) != kHeader)
+		return Error::BadHeader;
+	if (load<std::uint8_t>(p + offset::sequencer) != static_cast<std::uint8_t>(~load<std::uint8_t>(p + offset::ffSequencer)))
+		return Error::BadSequencer;
+	if (crc32<kCrcBytes>(p) != load<std::uint32_t>(p + offset::crc32))
+		return Error::BadCrc;
+	return Error::Ok;
+}
+
+/**
+ * @brief Reads the fields of a packet without validating it.
+ *
+ * @param p kPacketSize bytes, any alignment.
+ */
+inline Packet parse(const std::byte *p) noexcept
+{
+	detail::WirePacket wire;
+	std::memcpy(&wire, p, sizeof(wire));
+	Packet packet;
+	packet.header = wire.header;
+	packet.sequencer = wire.sequencer;
+	packet.ffSequencer = wire.ffSequencer;
+	packet.mux = wire.mux;
+	packet.flags = wire.flags;
+	packet.temperature = wire.temperature;
+	for (std::size_t i = 0; i < 3; i++) {
+		packet.gyro[i] = wire.gyro[i];
+		packet.accl[i] = wire.accl[i];
+	}
+	packet.crc32 = wire.crc32;
+	return packet;
+}
+
+/**
+ * @brief Converts the fields of a packet, like `imuDecodeSample`.
+ */
+template <typename Float = float>
+constexpr Sample<Float> toSample(const Packet &packet) noexcept
+{
+	Sample<Float> sample{};
+	for (std::size_t i = 0; i < 3; i++) {
+		sample.gyro[i] = fromFixed<Float>(packet.gyro[i]);
+		sample.accl[i] = fromFixed<Float>(packet.accl[i]);
+	}
+	sample.temperature = celsius<Float>(packet.temperature);
+	sample.flags = packet.flags;
+	sample.sequencer = packet.sequencer;
+	return sample;
+}
+
+/**
+ * @brief Validates and decodes a packet.
+ *
+ * @param bytes     At least kPacketSize bytes starting with the packet.
+ * @param sample    Filled only if the packet is valid.
+ * @return Error Error::Ok if the packet is valid.
+ */
+template <typename Float = float>
+inline Error decode(ByteSpan bytes, Sample<Float> &sample) noexcept
+{
+	Error error = check(bytes);
+	if (error == Error::Ok)
+		sample = toSample<Float>(parse(bytes.data()));
+	return error;
+}
+
+/**
+ * Result of `scan`.
+ *
+ * @field packets   Valid packets passed to the visitor.
+ * @field consumed  Bytes processed; the rest may start an incomplete packet.
+ * @field discarded Bytes skipped while searching for a valid packet.
+ */
+struct ScanResult {
+	std::size_t packets;
+	std::size_t consumed;
+	std::size_t discarded;
+};
+
+/**
+ * @brief Calls `visit(const Packet &)` for every valid packet of a byte stream.
+ *
+ * Invalid candidates are skipped one byte at a time up to the next header,
+ * like `imuFramerPush`. Fewer than kPacketSize trailing bytes are left
+ * unconsumed for the caller to prepend to the next chunk.
+ */
+template <typename Visitor>
+inline ScanResult scan(ByteSpan stream, Visitor &&visit)
+{
+	constexpr std::byte headerLo{ kHeader & 0xff };
+	ScanResult result{ 0, 0, 0 };
+	std::size_t pos = 0;
+	while (stream.size() - pos >= kPacketSize) {
+		if (check(stream.subspan(pos, kPacketSize)) == Error::Ok) {
+			visit(parse(stream.data() + pos));
+			result.packets++;
+			pos += kPacketSize;
+			continue;
+		}
+		std::size_t next = pos + 1;
+		while (next < stream.size() && stream[next] != headerLo)
+			next++;
+		result.discarded += next - pos;
+		pos = next;
+	}
+	result.consumed = pos;
+	return result;
+}
+
+} // namespace imuprot
+
+#endif
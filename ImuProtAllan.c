@@ -0,0 +1,296 @@
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ImuProtAllan.h"
+#include "ImuProtIsa.h"
+
+/** Samples decoded per call while reading a recording. */
+#define ALLAN_BATCH (1024)
+
+/**
+ * @brief Returns the number of ring steps per cluster length of an octave.
+ */
+static inline uint32_t allanSpan(int level) {
+	return level < 3 ? 1u << level : IMU_ALLAN_OVERLAP;
+}
+
+/**
+ * @brief Returns the samples between the phases an octave keeps.
+ */
+static inline uint64_t allanStride(int level) {
+	return (1ull << level) / allanSpan(level);
+}
+
+/**
+ * @brief Stores the phase in the ring of an octave and adds the second difference it completes.
+ */
+static inline void allanLevelPush(ImuAllanLevel_t *l, const double phase[IMU_ALLAN_CHANNELS], uint32_t span) {
+	const uint32_t size = 2 * span + 1;
+	memcpy(l->ring[l->head], phase, sizeof(l->ring[0]));
+	if (l->entries < 2 * span) {
+		memcpy(l->first[l->entries], phase, sizeof(l->first[0]));
+	} else {
+		const double *mid = l->ring[l->head >= span ? l->head - span : l->head + size - span];
+		const double *old = l->ring[l->head >= 2 * span ? l->head - 2 * span : l->head + size - 2 * span];
+		for (int c = 0; c < IMU_ALLAN_CHANNELS; c++) {
+			double d = phase[c] - 2.0 * mid[c] + old[c];
+			l->sum[c] += d * d;
+		}
+		l->terms++;
+	}
+	l->entries++;
+	l->head = l->head + 1 == size ? 0 : l->head + 1;
+}
+
+void imuAllanInit(ImuAllan_t *a, uint32_t packetRate) {
+	memset(a, 0, sizeof(*a));
+	a->packetRate = packetRate;
+}
+
+void imuAllanStart(ImuAllan_t *a, uint64_t index) {
+	a->first = index;
+	a->index = index;
+}
+
+void imuAllanPush(ImuAllan_t *a, const ImuSample_t *samples, size_t count) {
+	if (count && !a->started) {
+		// The offset keeps the phase small; it cancels in the second differences.
+		for (int c = 0; c < 3; c++) {
+			a->offset[c] = samples[0].gyro[c];
+			a->offset[c + 3] = samples[0].accl[c];
+		}
+		for (int k = 0; k < IMU_ALLAN_LEVELS; k++) {
+			if (!(a->first & (allanStride(k) - 1)))
+				allanLevelPush(&a->levels[k], a->phase, allanSpan(k));
+		}
+		a->started = 1;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const ImuSample_t *s = &samples[i];
+		for (int c = 0; c < 3; c++) {
+			a->phase[c] += s->gyro[c] - a->offset[c];
+			a->phase[c + 3] += s->accl[c] - a->offset[c + 3];
+		}
+		uint64_t n = ++a->index;
+		// Strides grow with the octave, so the first octave skipping this sample ends the loop.
+		for (int k = 0; k < IMU_ALLAN_LEVELS; k++) {
+			if (n & (allanStride(k) - 1))
+				break;
+			allanLevelPush(&a->levels[k], a->phase, allanSpan(k));
+		}
+	}
+	a->samples += count;
+}
+
+/**
+ * Phase origin of the segment being appended, relative to that of the
+ * accumulator appended to: its phase at the boundary, and the difference of
+ * the offsets, which adds a ramp from the boundary on.
+ */
+typedef struct {
+	uint64_t boundary;
+	double base[IMU_ALLAN_CHANNELS];
+	double slope[IMU_ALLAN_CHANNELS];
+} AllanRebase_t;
+
+/**
+ * @brief Moves a phase of the appended segment, taken at sample `index`, onto the phase origin.
+ */
+static inline void allanRebase(const AllanRebase_t *r, const double in[IMU_ALLAN_CHANNELS], uint64_t index,
+	double out[IMU_ALLAN_CHANNELS]) {
+	for (int c = 0; c < IMU_ALLAN_CHANNELS; c++)
+		out[c] = in[c] + r->base[c] + r->slope[c] * (double)(index - r->boundary);
+}
+
+/**
+ * @brief Appends the phases of one octave of the following segment.
+ */
+static void allanLevelMerge(ImuAllanLevel_t *to, const ImuAllanLevel_t *from, int level, const AllanRebase_t *r) {
+	if (!from->entries)
+		return;
+	const uint32_t span = allanSpan(level), size = 2 * span + 1;
+	const uint64_t stride = allanStride(level);
+	// Sample of the first phase of `from`; on the boundary, `to` ends with the same phase.
+	const uint64_t start = (r->boundary + stride - 1) / stride * stride;
+	const uint32_t dup = to->entries && start == r->boundary;
+
+	// The last phases of `to` and the first of `from`, in order.
+	double seq[4 * IMU_ALLAN_OVERLAP][IMU_ALLAN_CHANNELS];
+	uint32_t n = 0;
+	const uint32_t tail = to->entries < 2 * span ? (uint32_t)to->entries : 2 * span;
+	for (uint32_t back = tail; back-- > 0; n++)
+		memcpy(seq[n], to->ring[(to->head + 2 * size - 1 - back) % size], sizeof(seq[0]));
+	const uint32_t lead = from->entries < 2 * span ? (uint32_t)from->entries : 2 * span;
+	for (uint32_t p = dup; p < lead; p++, n++)
+		allanRebase(r, from->first[p], start + p * stride, seq[n]);
+
+	// Second differences straddling the boundary: `from` has none of these.
+	for (uint32_t i = 2 * span; i < n; i++) {
+		for (int c = 0; c < IMU_ALLAN_CHANNELS; c++) {
+			double d = seq[i][c] - 2.0 * seq[i - span][c] + seq[i - 2 * span][c];
+			to->sum[c] += d * d;
+		}
+		to->terms++;
+	}
+
+	for (uint32_t p = dup; p < lead && to->entries + p - dup < 2 * span; p++)
+		memcpy(to->first[to->entries + p - dup], seq[tail + p - dup], sizeof(to->first[0]));
+
+	if (from->entries >= size) {
+		const uint64_t oldest = start + (from->entries - size) * stride;
+		for (uint32_t j = 0; j < size; j++)
+			allanRebase(r, from->ring[(from->head + j) % size], oldest + j * stride, to->ring[j]);
+		to->head = 0;
+	} else if (n > tail) {
+		// All of `from` is in `seq`, after enough of `to` to fill the ring.
+		const uint32_t keep = n < size ? n : size;
+		for (uint32_t j = 0; j < keep; j++)
+			memcpy(to->ring[j], seq[n - keep + j], sizeof(to->ring[0]));
+		to->head = keep == size ? 0 : keep;
+	}
+
+	for (int c = 0; c < IMU_ALLAN_CHANNELS; c++)
+		to->sum[c] += from->sum[c];
+	to->terms += from->terms;
+	to->entries += from->entries - dup;
+}
+
+int imuAllanMerge(ImuAllan_t *to, const ImuAllan_t *from) {
+	if (!from->started)
+		return 0;
+	if (!to->started) {
+		if (to->index != from->first)
+			return -1;
+		*to = *from;
+		return 0;
+	}
+	if (to->index != from->first)
+		return -1;
+
+	AllanRebase_t r;
+	r.boundary = to->index;
+	for (int c = 0; c < IMU_ALLAN_CHANNELS; c++) {
+		r.base[c] = to->phase[c];
+		r.slope[c] = from->offset[c] - to->offset[c];
+	}
+	for (int k = 0; k < IMU_ALLAN_LEVELS; k++)
+		allanLevelMerge(&to->levels[k], &from->levels[k], k, &r);
+	allanRebase(&r, from->phase, from->index, to->phase);
+	to->index = from->index;
+	to->samples += from->samples;
+	return 0;
+}
+
+size_t imuAllanResult(const ImuAllan_t *a, ImuAllanPoint_t *points, size_t max) {
+	size_t n = 0;
+	for (int k = 0; k < IMU_ALLAN_LEVELS && n < max; k++) {
+		const ImuAllanLevel_t *l = &a->levels[k];
+		if (!l->terms)
+			continue;
+		double m = (double)(1ull << k);
+		ImuAllanPoint_t *p = &points[n++];
+		p->tau = a->packetRate ? m / a->packetRate : m;
+		for (int c = 0; c < IMU_ALLAN_CHANNELS; c++)
+			p->adev[c] = sqrt(l->sum[c] / (2.0 * m * m * (double)l->terms));
+		p->terms = l->terms;
+	}
+	return n;
+}
+
+/**
+ * Segment of a recording processed by one thread.
+ */
+typedef struct {
+	const ImuRecReader_t *reader;
+	uint64_t first;
+	uint64_t count;
+	ImuAllan_t *allan;
+} AllanSegment_t;
+
+static void *allanWorker(void *arg) {
+	AllanSegment_t *seg = arg;
+	ImuSample_t samples[ALLAN_BATCH];
+	ImuRecCursor_t cursor;
+	imuRecSeek(seg->reader, &cursor, seg->first);
+	for (uint64_t left = seg->count; left; ) {
+		size_t n;
+		const ImuRecRecord_t *run = imuRecNextRun(seg->reader, &cursor,
+			left < ALLAN_BATCH ? (size_t)left : ALLAN_BATCH, &n);
+		if (!run)
+			break;
+		imuDecodeSamples(&run->packet, sizeof(ImuRecRecord_t), samples, sizeof(ImuSample_t), n);
+		imuAllanPush(seg->allan, samples, n);
+		left -= n;
+	}
+	return NULL;
+}
+
+ImuRecError_t imuAllanFile(const char *path, unsigned threads, uint32_t packetRate, ImuAllan_t *a) {
+	ImuRecReader_t reader;
+	ImuRecError_t result = imuRecReaderOpen(&reader, path);
+	if (result != IMU_REC_OK)
+		return result;
+
+	uint64_t total = imuRecCount(&reader);
+	if (!packetRate && total > 1) {
+		uint64_t span = imuRecGet(&reader, total - 1)->rxTimeNs - imuRecGet(&reader, 0)->rxTimeNs;
+		packetRate = span ? (uint32_t)llround((double)(total - 1) * 1e9 / (double)span) : 0;
+	}
+	if (!threads) {
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = online > 0 ? (unsigned)online : 1;
+	}
+	if (threads > total / ALLAN_BATCH + 1)
+		threads = (unsigned)(total / ALLAN_BATCH + 1);
+
+	imuAllanInit(a, packetRate);
+	AllanSegment_t *segs = calloc(threads, sizeof(*segs));
+	pthread_t *workers = calloc(threads, sizeof(*workers));
+	int *running = calloc(threads, sizeof(*running));
+	if (!segs || !workers || !running) {
+		result = IMU_REC_NO_MEMORY;
+		goto done;
+	}
+	for (unsigned t = 0; t < threads; t++) {
+		segs[t].reader = &reader;
+		segs[t].first = total * t / threads;
+		segs[t].count = total * (t + 1) / threads - segs[t].first;
+		segs[t].allan = t ? malloc(sizeof(ImuAllan_t)) : a;
+		if (!segs[t].allan) {
+			result = IMU_REC_NO_MEMORY;
+			goto done;
+		}
+		if (t) {
+			imuAllanInit(segs[t].allan, packetRate);
+			imuAllanStart(segs[t].allan, segs[t].first);
+		}
+	}
+
+	for (unsigned t = 1; t < threads; t++)
+		running[t] = !pthread_create(&workers[t], NULL, allanWorker, &segs[t]);
+	allanWorker(&segs[0]);
+	for (unsigned t = 1; t < threads; t++) {
+		if (running[t])
+			pthread_join(workers[t], NULL);
+		else
+			allanWorker(&segs[t]);
+		imuAllanMerge(a, segs[t].allan);
+	}
+
+done:
+	if (segs) {
+		for (unsigned t = 1; t < threads; t++)
+			free(segs[t].allan);
+	}
+	free(running);
+	free(workers);
+	free(segs);
+	imuRecReaderClose(&reader);
+	return result;
+}
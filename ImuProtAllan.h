@@ -0,0 +1,164 @@
+/**
+ * Streaming Allan Deviation.
+ *
+ * Computes the overlapping Allan deviation of the six `gyro` and `accl`
+ * axes at octave-spaced cluster times tau = 2^k / packetRate in one pass,
+ * with memory that grows with the number of octaves, not with the number
+ * of samples, so multi-hour captures need no buffering.
+ *
+ * Each axis accumulates its phase x(n), the running sum of the readings.
+ * Octave k (cluster size m = 2^k) keeps the phase at a stride of
+ * s = max(1, m / IMU_ALLAN_OVERLAP) samples in a ring of
+ * 2 * IMU_ALLAN_OVERLAP + 1 entries and sums the squared second differences
+ *
+ *   x(j + 2m) - 2 x(j + m) + x(j)
+ *
+ * for every j on that stride:
+ *
+ *   AVAR(tau) = sum / (2 m^2 terms)
+ *
+ * Up to m = IMU_ALLAN_OVERLAP this is the fully overlapping estimator;
+ * above, IMU_ALLAN_OVERLAP overlapping clusters start within every cluster
+ * length, which keeps nearly all of its confidence at a constant cost of
+ * about five ring updates per sample and axis.
+ *
+ * Accumulators of consecutive segments of one recording merge exactly,
+ * which is how `imuAllanFile` splits a recording across threads. A segment
+ * accumulator is started at the index of its first sample in the recording,
+ * so that every octave keeps the phase on the same stride as a single pass,
+ * and each octave also keeps its first 2 * IMU_ALLAN_OVERLAP phases. The
+ * merge moves the later segment onto the phase origin of the earlier one and
+ * adds the second differences straddling the boundary, so the result does
+ * not depend on the segmentation.
+ */
+
+#ifndef ImuProtAllan_h_included__
+#define ImuProtAllan_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtRec.h"
+#include "ImuProtSample.h"
+
+/** Axes: gyro X, Y, Z, accl X, Y, Z. */
+#define IMU_ALLAN_CHANNELS (6)
+
+/** Octaves, cluster sizes 1 to 2^(IMU_ALLAN_LEVELS - 1) samples. */
+#define IMU_ALLAN_LEVELS (40)
+
+/** Overlapping clusters per cluster length above the fully overlapping octaves. */
+#define IMU_ALLAN_OVERLAP (8)
+
+/**
+ * One point of the Allan deviation curve.
+ *
+ * @field tau       Cluster time in s.
+ * @field adev      Allan deviation per axis, in the units of the readings.
+ * @field terms     Second differences averaged.
+ */
+typedef struct {
+	double tau;
+	double adev[IMU_ALLAN_CHANNELS];
+	uint64_t terms;
+} ImuAllanPoint_t;
+
+/**
+ * Accumulator of one octave. All fields are private.
+ */
+typedef struct {
+	double ring[2 * IMU_ALLAN_OVERLAP + 1][IMU_ALLAN_CHANNELS];
+	double first[2 * IMU_ALLAN_OVERLAP][IMU_ALLAN_CHANNELS];
+	double sum[IMU_ALLAN_CHANNELS];
+	uint64_t terms;
+	uint64_t entries;
+	uint32_t head;
+} ImuAllanLevel_t;
+
+/**
+ * Allan deviation accumulator. All fields are private.
+ */
+typedef struct {
+	double phase[IMU_ALLAN_CHANNELS];
+	double offset[IMU_ALLAN_CHANNELS];
+	uint64_t first;
+	uint64_t index;
+	uint64_t samples;
+	uint32_t packetRate;
+	int started;
+	ImuAllanLevel_t levels[IMU_ALLAN_LEVELS];
+} ImuAllan_t;
+
+/**
+ * @brief Initializes the accumulator.
+ *
+ * @param a             Accumulator.
+ * @param packetRate    Sample rate in Hz, sets the cluster times.
+ */
+void imuAllanInit(ImuAllan_t *a, uint32_t packetRate);
+
+/**
+ * @brief Starts the accumulator at a sample of a longer stream, for a segment to be merged.
+ *
+ * Call after `imuAllanInit`, before the first samples are added.
+ *
+ * @param a         Accumulator.
+ * @param index     Index of the first sample of the segment in the stream.
+ */
+void imuAllanStart(ImuAllan_t *a, uint64_t index);
+
+/**
+ * @brief Adds consecutive decoded samples.
+ *
+ * @param a         Accumulator.
+ * @param samples   Samples, e.g. from `imuDecodeSamples`.
+ * @param count     Number of samples.
+ */
+void imuAllanPush(ImuAllan_t *a, const ImuSample_t *samples, size_t count);
+
+/**
+ * @brief Appends the segment that follows.
+ *
+ * The result is the same as if the samples of `from` had been added to `to`.
+ *
+ * @param to    Accumulator to add to.
+ * @param from  Accumulator at the same rate, started at the sample after the last one of `to`.
+ * @return int 0 on success, -1 if `from` does not start where `to` ends.
+ */
+int imuAllanMerge(ImuAllan_t *to, const ImuAllan_t *from);
+
+/**
+ * @brief Returns the number of samples added, including merged ones.
+ */
+static inline uint64_t imuAllanSamples(const ImuAllan_t *a)
+{
+	return a->samples;
+}
+
+/**
+ * @brief Computes the Allan deviation curve.
+ *
+ * @param a         Accumulator.
+ * @param points    Output, one point per octave with at least one term.
+ * @param max       Capacity of `points`, IMU_ALLAN_LEVELS covers all octaves.
+ * @return size_t Number of points written.
+ */
+size_t imuAllanResult(const ImuAllan_t *a, ImuAllanPoint_t *points, size_t max);
+
+/**
+ * @brief Computes the Allan deviation of a recording on several threads.
+ *
+ * The records are split into one contiguous segment per thread; the
+ * partial accumulators are merged in order. The calling thread processes
+ * one segment; if fewer threads can be created, it processes the others too.
+ *
+ * @param path          Recording (`ImuProtRec.h`).
+ * @param threads       Worker threads, 0 for the number of online CPUs.
+ * @param packetRate    Sample rate in Hz, 0 to estimate it from the receive times.
+ * @param a             Output accumulator, initialized by the call.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuAllanFile(const char *path, unsigned threads, uint32_t packetRate, ImuAllan_t *a);
+
+#endif
@@ -0,0 +1,109 @@
+#include <math.h>
+#include <string.h>
+
+#include "ImuProtAttitude.h"
+
+/** Below this squared angle the exponential uses its series. */
+#define ATTITUDE_SERIES_LIMIT (1e-4)
+
+/*
+ * Both precisions share one implementation: ATTITUDE_DEFINE expands it for
+ * a state type, a scalar type, a function suffix and the math functions of
+ * that precision.
+ */
+#define ATTITUDE_DEFINE(State, T, S, SQRT, SIN, COS)                                            \
+                                                                                                 \
+void imuAttitudeInit##S(State *a, uint32_t packetRate) {                                        \
+	memset(a, 0, sizeof(*a));                                                                   \
+	a->q[0] = 1;                                                                                \
+	a->period = packetRate ? 1.0 / packetRate : 0.0;                                            \
+	imuAttitudeUnits##S(a, IMU_GYRO_TO_RAD);                                                    \
+}                                                                                               \
+                                                                                                 \
+void imuAttitudeUnits##S(State *a, double gyroScale) {                                          \
+	a->gyroScale = gyroScale;                                                                   \
+	a->scale = (T)(gyroScale * a->period * IMU_PROT_SCALE);                                     \
+}                                                                                               \
+                                                                                                 \
+void imuAttitudeSet##S(State *a, const T q[4]) {                                                \
+	memcpy(a->q, q, sizeof(a->q));                                                              \
+}                                                                                               \
+                                                                                                 \
+/* Rotates q by the rotation vector phi: q = q * exp(phi / 2), then renormalizes. */            \
+static inline void attitudeRotate##S(T q[4], const T phi[3]) {                                  \
+	T n2 = phi[0] * phi[0] + phi[1] * phi[1] + phi[2] * phi[2];                                 \
+	T c, s;                                                                                     \
+	if (n2 < (T)ATTITUDE_SERIES_LIMIT) {                                                        \
+		c = 1 - n2 * (T)(1.0 / 8) + n2 * n2 * (T)(1.0 / 384);                                   \
+		s = (T)0.5 - n2 * (T)(1.0 / 48) + n2 * n2 * (T)(1.0 / 3840);                            \
+	} else {                                                                                    \
+		T n = SQRT(n2);                                                                         \
+		c = COS(n / 2);                                                                         \
+		s = SIN(n / 2) / n;                                                                     \
+	}                                                                                           \
+	T r[4] = { c, s * phi[0], s * phi[1], s * phi[2] };                                         \
+	T w = q[0] * r[0] - q[1] * r[1] - q[2] * r[2] - q[3] * r[3];                                \
+	T x = q[0] * r[1] + q[1] * r[0] + q[2] * r[3] - q[3] * r[2];                                \
+	T y = q[0] * r[2] - q[1] * r[3] + q[2] * r[0] + q[3] * r[1];                                \
+	T z = q[0] * r[3] + q[1] * r[2] - q[2] * r[1] + q[3] * r[0];                                \
+	/* First-order renormalization: the norm is within rounding of 1. */                       \
+	T k = (3 - (w * w + x * x + y * y + z * z)) / 2;                                            \
+	q[0] = w * k;                                                                               \
+	q[1] = x * k;                                                                               \
+	q[2] = y * k;                                                                               \
+	q[3] = z * k;                                                                               \
+}                                                                                               \
+                                                                                                 \
+void imuAttitudePush##S(State *a, const ImuProt_t *packet) {                                    \
+	T d[3] = { packet->data.gyro[0] * a->scale, packet->data.gyro[1] * a->scale,                \
+		packet->data.gyro[2] * a->scale };                                                      \
+	uint32_t steps = 1;                                                                         \
+	if (a->started) {                                                                           \
+		steps = (uint8_t)(packet->sequencer - a->lastSeq);                                      \
+		if (steps == 0)                                                                         \
+			return; /* Duplicate. */                                                            \
+		if (steps > 1) {                                                                        \
+			a->gaps++;                                                                          \
+			a->lost += steps - 1;                                                               \
+		}                                                                                       \
+		if (steps > IMU_ATTITUDE_MAX_GAP + 1) {                                                 \
+			/* Long outage: the motion in between is unknown, keep the attitude. */             \
+			a->restarts++;                                                                      \
+			a->lastSeq = packet->sequencer;                                                     \
+			memcpy(a->prev, d, sizeof(d));                                                      \
+			return;                                                                             \
+		}                                                                                       \
+	}                                                                                           \
+	a->started = 1;                                                                             \
+	a->lastSeq = packet->sequencer;                                                             \
+	T phi[3] = {                                                                                \
+		steps * d[0] + (a->prev[1] * d[2] - a->prev[2] * d[1]) * (T)(1.0 / 12),                 \
+		steps * d[1] + (a->prev[2] * d[0] - a->prev[0] * d[2]) * (T)(1.0 / 12),                 \
+		steps * d[2] + (a->prev[0] * d[1] - a->prev[1] * d[0]) * (T)(1.0 / 12),                 \
+	};                                                                                          \
+	memcpy(a->prev, d, sizeof(d));                                                              \
+	attitudeRotate##S(a->q, phi);                                                               \
+	a->updates++;                                                                               \
+}                                                                                               \
+                                                                                                 \
+void imuAttitudePushBatch##S(State *a, const ImuProt_t *packets, size_t count) {                \
+	for (size_t i = 0; i < count; i++)                                                          \
+		imuAttitudePush##S(a, &packets[i]);                                                     \
+}                                                                                               \
+                                                                                                 \
+size_t imuAttitudeDrain##S(State *a, ImuRing_t *ring, size_t max) {                             \
+	size_t total = 0;                                                                           \
+	while (total < max) {                                                                       \
+		const ImuProt_t *packets;                                                               \
+		size_t n = imuRingPeek(ring, &packets, max - total);                                    \
+		if (!n)                                                                                 \
+			break;                                                                              \
+		imuAttitudePushBatch##S(a, packets, n);                                                 \
+		imuRingConsume(ring, n);                                                                \
+		total += n;                                                                             \
+	}                                                                                           \
+	return total;                                                                               \
+}
+
+ATTITUDE_DEFINE(ImuAttitude_t, double, , sqrt, sin, cos)
+ATTITUDE_DEFINE(ImuAttitudeF_t, float, F, sqrtf, sinf, cosf)
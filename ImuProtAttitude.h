@@ -0,0 +1,184 @@
+/**
+ * Strapdown Attitude Propagation.
+ *
+ * Integrates the gyro readings of validated packets into a unit quaternion
+ * (body to reference frame, { w, x, y, z }). Each packet is one update:
+ *
+ *   dTheta = gyro * gyroScale * period
+ *   phi    = dTheta + 1/12 dTheta(prev) x dTheta       (coning correction)
+ *   q      = q * [cos(|phi|/2), sin(|phi|/2) phi/|phi|]
+ *
+ * The rotation-vector exponential is evaluated with its 4th order series for
+ * the small angles of a single sample and exactly otherwise, and the
+ * quaternion is renormalized to first order after every update, so it stays
+ * unit length without a square root.
+ *
+ * Sequencer gaps of up to IMU_ATTITUDE_MAX_GAP packets are bridged by
+ * applying the rate of the packet after the gap over all missing periods, so
+ * the attitude keeps track of elapsed time. Longer outages are not
+ * extrapolated: the quaternion is left unchanged, propagation restarts from
+ * the packet after the outage and a restart is counted. Gaps and lost
+ * packets are counted either way. Earth rate and transport rate are not
+ * compensated: the reference frame is the inertial frame at start.
+ *
+ * `ImuAttitude_t` propagates in double precision, `ImuAttitudeF_t` in
+ * single precision with the same API suffixed with F. Both update from
+ * single packets, arrays or directly from an `ImuRing_t`.
+ */
+
+#ifndef ImuProtAttitude_h_included__
+#define ImuProtAttitude_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtRing.h"
+#include "ImuProtSample.h"
+
+/** Longest gap bridged by extrapolation; longer gaps restart propagation. */
+#define IMU_ATTITUDE_MAX_GAP (16)
+
+/**
+ * Double precision propagator. All fields are private.
+ */
+typedef struct {
+	double q[4];
+	double prev[3];
+	double scale;
+	double gyroScale;
+	double period;
+	uint64_t updates;
+	uint64_t gaps;
+	uint64_t lost;
+	uint64_t restarts;
+	uint8_t lastSeq;
+	uint8_t started;
+} ImuAttitude_t;
+
+/**
+ * Single precision propagator. All fields are private.
+ */
+typedef struct {
+	float q[4];
+	float prev[3];
+	float scale;
+	double gyroScale;
+	double period;
+	uint64_t updates;
+	uint64_t gaps;
+	uint64_t lost;
+	uint64_t restarts;
+	uint8_t lastSeq;
+	uint8_t started;
+} ImuAttitudeF_t;
+
+/**
+ * @brief Initializes the propagator at the identity attitude.
+ *
+ * @param a             State to initialize.
+ * @param packetRate    Packet rate in Hz.
+ */
+void imuAttitudeInit(ImuAttitude_t *a, uint32_t packetRate);
+void imuAttitudeInitF(ImuAttitudeF_t *a, uint32_t packetRate);
+
+/**
+ * @brief Sets the conversion of the gyro readings to rad/s, IMU_GYRO_TO_RAD by default.
+ */
+void imuAttitudeUnits(ImuAttitude_t *a, double gyroScale);
+void imuAttitudeUnitsF(ImuAttitudeF_t *a, double gyroScale);
+
+/**
+ * @brief Sets the attitude, e.g. from an alignment.
+ *
+ * @param a State.
+ * @param q Unit quaternion { w, x, y, z }, body to reference.
+ */
+void imuAttitudeSet(ImuAttitude_t *a, const double q[4]);
+void imuAttitudeSetF(ImuAttitudeF_t *a, const float q[4]);
+
+/**
+ * @brief Propagates the attitude by one validated packet.
+ *
+ * @param a         State.
+ * @param packet    Validated packet.
+ */
+void imuAttitudePush(ImuAttitude_t *a, const ImuProt_t *packet);
+void imuAttitudePushF(ImuAttitudeF_t *a, const ImuProt_t *packet);
+
+/**
+ * @brief Propagates the attitude by consecutive validated packets.
+ *
+ * @param a         State.
+ * @param packets   Packets.
+ * @param count     Number of packets.
+ */
+void imuAttitudePushBatch(ImuAttitude_t *a, const ImuProt_t *packets, size_t count);
+void imuAttitudePushBatchF(ImuAttitudeF_t *a, const ImuProt_t *packets, size_t count);
+
+/**
+ * @brief Propagates the attitude by the packets waiting in a ring and consumes them.
+ *
+ * Only the consumer thread of the ring may call it.
+ *
+ * @param a     State.
+ * @param ring  Ring of validated `ImuProt_t` packets.
+ * @param max   Maximum number of packets to consume.
+ * @return size_t Number of packets consumed.
+ */
+size_t imuAttitudeDrain(ImuAttitude_t *a, ImuRing_t *ring, size_t max);
+size_t imuAttitudeDrainF(ImuAttitudeF_t *a, ImuRing_t *ring, size_t max);
+
+/**
+ * @brief Returns the attitude quaternion.
+ */
+static inline const double *imuAttitudeQuat(const ImuAttitude_t *a)
+{
+	return a->q;
+}
+
+static inline const float *imuAttitudeQuatF(const ImuAttitudeF_t *a)
+{
+	return a->q;
+}
+
+/**
+ * @brief Returns the number of sequencer gaps bridged.
+ */
+static inline uint64_t imuAttitudeGaps(const ImuAttitude_t *a)
+{
+	return a->gaps;
+}
+
+static inline uint64_t imuAttitudeGapsF(const ImuAttitudeF_t *a)
+{
+	return a->gaps;
+}
+
+/**
+ * @brief Returns the number of packets lost in the gaps.
+ */
+static inline uint64_t imuAttitudeLost(const ImuAttitude_t *a)
+{
+	return a->lost;
+}
+
+static inline uint64_t imuAttitudeLostF(const ImuAttitudeF_t *a)
+{
+	return a->lost;
+}
+
+/**
+ * @brief Returns how often a gap longer than IMU_ATTITUDE_MAX_GAP restarted propagation.
+ */
+static inline uint64_t imuAttitudeRestarts(const ImuAttitude_t *a)
+{
+	return a->restarts;
+}
+
+static inline uint64_t imuAttitudeRestartsF(const ImuAttitudeF_t *a)
+{
+	return a->restarts;
+}
+
+#endif
@@ -0,0 +1,2255 @@
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ImuProt.h"
+#include "ImuProtAllan.h"
+#include "ImuProtAttitude.h"
+#include "ImuProtCalib.h"
+#include "ImuProtClock.h"
+#include "ImuProtDelta.h"
+#include "ImuProtFir.h"
+#include "ImuProtHex.h"
+#include "ImuProtIsa.h"
+#include "ImuProtLog.h"
+#include "ImuProtMoments.h"
+#include "ImuProtNet.h"
+#include "ImuProtPipe.h"
+#include "ImuProtRec.h"
+#include "ImuProtResample.h"
+#include "ImuProtRing.h"
+#include "ImuProtShm.h"
+#include "ImuProtSpectrum.h"
+#include "ImuProtTime.h"
+#include "ImuProtVerify.h"
+#include "ImuProtZupt.h"
+
+typedef struct {
+	const char *name;
+	const char *usage;
+	int (*run)(int argc, char **argv);
+} BenchCommand_t;
+
+static int benchHex(int argc, char **argv);
+static int benchRec(int argc, char **argv);
+static int benchLog(int argc, char **argv);
+static int benchShm(int argc, char **argv);
+static int benchNet(int argc, char **argv);
+static int benchTime(int argc, char **argv);
+static int benchClock(int argc, char **argv);
+static int benchRing(int argc, char **argv);
+static int benchPipe(int argc, char **argv);
+static int benchVerify(int argc, char **argv);
+static int benchIsa(int argc, char **argv);
+static int benchDelta(int argc, char **argv);
+static int benchFir(int argc, char **argv);
+static int benchAttitude(int argc, char **argv);
+static int benchAllan(int argc, char **argv);
+static int benchMoments(int argc, char **argv);
+static int benchSpectrum(int argc, char **argv);
+static int benchZupt(int argc, char **argv);
+static int benchCalib(int argc, char **argv);
+static int benchResample(int argc, char **argv);
+
+static const BenchCommand_t commands[] = {
+	{ "hex", "hex [packets]                      - hex log decoding throughput", benchHex },
+	{ "rec", "rec [packets] [file]               - recording write, open, seek and scan", benchRec },
+	{ "log", "log [packets]                      - compressed log ratio and codec throughput", benchLog },
+	{ "shm", "shm [packets] [spin|futex] [rate]  - shared memory ring throughput, latency and overruns", benchShm },
+	{ "net", "net [packets] [address] [rate]     - UDP republisher throughput and syscalls on loopback", benchNet },
+	{ "time", "time [packets] [ppm]               - per-packet timestamp accuracy on a simulated serial line", benchTime },
+	{ "clock", "clock [packets] [ppm] [rate Hz]    - sensor clock model drift and timestamp jitter", benchClock },
+	{ "ring", "ring [packets] [batch] [cpu] [cpu] - SPSC ring throughput and latency percentiles", benchRing },
+	{ "pipe", "pipe [packets] [slow sink policy]  - pipeline throughput with a fast and a slow sink", benchPipe },
+	{ "verify", "verify [packets] [threads]         - parallel capture verification against a sequential scan", benchVerify },
+	{ "isa", "isa [packets]                      - CRC, header scan and decode kernels at every ISA level", benchIsa },
+	{ "delta", "delta [packets] [ratio]            - coning compensated delta integration accuracy and throughput", benchDelta },
+	{ "fir", "fir [packets] [taps] [decimation]  - six-axis decimating FIR throughput and response", benchFir },
+	{ "attitude", "attitude [packets]                 - quaternion propagation accuracy and cost per update", benchAttitude },
+	{ "allan", "allan [samples]                    - streaming Allan deviation against white noise theory", benchAllan },
+	{ "moments", "moments [packets] [window]         - per-axis statistics kernels, merged partial states and windows", benchMoments },
+	{ "spectrum", "spectrum [seconds] [size]          - vibration PSD cost at 2500 Hz, peaks and noise floor", benchSpectrum },
+	{ "zupt", "zupt [seconds]                     - stationarity detection and gyro bias tracking over a temperature ramp", benchZupt },
+	{ "calib", "calib [packets]                    - calibration of 16 streams, temperature compensation and hot swap", benchCalib },
+	{ "resample", "resample [seconds] [devices] [Hz]  - multi-IMU alignment on drifting clocks, both interpolations", benchResample },
+};
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+int main(int argc, char **argv) {
+	if (argc >= 3 && !strcmp(argv[1], "--isa")) {
+		ImuIsa_t isa;
+		if (imuIsaParse(argv[2], &isa) != 0 || imuIsaSelect(isa) != 0) {
+			fprintf(stderr, "Unsupported ISA level: %s\n", argv[2]);
+			return 2;
+		}
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc >= 2) {
+		for (size_t i = 0; i < COMMAND_COUNT; i++) {
+			if (!strcmp(argv[1], commands[i].name))
+				return commands[i].run(argc - 2, argv + 2);
+		}
+	}
+
+	fprintf(stderr, "Usage: %s [--isa baseline|sse4.2|avx2|avx512] <benchmark> [arguments]\n", argv[0]);
+	for (size_t i = 0; i < COMMAND_COUNT; i++)
+		fprintf(stderr, "  %s\n", commands[i].usage);
+	return 2;
+}
+
+/**
+ * @brief Returns the monotonic clock in nanoseconds.
+ */
+static uint64_t benchNowNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Fills `count` valid packets with a random walk around the example readings.
+ *
+ * @param packets   Output array.
+ * @param count     Number of packets to generate.
+ * @param seed      Seed of the pseudo-random generator.
+ */
+static void benchMakePackets(ImuProt_t *packets, size_t count, uint32_t seed) {
+	int32_t gyro[3] = { -2358, -891, 456 };
+	int32_t accl[3] = { -4999, -7204, 639993 };
+	for (size_t i = 0; i < count; i++) {
+		ImuProt_t *p = &packets[i];
+		memset(p, 0, sizeof(*p));
+		p->header = IMU_PROT_HEADER;
+		p->sequencer = (uint8_t)i;
+		p->ff_sequencer = (uint8_t)~p->sequencer;
+		p->data.mux = (uint32_t)(i & 31) * 0x01010101u;
+		p->data.temperature = (uint16_t)(31103 + ((i >> 12) & 7));
+		for (int a = 0; a < 3; a++) {
+			seed = seed * 1664525u + 1013904223u;
+			gyro[a] += (int32_t)(seed >> 22) - 512;
+			seed = seed * 1664525u + 1013904223u;
+			accl[a] += (int32_t)(seed >> 21) - 1024;
+			p->data.gyro[a] = gyro[a];
+			p->data.accl[a] = accl[a];
+		}
+		p->crc32 = protCRC32((const uint8_t *)p, sizeof(ImuProt_t) - sizeof(uint32_t));
+	}
+}
+
+/**
+ * @brief Measures hex decoding with `strtol`, the scalar table and the selected SIMD kernel.
+ */
+static int benchHex(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 1000000;
+	size_t lineLen = IMU_HEX_PACKET_CHARS + 1;
+	ImuProt_t *packets = malloc(count * sizeof(ImuProt_t));
+	uint8_t *decoded = malloc(count * sizeof(ImuProt_t));
+	char *text = malloc(count * lineLen + 1);
+	if (!packets || !decoded || !text) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	benchMakePackets(packets, count, 1);
+	for (size_t i = 0; i < count; i++) {
+		const uint8_t *b = (const uint8_t *)&packets[i];
+		for (size_t j = 0; j < sizeof(ImuProt_t); j++)
+			sprintf(text + i * lineLen + 2 * j, "%02X", b[j]);
+		text[i * lineLen + IMU_HEX_PACKET_CHARS] = '\n';
+	}
+	double mb = (double)(count * lineLen) / 1e6;
+
+	uint64_t t0 = benchNowNs();
+	for (size_t i = 0; i < count; i++) {
+		const char *line = text + i * lineLen;
+		for (size_t j = 0; j < sizeof(ImuProt_t); j++) {
+			char byteStr[3] = { line[2 * j], line[2 * j + 1], '\0' };
+			decoded[i * sizeof(ImuProt_t) + j] = (uint8_t)strtol(byteStr, NULL, 16);
+		}
+	}
+	uint64_t t1 = benchNowNs();
+	printf("strtol   %8.1f MB/s\n", mb / ((t1 - t0) * 1e-9));
+
+	t0 = benchNowNs();
+	for (size_t i = 0; i < count; i++)
+		imuHexDecodeScalar(text + i * lineLen, IMU_HEX_PACKET_CHARS, decoded + i * sizeof(ImuProt_t), NULL);
+	t1 = benchNowNs();
+	printf("scalar   %8.1f MB/s\n", mb / ((t1 - t0) * 1e-9));
+
+	t0 = benchNowNs();
+	for (size_t i = 0; i < count; i++)
+		imuHexDecode(text + i * lineLen, IMU_HEX_PACKET_CHARS, decoded + i * sizeof(ImuProt_t), NULL);
+	t1 = benchNowNs();
+	printf("%-8s %8.1f MB/s\n", imuHexKernelName(), mb / ((t1 - t0) * 1e-9));
+
+	if (memcmp(decoded, packets, count * sizeof(ImuProt_t)) != 0) {
+		fprintf(stderr, "Decoded packets differ from the source\n");
+		return 1;
+	}
+
+	FILE *out = fopen("/dev/null", "wb");
+	ImuHexStats_t stats = { 0 };
+	t0 = benchNowNs();
+	imuHexConvertBuffer(text, count * lineLen, out, 0, NULL, NULL, &stats);
+	t1 = benchNowNs();
+	fclose(out);
+	printf("convert  %8.1f MB/s (decode + validate + write, %llu packets)\n",
+		mb / ((t1 - t0) * 1e-9), (unsigned long long)stats.packets);
+
+	free(text);
+	free(decoded);
+	free(packets);
+	return 0;
+}
+
+/**
+ * @brief Measures recording write speed, open time, time seeks and a zero-copy scan.
+ */
+static int benchRec(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 9000000;
+	const char *path = argc > 1 ? argv[1] : "/tmp/ImuProtBench.rec";
+	const size_t block = 65536;
+	const uint64_t periodNs = 400000;
+	ImuProt_t *packets = malloc(block * sizeof(ImuProt_t));
+	if (!packets) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, block, 2);
+
+	ImuRecWriter_t writer;
+	ImuRecError_t result = imuRecWriterOpen(&writer, path, 0);
+	uint64_t t0 = benchNowNs();
+	for (size_t i = 0; i < count && result == IMU_REC_OK; i++)
+		result = imuRecWrite(&writer, &packets[i % block], i * periodNs);
+	if (result == IMU_REC_OK)
+		result = imuRecWriterClose(&writer);
+	uint64_t t1 = benchNowNs();
+	free(packets);
+	if (result != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", path, imuRecErrorToString(result));
+		return 1;
+	}
+	double mb = count * (double)sizeof(ImuRecRecord_t) / 1e6;
+	printf("write    %8.1f MB/s, %.1f Mpackets/s\n", mb / ((t1 - t0) * 1e-9), count / ((t1 - t0) * 1e-3));
+
+	ImuRecReader_t reader;
+	t0 = benchNowNs();
+	result = imuRecReaderOpen(&reader, path);
+	t1 = benchNowNs();
+	if (result != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", path, imuRecErrorToString(result));
+		return 1;
+	}
+	printf("open     %8.1f us (%llu records, %zu chunks)\n", (t1 - t0) * 1e-3,
+		(unsigned long long)imuRecCount(&reader), imuRecChunks(&reader));
+
+	const size_t seeks = 1000000;
+	uint64_t sum = 0;
+	uint32_t seed = 3;
+	t0 = benchNowNs();
+	for (size_t i = 0; i < seeks; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		uint64_t index = imuRecFindTime(&reader, (uint64_t)(seed % count) * periodNs);
+		sum += imuRecGet(&reader, index)->packet.sequencer;
+	}
+	t1 = benchNowNs();
+	printf("seek     %8.1f ns per time seek\n", (double)(t1 - t0) / seeks);
+
+	ImuRecCursor_t cursor;
+	const ImuRecRecord_t *run;
+	size_t n, valid = 0;
+	imuRecSeek(&reader, &cursor, 0);
+	t0 = benchNowNs();
+	while ((run = imuRecNextRun(&reader, &cursor, SIZE_MAX, &n)) != NULL) {
+		for (size_t i = 0; i < n; i++)
+			valid += run[i].packet.header == IMU_PROT_HEADER;
+	}
+	t1 = benchNowNs();
+	printf("scan     %8.1f MB/s (%zu records, checksum %llu)\n", mb / ((t1 - t0) * 1e-9), valid,
+		(unsigned long long)sum);
+
+	imuRecReaderClose(&reader);
+	unlink(path);
+	return 0;
+}
+
+/**
+ * @brief Measures the compression ratio and the block codec speed, checking the round trip.
+ */
+static int benchLog(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 4000000;
+	const size_t block = IMU_LOG_BLOCK_PACKETS;
+	count -= count % block;
+	ImuProt_t *packets = malloc(count * sizeof(ImuProt_t));
+	ImuProt_t *decoded = malloc(count * sizeof(ImuProt_t));
+	uint8_t *encoded = malloc(count / block * imuLogBlockBound(block));
+	uint32_t *scratch = malloc(IMU_LOG_COLUMNS * block * sizeof(uint32_t));
+	size_t *offsets = malloc((count / block + 1) * sizeof(size_t));
+	if (!packets || !decoded || !encoded || !scratch || !offsets || !count) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, count, 4);
+
+	uint64_t t0 = benchNowNs();
+	offsets[0] = 0;
+	for (size_t b = 0; b < count / block; b++)
+		offsets[b + 1] = offsets[b] + imuLogEncodeBlock(packets + b * block, block, encoded + offsets[b], scratch);
+	uint64_t t1 = benchNowNs();
+	size_t size = offsets[count / block];
+	double mb = count * (double)sizeof(ImuProt_t) / 1e6;
+	printf("ratio    %8.2f (%.2f bytes per packet)\n", (double)count * sizeof(ImuProt_t) / size, (double)size / count);
+	printf("encode   %8.1f MB/s raw\n", mb / ((t1 - t0) * 1e-9));
+
+	t0 = benchNowNs();
+	for (size_t b = 0; b < count / block; b++) {
+		size_t n;
+		if (imuLogDecodeBlock(encoded + offsets[b], offsets[b + 1] - offsets[b], decoded + b * block,
+			block, scratch, &n) != IMU_LOG_OK || n != block) {
+			fprintf(stderr, "Block %zu failed to decode\n", b);
+			return 1;
+		}
+	}
+	t1 = benchNowNs();
+	printf("decode   %8.1f MB/s raw, %.1f MB/s compressed, %.1f Mpackets/s\n", mb / ((t1 - t0) * 1e-9),
+		size / 1e6 / ((t1 - t0) * 1e-9), count / ((t1 - t0) * 1e-3));
+
+	if (memcmp(packets, decoded, count * sizeof(ImuProt_t)) != 0) {
+		fprintf(stderr, "Round trip is not bit-exact\n");
+		return 1;
+	}
+
+	free(offsets);
+	free(scratch);
+	free(encoded);
+	free(decoded);
+	free(packets);
+	return 0;
+}
+
+/**
+ * @brief Reader process of the shared memory benchmark: validates every packet in place.
+ */
+static int benchShmReader(const char *name, size_t count, uint32_t spin) {
+	ImuShmReader_t reader;
+	ImuShmError_t result = imuShmOpen(&reader, name, IMU_SHM_FROM_OLDEST);
+	if (result != IMU_SHM_OK) {
+		fprintf(stderr, "%s: %s\n", name, imuShmErrorToString(result));
+		return 1;
+	}
+
+	size_t received = 0, invalid = 0;
+	uint64_t latencyNs = 0;
+	uint64_t t0 = benchNowNs();
+	while (received + imuShmLost(&reader) < count) {
+		uint64_t rxTimeNs;
+		const ImuProt_t *packet = imuShmPeek(&reader, &rxTimeNs);
+		if (!packet) {
+			imuShmWait(&reader, spin, 0);
+			continue;
+		}
+		int valid = checkImuProtBuffer(packet) == IMU_PROT_OK;
+		uint64_t now = benchNowNs();
+		if (imuShmRelease(&reader)) {
+			invalid += !valid;
+			latencyNs += now - rxTimeNs;
+			received++;
+		}
+	}
+	uint64_t t1 = benchNowNs();
+	printf("read     %8.1f Mpackets/s, %zu received, %llu lost, %zu invalid, mean latency %.0f ns\n",
+		received / ((t1 - t0) * 1e-3), received, (unsigned long long)imuShmLost(&reader), invalid,
+		received ? (double)latencyNs / received : 0.0);
+	fflush(stdout);
+	imuShmReaderClose(&reader);
+	return invalid != 0;
+}
+
+/**
+ * @brief Publishes packets to a reader in a child process, in batches of 32 or
+ * one by one at `rate` packets per second.
+ */
+static int benchShm(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 10000000;
+	uint32_t spin = argc > 1 && !strcmp(argv[1], "futex") ? 0 : UINT32_MAX;
+	uint64_t rate = argc > 2 ? strtoull(argv[2], NULL, 0) : 0;
+	const char *name = "/ImuProtBench";
+	const size_t batch = rate ? 1 : 32, block = 4096;
+	ImuProt_t *packets = malloc(block * sizeof(ImuProt_t));
+	if (!packets) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, block, 5);
+
+	ImuShmWriter_t writer;
+	ImuShmError_t result = imuShmCreate(&writer, name, 65536);
+	if (result != IMU_SHM_OK) {
+		fprintf(stderr, "%s: %s\n", name, imuShmErrorToString(result));
+		return 1;
+	}
+
+	fflush(stdout);
+	pid_t child = fork();
+	if (child == 0)
+		_exit(benchShmReader(name, count, spin));
+
+	// Let the reader register so that it sees the first packet.
+	while (!atomic_load(&writer.shm->readers[0].pid))
+		nanosleep(&(struct timespec){ .tv_nsec = 100000 }, NULL);
+
+	uint64_t rxTimesNs[32];
+	uint64_t t0 = benchNowNs();
+	for (size_t i = 0; i < count; i += batch) {
+		size_t n = count - i < batch ? count - i : batch;
+		if (rate) {
+			uint64_t due = t0 + i * 1000000000u / rate;
+			struct timespec ts = { .tv_sec = (time_t)(due / 1000000000u), .tv_nsec = (long)(due % 1000000000u) };
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		}
+		uint64_t now = benchNowNs();
+		for (size_t j = 0; j < n; j++)
+			rxTimesNs[j] = now;
+		imuShmPublish(&writer, packets + i % block, rxTimesNs, n);
+	}
+	uint64_t t1 = benchNowNs();
+	printf("publish  %8.1f Mpackets/s (%s readers)\n", count / ((t1 - t0) * 1e-3),
+		spin ? "busy-polling" : "futex");
+	fflush(stdout);
+
+	int status = 1;
+	waitpid(child, &status, 0);
+	imuShmWriterClose(&writer, 1);
+	free(packets);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+/**
+ * @brief Receiver process of the UDP benchmark.
+ */
+static int benchNetReceiver(ImuNetReceiver_t *receiver, size_t count) {
+	size_t received = 0;
+	uint64_t latencyNs = 0, t0 = 0, t1 = 0;
+	while (received < count) {
+		const ImuRecRecord_t *records;
+		size_t n;
+		ImuNetError_t result = imuNetReceive(receiver, &records, &n);
+		if (result == IMU_NET_TIMEOUT)
+			break;
+		if (result != IMU_NET_OK) {
+			fprintf(stderr, "receive: %s\n", imuNetErrorToString(result));
+			return 1;
+		}
+		t1 = benchNowNs();
+		if (!received)
+			t0 = t1;
+		for (size_t i = 0; i < n; i++)
+			latencyNs += t1 - records[i].rxTimeNs;
+		received += n;
+	}
+
+	const ImuNetStats_t *stats = imuNetReceiverStats(receiver);
+	printf("receive  %8.1f kpackets/s, %zu received, %llu datagrams lost, %llu invalid, "
+		"%.1f packets per syscall, mean latency %.0f us\n",
+		t1 > t0 ? received / ((t1 - t0) * 1e-6) : 0.0, received,
+		(unsigned long long)stats->lostDatagrams, (unsigned long long)stats->invalid,
+		stats->syscalls ? (double)received / stats->syscalls : 0.0,
+		received ? latencyNs / 1e3 / received : 0.0);
+	fflush(stdout);
+	imuNetReceiverClose(receiver);
+	return stats->invalid != 0;
+}
+
+/**
+ * @brief Sends packets to a receiver in a child process, at full speed or at
+ * `rate` packets per second with a flush after every packet.
+ */
+static int benchNet(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 1000000;
+	const char *address = argc > 1 ? argv[1] : "127.0.0.1";
+	uint64_t rate = argc > 2 ? strtoull(argv[2], NULL, 0) : 0;
+	const uint16_t port = 47001;
+	const size_t block = 4096;
+	ImuProt_t *packets = malloc(block * sizeof(ImuProt_t));
+	ImuNetSender_t *sender = malloc(sizeof(ImuNetSender_t));
+	ImuNetReceiver_t *receiver = malloc(sizeof(ImuNetReceiver_t));
+	if (!packets || !sender || !receiver) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, block, 6);
+
+	// Bind before forking so that no datagram is sent to a closed port.
+	ImuNetError_t result = imuNetReceiverOpen(receiver, address, port, NULL, 1, 500);
+	if (result == IMU_NET_OK)
+		result = imuNetSenderOpen(sender, address, port, NULL, 1, 1, 0);
+	if (result != IMU_NET_OK) {
+		fprintf(stderr, "%s: %s\n", address, imuNetErrorToString(result));
+		return 1;
+	}
+
+	fflush(stdout);
+	pid_t child = fork();
+	if (child == 0)
+		_exit(benchNetReceiver(receiver, count));
+	imuNetReceiverClose(receiver);
+
+	uint64_t t0 = benchNowNs();
+	for (size_t i = 0; i < count && result == IMU_NET_OK; i++) {
+		if (rate) {
+			uint64_t due = t0 + i * 1000000000u / rate;
+			struct timespec ts = { .tv_sec = (time_t)(due / 1000000000u), .tv_nsec = (long)(due % 1000000000u) };
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		}
+		result = imuNetSend(sender, &packets[i % block], benchNowNs());
+		if (rate && result == IMU_NET_OK)
+			result = imuNetFlush(sender);
+	}
+	if (result == IMU_NET_OK)
+		result = imuNetFlush(sender);
+	uint64_t t1 = benchNowNs();
+	if (result != IMU_NET_OK)
+		fprintf(stderr, "send: %s\n", imuNetErrorToString(result));
+
+	const ImuNetStats_t *stats = imuNetSenderStats(sender);
+	printf("send     %8.1f kpackets/s, %llu datagrams, %.1f packets per syscall\n",
+		count / ((t1 - t0) * 1e-6), (unsigned long long)stats->datagrams,
+		stats->syscalls ? (double)stats->packets / stats->syscalls : 0.0);
+	fflush(stdout);
+	imuNetSenderClose(sender);
+
+	int status = 1;
+	waitpid(child, &status, 0);
+	free(receiver);
+	free(sender);
+	free(packets);
+	return result == IMU_NET_OK && WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+/**
+ * @brief Accumulates absolute timestamp errors.
+ */
+typedef struct {
+	double sum;
+	uint64_t max;
+} BenchError_t;
+
+static void benchErrorAdd(BenchError_t *e, uint64_t estimate, uint64_t truth) {
+	uint64_t err = estimate > truth ? estimate - truth : truth - estimate;
+	e->sum += (double)err;
+	if (err > e->max)
+		e->max = err;
+}
+
+/**
+ * @brief Simulates a back-to-back packet stream read in random chunks with
+ * random read latency and occasional corrupted packets, and compares the
+ * timestamps with the true arrival times.
+ */
+static int benchTime(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 1000000;
+	double ppm = argc > 1 ? strtod(argv[1], NULL) : 30.0;
+	const uint64_t byteNs = IMU_TIME_BITS_PER_BYTE * 1000000000ull / IMO_PROT_BAUDRATE;
+	const double scale = 1.0 + ppm * 1e-6;
+	size_t *endOffsets = malloc(64 * sizeof(size_t));
+	uint32_t *periods = malloc(64 * sizeof(uint32_t));
+	uint64_t *truth = malloc(64 * sizeof(uint64_t));
+	uint64_t *timesNs = malloc(64 * sizeof(uint64_t));
+	if (!endOffsets || !periods || !truth || !timesNs) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	ImuTimeStamper_t stamper;
+	imuTimeInit(&stamper, 0, 0);
+	BenchError_t naive = { 0 }, raw = { 0 }, smooth = { 0 };
+	uint64_t bytes = 0, packets = 0, lost = 0, sampleNs = 1000000, lastNs = 0, costNs = 0;
+	uint32_t seed = 7, gap = 1;
+	int monotonic = 1;
+
+	while (packets < count) {
+		// The driver samples the line at a random instant and returns after a random latency.
+		seed = seed * 1664525u + 1013904223u;
+		sampleNs += 200000 + (seed >> 8) % 1800000;
+		seed = seed * 1664525u + 1013904223u;
+		uint64_t latencyNs = 20000 + (seed >> 8) % 280000 + (((seed >> 20) & 63) == 0 ? 2000000 : 0);
+		uint64_t available = (uint64_t)(sampleNs / (byteNs * scale));
+		size_t chunkLen = (size_t)(available - bytes);
+		size_t n = 0;
+		uint64_t end = (bytes / sizeof(ImuProt_t) + 1) * sizeof(ImuProt_t);
+		for (; end <= available && n < 64; end += sizeof(ImuProt_t)) {
+			// One packet in 1000 fails its CRC and never reaches the stamper.
+			seed = seed * 1664525u + 1013904223u;
+			if ((seed >> 8) % 1000 == 0) {
+				gap++;
+				lost++;
+				continue;
+			}
+			endOffsets[n] = (size_t)(end - bytes);
+			periods[n] = gap;
+			truth[n] = (uint64_t)(end * byteNs * scale);
+			gap = 1;
+			n++;
+		}
+		if (n == 64)
+			chunkLen = endOffsets[n - 1];
+
+		uint64_t readTimeNs = sampleNs + latencyNs;
+		uint64_t t0 = benchNowNs();
+		imuTimeStampChunk(&stamper, chunkLen, readTimeNs, endOffsets, periods, n, timesNs);
+		costNs += benchNowNs() - t0;
+
+		for (size_t i = 0; i < n; i++) {
+			benchErrorAdd(&naive, readTimeNs, truth[i]);
+			imuTimeChunk(&stamper, chunkLen, readTimeNs);
+			benchErrorAdd(&raw, imuTimeRaw(&stamper, endOffsets[i]), truth[i]);
+			benchErrorAdd(&smooth, timesNs[i], truth[i]);
+			monotonic &= timesNs[i] > lastNs;
+			lastNs = timesNs[i];
+		}
+		bytes += chunkLen;
+		packets += n;
+	}
+
+	printf("naive    mean %8.1f us, max %8.1f us (read completion time)\n", naive.sum / packets / 1e3, naive.max / 1e3);
+	printf("raw      mean %8.1f us, max %8.1f us (back-computed from byte offset)\n", raw.sum / packets / 1e3, raw.max / 1e3);
+	printf("model    mean %8.1f us, max %8.1f us (clock model, %llu resyncs, %s)\n", smooth.sum / packets / 1e3,
+		smooth.max / 1e3, (unsigned long long)imuTimeResyncs(&stamper), monotonic ? "monotonic" : "NOT monotonic");
+	printf("cost     %8.1f ns per packet (%llu packets lost)\n", (double)costNs / packets, (unsigned long long)lost);
+
+	free(timesNs);
+	free(truth);
+	free(periods);
+	free(endOffsets);
+	return !monotonic;
+}
+
+/**
+ * @brief Feeds a simulated stream with oscillator drift, receive jitter and
+ * lost packets to the clock model and compares it with the true sample times.
+ */
+static int benchClock(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 1000000;
+	double ppm = argc > 1 ? strtod(argv[1], NULL) : 40.0;
+	uint32_t rate = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 2000;
+	const size_t block = 4096;
+	double *rawErr = malloc(count * sizeof(double));
+	double *modelErr = malloc(count * sizeof(double));
+	ImuProt_t *packets = malloc(block * sizeof(ImuProt_t));
+	if (!rawErr || !modelErr || !packets || !rate) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, block, 8);
+	for (size_t i = IMU_CLOCK_RATE_WORD; i < block; i += 32) {
+		packets[i].data.mux = rate;
+		packets[i].crc32 = protCRC32((const uint8_t *)&packets[i], sizeof(ImuProt_t) - sizeof(uint32_t));
+	}
+
+	ImuClock_t clock;
+	imuClockInit(&clock, 0);
+	const double periodNs = 1e9 / rate * (1.0 + ppm * 1e-6);
+	const uint64_t startNs = 1700000000ull * 1000000000ull;
+	uint32_t seed = 9;
+	size_t used = 0, dropped = 0;
+	uint64_t costNs = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		if ((seed >> 8) % 1000 == 0 || (i >= count / 2 && i < count / 2 + 1000)) {
+			dropped++;      // Lost on the line, plus one long outage.
+			continue;
+		}
+		seed = seed * 1664525u + 1013904223u;
+		uint64_t truth = startNs + (uint64_t)(i * periodNs);
+		uint64_t latency = 20000 + (seed >> 8) % 280000 + ((((seed >> 20) & 255) == 0) ? 3000000 : 0);
+		uint64_t rx = truth + latency;
+
+		uint64_t t0 = benchNowNs();
+		uint64_t model = imuClockUpdate(&clock, &packets[i % block], rx);
+		costNs += benchNowNs() - t0;
+		rawErr[used] = (double)(int64_t)(rx - truth);
+		modelErr[used] = (double)(int64_t)(model - truth);
+		used++;
+	}
+
+	// The model keeps the mean latency as offset; compare the scatter around it
+	// over the second half, after the filter settled.
+	double rawMean = 0, modelMean = 0, rawDev = 0, modelDev = 0, modelMax = 0;
+	size_t from = used / 4, n = used - from;
+	for (size_t i = from; i < used; i++) {
+		rawMean += rawErr[i] / n;
+		modelMean += modelErr[i] / n;
+	}
+	for (size_t i = from; i < used; i++) {
+		double r = rawErr[i] - rawMean, m = modelErr[i] - modelMean;
+		rawDev += (r < 0 ? -r : r) / n;
+		modelDev += (m < 0 ? -m : m) / n;
+		if ((m < 0 ? -m : m) > modelMax)
+			modelMax = m < 0 ? -m : m;
+	}
+
+	ImuClockQuality_t q;
+	imuClockQuality(&clock, &q);
+	printf("drift    %8.2f ppm estimated, %.2f ppm true (rate %u Hz from mux, %s)\n", q.driftPpm, ppm,
+		q.packetRate, q.locked ? "locked" : "not locked");
+	printf("samples  %8llu, %llu lost (%zu dropped), jitter metric %.1f us\n", (unsigned long long)q.samples,
+		(unsigned long long)q.lost, dropped, q.jitterNs / 1e3);
+	printf("raw      offset %8.1f us, scatter %8.1f us\n", rawMean / 1e3, rawDev / 1e3);
+	printf("model    offset %8.1f us, scatter %8.1f us, max %.1f us\n", modelMean / 1e3, modelDev / 1e3, modelMax / 1e3);
+	printf("cost     %8.1f ns per update\n", (double)costNs / used);
+
+	free(packets);
+	free(modelErr);
+	free(rawErr);
+	return 0;
+}
+
+/**
+ * @brief Pins the calling thread to a CPU, modulo the number of CPUs.
+ */
+static void benchPin(int cpu) {
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpus > 0 ? cpu % cpus : 0, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+typedef struct {
+	ImuRing_t *ring;
+	const ImuProt_t *packets;
+	size_t block;
+	size_t count;
+	size_t batch;
+	int cpu;
+} BenchRingProducer_t;
+
+/**
+ * @brief Producer thread: pushes batches stamped with the push time in the accl[0..1] words.
+ */
+static void *benchRingProducer(void *arg) {
+	BenchRingProducer_t *p = arg;
+	benchPin(p->cpu);
+	for (size_t i = 0; i < p->count; ) {
+		ImuProt_t *slots;
+		size_t n = imuRingReserve(p->ring, &slots, p->count - i < p->batch ? p->count - i : p->batch);
+		if (!n) {
+			sched_yield();
+			continue;
+		}
+		uint64_t now = benchNowNs();
+		for (size_t j = 0; j < n; j++) {
+			slots[j] = p->packets[(i + j) % p->block];
+			memcpy(slots[j].data.accl, &now, sizeof(now));
+		}
+		imuRingCommit(p->ring, n);
+		i += n;
+	}
+	return NULL;
+}
+
+static int benchCompareU32(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Streams packets through the ring between two pinned threads and reports latency percentiles.
+ */
+static int benchRing(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 5000000;
+	size_t batch = argc > 1 ? strtoul(argv[1], NULL, 0) : 32;
+	int producerCpu = argc > 2 ? atoi(argv[2]) : 0;
+	int consumerCpu = argc > 3 ? atoi(argv[3]) : 1;
+	const size_t block = 4096;
+	ImuProt_t *packets = malloc(block * sizeof(ImuProt_t));
+	uint32_t *latency = malloc(count * sizeof(uint32_t));
+	ImuRing_t ring;
+	if (!packets || !latency || !batch || imuRingInit(&ring, 4096) != 0) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, block, 10);
+
+	BenchRingProducer_t producer = { &ring, packets, block, count, batch, producerCpu };
+	pthread_t thread;
+	benchPin(consumerCpu);
+	uint64_t t0 = benchNowNs();
+	pthread_create(&thread, NULL, benchRingProducer, &producer);
+
+	uint64_t sum = 0;
+	for (size_t i = 0; i < count; ) {
+		const ImuProt_t *slots;
+		size_t n = imuRingPeek(&ring, &slots, batch);
+		if (!n) {
+			sched_yield();
+			continue;
+		}
+		uint64_t now = benchNowNs(), stamp;
+		for (size_t j = 0; j < n; j++) {
+			memcpy(&stamp, slots[j].data.accl, sizeof(stamp));
+			latency[i + j] = now - stamp > UINT32_MAX ? UINT32_MAX : (uint32_t)(now - stamp);
+			sum += slots[j].data.gyro[0];
+		}
+		imuRingConsume(&ring, n);
+		i += n;
+	}
+	uint64_t t1 = benchNowNs();
+	pthread_join(thread, NULL);
+
+	qsort(latency, count, sizeof(uint32_t), benchCompareU32);
+	printf("ring     %8.1f Mpackets/s, %.1f MB/s (batch %zu, cpus %d -> %d, checksum %llu)\n",
+		count / ((t1 - t0) * 1e-3), count * (double)sizeof(ImuProt_t) / ((t1 - t0) * 1e-3), batch,
+		producerCpu, consumerCpu, (unsigned long long)sum);
+	printf("latency  p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns, p99.99 %.0f ns, max %.0f ns\n",
+		(double)latency[count / 2], (double)latency[(size_t)(count * 0.99)],
+		(double)latency[(size_t)(count * 0.999)], (double)latency[(size_t)(count * 0.9999)],
+		(double)latency[count - 1]);
+
+	imuRingFree(&ring);
+	free(latency);
+	free(packets);
+	return 0;
+}
+
+typedef struct {
+	int fd;
+	const ImuProt_t *packets;
+	size_t block;
+	size_t count;
+} BenchPipeWriter_t;
+
+/**
+ * @brief Writes the raw packet stream into the pipe, with a damaged byte every 10000 packets.
+ */
+static void *benchPipeWriter(void *arg) {
+	BenchPipeWriter_t *w = arg;
+	uint8_t chunk[100 * sizeof(ImuProt_t)];
+	for (size_t i = 0; i < w->count; ) {
+		size_t n = w->count - i < 100 ? w->count - i : 100;
+		for (size_t j = 0; j < n; j++) {
+			memcpy(chunk + j * sizeof(ImuProt_t), &w->packets[(i + j) % w->block], sizeof(ImuProt_t));
+			if ((i + j) % 10000 == 9999)
+				chunk[j * sizeof(ImuProt_t) + 20] ^= 0x40;
+		}
+		const uint8_t *p = chunk;
+		size_t len = n * sizeof(ImuProt_t);
+		while (len) {
+			ssize_t written = write(w->fd, p, len);
+			if (written <= 0)
+				break;
+			p += written;
+			len -= (size_t)written;
+		}
+		i += n;
+	}
+	close(w->fd);
+	return NULL;
+}
+
+typedef struct {
+	uint64_t packets;
+	double sum;
+	unsigned delayUs;
+} BenchPipeSink_t;
+
+static size_t benchPipeSinkWrite(void *ctx, const ImuPipeItem_t *items, size_t count) {
+	BenchPipeSink_t *s = ctx;
+	for (size_t i = 0; i < count; i++)
+		s->sum += items[i].sample.gyro[0];
+	s->packets += count;
+	if (s->delayUs) {
+		struct timespec ts = { .tv_sec = 0, .tv_nsec = (long)s->delayUs * 1000 };
+		nanosleep(&ts, NULL);
+	}
+	return 0;
+}
+
+/**
+ * @brief Streams packets through a pipe into the pipeline, with one fast
+ * blocking sink and one slow sink using the given policy.
+ */
+static int benchPipe(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 2000000;
+	ImuPipePolicy_t slowPolicy = IMU_PIPE_DROP_OLDEST;
+	if (argc > 1 && !strcmp(argv[1], "newest"))
+		slowPolicy = IMU_PIPE_DROP_NEWEST;
+	else if (argc > 1 && !strcmp(argv[1], "block"))
+		slowPolicy = IMU_PIPE_BLOCK;
+	const size_t block = 4096;
+	ImuProt_t *packets = malloc(block * sizeof(ImuProt_t));
+	ImuPipe_t *pipeline = aligned_alloc(IMU_RING_CACHE_LINE, sizeof(ImuPipe_t));
+	int fds[2];
+	if (!packets || !pipeline || pipe(fds) != 0) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, block, 11);
+
+	BenchPipeSink_t fast = { 0, 0.0, 0 }, slow = { 0, 0.0, 200 };
+	ImuPipeSink_t sinks[2] = {
+		{ "fast", benchPipeSinkWrite, NULL, &fast, IMU_PIPE_BLOCK, -1 },
+		{ "slow", benchPipeSinkWrite, NULL, &slow, slowPolicy, -1 },
+	};
+	ImuPipeConfig_t config;
+	imuPipeConfigInit(&config, fds[0]);
+
+	BenchPipeWriter_t writer = { fds[1], packets, block, count };
+	pthread_t thread;
+	uint64_t t0 = benchNowNs();
+	ImuPipeError_t result = imuPipeStart(pipeline, &config, sinks, 2);
+	if (result != IMU_PIPE_OK) {
+		fprintf(stderr, "pipeline: %s\n", imuPipeErrorToString(result));
+		return 1;
+	}
+	pthread_create(&thread, NULL, benchPipeWriter, &writer);
+	pthread_join(thread, NULL);
+	ImuPipeStats_t stats;
+	result = imuPipeJoin(pipeline, &stats);
+	uint64_t t1 = benchNowNs();
+	close(fds[0]);
+
+	printf("pipeline %8.1f Mpackets/s (%llu valid, %llu CRC errors, %llu resyncs, %llu bytes discarded)\n",
+		stats.frame.packets / ((t1 - t0) * 1e-3), (unsigned long long)stats.frame.packets,
+		(unsigned long long)stats.frame.errors[IMU_PROT_BAD_CRC], (unsigned long long)stats.frame.resyncs,
+		(unsigned long long)stats.frame.discarded);
+	printf("sequence %llu gaps, %llu packets lost, %llu mux cycles\n", (unsigned long long)stats.gaps,
+		(unsigned long long)stats.lost, (unsigned long long)stats.muxCycles);
+	for (size_t s = 0; s < stats.sinkCount; s++)
+		printf("sink     %-5s %10llu delivered, %10llu dropped, %llu failed\n", sinks[s].name,
+			(unsigned long long)stats.delivered[s], (unsigned long long)stats.sinkDropped[s],
+			(unsigned long long)stats.sinkFailed[s]);
+	ImuHist_t *latency = malloc(sizeof(ImuHist_t));
+	for (size_t s = 0; latency && s < stats.sinkCount; s++) {
+		char label[32];
+		snprintf(label, sizeof(label), "latency  %-5s us", sinks[s].name);
+		imuHistInit(latency);
+		imuPipeLatency(pipeline, s, latency);
+		imuHistPrint(latency, stdout, label, 1000.0);
+	}
+	free(latency);
+
+	int ok = result == IMU_PIPE_OK && fast.packets == stats.frame.packets
+		&& stats.frame.packets == count - count / 10000;
+	if (!ok)
+		fprintf(stderr, "Unexpected packet counts\n");
+	free(pipeline);
+	free(packets);
+	return !ok;
+}
+
+/**
+ * @brief Builds a raw capture with damaged, dropped, truncated and inserted bytes.
+ *
+ * @return size_t Size of the capture.
+ */
+static size_t benchMakeCapture(uint8_t *capture, const ImuProt_t *packets, size_t block, size_t count) {
+	size_t len = 0;
+	uint32_t seed = 5;
+	for (size_t i = 0; i < count; i++) {
+		memcpy(capture + len, &packets[i % block], sizeof(ImuProt_t));
+		seed = seed * 1664525u + 1013904223u;
+		if (i % 997 != 996 || i + 1 == count) {
+			len += sizeof(ImuProt_t);
+			continue;
+		}
+		switch ((seed >> 20) & 3) {
+		case 0:
+			// Damaged byte.
+			capture[len + 8 + ((seed >> 8) & 15)] ^= 0x10;
+			len += sizeof(ImuProt_t);
+			break;
+		case 1:
+			// Lost packet.
+			break;
+		case 2:
+			// Truncated packet.
+			len += 1 + ((seed >> 8) & 31);
+			break;
+		default:
+			// Line noise with a false header.
+			len += sizeof(ImuProt_t);
+			capture[len++] = 0x74;
+			capture[len++] = 0x95;
+			capture[len++] = (uint8_t)seed;
+			break;
+		}
+	}
+	return len;
+}
+
+static int benchVerifySame(const ImuVerifyStats_t *a, const ImuVerifyStats_t *b) {
+	return !memcmp(&a->frame, &b->frame, sizeof(a->frame)) && a->gaps == b->gaps && a->lost == b->lost;
+}
+
+/**
+ * @brief Verifies a damaged capture sequentially with the deframer and in
+ * parallel with several chunk sizes and thread counts, and checks that all
+ * counters agree.
+ */
+static int benchVerify(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 4000000;
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned maxThreads = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 0) : (online > 0 ? (unsigned)online : 1);
+	const size_t block = 4096;
+	ImuProt_t *packets = malloc(block * sizeof(ImuProt_t));
+	uint8_t *capture = malloc(count * (sizeof(ImuProt_t) + 3));
+	ImuProt_t *framed = malloc(IMU_PIPE_BATCH * sizeof(ImuProt_t));
+	if (!packets || !capture || !framed) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, block, 3);
+	size_t len = benchMakeCapture(capture, packets, block, count);
+
+	// Reference: the streaming deframer over the whole capture.
+	ImuFramer_t framer;
+	imuFramerInit(&framer);
+	ImuVerifyStats_t reference;
+	memset(&reference, 0, sizeof(reference));
+	int lastSeq = -1;
+	uint64_t t0 = benchNowNs();
+	for (size_t pos = 0; pos < len; ) {
+		size_t consumed, n = imuFramerPush(&framer, capture + pos, len - pos < 65536 ? len - pos : 65536,
+			framed, NULL, IMU_PIPE_BATCH, &consumed);
+		for (size_t i = 0; i < n; i++) {
+			if (lastSeq >= 0 && framed[i].sequencer != ((lastSeq + 1) & 0xFF)) {
+				reference.gaps++;
+				reference.lost += (unsigned)(framed[i].sequencer - lastSeq - 1) & 0xFF;
+			}
+			lastSeq = framed[i].sequencer;
+		}
+		pos += consumed;
+	}
+	uint64_t t1 = benchNowNs();
+	reference.frame = *imuFramerStats(&framer);
+	printf("deframer %8.1f MB/s  %llu valid, %llu bad header, %llu bad sequencer, %llu bad CRC, "
+		"%llu resyncs, %llu gaps, %llu lost\n",
+		len / ((t1 - t0) * 1e-3), (unsigned long long)reference.frame.packets,
+		(unsigned long long)reference.frame.errors[IMU_PROT_BAD_HEADER],
+		(unsigned long long)reference.frame.errors[IMU_PROT_BAD_SEQUENCER],
+		(unsigned long long)reference.frame.errors[IMU_PROT_BAD_CRC],
+		(unsigned long long)reference.frame.resyncs, (unsigned long long)reference.gaps,
+		(unsigned long long)reference.lost);
+
+	int ok = 1;
+	const size_t chunkSizes[] = { 4093, 65536, 1u << 20, IMU_VERIFY_CHUNK };
+	for (size_t c = 0; c < sizeof(chunkSizes) / sizeof(chunkSizes[0]); c++) {
+		for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+			ImuVerifyStats_t stats;
+			t0 = benchNowNs();
+			imuVerifyBuffer(capture, len, threads, chunkSizes[c], &stats);
+			t1 = benchNowNs();
+			int same = benchVerifySame(&stats, &reference);
+			ok &= same;
+			printf("verify   %8.1f MB/s  chunk %8zu, %2u threads, %7llu chunks, %4llu rescans%s\n",
+				len / ((t1 - t0) * 1e-3), chunkSizes[c], threads, (unsigned long long)stats.chunks,
+				(unsigned long long)stats.rescans, same ? "" : "  MISMATCH");
+			if (threads == maxThreads)
+				break;
+			if (threads * 2 > maxThreads)
+				threads = maxThreads / 2;
+		}
+	}
+
+	if (!ok)
+		fprintf(stderr, "Parallel counters differ from the sequential scan\n");
+	free(framed);
+	free(capture);
+	free(packets);
+	return !ok;
+}
+
+/**
+ * @brief Times the dispatched kernels at every level the CPU supports and
+ * checks that each level matches the baseline.
+ */
+static int benchIsa(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 1000000;
+	const size_t block = 4096;
+	ImuProt_t *packets = malloc(count * sizeof(ImuProt_t));
+	uint8_t *capture = malloc(count * (sizeof(ImuProt_t) + 3));
+	uint32_t *crcs[2] = { malloc(count * sizeof(uint32_t)), malloc(count * sizeof(uint32_t)) };
+	ImuSample_t *samples[2] = { malloc(count * sizeof(ImuSample_t)), malloc(count * sizeof(ImuSample_t)) };
+	if (!packets || !capture || !crcs[0] || !crcs[1] || !samples[0] || !samples[1]) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	benchMakePackets(packets, count, 7);
+	size_t len = benchMakeCapture(capture, packets, count < block ? count : block, count);
+
+	ImuIsa_t active = imuIsaActive();
+	size_t headers = 0;
+	int ok = 1;
+	printf("detected %s, active %s\n", imuIsaName(imuIsaDetect()), imuIsaName(active));
+	for (int isa = IMU_ISA_BASELINE; isa < IMU_ISA_COUNT; isa++) {
+		if (imuIsaSelect((ImuIsa_t)isa) != 0) {
+			printf("%-8s unsupported\n", imuIsaName((ImuIsa_t)isa));
+			continue;
+		}
+		int out = isa != IMU_ISA_BASELINE;
+
+		uint64_t t0 = benchNowNs();
+		imuCrcPackets(packets, count, crcs[out]);
+		uint64_t t1 = benchNowNs();
+		size_t found = 0;
+		for (size_t pos = 0; pos < len; pos++, found++)
+			pos += imuFindHeader(capture + pos, len - pos);
+		uint64_t t2 = benchNowNs();
+		imuDecodeSamples(packets, sizeof(ImuProt_t), samples[out], sizeof(ImuSample_t), count);
+		uint64_t t3 = benchNowNs();
+
+		int same = 1;
+		if (out) {
+			same = !memcmp(crcs[0], crcs[1], count * sizeof(uint32_t)) && found == headers &&
+				!memcmp(samples[0], samples[1], count * sizeof(ImuSample_t));
+		} else {
+			headers = found;
+			for (size_t i = 0; i < count && same; i++)
+				same = crcs[0][i] == packets[i].crc32;
+		}
+		ok &= same;
+		printf("%-8s crc %8.1f Mpackets/s  scan %8.1f MB/s  decode %8.1f Mpackets/s%s\n",
+			imuIsaName((ImuIsa_t)isa), count / ((t1 - t0) * 1e-3), len / ((t2 - t1) * 1e-3),
+			count / ((t3 - t2) * 1e-3), same ? "" : "  MISMATCH");
+	}
+	imuIsaSelect(active);
+
+	if (!ok)
+		fprintf(stderr, "Kernel results differ between levels\n");
+	for (int i = 0; i < 2; i++) {
+		free(samples[i]);
+		free(crcs[i]);
+	}
+	free(capture);
+	free(packets);
+	return !ok;
+}
+
+/**
+ * @brief q = a * b for quaternions stored as { w, x, y, z }.
+ */
+static void benchQuatMul(const double a[4], const double b[4], double q[4]) {
+	q[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+	q[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+	q[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+	q[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+/**
+ * @brief Body attitude of classical coning: the z axis circles at `halfAngle` with angular rate `omega`.
+ *
+ * @param t         Time in s.
+ * @param q         Attitude, body to reference.
+ * @param rate      Optional, body angular rate in rad/s.
+ */
+static void benchConing(double t, double halfAngle, double omega, double q[4], double rate[3]) {
+	double s = sin(halfAngle / 2);
+	q[0] = cos(halfAngle / 2);
+	q[1] = s * cos(omega * t);
+	q[2] = s * sin(omega * t);
+	q[3] = 0.0;
+	if (rate) {
+		// rate = 2 conj(q) * dq/dt
+		double conj[4] = { q[0], -q[1], -q[2], -q[3] };
+		double dq[4] = { 0.0, -s * omega * sin(omega * t), s * omega * cos(omega * t), 0.0 };
+		double w[4];
+		benchQuatMul(conj, dq, w);
+		for (int i = 0; i < 3; i++)
+			rate[i] = 2.0 * w[i + 1];
+	}
+}
+
+/**
+ * @brief Integral of the coning body rate over [t0, t1] (Simpson, 16 intervals): what a gyro reports.
+ */
+static void benchConingIncrement(double t0, double t1, double halfAngle, double omega, double v[3]) {
+	const int n = 16;
+	double q[4], w[3];
+	v[0] = v[1] = v[2] = 0.0;
+	for (int k = 0; k <= n; k++) {
+		double weight = k == 0 || k == n ? 1.0 : k % 2 ? 4.0 : 2.0;
+		benchConing(t0 + (t1 - t0) * k / n, halfAngle, omega, q, w);
+		for (int a = 0; a < 3; a++)
+			v[a] += weight * w[a] * (t1 - t0) / (3.0 * n);
+	}
+}
+
+/**
+ * @brief Rotation vector of a unit quaternion.
+ */
+static void benchRotationVector(const double q[4], double v[3]) {
+	double n = sqrt(q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	double k = n > 1e-300 ? 2.0 * atan2(n, q[0]) / n : 2.0;
+	for (int i = 0; i < 3; i++)
+		v[i] = q[i + 1] * k;
+}
+
+/**
+ * @brief Integrates a coning motion into delta-angles, compares them with
+ * the exact rotation and with plain summation, and measures throughput.
+ */
+static int benchDelta(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 2000000;
+	uint32_t ratio = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 10;
+	const uint32_t rate = 2000;
+	const double halfAngle = 0.5 * M_PI / 180, omega = 2 * M_PI * 25.0, period = 1.0 / rate;
+	ImuProt_t *packets = malloc(count * sizeof(ImuProt_t));
+	ImuDelta_t *deltas = malloc((count / (ratio ? ratio : 1) + 1) * sizeof(ImuDelta_t));
+	if (!packets || !deltas || !ratio) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	// Readings are the mean rates over each sample period, in deg/s and m/s^2.
+	for (size_t i = 0; i < count; i++) {
+		double v[3];
+		benchConingIncrement(i * period, (i + 1) * period, halfAngle, omega, v);
+		ImuProt_t *p = &packets[i];
+		memset(p, 0, sizeof(*p));
+		p->header = IMU_PROT_HEADER;
+		p->sequencer = (uint8_t)i;
+		p->ff_sequencer = (uint8_t)~p->sequencer;
+		for (int a = 0; a < 3; a++) {
+			p->data.gyro[a] = (int32_t)lround(v[a] / period / IMU_GYRO_TO_RAD / IMU_PROT_SCALE);
+			p->data.accl[a] = a == 2 ? (int32_t)lround(9.80665 / IMU_PROT_SCALE) : 0;
+		}
+	}
+
+	ImuDeltaInteg_t integ;
+	imuDeltaInit(&integ, rate, rate / ratio);
+	size_t written;
+	uint64_t t0 = benchNowNs();
+	imuDeltaPushBatch(&integ, packets, count, deltas, count / ratio + 1, &written);
+	uint64_t t1 = benchNowNs();
+
+	double errComp = 0.0, errPlain = 0.0;
+	for (size_t k = 0; k < written; k++) {
+		double q0[4], q1[4], dq[4], truth[3];
+		benchConing(k * ratio * period, halfAngle, omega, q0, NULL);
+		benchConing((k + 1) * ratio * period, halfAngle, omega, q1, NULL);
+		double conj[4] = { q0[0], -q0[1], -q0[2], -q0[3] };
+		benchQuatMul(conj, q1, dq);
+		benchRotationVector(dq, truth);
+		double plain[3] = { 0.0, 0.0, 0.0 };
+		for (size_t i = k * ratio; i < (k + 1) * ratio; i++) {
+			for (int a = 0; a < 3; a++)
+				plain[a] += packets[i].data.gyro[a] * (double)IMU_PROT_SCALE * IMU_GYRO_TO_RAD * period;
+		}
+		for (int a = 0; a < 3; a++) {
+			errComp += (deltas[k].angle[a] - truth[a]) * (deltas[k].angle[a] - truth[a]);
+			errPlain += (plain[a] - truth[a]) * (plain[a] - truth[a]);
+		}
+	}
+	double outRate = (double)rate / ratio;
+	printf("delta    %zu packets at %u Hz to %zu intervals at %.0f Hz, %.1f Msamples/s, %.1f ns/sample\n",
+		count, rate, written, outRate, count / ((t1 - t0) * 1e-3), (double)(t1 - t0) / count);
+	printf("coning   %.2f deg at %.0f Hz: RMS angle error per interval, plain sum %.3e rad, "
+		"compensated %.3e rad; drift %.3e vs %.3e rad/s\n",
+		2 * halfAngle * 180 / M_PI, omega / (2 * M_PI), sqrt(errPlain / written), sqrt(errComp / written),
+		sqrt(errPlain / written) * outRate, sqrt(errComp / written) * outRate);
+	free(deltas);
+	free(packets);
+	return 0;
+}
+
+/**
+ * @brief Returns the RMS of one output channel after the filter transient, relative to `amplitude`, in dB.
+ */
+static double benchFirGain(const ImuSample_t *out, size_t count, size_t skip, int channel, double amplitude) {
+	double sum = 0.0;
+	for (size_t i = skip; i < count; i++) {
+		double v = channel < 3 ? out[i].gyro[channel] : out[i].accl[channel - 3];
+		sum += v * v;
+	}
+	return 20.0 * log10(sqrt(sum / (count - skip)) * sqrt(2.0) / amplitude);
+}
+
+/**
+ * @brief Decimates the six axes with the floating-point and the fixed-point
+ * filter at every ISA level; reports throughput, frequency response and
+ * the agreement between the variants.
+ */
+static int benchFir(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 2000000;
+	size_t taps = argc > 1 ? strtoul(argv[1], NULL, 0) : 64;
+	uint32_t decimation = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 10;
+	const uint32_t rate = 2000;
+	const double amplitude = 100.0;
+	const double freqs[IMU_FIR_CHANNELS] = { 10.0, 40.0, 80.0, 120.0, 300.0, 700.0 };
+	ImuProt_t *packets = malloc(count * sizeof(ImuProt_t));
+	ImuSample_t *out = malloc((count / (decimation ? decimation : 1) + 1) * sizeof(ImuSample_t));
+	ImuData_t *fixedOut = malloc((count / (decimation ? decimation : 1) + 1) * sizeof(ImuData_t));
+	ImuData_t *fixedRef = malloc((count / (decimation ? decimation : 1) + 1) * sizeof(ImuData_t));
+	float *coefficients = malloc(IMU_FIR_MAX_TAPS * sizeof(float));
+	ImuFir_t *fir = aligned_alloc(64, sizeof(ImuFir_t));
+	ImuFirFixed_t *fixed = aligned_alloc(64, sizeof(ImuFirFixed_t));
+	if (!packets || !out || !fixedOut || !fixedRef || !coefficients || !fir || !fixed) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	if (!decimation || !taps || taps > IMU_FIR_MAX_TAPS) {
+		fprintf(stderr, "Taps must be 1 to %d, decimation at least 1\n", IMU_FIR_MAX_TAPS);
+		return 2;
+	}
+
+	// One tone per axis, from the pass band to far into the stop band.
+	memset(packets, 0, count * sizeof(ImuProt_t));
+	for (size_t i = 0; i < count; i++) {
+		ImuProt_t *p = &packets[i];
+		p->header = IMU_PROT_HEADER;
+		p->sequencer = (uint8_t)i;
+		p->ff_sequencer = (uint8_t)~p->sequencer;
+		for (int c = 0; c < IMU_FIR_CHANNELS; c++) {
+			int32_t v = (int32_t)lround(amplitude * sin(2 * M_PI * freqs[c] * i / rate) / IMU_PROT_SCALE);
+			if (c < 3)
+				p->data.gyro[c] = v;
+			else
+				p->data.accl[c - 3] = v;
+		}
+	}
+	imuFirDesign(coefficients, taps, 0.4 / decimation);
+
+	ImuIsa_t active = imuIsaActive();
+	size_t outputs = 0;
+	int ok = 1;
+	for (int isa = IMU_ISA_BASELINE; isa < IMU_ISA_COUNT; isa++) {
+		if (imuIsaSelect((ImuIsa_t)isa) != 0)
+			continue;
+		imuFirInit(fir, coefficients, taps, decimation);
+		imuFirFixedInit(fixed, coefficients, taps, decimation);
+		size_t written, fixedWritten;
+		uint64_t t0 = benchNowNs();
+		imuFirPush(fir, packets, count, out, count / decimation + 1, &written);
+		uint64_t t1 = benchNowNs();
+		imuFirFixedPush(fixed, packets, count, fixedOut, count / decimation + 1, &fixedWritten);
+		uint64_t t2 = benchNowNs();
+
+		// Fixed point is bit-exact across levels; float agrees to its precision.
+		double maxDiff = 0.0;
+		for (size_t k = 0; k < written; k++) {
+			for (int c = 0; c < 3; c++) {
+				double d = fabs(out[k].gyro[c] - floatData(fixedOut[k].gyro[c]));
+				double e = fabs(out[k].accl[c] - floatData(fixedOut[k].accl[c]));
+				maxDiff = d > maxDiff ? d : maxDiff;
+				maxDiff = e > maxDiff ? e : maxDiff;
+			}
+		}
+		int same = 1;
+		if (isa == IMU_ISA_BASELINE) {
+			memcpy(fixedRef, fixedOut, fixedWritten * sizeof(ImuData_t));
+			outputs = fixedWritten;
+		} else {
+			same = fixedWritten == outputs && !memcmp(fixedRef, fixedOut, outputs * sizeof(ImuData_t));
+		}
+		ok &= same;
+		printf("%-8s float %7.1f Msamples/s  fixed %7.1f Msamples/s  (%zu taps, /%u, 6 axes)  "
+			"max float-fixed difference %.2e%s\n",
+			imuIsaName((ImuIsa_t)isa), count / ((t1 - t0) * 1e-3), count / ((t2 - t1) * 1e-3), taps,
+			decimation, maxDiff, same ? "" : "  MISMATCH");
+	}
+	imuIsaSelect(active);
+
+	printf("response");
+	for (int c = 0; c < IMU_FIR_CHANNELS; c++)
+		printf("  %.0f Hz %.1f dB", freqs[c], benchFirGain(out, outputs, taps / decimation + 1, c, amplitude));
+	printf("  (output rate %.0f Hz)\n", (double)rate / decimation);
+
+	if (!ok)
+		fprintf(stderr, "Fixed-point results differ between levels\n");
+	free(fixed);
+	free(fir);
+	free(coefficients);
+	free(fixedRef);
+	free(fixedOut);
+	free(out);
+	free(packets);
+	return !ok;
+}
+
+/**
+ * @brief Returns the angle between two attitude quaternions in rad.
+ */
+static double benchQuatAngle(const double a[4], const double b[4]) {
+	double conj[4] = { a[0], -a[1], -a[2], -a[3] };
+	double d[4];
+	benchQuatMul(conj, b, d);
+	return 2.0 * atan2(sqrt(d[1] * d[1] + d[2] * d[2] + d[3] * d[3]), fabs(d[0]));
+}
+
+/**
+ * @brief Propagates the attitude through a coning motion, with and without
+ * dropped packets, in double and single precision; reports the final error
+ * against the exact attitude and the cost per update.
+ */
+static int benchAttitude(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 2000000;
+	const uint32_t rate = 2000;
+	const double halfAngle = 0.5 * M_PI / 180, omega = 2 * M_PI * 25.0, period = 1.0 / rate;
+	ImuProt_t *packets = malloc(count * sizeof(ImuProt_t));
+	ImuProt_t *dropped = malloc(count * sizeof(ImuProt_t));
+	ImuRing_t ring;
+	if (!packets || !dropped || imuRingInit(&ring, 4096) != 0) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	// Mean rates over each sample period, in deg/s.
+	size_t kept = 0;
+	for (size_t i = 0; i < count; i++) {
+		double v[3];
+		benchConingIncrement(i * period, (i + 1) * period, halfAngle, omega, v);
+		ImuProt_t *p = &packets[i];
+		memset(p, 0, sizeof(*p));
+		p->header = IMU_PROT_HEADER;
+		p->sequencer = (uint8_t)i;
+		p->ff_sequencer = (uint8_t)~p->sequencer;
+		for (int a = 0; a < 3; a++)
+			p->data.gyro[a] = (int32_t)lround(v[a] / period / IMU_GYRO_TO_RAD / IMU_PROT_SCALE);
+		if (i % 97 != 50)
+			dropped[kept++] = *p;
+	}
+	double truth[4];
+	benchConing(count * period, halfAngle, omega, truth, NULL);
+	double start[4];
+	benchConing(0.0, halfAngle, omega, start, NULL);
+	float startF[4] = { (float)start[0], (float)start[1], (float)start[2], (float)start[3] };
+
+	ImuAttitude_t att;
+	ImuAttitudeF_t attF;
+	const ImuProt_t *inputs[2] = { packets, dropped };
+	const size_t counts[2] = { count, kept };
+	for (int run = 0; run < 2; run++) {
+		imuAttitudeInit(&att, rate);
+		imuAttitudeSet(&att, start);
+		uint64_t t0 = benchNowNs();
+		imuAttitudePushBatch(&att, inputs[run], counts[run]);
+		uint64_t t1 = benchNowNs();
+		imuAttitudeInitF(&attF, rate);
+		imuAttitudeSetF(&attF, startF);
+		imuAttitudePushBatchF(&attF, inputs[run], counts[run]);
+		uint64_t t2 = benchNowNs();
+		const float *qf = imuAttitudeQuatF(&attF);
+		double qd[4] = { qf[0], qf[1], qf[2], qf[3] };
+		printf("attitude %-7s %zu updates over %.0f s, %llu lost: double %.1f ns/update, error %.2e rad; "
+			"float %.1f ns/update, error %.2e rad\n",
+			run ? "dropped" : "all", counts[run], count * period, (unsigned long long)imuAttitudeLost(&att),
+			(double)(t1 - t0) / counts[run], benchQuatAngle(imuAttitudeQuat(&att), truth),
+			(double)(t2 - t1) / counts[run], benchQuatAngle(qd, truth));
+	}
+
+	// Through a ring, as on the ingest core: produce a batch, drain it.
+	imuAttitudeInit(&att, rate);
+	imuAttitudeSet(&att, start);
+	uint64_t t0 = benchNowNs();
+	for (size_t pos = 0; pos < count; ) {
+		pos += imuRingPush(&ring, packets + pos, count - pos < IMU_PIPE_BATCH ? count - pos : IMU_PIPE_BATCH);
+		imuAttitudeDrain(&att, &ring, SIZE_MAX);
+	}
+	uint64_t t1 = benchNowNs();
+	printf("attitude ring    %zu updates: %.1f ns/update including the ring, error %.2e rad\n",
+		count, (double)(t1 - t0) / count, benchQuatAngle(imuAttitudeQuat(&att), truth));
+
+	imuRingFree(&ring);
+	free(dropped);
+	free(packets);
+	return 0;
+}
+
+/**
+ * @brief Streams white noise through the Allan deviation, whole and as merged
+ * segments, which must give the same curve.
+ */
+static int benchAllan(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 4000000;
+	const uint32_t rate = 2000;
+	const int segments = 4;
+	ImuSample_t *samples = malloc(count * sizeof(ImuSample_t));
+	ImuAllan_t *whole = malloc(sizeof(ImuAllan_t));
+	ImuAllan_t *merged = malloc(sizeof(ImuAllan_t));
+	ImuAllan_t *part = malloc(sizeof(ImuAllan_t));
+	if (!samples || !whole || !merged || !part) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	// Gaussian white noise (Box-Muller) on a constant bias; sigma 0.1 deg/s and 0.01 m/s^2.
+	uint64_t seed = 0x9E3779B97F4A7C15u;
+	for (size_t i = 0; i < count; i++) {
+		double v[6];
+		for (int c = 0; c < 6; c += 2) {
+			seed = seed * 6364136223846793005u + 1442695040888963407u;
+			double u1 = ((seed >> 11) + 1.0) / 9007199254740993.0;
+			seed = seed * 6364136223846793005u + 1442695040888963407u;
+			double u2 = (seed >> 11) / 9007199254740992.0;
+			double r = sqrt(-2.0 * log(u1));
+			v[c] = r * cos(2 * M_PI * u2);
+			v[c + 1] = r * sin(2 * M_PI * u2);
+		}
+		ImuSample_t *s = &samples[i];
+		memset(s, 0, sizeof(*s));
+		for (int a = 0; a < 3; a++) {
+			s->gyro[a] = (float)(0.5 * (a + 1) + 0.1 * v[a]);
+			s->accl[a] = (float)((a == 2 ? 9.81 : 0.0) + 0.01 * v[a + 3]);
+		}
+	}
+
+	imuAllanInit(whole, rate);
+	uint64_t t0 = benchNowNs();
+	imuAllanPush(whole, samples, count);
+	uint64_t t1 = benchNowNs();
+	imuAllanInit(merged, rate);
+	int ok = 1;
+	for (int k = 0; k < segments; k++) {
+		size_t first = count * k / segments, last = count * (k + 1) / segments;
+		ImuAllan_t *to = k ? part : merged;
+		if (k) {
+			imuAllanInit(part, rate);
+			imuAllanStart(part, first);
+		}
+		imuAllanPush(to, samples + first, last - first);
+		if (k)
+			ok &= imuAllanMerge(merged, part) == 0;
+	}
+	printf("allan %zu samples: %.1f ns/sample (6 axes)\n", count, (double)(t1 - t0) / count);
+
+	ImuAllanPoint_t a[IMU_ALLAN_LEVELS], b[IMU_ALLAN_LEVELS];
+	size_t n = imuAllanResult(whole, a, IMU_ALLAN_LEVELS);
+	size_t nm = imuAllanResult(merged, b, IMU_ALLAN_LEVELS);
+	ok &= nm == n;
+	printf("%10s %10s %12s %12s %12s %12s %12s\n", "tau s", "terms", "gyro x/th", "accl x/th", "worst/th",
+		"merged/whole", "merged terms");
+	for (size_t i = 0; i < n; i++) {
+		double m = a[i].tau * rate;
+		double worst = 1.0, diff = 0.0;
+		for (int c = 0; c < 6; c++) {
+			double ratio = a[i].adev[c] / ((c < 3 ? 0.1 : 0.01) / sqrt(m));
+			if (fabs(ratio - 1.0) > fabs(worst - 1.0))
+				worst = ratio;
+			if (i < nm && fabs(b[i].adev[c] / a[i].adev[c] - 1.0) > fabs(diff))
+				diff = b[i].adev[c] / a[i].adev[c] - 1.0;
+		}
+		// Rebasing the segments only rounds differently.
+		ok &= i < nm && b[i].terms == a[i].terms && fabs(diff) < 1e-6;
+		printf("%10.4g %10llu %12.4f %12.4f %12.4f %+12.2e %12llu\n", a[i].tau, (unsigned long long)a[i].terms,
+			a[i].adev[0] / (0.1 / sqrt(m)), a[i].adev[3] / (0.01 / sqrt(m)), worst, diff,
+			i < nm ? (unsigned long long)b[i].terms : 0ull);
+	}
+	if (!ok)
+		fprintf(stderr, "Merged segments differ from the whole stream\n");
+
+	free(part);
+	free(merged);
+	free(whole);
+	free(samples);
+	return !ok;
+}
+
+/**
+ * @brief Per-packet Welford update in double precision, the reference for the block kernels.
+ */
+static void benchWelford(const ImuProt_t *packets, size_t count, ImuMomentsSummary_t *out) {
+	double mean[IMU_MOMENTS_CHANNELS] = { 0 }, m2[IMU_MOMENTS_CHANNELS] = { 0 };
+	for (size_t i = 0; i < count; i++) {
+		const ImuData_t *d = &packets[i].data;
+		double x[IMU_MOMENTS_CHANNELS];
+		for (int c = 0; c < 3; c++) {
+			x[c] = d->gyro[c] * (double)IMU_PROT_SCALE;
+			x[c + 3] = d->accl[c] * (double)IMU_PROT_SCALE;
+		}
+		x[6] = 0.01 * d->temperature - (double)KELVIN;
+		for (int c = 0; c < IMU_MOMENTS_CHANNELS; c++) {
+			double delta = x[c] - mean[c];
+			mean[c] += delta / (double)(i + 1);
+			m2[c] += delta * (x[c] - mean[c]);
+		}
+	}
+	out->count = count;
+	for (int c = 0; c < IMU_MOMENTS_CHANNELS; c++) {
+		out->mean[c] = mean[c];
+		out->variance[c] = count > 1 ? m2[c] / (double)(count - 1) : 0.0;
+	}
+}
+
+/**
+ * @brief Returns the largest relative difference of the means and variances.
+ */
+static double benchMomentsDiff(const ImuMomentsSummary_t *a, const ImuMomentsSummary_t *b) {
+	double worst = 0.0;
+	for (int c = 0; c < IMU_MOMENTS_CHANNELS; c++) {
+		double dm = fabs(a->mean[c] - b->mean[c]) / fmax(fabs(b->mean[c]), 1e-300);
+		double dv = fabs(a->variance[c] - b->variance[c]) / fmax(fabs(b->variance[c]), 1e-300);
+		worst = fmax(worst, fmax(dm, dv));
+	}
+	return worst;
+}
+
+/**
+ * @brief Measures the statistics kernels at every ISA level against a per-packet Welford reference.
+ */
+static int benchMoments(int argc, char **argv) {
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 2000000;
+	uint64_t window = argc > 1 ? strtoull(argv[1], NULL, 0) : 20000;
+	const int parts = 8;
+	ImuProt_t *packets = malloc(count * sizeof(ImuProt_t));
+	ImuMomentsWindow_t *win = malloc(sizeof(ImuMomentsWindow_t));
+	if (!packets || !win || !count) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	if (imuMomentsWindowInit(win, window) != 0) {
+		fprintf(stderr, "Window shorter than %d packets\n", IMU_MOMENTS_BLOCKS);
+		return 2;
+	}
+	benchMakePackets(packets, count, 11);
+
+	ImuMomentsSummary_t ref, sum;
+	uint64_t t0 = benchNowNs();
+	benchWelford(packets, count, &ref);
+	uint64_t t1 = benchNowNs();
+	printf("welford  scalar   %6.2f ns/packet\n", (double)(t1 - t0) / count);
+
+	ImuIsa_t active = imuIsaActive();
+	ImuMoments_t whole, merged, part;
+	for (int isa = IMU_ISA_BASELINE; isa < IMU_ISA_COUNT; isa++) {
+		if (imuIsaSelect((ImuIsa_t)isa) != 0)
+			continue;
+		imuMomentsInit(&whole);
+		t0 = benchNowNs();
+		imuMomentsPush(&whole, packets, sizeof(ImuProt_t), count);
+		t1 = benchNowNs();
+		imuMomentsSummary(&whole, &sum);
+		printf("moments  %-8s %6.2f ns/packet, max relative difference %.2e\n", imuIsaName((ImuIsa_t)isa),
+			(double)(t1 - t0) / count, benchMomentsDiff(&sum, &ref));
+	}
+	imuIsaSelect(active);
+
+	// Partial states of contiguous parts, merged in reverse order.
+	imuMomentsInit(&merged);
+	for (int k = parts - 1; k >= 0; k--) {
+		size_t first = count * k / parts, last = count * (k + 1) / parts;
+		imuMomentsInit(&part);
+		imuMomentsPush(&part, packets + first, sizeof(ImuProt_t), last - first);
+		imuMomentsMerge(&merged, &part);
+	}
+	imuMomentsSummary(&merged, &sum);
+	printf("merged   %d parts: %llu packets, max relative difference %.2e, min/max %s\n", parts,
+		(unsigned long long)sum.count, benchMomentsDiff(&sum, &ref),
+		!memcmp(merged.min, whole.min, sizeof(whole.min)) && !memcmp(merged.max, whole.max, sizeof(whole.max))
+			? "identical" : "DIFFER");
+
+	// Window, fed in uneven batches.
+	t0 = benchNowNs();
+	for (size_t pos = 0, batch = 1; pos < count; pos += batch, batch = batch * 7 % 997 + 1)
+		imuMomentsWindowPush(win, packets + pos, sizeof(ImuProt_t), count - pos < batch ? count - pos : batch);
+	t1 = benchNowNs();
+	ImuMoments_t view;
+	imuMomentsWindowView(win, &view);
+	imuMomentsSummary(&view, &sum);
+	benchWelford(packets + count - sum.count, (size_t)sum.count, &ref);
+	printf("window   %llu: %6.2f ns/packet, view of %llu packets, max relative difference %.2e\n",
+		(unsigned long long)window, (double)(t1 - t0) / count, (unsigned long long)sum.count,
+		benchMomentsDiff(&sum, &ref));
+
+	free(win);
+	free(packets);
+	return 0;
+}
+
+/**
+ * @brief Compares one PSD frame of a segment with a direct DFT in double precision.
+ */
+static double benchSpectrumDft(const ImuSample_t *samples, uint32_t rate, uint32_t size) {
+	ImuSpectrum_t spec;
+	if (imuSpectrumInit(&spec, rate, size, size, 1, IMU_SPECTRUM_HANN) != 0)
+		return -1.0;
+	imuSpectrumPush(&spec, samples, size);
+	const float *frame = imuSpectrumFrame(&spec);
+	double worst = 0.0, power = 0.0;
+	for (uint32_t i = 0; i < size; i++) {
+		double w = 0.5 - 0.5 * cos(2 * M_PI * i / size);
+		power += w * w;
+	}
+	for (int c = 0; c < IMU_SPECTRUM_CHANNELS; c++) {
+		double x[size], psd[size / 2 + 1], mean = 0.0, peak = 0.0;
+		for (uint32_t i = 0; i < size; i++) {
+			x[i] = c < 3 ? samples[i].gyro[c] : samples[i].accl[c - 3];
+			mean += x[i] / size;
+		}
+		for (uint32_t k = 0; k <= size / 2; k++) {
+			double re = 0.0, im = 0.0;
+			for (uint32_t i = 0; i < size; i++) {
+				double v = (x[i] - mean) * (0.5 - 0.5 * cos(2 * M_PI * i / size));
+				re += v * cos(2 * M_PI * k * i / size);
+				im -= v * sin(2 * M_PI * k * i / size);
+			}
+			psd[k] = (re * re + im * im) / (rate * power) * (k == 0 || k == size / 2 ? 1 : 2);
+			peak = fmax(peak, psd[k]);
+		}
+		for (uint32_t k = 0; k <= size / 2; k++)
+			worst = fmax(worst, fabs(frame[k * IMU_SPECTRUM_LANES + c] - psd[k]) / peak);
+	}
+	imuSpectrumFree(&spec);
+	return worst;
+}
+
+/**
+ * @brief Measures the spectrum analyzer on six sines in white noise at 2500 Hz.
+ */
+static int benchSpectrum(int argc, char **argv) {
+	const uint32_t rate = 2500;
+	double seconds = argc > 0 ? atof(argv[0]) : 600.0;
+	uint32_t size = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 1024;
+	size_t count = (size_t)(seconds * rate);
+	const double sigma = 0.01;
+	ImuSample_t *samples = malloc(count * sizeof(ImuSample_t));
+	if (!samples || count < size) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	// Axis c: sine of amplitude 1 at 50 + 100 c Hz, noise sigma 0.01, gravity on accl z.
+	uint64_t seed = 0x2545F4914F6CDD1Du;
+	for (size_t i = 0; i < count; i++) {
+		double t = (double)i / rate;
+		float v[IMU_SPECTRUM_CHANNELS];
+		for (int c = 0; c < IMU_SPECTRUM_CHANNELS; c++) {
+			double noise = 0.0;
+			for (int k = 0; k < 12; k++) {
+				seed = seed * 6364136223846793005u + 1442695040888963407u;
+				noise += (seed >> 11) / 9007199254740992.0;
+			}
+			v[c] = (float)(sin(2 * M_PI * (50.0 + 100.0 * c) * t) + sigma * (noise - 6.0) + (c == 5 ? 9.81 : 0.0));
+		}
+		memset(&samples[i], 0, sizeof(samples[i]));
+		memcpy(samples[i].gyro, v, sizeof(samples[i].gyro));
+		memcpy(samples[i].accl, v + 3, sizeof(samples[i].accl));
+	}
+	printf("spectrum FFT against direct DFT (256 points): max error %.2e of the peak\n",
+		benchSpectrumDft(samples, rate, 256));
+
+	ImuIsa_t active = imuIsaActive();
+	for (int isa = IMU_ISA_BASELINE; isa < IMU_ISA_COUNT; isa++) {
+		if (imuIsaSelect((ImuIsa_t)isa) != 0)
+			continue;
+		ImuSpectrum_t spec;
+		uint32_t hop = size / 2, averages = (rate + hop / 2) / hop;
+		if (imuSpectrumInit(&spec, rate, size, hop, averages ? averages : 1, IMU_SPECTRUM_HANN) != 0) {
+			fprintf(stderr, "Unsupported size %u\n", size);
+			return 2;
+		}
+		uint64_t t0 = benchNowNs();
+		for (size_t pos = 0; pos < count; )
+			pos += imuSpectrumPush(&spec, samples + pos, count - pos);
+		uint64_t t1 = benchNowNs();
+		double ns = (double)(t1 - t0) / count;
+		printf("spectrum %-8s size %u, hop %u, %u averages: %llu frames, %.1f ns/sample, "
+			"%.4f %% of a core at %u Hz\n", imuIsaName((ImuIsa_t)isa), size, hop, spec.averages,
+			(unsigned long long)imuSpectrumFrames(&spec), ns, ns * rate * 1e-7, rate);
+
+		if ((ImuIsa_t)isa == active) {
+			const float *frame = imuSpectrumFrame(&spec);
+			const double df = imuSpectrumBinHz(&spec, 1);
+			for (int c = 0; c < IMU_SPECTRUM_CHANNELS; c++) {
+				uint32_t peak = 1;
+				for (uint32_t k = 1; k < imuSpectrumBins(&spec); k++)
+					if (frame[k * IMU_SPECTRUM_LANES + c] > frame[peak * IMU_SPECTRUM_LANES + c])
+						peak = k;
+				double power = 0.0, floor = 0.0;
+				for (uint32_t k = peak - 4; k <= peak + 4; k++)
+					power += frame[k * IMU_SPECTRUM_LANES + c] * df;
+				uint32_t quiet = 0;
+				for (uint32_t k = 10; k < imuSpectrumBins(&spec) - 1; k++) {
+					if (k + 20 < peak || k > peak + 20) {
+						floor += frame[k * IMU_SPECTRUM_LANES + c];
+						quiet++;
+					}
+				}
+				printf("  axis %d: peak %7.2f Hz (true %5.1f), power %.4f (true 0.5), floor %.2e (true %.2e)\n",
+					c, peak * df, 50.0 + 100.0 * c, power, floor / quiet, 2 * sigma * sigma / rate);
+			}
+		}
+		imuSpectrumFree(&spec);
+	}
+	imuIsaSelect(active);
+	free(samples);
+	return 0;
+}
+
+/**
+ * @brief Returns a Gaussian deviate (sum of 12 uniforms) from a 64-bit LCG.
+ */
+static double benchGauss(uint64_t *seed) {
+	double sum = 0.0;
+	for (int k = 0; k < 12; k++) {
+		*seed = *seed * 6364136223846793005u + 1442695040888963407u;
+		sum += (*seed >> 11) / 9007199254740992.0;
+	}
+	return sum - 6.0;
+}
+
+/**
+ * @brief Alternates 3 s at rest and 2 s of motion while the temperature and the gyro bias drift.
+ */
+static int benchZupt(int argc, char **argv) {
+	const uint32_t rate = 2000;
+	double seconds = argc > 0 ? atof(argv[0]) : 600.0;
+	size_t count = (size_t)(seconds * rate);
+	ImuSample_t *samples = malloc(count * sizeof(ImuSample_t));
+	uint8_t *truth = malloc(count);
+	uint8_t *flags = malloc(count);
+	ImuZupt_t *zupt = malloc(sizeof(ImuZupt_t));
+	if (!samples || !truth || !flags || !zupt) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	// Bias in deg/s grows by 0.01 deg/s per degree over a 20 to 40 C ramp; noise 0.05 deg/s and 0.005 m/s^2.
+	const double bias0[3] = { 0.2, -0.1, 0.05 }, slope = 0.01, g = IMU_ZUPT_GRAVITY;
+	uint64_t seed = 12345;
+	double tilt[2] = { 0.0, 0.0 };
+	for (size_t i = 0; i < count; i++) {
+		double t = (double)i / rate, temp = 20.0 + 20.0 * t / seconds;
+		double phase = fmod(t, 5.0);
+		int still = phase < 3.0;
+		if (still && i % (5 * rate) == 0) {
+			tilt[0] = 0.2 * benchGauss(&seed);
+			tilt[1] = 0.2 * benchGauss(&seed);
+		}
+		ImuSample_t *s = &samples[i];
+		memset(s, 0, sizeof(*s));
+		s->temperature = (float)temp;
+		double down[3] = { sin(tilt[1]), -sin(tilt[0]) * cos(tilt[1]), cos(tilt[0]) * cos(tilt[1]) };
+		for (int a = 0; a < 3; a++) {
+			double bias = bias0[a] + slope * (temp - 25.0);
+			double motion = still ? 0.0 : sin(M_PI * (phase - 3.0) / 2.0);
+			s->gyro[a] = (float)(bias + 30.0 * motion * sin(2 * M_PI * 1.5 * t + a) + 0.05 * benchGauss(&seed));
+			s->accl[a] = (float)(g * down[a] + 2.0 * motion * cos(2 * M_PI * 2.5 * t + a)
+				+ 0.005 * benchGauss(&seed));
+		}
+		truth[i] = (uint8_t)still;
+	}
+
+	if (imuZuptInit(zupt, rate / 20, 20.0, rate) != 0) {
+		fprintf(stderr, "Bad detector parameters\n");
+		return 2;
+	}
+	double worst = 0.0, sum = 0.0;
+	uint64_t spent = 0;
+	for (size_t pos = 0; pos < count; ) {
+		uint64_t t1 = benchNowNs();
+		pos += imuZuptPush(zupt, samples + pos, count - pos, flags + pos);
+		spent += benchNowNs() - t1;
+		if (!imuZuptUpdated(zupt))
+			continue;
+		const ImuZuptBias_t *b = imuZuptBias(zupt);
+		for (int a = 0; a < 3; a++) {
+			double err = fabs(b->gyro[a] - (bias0[a] + slope * (b->temperature - 25.0)));
+			worst = fmax(worst, err);
+			sum += err;
+		}
+	}
+
+	size_t still = 0, detected = 0, moving = 0, falseStill = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (truth[i]) {
+			still++;
+			detected += flags[i];
+		} else {
+			moving++;
+			falseStill += flags[i];
+		}
+	}
+	const ImuZuptBias_t *b = imuZuptBias(zupt);
+	printf("zupt %zu samples: %.1f ns/sample; stationary detected %.2f %% of rest samples, "
+		"%.4f %% of motion samples\n", count, (double)spent / count, 100.0 * detected / still,
+		100.0 * falseStill / moving);
+	printf("bias %llu updates: mean error %.5f deg/s, worst %.5f deg/s (noise %.3f deg/s over %llu samples)\n",
+		(unsigned long long)b->updates, b->updates ? sum / (3.0 * b->updates) : 0.0, worst, b->noise[0],
+		(unsigned long long)b->samples);
+
+	free(zupt);
+	free(flags);
+	free(truth);
+	free(samples);
+	return 0;
+}
+
+/**
+ * @brief Calibration parameters of bench device `d`: small biases, scale errors and misalignments.
+ */
+static void benchCalibParams(uint32_t d, ImuCalibParams_t *p) {
+	imuCalibIdentity(p);
+	ImuCalibAxes_t *triads[2] = { &p->gyro, &p->accl };
+	for (int t = 0; t < 2; t++) {
+		for (int i = 0; i < 3; i++) {
+			triads[t]->bias[i] = 0.01f * (float)((d + 3 * t + i) % 7) - 0.03f;
+			triads[t]->scale[i] = 1.0f + 0.001f * (float)((d * 5 + i) % 9) - 0.004f;
+			for (int j = 0; j < 3; j++) {
+				if (i != j)
+					triads[t]->misalign[i][j] = 0.0005f * (float)((d + i * 3 + j) % 5) - 0.001f;
+			}
+		}
+	}
+}
+
+typedef struct {
+	ImuCalibTable_t *table;
+	uint32_t serialId;
+	volatile int stop;
+	uint64_t swaps;
+} BenchCalibWriter_t;
+
+/**
+ * @brief Writer thread: swaps the parameters of one device between unit and double scale.
+ */
+static void *benchCalibWriter(void *arg) {
+	BenchCalibWriter_t *w = arg;
+	ImuCalibParams_t params[2];
+	imuCalibIdentity(&params[0]);
+	imuCalibIdentity(&params[1]);
+	for (int i = 0; i < 3; i++)
+		params[1].gyro.scale[i] = params[1].accl.scale[i] = 2.0f;
+	while (!w->stop) {
+		imuCalibSet(w->table, w->serialId, &params[w->swaps & 1]);
+		w->swaps++;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Calibrates 16 interleaved streams and a temperature ramp against a double precision reference, and while the parameters are swapped.
+ */
+static int benchCalib(int argc, char **argv) {
+	enum { DEVICES = 16, BATCH = 64 };
+	const uint32_t rate = 2000;
+	size_t count = argc > 0 ? strtoul(argv[0], NULL, 0) : 200000;
+	count = (count + BATCH - 1) / BATCH * BATCH;
+	ImuProt_t *packets = malloc((DEVICES + 1) * count * sizeof(ImuProt_t));
+	ImuSample_t *samples = malloc(DEVICES * count * sizeof(ImuSample_t));
+	ImuSample_t *base = malloc(DEVICES * count * sizeof(ImuSample_t));
+	ImuCalibTable_t *table = malloc(sizeof(ImuCalibTable_t));
+	ImuCalib_t *streams = malloc(DEVICES * sizeof(ImuCalib_t));
+	if (!packets || !samples || !base || !table || !streams) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	imuCalibTableInit(table);
+	for (uint32_t d = 0; d < DEVICES; d++) {
+		ImuProt_t *p = packets + d * count;
+		benchMakePackets(p, count, 100 + d);
+		for (size_t i = IMU_CALIB_SERIAL_WORD; i < count; i += 32) {
+			p[i].data.mux = 0x5E000 + d;
+			p[i].crc32 = protCRC32((const uint8_t *)&p[i], sizeof(ImuProt_t) - sizeof(uint32_t));
+		}
+		ImuCalibParams_t params;
+		benchCalibParams(d, &params);
+		imuCalibSet(table, 0x5E000 + d, &params);
+	}
+
+	// Batches of the 16 streams in turn, as they come out of a receiver.
+	ImuIsa_t active = imuIsaActive();
+	uint64_t spent[2] = { 0, 0 };
+	for (int pass = 0; pass < 2; pass++) {
+		ImuSample_t *out = pass ? samples : base;
+		if (!pass)
+			imuIsaSelect(IMU_ISA_BASELINE);
+		for (uint32_t d = 0; d < DEVICES; d++)
+			imuCalibInit(&streams[d], table);
+		uint64_t decodeNs = 0, calibNs = 0;
+		for (size_t pos = 0; pos < count; pos += BATCH) {
+			for (uint32_t d = 0; d < DEVICES; d++) {
+				size_t at = d * count + pos;
+				uint64_t t0 = benchNowNs();
+				imuCalibObserve(&streams[d], packets + at, sizeof(ImuProt_t), BATCH);
+				imuDecodeSamples(packets + at, sizeof(ImuProt_t), out + at, sizeof(ImuSample_t), BATCH);
+				uint64_t t1 = benchNowNs();
+				imuCalibApply(&streams[d], out + at, BATCH);
+				calibNs += benchNowNs() - t1;
+				decodeNs += t1 - t0;
+			}
+		}
+		spent[pass] = calibNs;
+		if (!pass)
+			imuIsaSelect(active);
+		else
+			printf("decode %.2f ns/sample, calibrate %.2f ns/sample\n", (double)decodeNs / (DEVICES * count),
+				(double)calibNs / (DEVICES * count));
+	}
+
+	double worst = 0.0;
+	size_t passed = 0;
+	for (uint32_t d = 0; d < DEVICES; d++) {
+		ImuCalibParams_t params;
+		benchCalibParams(d, &params);
+		const ImuCalibAxes_t *triads[2] = { &params.gyro, &params.accl };
+		for (size_t i = 0; i < count; i++) {
+			const ImuProt_t *p = &packets[d * count + i];
+			const ImuSample_t *s = &samples[d * count + i];
+			int32_t raw[2][3];
+			memcpy(raw[0], p->data.gyro, sizeof(raw[0]));
+			memcpy(raw[1], p->data.accl, sizeof(raw[1]));
+			const float *got[2] = { s->gyro, s->accl };
+			for (int t = 0; t < 2; t++) {
+				for (int a = 0; a < 3; a++) {
+					double y = 0.0;
+					for (int j = 0; j < 3; j++)
+						y += (double)triads[t]->misalign[a][j] * triads[t]->scale[j]
+							* ((double)raw[t][j] * IMU_PROT_SCALE - triads[t]->bias[j]);
+					worst = fmax(worst, fabs(got[t][a] - y) / fmax(1.0, fabs(y)));
+				}
+			}
+			passed += s->flags == p->data.flags && s->sequencer == p->sequencer;
+		}
+	}
+	int same = !memcmp(samples, base, DEVICES * count * sizeof(ImuSample_t));
+	printf("%d devices x %zu samples: worst relative error %.2e, fields kept %s, %s and baseline %s\n",
+		DEVICES, count, worst, passed == DEVICES * count ? "yes" : "NO", imuIsaName(active),
+		same ? "agree" : "DIFFER");
+	printf("%d devices at %u Hz: %.4f %% of a core (baseline %.4f %%)\n", DEVICES, rate,
+		100.0 * spent[1] / (DEVICES * count) * DEVICES * rate * 1e-9,
+		100.0 * spent[0] / (DEVICES * count) * DEVICES * rate * 1e-9);
+
+	// Temperature compensation over a 10 to 50 C ramp, the reading dithering by one step.
+	ImuProt_t *ramp = packets + count;
+	for (size_t i = 0; i < count; i++) {
+		ramp[i] = packets[i];
+		ramp[i].data.temperature = (uint16_t)(28315 + 4000 * i / count + ((i >> 6) & 1));
+		ramp[i].crc32 = protCRC32((const uint8_t *)&ramp[i], sizeof(ImuProt_t) - sizeof(uint32_t));
+	}
+	ImuCalibParams_t drift;
+	benchCalibParams(0, &drift);
+	drift.reference = 25.0f;
+	for (int j = 0; j < 3; j++) {
+		const float b[IMU_CALIB_ORDER] = { 0.002f, 1e-4f, -2e-6f }, sc[IMU_CALIB_ORDER] = { 1e-4f, -1e-6f, 1e-8f };
+		memcpy(drift.gyro.biasDrift[j], b, sizeof(b));
+		memcpy(drift.gyro.scaleDrift[j], sc, sizeof(sc));
+		memcpy(drift.accl.biasDrift[j], b, sizeof(b));
+		memcpy(drift.accl.scaleDrift[j], sc, sizeof(sc));
+	}
+	ImuCalibParams_t fixed;
+	benchCalibParams(0, &fixed);
+	imuCalibSet(table, 0x5E100, &fixed);
+	imuCalibSet(table, 0x5E101, &drift);
+	uint64_t compNs[2] = { 0, 0 };
+	for (int pass = 0; pass < 2; pass++) {
+		ImuCalib_t *c = &streams[pass];
+		imuCalibInit(c, table);
+		imuCalibSerial(c, 0x5E100 + pass);
+		for (size_t pos = 0; pos < count; pos += BATCH) {
+			imuDecodeSamples(ramp + pos, sizeof(ImuProt_t), samples + pos, sizeof(ImuSample_t), BATCH);
+			uint64_t t1 = benchNowNs();
+			imuCalibApply(c, samples + pos, BATCH);
+			compNs[pass] += benchNowNs() - t1;
+		}
+	}
+	worst = 0.0;
+	const ImuCalibAxes_t *triads[2] = { &drift.gyro, &drift.accl };
+	size_t readings = 1;
+	for (size_t i = 0; i < count; i++) {
+		const ImuProt_t *p = &ramp[i];
+		readings += i && p->data.temperature != ramp[i - 1].data.temperature;
+		double dt = tempFromKelvin(p->data.temperature) - 25.0;
+		int32_t raw[2][3];
+		memcpy(raw[0], p->data.gyro, sizeof(raw[0]));
+		memcpy(raw[1], p->data.accl, sizeof(raw[1]));
+		const float *got[2] = { samples[i].gyro, samples[i].accl };
+		for (int t = 0; t < 2; t++) {
+			double bias[3], scale[3];
+			for (int j = 0; j < 3; j++) {
+				const float *b = triads[t]->biasDrift[j], *sc = triads[t]->scaleDrift[j];
+				bias[j] = triads[t]->bias[j] + dt * (b[0] + dt * (b[1] + dt * b[2]));
+				scale[j] = triads[t]->scale[j] + dt * (sc[0] + dt * (sc[1] + dt * sc[2]));
+			}
+			for (int a = 0; a < 3; a++) {
+				double y = 0.0;
+				for (int j = 0; j < 3; j++)
+					y += (double)triads[t]->misalign[a][j] * scale[j] * ((double)raw[t][j] * IMU_PROT_SCALE - bias[j]);
+				worst = fmax(worst, fabs(got[t][a] - y) / fmax(1.0, fabs(y)));
+			}
+		}
+	}
+	printf("temperature compensation: %.2f ns/sample (fixed %.2f ns/sample), worst relative error %.2e, "
+		"%llu evaluations for %zu reading changes\n", (double)compNs[1] / count, (double)compNs[0] / count, worst,
+		(unsigned long long)imuCalibEvaluations(&streams[1]), readings);
+
+	// Hot swap: every batch must be calibrated entirely with one of the two parameter sets.
+	ImuCalibParams_t identity;
+	imuCalibIdentity(&identity);
+	imuCalibSet(table, 0x5E000, &identity);
+	BenchCalibWriter_t writer = { table, 0x5E000, 0, 0 };
+	pthread_t thread;
+	pthread_create(&thread, NULL, benchCalibWriter, &writer);
+	size_t batches = 0, unit = 0, doubled = 0, torn = 0;
+	ImuCalib_t *c = &streams[0];
+	imuCalibInit(c, table);
+	imuCalibSerial(c, 0x5E000);
+	uint64_t t0 = benchNowNs();
+	while (benchNowNs() - t0 < 200000000u) {
+		for (size_t pos = 0; pos + BATCH <= count; pos += BATCH, batches++) {
+			ImuSample_t batch[BATCH];
+			imuDecodeSamples(packets + pos, sizeof(ImuProt_t), batch, sizeof(ImuSample_t), BATCH);
+			imuCalibApply(c, batch, BATCH);
+			int kind = -1;
+			for (size_t i = 0; i < BATCH; i++) {
+				const ImuSample_t *s = &batch[i];
+				float raw = floatData(packets[pos + i].data.accl[2]);
+				int k = s->accl[2] == raw ? 0 : s->accl[2] == 2.0f * raw ? 1 : 2;
+				if (kind < 0)
+					kind = k;
+				if (k != kind)
+					kind = 2;
+			}
+			unit += kind == 0;
+			doubled += kind == 1;
+			torn += kind == 2;
+		}
+	}
+	writer.stop = 1;
+	pthread_join(thread, NULL);
+	printf("hot swap: %llu updates during %zu batches: %zu unit, %zu doubled, %zu torn\n",
+		(unsigned long long)writer.swaps, batches, unit, doubled, torn);
+
+	free(streams);
+	free(table);
+	free(base);
+	free(samples);
+	free(packets);
+	return !same || torn != 0;
+}
+
+/**
+ * @brief Rate of channel `c` of the bench motion at time `t` in seconds, or its mean over (t0, t] if t0 < t.
+ */
+static double benchResampleSignal(int c, double t0, double t) {
+	const double f = 3.0 + 4.0 * c, w = 2.0 * M_PI * f, phase = 0.7 * c, amplitude = 10.0 + c;
+	if (t0 >= t)
+		return amplitude * sin(w * t + phase);
+	return amplitude * (cos(w * t0 + phase) - cos(w * t + phase)) / (w * (t - t0));
+}
+
+/**
+ * @brief Aligns IMUs with drifting clocks, one late and one with an outage, in both interpolations.
+ */
+static int benchResample(int argc, char **argv) {
+	const uint32_t rate = 2000;
+	double seconds = argc > 0 ? atof(argv[0]) : 10.0;
+	uint32_t devices = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 16;
+	uint32_t outRate = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 0) : 1000;
+	if (!devices || !outRate || seconds <= 0.0) {
+		fprintf(stderr, "Bad arguments\n");
+		return 2;
+	}
+	const size_t count = (size_t)(seconds * rate);
+	const uint64_t roundNs = 1000000, lateNs = 3000000, periodNs = 1000000000u / outRate;
+	const double outage[2] = { 0.4 * seconds, 0.4 * seconds + 0.05 };
+	ImuSample_t *samples = malloc(devices * count * sizeof(ImuSample_t));
+	uint64_t *times = malloc(devices * count * sizeof(uint64_t));
+	size_t *pos = malloc(devices * sizeof(size_t));
+	if (!samples || !times || !pos) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	int ok = 1;
+	for (int mode = IMU_RESAMPLE_LINEAR; mode <= IMU_RESAMPLE_HERMITE; mode++) {
+		// Clocks off by up to +-200 ppm with random phase; linear readings are instantaneous, spline readings means.
+		uint64_t seed = 99;
+		for (uint32_t d = 0; d < devices; d++) {
+			double ppm = 400.0 * d / devices - 200.0, phase = (benchGauss(&seed) + 6.0) / 12.0 / rate;
+			for (size_t i = 0; i < count; i++) {
+				double t = 0.01 + phase + i / (rate * (1.0 + ppm * 1e-6));
+				double t0 = mode == IMU_RESAMPLE_HERMITE ? t - 1.0 / (rate * (1.0 + ppm * 1e-6)) : t;
+				ImuSample_t *s = &samples[d * count + i];
+				memset(s, 0, sizeof(*s));
+				for (int c = 0; c < 3; c++) {
+					s->gyro[c] = (float)benchResampleSignal(c, t0, t);
+					s->accl[c] = (float)benchResampleSignal(c + 3, t0, t);
+				}
+				s->temperature = (float)(20.0 + t);
+				times[d * count + i] = (uint64_t)(t * 1e9);
+			}
+			pos[d] = 0;
+		}
+
+		ImuResample_t r;
+		if (imuResampleInit(&r, devices, periodNs, 256, (ImuResampleMode_t)mode, 10000000) != 0) {
+			fprintf(stderr, "Bad resampler parameters\n");
+			return 2;
+		}
+		double sum = 0.0, worst = 0.0, latency = 0.0;
+		size_t values = 0;
+		uint64_t pushNs = 0, nextNs = 0;
+		for (uint64_t now = roundNs; pos[0] < count; now += roundNs) {
+			// Each round delivers the samples taken until then; device 1 delivers late.
+			for (uint32_t d = 0; d < devices; d++) {
+				uint64_t until = d != 1 ? now : now > lateNs ? now - lateNs : 0;
+				size_t from = pos[d];
+				while (pos[d] < count && times[d * count + pos[d]] < until)
+					pos[d]++;
+				for (size_t i = from; i < pos[d]; ) {
+					size_t end = i;
+					while (end < pos[d] && (d != 3 || times[d * count + end] * 1e-9 < outage[0]
+						|| times[d * count + end] * 1e-9 >= outage[1]))
+						end++;
+					uint64_t t1 = benchNowNs();
+					imuResamplePush(&r, d, times + d * count + i, samples + d * count + i, end - i);
+					pushNs += benchNowNs() - t1;
+					i = end + (end < pos[d]);
+				}
+			}
+			for (;;) {
+				uint64_t t1 = benchNowNs();
+				int frame = imuResampleNext(&r);
+				nextNs += benchNowNs() - t1;
+				if (!frame)
+					break;
+				double t = imuResampleTime(&r) * 1e-9, t0 = mode == IMU_RESAMPLE_HERMITE ? t - periodNs * 1e-9 : t;
+				latency += imuResampleStats(&r)->latencyNs;
+				for (int c = 0; c < 6; c++) {
+					const float *v = imuResampleChannel(&r, c);
+					double truth = benchResampleSignal(c, t0, t);
+					for (uint32_t d = 0; d < devices; d++) {
+						if (!imuResampleValid(&r, d))
+							continue;
+						double err = fabs(v[d] - truth) / (10.0 + c);
+						sum += err * err;
+						worst = fmax(worst, err);
+						values++;
+					}
+				}
+			}
+		}
+
+		const ImuResampleStats_t *st = imuResampleStats(&r);
+		double rms = values ? sqrt(sum / values) : 0.0;
+		printf("%-7s %u devices %llu frames at %u Hz: %.1f ns/frame (%.2f ns/device), push %.1f ns/sample\n",
+			mode == IMU_RESAMPLE_HERMITE ? "hermite" : "linear", devices, (unsigned long long)st->frames, outRate,
+			(double)nextNs / st->frames, (double)nextNs / st->frames / devices, (double)pushNs / (devices * count));
+		printf("        error rms %.2e, worst %.2e of amplitude; %llu device frames missing, latency mean %.2f ms, "
+			"max %.2f ms, %llu overruns, %llu late\n", rms, worst, (unsigned long long)st->missing,
+			latency / st->frames * 1e-6, st->maxLatencyNs * 1e-6, (unsigned long long)st->overruns,
+			(unsigned long long)st->late);
+		ok &= values > 0;
+		imuResampleFree(&r);
+	}
+
+	free(pos);
+	free(times);
+	free(samples);
+	return !ok;
+}
@@ -0,0 +1,256 @@
+#include <string.h>
+
+#include "ImuProtCalib.h"
+#include "ImuProtIsa.h"
+
+#define CALIB_INLINE static inline __attribute__((always_inline))
+
+_Static_assert(sizeof(ImuSample_t) == IMU_CALIB_LANES * sizeof(float), "sample layout");
+
+/*
+ * Kernel on vectors of W lanes, a sample being IMU_CALIB_LANES / W vectors.
+ * Expanded per vector width, since the compiler keeps a vector of the
+ * native width in registers but spills wider ones. When `keyed`, only the
+ * leading run of samples with the temperature of the first one, which the
+ * map was folded for, is processed.
+ */
+#define CALIB_DEFINE(W)                                                                                \
+                                                                                                       \
+typedef float CalibVec##W##_t __attribute__((vector_size(W * sizeof(float))));                         \
+typedef float CalibLoad##W##_t __attribute__((vector_size(W * sizeof(float)), aligned(4), may_alias)); \
+typedef int32_t CalibMask##W##_t __attribute__((vector_size(W * sizeof(int32_t))));                    \
+                                                                                                       \
+CALIB_INLINE size_t calibApply##W(const ImuCalibMap_t *m, ImuSample_t *samples, size_t count, int keyed) { \
+	enum { V = IMU_CALIB_LANES / W };                                                                  \
+	CalibVec##W##_t column[6][V], offset[V];                                                           \
+	CalibMask##W##_t keep[V];                                                                          \
+	const int32_t lanes[IMU_CALIB_LANES] = { 0, 0, 0, 0, 0, 0, -1, -1 };                               \
+	memcpy(column, m->column, sizeof(column));                                                         \
+	memcpy(offset, m->offset, sizeof(offset));                                                         \
+	memcpy(keep, lanes, sizeof(keep));                                                                 \
+	for (size_t i = 0; i < count; i++) {                                                               \
+		if (keyed && i && samples[i].temperature != m->temperature)                                    \
+			return i;                                                                                  \
+		CalibLoad##W##_t *x = (CalibLoad##W##_t *)&samples[i];                                         \
+		const float g0 = samples[i].gyro[0], g1 = samples[i].gyro[1], g2 = samples[i].gyro[2];         \
+		const float a0 = samples[i].accl[0], a1 = samples[i].accl[1], a2 = samples[i].accl[2];         \
+		for (int v = 0; v < V; v++) {                                                                  \
+			CalibVec##W##_t y = offset[v] + column[0][v] * g0 + column[1][v] * g1 + column[2][v] * g2  \
+				+ column[3][v] * a0 + column[4][v] * a1 + column[5][v] * a2;                           \
+			CalibMask##W##_t r = ((CalibMask##W##_t)y & ~keep[v]) | ((CalibMask##W##_t)x[v] & keep[v]); \
+			x[v] = (CalibVec##W##_t)r;                                                                 \
+		}                                                                                              \
+	}                                                                                                  \
+	return count;                                                                                      \
+}
+
+CALIB_DEFINE(4)
+CALIB_DEFINE(8)
+
+typedef size_t (*CalibKernel_t)(const ImuCalibMap_t *m, ImuSample_t *samples, size_t count, int keyed);
+
+static size_t calibApplyBaseline(const ImuCalibMap_t *m, ImuSample_t *samples, size_t count, int keyed) {
+	return calibApply4(m, samples, count, keyed);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#define CALIB_TARGET(t) static __attribute__((target(t)))
+
+CALIB_TARGET("arch=x86-64-v3") size_t calibApplyAvx2(const ImuCalibMap_t *m, ImuSample_t *samples, size_t count,
+	int keyed) {
+	return calibApply8(m, samples, count, keyed);
+}
+
+#define CALIB_APPLY_AVX2 calibApplyAvx2
+
+#else
+
+#define CALIB_APPLY_AVX2 calibApplyBaseline
+
+#endif
+
+void imuCalibIdentity(ImuCalibParams_t *params) {
+	memset(params, 0, sizeof(*params));
+	for (int i = 0; i < 3; i++) {
+		params->gyro.scale[i] = params->accl.scale[i] = 1.0f;
+		params->gyro.misalign[i][i] = params->accl.misalign[i][i] = 1.0f;
+	}
+}
+
+void imuCalibTableInit(ImuCalibTable_t *table) {
+	memset(table, 0, sizeof(*table));
+}
+
+int imuCalibSet(ImuCalibTable_t *table, uint32_t serialId, const ImuCalibParams_t *params) {
+	uint32_t count = atomic_load_explicit(&table->count, memory_order_relaxed);
+	for (uint32_t i = 0; i < count; i++) {
+		ImuCalibEntry_t *e = &table->entries[i];
+		if (e->serialId != serialId)
+			continue;
+		// Fill the buffer no stream is directed to, then direct them to it. A
+		// stream still copying that buffer finds the version moved on and retries.
+		uint32_t version = atomic_load_explicit(&e->version, memory_order_relaxed) + 1;
+		atomic_thread_fence(memory_order_release);
+		e->params[version & 1] = *params;
+		atomic_store_explicit(&e->version, version, memory_order_release);
+		return 0;
+	}
+	if (count == IMU_CALIB_MAX_DEVICES)
+		return -1;
+	ImuCalibEntry_t *e = &table->entries[count];
+	e->serialId = serialId;
+	e->params[0] = *params;
+	atomic_store_explicit(&e->version, 0, memory_order_relaxed);
+	atomic_store_explicit(&table->count, count + 1, memory_order_release);
+	return 0;
+}
+
+void imuCalibInit(ImuCalib_t *c, const ImuCalibTable_t *table) {
+	memset(c, 0, sizeof(*c));
+	c->table = table;
+}
+
+void imuCalibSerial(ImuCalib_t *c, uint32_t serialId) {
+	if (c->known && c->serialId == serialId)
+		return;
+	c->serialId = serialId;
+	c->known = 1;
+	c->entry = NULL;
+	c->scanned = 0;
+}
+
+void imuCalibObserve(ImuCalib_t *c, const ImuProt_t *packets, size_t packetStride, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		const ImuProt_t *p = (const ImuProt_t *)((const uint8_t *)packets + i * packetStride);
+		if ((p->sequencer & 31) == IMU_CALIB_SERIAL_WORD)
+			imuCalibSerial(c, p->data.mux);
+	}
+}
+
+/**
+ * @brief Evaluates a drift polynomial without its constant term.
+ */
+static float calibDrift(const float coef[IMU_CALIB_ORDER], float dt) {
+	float p = 0.0f;
+	for (int k = IMU_CALIB_ORDER - 1; k >= 0; k--)
+		p = (p + coef[k]) * dt;
+	return p;
+}
+
+/**
+ * @brief Folds the parameters at a temperature into the affine map applied by the kernels.
+ */
+static void calibFold(ImuCalib_t *c, ImuCalibMap_t *map, float temperature) {
+	const ImuCalibAxes_t *triads[2] = { &c->params.gyro, &c->params.accl };
+	const float dt = c->drifting ? temperature - c->params.reference : 0.0f;
+	memset(map->column, 0, sizeof(map->column));
+	memset(map->offset, 0, sizeof(map->offset));
+	for (int t = 0; t < 2; t++) {
+		const ImuCalibAxes_t *a = triads[t];
+		float bias[3], scale[3];
+		for (int j = 0; j < 3; j++) {
+			bias[j] = a->bias[j] + calibDrift(a->biasDrift[j], dt);
+			scale[j] = a->scale[j] + calibDrift(a->scaleDrift[j], dt);
+		}
+		for (int i = 0; i < 3; i++) {
+			float d = 0.0f;
+			for (int j = 0; j < 3; j++) {
+				float m = a->misalign[i][j] * scale[j];
+				map->column[3 * t + j][3 * t + i] = m;
+				d -= m * bias[j];
+			}
+			map->offset[3 * t + i] = d;
+		}
+	}
+	map->temperature = temperature;
+	map->valid = 1;
+	c->evaluations++;
+}
+
+/**
+ * @brief Takes new parameters: drops the cached maps, and folds the only map if there is no drift.
+ */
+static void calibLoad(ImuCalib_t *c, const ImuCalibParams_t *params) {
+	c->params = *params;
+	c->drifting = 0;
+	const ImuCalibAxes_t *triads[2] = { &params->gyro, &params->accl };
+	for (int t = 0; t < 2; t++) {
+		for (int j = 0; j < 3; j++) {
+			for (int k = 0; k < IMU_CALIB_ORDER; k++)
+				c->drifting |= triads[t]->biasDrift[j][k] != 0.0f || triads[t]->scaleDrift[j][k] != 0.0f;
+		}
+	}
+	c->maps[0].valid = c->maps[1].valid = 0;
+	c->current = 0;
+	if (!c->drifting)
+		calibFold(c, &c->maps[0], params->reference);
+}
+
+/**
+ * @brief Finds the entry of the stream and refolds its parameters if they changed.
+ *
+ * @return int 1 if the stream has parameters.
+ */
+static int calibRefresh(ImuCalib_t *c) {
+	if (!c->known)
+		return 0;
+	if (!c->entry) {
+		uint32_t count = atomic_load_explicit(&c->table->count, memory_order_acquire);
+		for (uint32_t i = c->scanned; i < count && !c->entry; i++) {
+			if (c->table->entries[i].serialId == c->serialId)
+				c->entry = &c->table->entries[i];
+		}
+		c->scanned = count;
+		if (!c->entry)
+			return 0;
+		// One behind the published version, so that the parameters are folded below.
+		c->version = atomic_load_explicit(&c->entry->version, memory_order_relaxed) - 1;
+	}
+
+	uint32_t version = atomic_load_explicit(&c->entry->version, memory_order_acquire);
+	if (version == c->version)
+		return 1;
+	for (;;) {
+		ImuCalibParams_t params = c->entry->params[version & 1];
+		atomic_thread_fence(memory_order_acquire);
+		uint32_t now = atomic_load_explicit(&c->entry->version, memory_order_relaxed);
+		if (now == version) {
+			calibLoad(c, &params);
+			c->version = version;
+			return 1;
+		}
+		// Rewritten while copied: take the newest.
+		version = atomic_load_explicit(&c->entry->version, memory_order_acquire);
+	}
+}
+
+void imuCalibApply(ImuCalib_t *c, ImuSample_t *samples, size_t count) {
+	c->active = calibRefresh(c);
+	if (!c->active)
+		return;
+	CalibKernel_t kernel = imuIsaActive() >= IMU_ISA_AVX2 ? CALIB_APPLY_AVX2 : calibApplyBaseline;
+	if (!c->drifting) {
+		kernel(&c->maps[0], samples, count, 0);
+		return;
+	}
+	// Runs of samples with the same temperature reading share a map.
+	for (size_t pos = 0; pos < count; ) {
+		const float temperature = samples[pos].temperature;
+		ImuCalibMap_t *map = &c->maps[c->current];
+		if (!map->valid || map->temperature != temperature) {
+			c->current ^= 1;
+			map = &c->maps[c->current];
+			if (!map->valid || map->temperature != temperature)
+				calibFold(c, map, temperature);
+		}
+		pos += kernel(map, samples + pos, count - pos, 1);
+	}
+}
+
+void imuCalibDecode(ImuCalib_t *c, const ImuProt_t *packets, size_t packetStride, ImuSample_t *samples,
+	size_t count) {
+	imuCalibObserve(c, packets, packetStride, count);
+	imuDecodeSamples(packets, packetStride, samples, sizeof(ImuSample_t), count);
+	imuCalibApply(c, samples, count);
+}
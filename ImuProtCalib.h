@@ -0,0 +1,225 @@
+/**
+ * Sensor Calibration Stage.
+ *
+ * Applies the calibration of each IMU to its decoded samples. Each sensor
+ * triad is corrected for bias, scale factor and axis misalignment:
+ *
+ *   y = M * diag(s) * (x - b)
+ *
+ * with the bias `b` and the scale factors `s` per axis and the 3x3
+ * misalignment matrix `M` (identity for orthogonal axes). The stage folds
+ * them into one affine map, y = C * x + d, and applies gyro and accl
+ * together: a sample is 32 bytes, so it travels as one 8-lane vector (two
+ * 4-lane vectors on the baseline level) and the correction costs six
+ * broadcast multiply-adds and a blend that keeps the temperature, flags and
+ * sequencer. The kernels are compiled per ISA level and follow `ImuProtIsa.h`.
+ *
+ * Bias and scale factor may drift with temperature, modeled per axis as
+ * polynomials in the offset from a reference temperature T0:
+ *
+ *   b(T) = b + sum(k = 1..N) bk * (T - T0)^k
+ *   s(T) = s + sum(k = 1..N) sk * (T - T0)^k
+ *
+ * The temperature changes slowly and comes in steps of 0.01 K, so the stage
+ * evaluates the polynomials and folds the map only when the temperature of
+ * a sample differs from that of the map, i.e. when the raw `uint16_t` value
+ * changes, and then applies the cached map to the run of samples that share
+ * the reading. The two most recent maps are kept, so a reading dithering
+ * between two adjacent values does not re-evaluate either. A compensated
+ * sample then costs the same multiply-adds as an uncompensated one, plus a
+ * compare of its temperature.
+ *
+ * Parameters live in an `ImuCalibTable_t` keyed by the `serialId` the IMU
+ * reports in mux word IMU_CALIB_SERIAL_WORD. Each stream has an `ImuCalib_t`
+ * that learns the serial ID from the packets, looks it up once and keeps a
+ * private copy of the folded map. Updating the table never blocks the
+ * streams: the writer fills the idle one of two parameter buffers and
+ * publishes it with a version number, which each stream checks once per
+ * batch, copying the new parameters and re-reading them if the version moved
+ * meanwhile. A batch therefore uses either the old or the new calibration,
+ * never a mix. Samples of an IMU whose serial ID is not known yet, or has
+ * no entry, pass through unchanged.
+ */
+
+#ifndef ImuProtCalib_h_included__
+#define ImuProtCalib_h_included__
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProtSample.h"
+
+/** Mux word holding `serialId`. */
+#define IMU_CALIB_SERIAL_WORD (6)
+
+/** Maximum number of IMUs in a table. */
+#define IMU_CALIB_MAX_DEVICES (64)
+
+/** Values of the folded map per column, one lane per `ImuSample_t` word. */
+#define IMU_CALIB_LANES (8)
+
+/** Highest power of the temperature polynomials. */
+#define IMU_CALIB_ORDER (3)
+
+/**
+ * Calibration of one sensor triad, in the units of the readings.
+ *
+ * @field bias          Bias per axis at the reference temperature, subtracted from the readings.
+ * @field scale         Scale factor per axis at the reference temperature, applied after the bias.
+ * @field misalign      Misalignment matrix, applied last; row i gives output axis i.
+ * @field biasDrift     Bias polynomial per axis, coefficients of (T - T0)^1 to (T - T0)^IMU_CALIB_ORDER.
+ * @field scaleDrift    Scale factor polynomial per axis, likewise.
+ */
+typedef struct {
+	float bias[3];
+	float scale[3];
+	float misalign[3][3];
+	float biasDrift[3][IMU_CALIB_ORDER];
+	float scaleDrift[3][IMU_CALIB_ORDER];
+} ImuCalibAxes_t;
+
+/**
+ * Calibration of one IMU.
+ *
+ * @field gyro          Gyro triad.
+ * @field accl          Accelerometer triad.
+ * @field reference     Reference temperature T0 in degrees Celsius.
+ */
+typedef struct {
+	ImuCalibAxes_t gyro;
+	ImuCalibAxes_t accl;
+	float reference;
+} ImuCalibParams_t;
+
+/**
+ * Table entry, one per IMU. Private.
+ */
+typedef struct {
+	_Atomic uint32_t version;
+	uint32_t serialId;
+	ImuCalibParams_t params[2];
+} ImuCalibEntry_t;
+
+/**
+ * Parameter table shared by the streams. All fields are private.
+ *
+ * One thread at a time may call `imuCalibSet`; any number of streams may
+ * read the table meanwhile.
+ */
+typedef struct {
+	ImuCalibEntry_t entries[IMU_CALIB_MAX_DEVICES];
+	_Atomic uint32_t count;
+} ImuCalibTable_t;
+
+/**
+ * Folded map at one temperature. Private.
+ */
+typedef struct {
+	_Alignas(32) float column[6][IMU_CALIB_LANES];
+	_Alignas(32) float offset[IMU_CALIB_LANES];
+	float temperature;
+	int valid;
+} ImuCalibMap_t;
+
+/**
+ * Calibration state of one stream. All fields are private.
+ */
+typedef struct {
+	ImuCalibMap_t maps[2];
+	ImuCalibParams_t params;
+	const ImuCalibTable_t *table;
+	const ImuCalibEntry_t *entry;
+	uint64_t evaluations;
+	uint32_t serialId;
+	uint32_t version;
+	uint32_t scanned;
+	uint32_t current;
+	int known;
+	int active;
+	int drifting;
+} ImuCalib_t;
+
+/**
+ * @brief Fills identity parameters: zero bias, unit scale, no misalignment, no drift.
+ */
+void imuCalibIdentity(ImuCalibParams_t *params);
+
+/**
+ * @brief Initializes an empty table.
+ */
+void imuCalibTableInit(ImuCalibTable_t *table);
+
+/**
+ * @brief Adds or replaces the parameters of an IMU.
+ *
+ * Streams pick up the new parameters at their next batch.
+ *
+ * @param table     Table.
+ * @param serialId  Serial ID of the IMU.
+ * @param params    Parameters.
+ * @return int 0 on success, -1 if the table is full.
+ */
+int imuCalibSet(ImuCalibTable_t *table, uint32_t serialId, const ImuCalibParams_t *params);
+
+/**
+ * @brief Initializes the stage of a stream.
+ *
+ * @param c         State to initialize.
+ * @param table     Parameter table, which must outlive the stage.
+ */
+void imuCalibInit(ImuCalib_t *c, const ImuCalibTable_t *table);
+
+/**
+ * @brief Sets the serial ID of the stream, e.g. when it is known from configuration.
+ */
+void imuCalibSerial(ImuCalib_t *c, uint32_t serialId);
+
+/**
+ * @brief Learns the serial ID of the stream from the mux words of validated packets.
+ *
+ * @param c             State.
+ * @param packets       First packet.
+ * @param packetStride  Bytes from one packet to the next.
+ * @param count         Number of packets.
+ */
+void imuCalibObserve(ImuCalib_t *c, const ImuProt_t *packets, size_t packetStride, size_t count);
+
+/**
+ * @brief Calibrates decoded samples in place.
+ *
+ * @param c         State.
+ * @param samples   Samples, e.g. from `imuDecodeSamples`.
+ * @param count     Number of samples.
+ */
+void imuCalibApply(ImuCalib_t *c, ImuSample_t *samples, size_t count);
+
+/**
+ * @brief Decodes and calibrates validated packets, learning the serial ID on the way.
+ *
+ * @param c             State.
+ * @param packets       First packet.
+ * @param packetStride  Bytes from one packet to the next.
+ * @param samples       Output samples.
+ * @param count         Number of packets.
+ */
+void imuCalibDecode(ImuCalib_t *c, const ImuProt_t *packets, size_t packetStride, ImuSample_t *samples,
+	size_t count);
+
+/**
+ * @brief Returns 1 if the last batch was calibrated, 0 if it passed through.
+ */
+static inline int imuCalibActive(const ImuCalib_t *c)
+{
+	return c->active;
+}
+
+/**
+ * @brief Returns the number of times the map was folded, once per new temperature reading when compensating.
+ */
+static inline uint64_t imuCalibEvaluations(const ImuCalib_t *c)
+{
+	return c->evaluations;
+}
+
+#endif
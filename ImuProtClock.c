@@ -0,0 +1,116 @@
+#include "ImuProtClock.h"
+
+/**
+ * @brief Restarts the fit, keeping the counters.
+ */
+static void clockReset(ImuClock_t *c, uint32_t packetRate) {
+	c->packetRate = packetRate;
+	c->nominalNs = packetRate ? 1e9 / packetRate : 0.0;
+	c->periodNs = c->nominalNs;
+	c->jitterNs = 0.0;
+	c->updates = 0;
+}
+
+void imuClockInit(ImuClock_t *c, uint32_t packetRate) {
+	c->timeNs = 0.0;
+	c->baseNs = 0;
+	c->lastRxNs = 0;
+	c->sample = 0;
+	c->lost = 0;
+	c->resets = 0;
+	c->lastSeq = 0;
+	c->started = 0;
+	clockReset(c, packetRate);
+}
+
+/**
+ * @brief Returns the number of samples since the previous packet.
+ *
+ * The sequencer gives the count modulo 256; the elapsed host time picks the
+ * multiple of 256 when the stream paused for longer than the sequencer range.
+ */
+static uint64_t clockSteps(const ImuClock_t *c, uint8_t seq, uint64_t rxTimeNs) {
+	uint64_t steps = (uint8_t)(seq - c->lastSeq);
+	if (c->periodNs > 0.0 && rxTimeNs > c->lastRxNs) {
+		double expected = (double)(rxTimeNs - c->lastRxNs) / c->periodNs;
+		if (expected > 128.0 + steps)
+			steps += 256 * (uint64_t)((expected - steps + 128.0) / 256.0);
+	}
+	return steps;
+}
+
+uint64_t imuClockUpdate(ImuClock_t *c, const ImuProt_t *packet, uint64_t rxTimeNs) {
+	if ((packet->sequencer & 31) == IMU_CLOCK_RATE_WORD) {
+		uint32_t rate = packet->data.mux & 0xFFFFu;
+		if (rate && rate != c->packetRate && c->packetRate) {
+			c->resets++;
+			clockReset(c, rate);
+		} else if (rate && !c->packetRate) {
+			// First report: the fit so far only lacked the nominal period.
+			c->packetRate = rate;
+			c->nominalNs = 1e9 / rate;
+			if (c->updates < 2)
+				c->periodNs = c->nominalNs;
+		}
+	}
+
+	double steps = 1.0;
+	if (c->started) {
+		uint64_t n = clockSteps(c, packet->sequencer, rxTimeNs);
+		if (n == 0)
+			return imuClockPredict(c, 0);   // Repeated packet.
+		c->lost += n - 1;
+		c->sample += n;
+		steps = (double)n;
+	}
+	c->started = 1;
+	c->lastSeq = packet->sequencer;
+	c->lastRxNs = rxTimeNs;
+
+	double k = (double)++c->updates;
+	if (k == 1.0) {
+		c->baseNs = rxTimeNs;
+		c->timeNs = 0.0;
+		return rxTimeNs;
+	}
+
+	// Growing least squares gains, then fixed gains of a critically damped filter.
+	double alpha = 2.0 * (2.0 * k - 1.0) / (k * (k + 1.0));
+	double beta = 6.0 / (k * (k + 1.0));
+	if (alpha < IMU_CLOCK_ALPHA_MIN) {
+		alpha = IMU_CLOCK_ALPHA_MIN;
+		beta = alpha * alpha / (2.0 - alpha);
+	}
+
+	double predicted = c->timeNs + steps * c->periodNs;
+	double residual = (double)(int64_t)(rxTimeNs - c->baseNs) - predicted;
+	double absResidual = residual < 0.0 ? -residual : residual;
+	if (c->updates > IMU_CLOCK_LOCK_SAMPLES) {
+		double limit = IMU_CLOCK_OUTLIER_FACTOR * c->jitterNs;
+		if (residual > limit)
+			residual = limit;
+		else if (residual < -limit)
+			residual = -limit;
+	}
+	c->jitterNs += (absResidual - c->jitterNs) * (k < 64.0 ? 1.0 / k : 1.0 / 64);
+
+	c->timeNs = predicted + alpha * residual;
+	c->periodNs += beta * residual / steps;
+
+	// Keep the fractional part in the double, so precision does not depend on the clock epoch.
+	int64_t whole = (int64_t)c->timeNs;
+	c->baseNs += (uint64_t)whole;
+	c->timeNs -= (double)whole;
+	return c->baseNs;
+}
+
+void imuClockQuality(const ImuClock_t *c, ImuClockQuality_t *q) {
+	q->periodNs = c->periodNs;
+	q->driftPpm = c->nominalNs > 0.0 ? (c->periodNs / c->nominalNs - 1.0) * 1e6 : 0.0;
+	q->jitterNs = c->jitterNs;
+	q->samples = c->sample;
+	q->lost = c->lost;
+	q->resets = c->resets;
+	q->packetRate = c->packetRate;
+	q->locked = c->updates > IMU_CLOCK_LOCK_SAMPLES;
+}
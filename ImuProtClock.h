@@ -0,0 +1,121 @@
+/**
+ * Sensor Clock Model.
+ *
+ * Relates the IMU sample clock to the host clock. Every packet carries an
+ * 8-bit sequencer, which is unwrapped into a 64-bit sample count, and mux
+ * word 12 reports the nominal `packetRate`. The model fits the host receive
+ * times against the sample count with a line:
+ *
+ *   hostTime(n) = offset + n * period
+ *
+ * using an alpha-beta filter. Its gains start as those of a growing least
+ * squares fit, so the first packets give an exact line, and settle at fixed
+ * values so that the fit keeps tracking temperature drift. Each update is
+ * O(1). The difference between the estimated and the nominal period is the
+ * drift of the IMU oscillator; the mean residual is the quality metric.
+ *
+ * Lost packets are counted from sequencer jumps. Gaps longer than the 8-bit
+ * sequencer range are resolved with the host time elapsed since the last
+ * packet.
+ */
+
+#ifndef ImuProtClock_h_included__
+#define ImuProtClock_h_included__
+
+#include <stdint.h>
+
+#include "ImuProt.h"
+
+/** Mux word holding `packetRate` in its low 16 bits. */
+#define IMU_CLOCK_RATE_WORD (12)
+
+/** Steady-state phase gain of the filter. */
+#define IMU_CLOCK_ALPHA_MIN (1.0 / 1024)
+
+/** Residuals beyond this many mean residuals are clipped, after the model locks. */
+#define IMU_CLOCK_OUTLIER_FACTOR (8.0)
+
+/** Updates after which the model is considered locked. */
+#define IMU_CLOCK_LOCK_SAMPLES (64)
+
+/**
+ * Clock model state. All fields are private.
+ */
+typedef struct {
+	double nominalNs;
+	double periodNs;
+	double timeNs;
+	double jitterNs;
+	uint64_t baseNs;
+	uint64_t lastRxNs;
+	uint64_t sample;
+	uint64_t updates;
+	uint64_t lost;
+	uint64_t resets;
+	uint32_t packetRate;
+	uint8_t lastSeq;
+	uint8_t started;
+} ImuClock_t;
+
+/**
+ * Model quality.
+ *
+ * @field periodNs      Estimated sample period in host nanoseconds.
+ * @field driftPpm      Deviation of the estimated period from the nominal one.
+ * @field jitterNs      Mean absolute residual of the receive times.
+ * @field samples       Unwrapped sample count of the last packet.
+ * @field lost          Packets missing from the sequencer.
+ * @field resets        Restarts after a changed packet rate.
+ * @field packetRate    Packet rate reported by the IMU, 0 if not yet received.
+ * @field locked        Non-zero once the model has settled.
+ */
+typedef struct {
+	double periodNs;
+	double driftPpm;
+	double jitterNs;
+	uint64_t samples;
+	uint64_t lost;
+	uint64_t resets;
+	uint32_t packetRate;
+	int locked;
+} ImuClockQuality_t;
+
+/**
+ * @brief Initializes the model.
+ *
+ * @param c             State to initialize.
+ * @param packetRate    Nominal packet rate in Hz, 0 to wait for the mux word.
+ */
+void imuClockInit(ImuClock_t *c, uint32_t packetRate);
+
+/**
+ * @brief Adds a validated packet and returns its time on the model line.
+ *
+ * @param c         State.
+ * @param packet    Validated packet.
+ * @param rxTimeNs  Host receive time of the packet, e.g. from `imuTimePacket`.
+ * @return uint64_t Host time of the packet's sample according to the model.
+ */
+uint64_t imuClockUpdate(ImuClock_t *c, const ImuProt_t *packet, uint64_t rxTimeNs);
+
+/**
+ * @brief Predicts the host time of a sample relative to the last packet.
+ *
+ * @param c         State.
+ * @param samples   Samples after the last packet, may be negative.
+ * @return uint64_t Predicted host time.
+ */
+static inline uint64_t imuClockPredict(const ImuClock_t *c, int64_t samples)
+{
+	return c->baseNs + (uint64_t)(int64_t)(c->timeNs + (double)samples * c->periodNs);
+}
+
+/**
+ * @brief Reports the model quality.
+ *
+ * @param c State.
+ * @param q Output.
+ */
+void imuClockQuality(const ImuClock_t *c, ImuClockQuality_t *q);
+
+#endif
@@ -0,0 +1,70 @@
+#include <string.h>
+
+#include "ImuProtCrc.h"
+
+#define PACKET_CRC_BYTES (sizeof(ImuProt_t) - sizeof(uint32_t))
+
+// crcSlice[k][b] is the CRC of byte b followed by k zero bytes.
+static uint32_t crcSlice[8][256];
+
+// crcPacket[i][b] is the contribution of byte b at offset i of a packet; the
+// packet CRC is the XOR of all contributions and of the CRC of a zero packet.
+static uint32_t crcPacket[PACKET_CRC_BYTES][256];
+static uint32_t crcPacketZero;
+
+__attribute__((constructor))
+static void crcInitTables(void) {
+	for (uint32_t b = 0; b < 256; b++) {
+		uint32_t crc = b;
+		for (int j = 0; j < 8; j++)
+			crc = (crc & 1) ? (crc >> 1) ^ (uint32_t)CRC32_POLYNOM : crc >> 1;
+		crcSlice[0][b] = crc;
+	}
+	for (uint32_t b = 0; b < 256; b++) {
+		for (int k = 1; k < 8; k++)
+			crcSlice[k][b] = (crcSlice[k - 1][b] >> 8) ^ crcSlice[0][crcSlice[k - 1][b] & 0xff];
+	}
+
+	for (uint32_t b = 0; b < 256; b++) {
+		uint32_t crc = crcSlice[0][b];
+		for (size_t i = PACKET_CRC_BYTES; i-- > 0;) {
+			crcPacket[i][b] = crc;
+			crc = crcSlice[0][crc & 0xff] ^ (crc >> 8);
+		}
+	}
+	static const uint8_t zero[PACKET_CRC_BYTES];
+	crcPacketZero = imuCrc32(zero, sizeof(zero));
+}
+
+uint32_t imuCrc32Update(uint32_t crc, const void *buff, size_t len) {
+	const uint8_t *p = buff;
+
+	while (len >= 8) {
+		uint32_t lo, hi;
+		memcpy(&lo, p, 4);
+		memcpy(&hi, p + 4, 4);
+		lo ^= crc;
+		crc = crcSlice[7][lo & 0xff] ^ crcSlice[6][(lo >> 8) & 0xff] ^
+			crcSlice[5][(lo >> 16) & 0xff] ^ crcSlice[4][lo >> 24] ^
+			crcSlice[3][hi & 0xff] ^ crcSlice[2][(hi >> 8) & 0xff] ^
+			crcSlice[1][(hi >> 16) & 0xff] ^ crcSlice[0][hi >> 24];
+		p += 8;
+		len -= 8;
+	}
+	while (len--)
+		crc = crcSlice[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+uint32_t imuPacketCrc32(const ImuProt_t *packet) {
+	const uint8_t *p = (const uint8_t *)packet;
+	uint32_t crc = crcPacketZero;
+	for (size_t i = 0; i < PACKET_CRC_BYTES; i++)
+		crc ^= crcPacket[i][p[i]];
+	return crc;
+}
+
+const uint32_t *imuPacketCrcTables(uint32_t *zero) {
+	*zero = crcPacketZero;
+	return &crcPacket[0][0];
+}
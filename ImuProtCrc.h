@@ -0,0 +1,65 @@
+/**
+ * Fast CRC32 for IMU Protocol Buffers.
+ *
+ * Same checksum as `protCRC32` (reflected polynomial CRC32_POLYNOM), computed
+ * with slicing-by-8 tables: eight bytes per step instead of one. Meant for
+ * bulk work such as recomputing packet CRCs or checking large blocks, where
+ * the byte-wise table of `ImuProt.h` becomes the bottleneck.
+ */
+
+#ifndef ImuProtCrc_h_included__
+#define ImuProtCrc_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+
+/**
+ * @brief Continues a CRC32 computation over a buffer of any length.
+ *
+ * The running value is neither initialized nor finalized, so long buffers
+ * can be processed piecewise: start with CRC32_INITIAL and XOR the final
+ * value with CRC32_INITIAL.
+ *
+ * @param crc   Running CRC value.
+ * @param buff  Pointer to the data.
+ * @param len   Length of the data in bytes.
+ * @return uint32_t The updated running CRC value.
+ */
+uint32_t imuCrc32Update(uint32_t crc, const void *buff, size_t len);
+
+/**
+ * @brief Computes the CRC32 checksum of a buffer, same result as `protCRC32`.
+ *
+ * @param buff  Pointer to the data.
+ * @param len   Length of the data in bytes.
+ * @return uint32_t The computed CRC32 checksum.
+ */
+static inline uint32_t imuCrc32(const void *buff, size_t len)
+{
+	return imuCrc32Update(CRC32_INITIAL, buff, len) ^ (uint32_t)CRC32_INITIAL;
+}
+
+/**
+ * @brief Computes the CRC32 field of a packet.
+ *
+ * Uses one table per byte position: the 36 lookups are independent of each
+ * other instead of forming a dependency chain, which makes this several
+ * times faster than a byte-wise or sliced CRC for this fixed length.
+ *
+ * @param packet Packet whose first 36 bytes are checksummed.
+ * @return uint32_t The value expected in `packet->crc32`.
+ */
+uint32_t imuPacketCrc32(const ImuProt_t *packet);
+
+/**
+ * @brief Returns the position tables of `imuPacketCrc32`, for vectorized kernels.
+ *
+ * @param zero Receives the CRC of a packet of zero bytes.
+ * @return const uint32_t* 36 consecutive tables of 256 entries; entry
+ *         `i * 256 + b` is the contribution of byte b at offset i.
+ */
+const uint32_t *imuPacketCrcTables(uint32_t *zero);
+
+#endif
@@ -0,0 +1,125 @@
+#include <string.h>
+
+#include "ImuProtDelta.h"
+
+/**
+ * @brief out = a x b.
+ */
+static inline void deltaCross(const double a[3], const double b[3], double out[3]) {
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+/**
+ * @brief Clears the accumulators of the current interval.
+ */
+static void deltaClear(ImuDeltaInteg_t *g) {
+	memset(g->alpha, 0, sizeof(g->alpha));
+	memset(g->nu, 0, sizeof(g->nu));
+	memset(g->beta, 0, sizeof(g->beta));
+	memset(g->scul, 0, sizeof(g->scul));
+	g->samples = 0;
+	g->filled = 0;
+	g->flags = 0;
+}
+
+void imuDeltaInit(ImuDeltaInteg_t *g, uint32_t packetRate, uint32_t outputRate) {
+	memset(g, 0, sizeof(*g));
+	g->period = packetRate ? 1.0 / packetRate : 0.0;
+	g->ratio = outputRate && packetRate > outputRate ? (packetRate + outputRate / 2) / outputRate : 1;
+	g->gyroScale = IMU_GYRO_TO_RAD;
+	g->acclScale = IMU_ACCL_TO_MPS2;
+}
+
+void imuDeltaUnits(ImuDeltaInteg_t *g, double gyroScale, double acclScale) {
+	g->gyroScale = gyroScale;
+	g->acclScale = acclScale;
+}
+
+/**
+ * @brief Integrates one minor interval.
+ */
+static inline void deltaStep(ImuDeltaInteg_t *g, const double angle[3], const double velocity[3]) {
+	double a[3], n[3], c[3];
+	for (int i = 0; i < 3; i++) {
+		a[i] = g->alpha[i] + g->prevAngle[i] * (1.0 / 6);
+		n[i] = g->nu[i] + g->prevVelocity[i] * (1.0 / 6);
+	}
+	deltaCross(a, angle, c);
+	for (int i = 0; i < 3; i++)
+		g->beta[i] += 0.5 * c[i];
+	deltaCross(a, velocity, c);
+	for (int i = 0; i < 3; i++)
+		g->scul[i] += 0.5 * c[i];
+	deltaCross(n, angle, c);
+	for (int i = 0; i < 3; i++) {
+		g->scul[i] += 0.5 * c[i];
+		g->alpha[i] += angle[i];
+		g->nu[i] += velocity[i];
+		g->prevAngle[i] = angle[i];
+		g->prevVelocity[i] = velocity[i];
+	}
+	g->samples++;
+}
+
+/**
+ * @brief Writes the compensated interval and starts the next one.
+ */
+static void deltaEmit(ImuDeltaInteg_t *g, ImuDelta_t *out) {
+	double rot[3];
+	deltaCross(g->alpha, g->nu, rot);
+	for (int i = 0; i < 3; i++) {
+		out->angle[i] = g->alpha[i] + g->beta[i];
+		out->velocity[i] = g->nu[i] + 0.5 * rot[i] + g->scul[i];
+	}
+	out->dt = g->samples * g->period;
+	out->samples = g->samples;
+	out->filled = g->filled;
+	out->flags = g->flags;
+	out->sequencer = g->lastSeq;
+	deltaClear(g);
+}
+
+int imuDeltaPush(ImuDeltaInteg_t *g, const ImuProt_t *packet, ImuDelta_t *out) {
+	const double gyroScale = g->gyroScale * g->period * IMU_PROT_SCALE;
+	const double acclScale = g->acclScale * g->period * IMU_PROT_SCALE;
+	double angle[3], velocity[3];
+	for (int i = 0; i < 3; i++) {
+		angle[i] = packet->data.gyro[i] * gyroScale;
+		velocity[i] = packet->data.accl[i] * acclScale;
+	}
+
+	uint32_t steps = 1;
+	if (g->started) {
+		steps = (uint8_t)(packet->sequencer - g->lastSeq);
+		if (steps == 0 || steps > IMU_DELTA_MAX_GAP + 1) {
+			// Duplicate or long outage: the motion in between is unknown.
+			g->restarts++;
+			deltaClear(g);
+			memset(g->prevAngle, 0, sizeof(g->prevAngle));
+			memset(g->prevVelocity, 0, sizeof(g->prevVelocity));
+			steps = 1;
+		}
+	}
+	g->started = 1;
+	g->lastSeq = packet->sequencer;
+	g->flags |= packet->data.flags;
+	g->filled += steps - 1;
+	while (steps--)
+		deltaStep(g, angle, velocity);
+
+	if (g->samples < g->ratio)
+		return 0;
+	deltaEmit(g, out);
+	return 1;
+}
+
+size_t imuDeltaPushBatch(ImuDeltaInteg_t *g, const ImuProt_t *packets, size_t count, ImuDelta_t *out,
+	size_t max, size_t *written) {
+	size_t n = 0, i = 0;
+	for (; i < count && n < max; i++)
+		n += (size_t)imuDeltaPush(g, &packets[i], &out[n]);
+	*written = n;
+	return i;
+}
@@ -0,0 +1,144 @@
+/**
+ * Coning and Sculling Compensated Delta Integrator.
+ *
+ * Pre-integrates the full-rate `gyro` and `accl` readings into delta-angle
+ * and delta-velocity vectors at a lower output rate, e.g. 2000 Hz packets
+ * into 200 Hz navigation updates. Summing the readings is exact only when
+ * the rotation axis is fixed; under vibration the body rotates about a
+ * moving axis and the plain sums drift (coning error in the angle, sculling
+ * error in the velocity). Every packet is one minor interval of the
+ * recursive two-speed algorithm of Savage ("Strapdown Inertial Navigation
+ * Integration Algorithm Design", 1998):
+ *
+ *   alpha(i) = alpha(i-1) + dTheta(i)
+ *   nu(i)    = nu(i-1) + dV(i)
+ *   beta    += 1/2 (alpha(i-1) + 1/6 dTheta(i-1)) x dTheta(i)
+ *   scul    += 1/2 ((alpha(i-1) + 1/6 dTheta(i-1)) x dV(i)
+ *                  + (nu(i-1) + 1/6 dV(i-1)) x dTheta(i))
+ *
+ * and at the end of the output interval
+ *
+ *   deltaAngle    = alpha + beta
+ *   deltaVelocity = nu + 1/2 alpha x nu + scul
+ *
+ * The readings are taken as rates averaged over their sample period. A
+ * sequencer gap is bridged by repeating the packet after it for each
+ * missing sample, so the integrated time matches the elapsed time; the
+ * interval holding the gap is lengthened accordingly and reports how many
+ * samples were filled in.
+ */
+
+#ifndef ImuProtDelta_h_included__
+#define ImuProtDelta_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtSample.h"
+
+/** Longest gap bridged by repetition; longer gaps restart the interval. */
+#define IMU_DELTA_MAX_GAP (16)
+
+/**
+ * Integrated output interval.
+ *
+ * @field angle     Compensated delta-angle (rotation vector) in rad.
+ * @field velocity  Compensated delta-velocity in m/s, in the body frame at the interval start.
+ * @field dt        Length of the interval in s.
+ * @field samples   Sample periods integrated.
+ * @field filled    Sample periods filled in for lost packets.
+ * @field flags     Status flags of all packets, ORed.
+ * @field sequencer Sequencer of the last packet.
+ */
+typedef struct {
+	double angle[3];
+	double velocity[3];
+	double dt;
+	uint32_t samples;
+	uint32_t filled;
+	uint16_t flags;
+	uint8_t sequencer;
+} ImuDelta_t;
+
+/**
+ * Integrator state. All fields are private.
+ */
+typedef struct {
+	double alpha[3];
+	double nu[3];
+	double beta[3];
+	double scul[3];
+	double prevAngle[3];
+	double prevVelocity[3];
+	double period;
+	double gyroScale;
+	double acclScale;
+	uint32_t ratio;
+	uint32_t samples;
+	uint32_t filled;
+	uint16_t flags;
+	uint8_t lastSeq;
+	uint8_t started;
+	uint64_t restarts;
+} ImuDeltaInteg_t;
+
+/**
+ * @brief Initializes the integrator.
+ *
+ * @param g             State to initialize.
+ * @param packetRate    Packet rate in Hz, e.g. `packetRate` of the mux data.
+ * @param outputRate    Output rate in Hz, rounded to an integer divisor of `packetRate`.
+ */
+void imuDeltaInit(ImuDeltaInteg_t *g, uint32_t packetRate, uint32_t outputRate);
+
+/**
+ * @brief Sets the conversion of the readings to SI units.
+ *
+ * @param g         State.
+ * @param gyroScale Radians per second per `floatData(gyro)` unit, IMU_GYRO_TO_RAD by default.
+ * @param acclScale m/s^2 per `floatData(accl)` unit, IMU_ACCL_TO_MPS2 by default.
+ */
+void imuDeltaUnits(ImuDeltaInteg_t *g, double gyroScale, double acclScale);
+
+/**
+ * @brief Adds a validated packet.
+ *
+ * @param g         State.
+ * @param packet    Validated packet.
+ * @param out       Receives the interval when one completes.
+ * @return int 1 if `out` was written, 0 otherwise.
+ */
+int imuDeltaPush(ImuDeltaInteg_t *g, const ImuProt_t *packet, ImuDelta_t *out);
+
+/**
+ * @brief Adds consecutive validated packets.
+ *
+ * @param g         State.
+ * @param packets   Packets.
+ * @param count     Number of packets.
+ * @param out       Receives the completed intervals.
+ * @param max       Capacity of `out`.
+ * @param written   Receives the number of intervals written.
+ * @return size_t Number of packets consumed; all of them unless `out` filled up.
+ */
+size_t imuDeltaPushBatch(ImuDeltaInteg_t *g, const ImuProt_t *packets, size_t count, ImuDelta_t *out,
+	size_t max, size_t *written);
+
+/**
+ * @brief Returns the number of sample periods per output interval.
+ */
+static inline uint32_t imuDeltaRatio(const ImuDeltaInteg_t *g)
+{
+	return g->ratio;
+}
+
+/**
+ * @brief Returns how often a gap longer than IMU_DELTA_MAX_GAP restarted the interval.
+ */
+static inline uint64_t imuDeltaRestarts(const ImuDeltaInteg_t *g)
+{
+	return g->restarts;
+}
+
+#endif
@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include "ImuProt.h"
+#include "ImuProtHex.h"
 
 // 74951EE10000000000008179CAF6FFFF85FCFFFFC801000079ECFFFFDCE3FFFFF9C30900BA11DF0F
 // 74951FE00000000000007F79AFFEFFFFCFF4FFFFEAFBFFFF36F1FFFFC5E3FFFFA8C30900C14BE115
@@ -13,7 +14,6 @@ const uint8_t * hexStringToByteArray(const char* hexString, uint8_t * byteArray,
 void printByteArray(const unsigned char* byteArray, size_t byteArrayLen);
 void parsePacket(const char * packetHex);
 void printPacket(const uint8_t * buffer);
-const char* ImuProtErrorToString(ImuProtError_t error);
 
 int main(void) {
 	printf("Size Header Sequencers Temperature GyroX      GyroY      GyroZ      AcclX      AcclY"
@@ -72,6 +72,7 @@ void printPacket(const uint8_t * buffer) {
  *
  * This function takes a string representing hexadecimal values and converts it into a byte array.
  * The length of the resulting byte array is computed and stored in the provided `byteArrayLen` pointer.
+ * Malformed characters are reported on stderr instead of silently turning into zero.
  *
  * @param hexString A string containing hexadecimal values, with each pair of characters representing a byte.
  * @param byteArray A pointer to an array where the converted byte values will be stored.
@@ -81,11 +82,12 @@ void printPacket(const uint8_t * buffer) {
  */
 const uint8_t * hexStringToByteArray(const char* hexString, uint8_t * byteArray, size_t* byteArrayLen) {
     size_t strLen = strlen(hexString);
+    size_t errorOffset;
     *byteArrayLen = strLen / 2;
-    
-    for (size_t i = 0; i < *byteArrayLen; i++) {
-        char byteStr[3] = { hexString[i * 2], hexString[i * 2 + 1], '\0' };
-        byteArray[i] = (uint8_t )strtol(byteStr, NULL, 16);
+
+    ImuHexError_t result = imuHexDecode(hexString, *byteArrayLen * 2, byteArray, &errorOffset);
+    if (result != IMU_HEX_OK) {
+        fprintf(stderr, "%s at offset %zu: \"%s\"\n", imuHexErrorToString(result), errorOffset, hexString);
     }
 
 	return byteArray;
@@ -104,23 +106,3 @@ void printByteArray(const unsigned char* byteArray, size_t byteArrayLen) {
     }
     printf("\n");
 }
-
-/**
- * @brief Converts an ImuProtError_t error code to its corresponding string representation.
- *
- * @param error The ImuProtError_t error code.
- * @return A string that describes the error.
- */
-const char* ImuProtErrorToString(ImuProtError_t error) {
-    switch (error) {
-        case IMU_PROT_OK:
-            return "OK.";
-        case IMU_PROT_BAD_HEADER:
-            return "Invalid header!";
-        case IMU_PROT_BAD_SEQUENCER:
-            return "Invalid sequencer!";
-        case IMU_PROT_BAD_CRC:
-            return "CRC validation failed!";
-    }
-	return "Unknown error.";
-}
@@ -0,0 +1,50 @@
+#include <cstdio>
+#include <vector>
+
+#include "ImuProt.hpp"
+
+// Same packets and output as ImuProtExample.c, decoded with ImuProt.hpp.
+
+static std::vector<std::byte> fromHex(const char *hex) {
+	auto nibble = [](char c) {
+		return c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : c >= 'a' && c <= 'f' ? c - 'a' + 10 : 0;
+	};
+	std::vector<std::byte> bytes;
+	for (; hex[0] && hex[1]; hex += 2)
+		bytes.push_back(static_cast<std::byte>(nibble(hex[0]) << 4 | nibble(hex[1])));
+	return bytes;
+}
+
+/**
+ * @brief Validates and prints a packet given as a hex string.
+ */
+static void parsePacket(const char *packetHex) {
+	std::vector<std::byte> bytes = fromHex(packetHex);
+	imuprot::ByteSpan span(bytes.data(), bytes.size());
+	imuprot::Error result = imuprot::check(span);
+	imuprot::Packet packet = imuprot::parse(bytes.data());
+	imuprot::Sample<float> sample = imuprot::toSample(packet);
+
+	std::printf("0x%04X 0x%02X 0x%02X % 8.2f  % 10.3f % 10.3f % 10.3f % 10.3f % 10.3f % 10.3f  0x%08X 0x%08X (%d) %s\n",
+		packet.header, packet.sequencer, packet.ffSequencer, sample.temperature,
+		sample.gyro[0], sample.gyro[1], sample.gyro[2], sample.accl[0], sample.accl[1], sample.accl[2],
+		packet.crc32, imuprot::crc32<imuprot::kCrcBytes>(bytes.data()), static_cast<int>(result),
+		imuprot::toString(result));
+}
+
+int main() {
+	std::printf("Size Header Sequencers Temperature GyroX      GyroY      GyroZ      AcclX      AcclY"
+		"      AcclZ    CRC32      Check      Validation result\n");
+	parsePacket("74951EE10000000000008179CAF6FFFF85FCFFFFC801000079ECFFFFDCE3FFFFF9C30900BA11DF0F");
+	parsePacket("74951FE00000000000007F79AFFEFFFFCFF4FFFFEAFBFFFF36F1FFFFC5E3FFFFA8C30900C14BE115");
+	parsePacket("749520DF3F03000000007F79F2F6FFFFD7EEFFFF13F6FFFF82EFFFFF5AE6FFFF01C90900022D0189");
+	parsePacket("749522DD0000000000007F7912EFFFFF99F4FFFFFEF9FFFFBFEAFFFFAADCFFFFB5CA0900C8E47F2F");
+	parsePacket("749422DD0000000000007F7912EFFFFF99F4FFFFFEF9FFFFBFEAFFFFAADCFFFFB5CA0900C8E47F2F");	// Broken packet
+	parsePacket("749522CD0000000000007F7912EFFFFF99F4FFFFFEF9FFFFBFEAFFFFAADCFFFFB5CA0900C8E47F2F");	// Broken packet
+	parsePacket("749522DD0000100000007F7912EFFFFF99F4FFFFFEF9FFFFBFEAFFFFAADCFFFFB5CA0900C8E47F2F");	// Broken packet
+
+	// The protocol description is usable at compile time.
+	static_assert(imuprot::mux::packetRate.extract(0xABCD0190u) == 400);
+	static_assert(imuprot::celsius<double>(29315) > 19.99 && imuprot::celsius<double>(29315) < 20.01);
+	return 0;
+}
@@ -0,0 +1,235 @@
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <string.h>
+
+#include "ImuProtFir.h"
+#include "ImuProtIsa.h"
+
+#define FIR_INLINE static inline __attribute__((always_inline))
+
+typedef float FirVecF_t __attribute__((vector_size(IMU_FIR_LANES * sizeof(float))));
+typedef int32_t FirVecI_t __attribute__((vector_size(IMU_FIR_LANES * sizeof(int32_t))));
+typedef int64_t FirVecL_t __attribute__((vector_size(IMU_FIR_LANES * sizeof(int64_t))));
+
+/*
+ * Kernels: one output frame from `count` history frames. Written with vector
+ * extensions and compiled once per ISA level by the wrappers below.
+ */
+
+FIR_INLINE void firDotFloat(const float *history, const float *taps, size_t count, float *out) {
+	const FirVecF_t *x = (const FirVecF_t *)history;
+	FirVecF_t a0 = { 0 }, a1 = { 0 }, a2 = { 0 }, a3 = { 0 };
+	size_t k = 0;
+	// Four accumulators hide the multiply-add latency.
+	for (; k + 4 <= count; k += 4) {
+		a0 += taps[k] * x[k];
+		a1 += taps[k + 1] * x[k + 1];
+		a2 += taps[k + 2] * x[k + 2];
+		a3 += taps[k + 3] * x[k + 3];
+	}
+	for (; k < count; k++)
+		a0 += taps[k] * x[k];
+	FirVecF_t sum = (a0 + a1) + (a2 + a3);
+	memcpy(out, &sum, sizeof(sum));
+}
+
+FIR_INLINE void firDotFixed(const int32_t *history, const int32_t *taps, size_t count, int32_t *out) {
+	const FirVecI_t *x = (const FirVecI_t *)history;
+	FirVecL_t a0 = { 0 }, a1 = { 0 };
+	size_t k = 0;
+	for (; k + 2 <= count; k += 2) {
+		a0 += (int64_t)taps[k] * __builtin_convertvector(x[k], FirVecL_t);
+		a1 += (int64_t)taps[k + 1] * __builtin_convertvector(x[k + 1], FirVecL_t);
+	}
+	for (; k < count; k++)
+		a0 += (int64_t)taps[k] * __builtin_convertvector(x[k], FirVecL_t);
+	FirVecL_t sum = (a0 + a1 + ((int64_t)1 << (IMU_FIR_FIXED_BITS - 1))) >> IMU_FIR_FIXED_BITS;
+	for (int i = 0; i < IMU_FIR_LANES; i++)
+		out[i] = sum[i] > INT32_MAX ? INT32_MAX : sum[i] < INT32_MIN ? INT32_MIN : (int32_t)sum[i];
+}
+
+static void firFloatBaseline(const float *history, const float *taps, size_t count, float *out) {
+	firDotFloat(history, taps, count, out);
+}
+
+static void firFixedBaseline(const int32_t *history, const int32_t *taps, size_t count, int32_t *out) {
+	firDotFixed(history, taps, count, out);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#include <immintrin.h>
+
+#define FIR_TARGET(t) static __attribute__((target(t)))
+
+FIR_TARGET("arch=x86-64-v3") void firFloatAvx2(const float *history, const float *taps, size_t count,
+	float *out) {
+	firDotFloat(history, taps, count, out);
+}
+
+// Sign-extended 32 x 32 bit products with vpmuldq: even lanes, then odd lanes shifted down.
+static inline __attribute__((always_inline, target("avx2"))) void firDotFixedMuldq(const int32_t *history, const int32_t *taps, size_t count, int32_t *out) {
+	__m256i even = _mm256_setzero_si256(), odd = _mm256_setzero_si256();
+	for (size_t k = 0; k < count; k++) {
+		__m256i x = _mm256_load_si256((const __m256i *)(history + k * IMU_FIR_LANES));
+		__m256i h = _mm256_set1_epi32(taps[k]);
+		even = _mm256_add_epi64(even, _mm256_mul_epi32(x, h));
+		odd = _mm256_add_epi64(odd, _mm256_mul_epi32(_mm256_srli_epi64(x, 32), h));
+	}
+	int64_t e[4], o[4];
+	_mm256_storeu_si256((__m256i *)e, even);
+	_mm256_storeu_si256((__m256i *)o, odd);
+	for (int i = 0; i < 4; i++) {
+		int64_t a = (e[i] + ((int64_t)1 << (IMU_FIR_FIXED_BITS - 1))) >> IMU_FIR_FIXED_BITS;
+		int64_t b = (o[i] + ((int64_t)1 << (IMU_FIR_FIXED_BITS - 1))) >> IMU_FIR_FIXED_BITS;
+		out[2 * i] = a > INT32_MAX ? INT32_MAX : a < INT32_MIN ? INT32_MIN : (int32_t)a;
+		out[2 * i + 1] = b > INT32_MAX ? INT32_MAX : b < INT32_MIN ? INT32_MIN : (int32_t)b;
+	}
+}
+
+FIR_TARGET("arch=x86-64-v3") void firFixedAvx2(const int32_t *history, const int32_t *taps, size_t count,
+	int32_t *out) {
+	firDotFixedMuldq(history, taps, count, out);
+}
+
+FIR_TARGET("arch=x86-64-v4") void firFloatAvx512(const float *history, const float *taps, size_t count,
+	float *out) {
+	firDotFloat(history, taps, count, out);
+}
+
+FIR_TARGET("arch=x86-64-v4") void firFixedAvx512(const int32_t *history, const int32_t *taps, size_t count,
+	int32_t *out) {
+	firDotFixedMuldq(history, taps, count, out);
+}
+
+#define FIR_FLOAT_AVX2 firFloatAvx2
+#define FIR_FIXED_AVX2 firFixedAvx2
+#define FIR_FLOAT_AVX512 firFloatAvx512
+#define FIR_FIXED_AVX512 firFixedAvx512
+
+#else
+
+#define FIR_FLOAT_AVX2 firFloatBaseline
+#define FIR_FIXED_AVX2 firFixedBaseline
+#define FIR_FLOAT_AVX512 firFloatBaseline
+#define FIR_FIXED_AVX512 firFixedBaseline
+
+#endif
+
+void imuFirDesign(float *taps, size_t count, double cutoff) {
+	double sum = 0.0;
+	double center = (count - 1) / 2.0;
+	for (size_t n = 0; n < count; n++) {
+		double t = n - center;
+		double h = t == 0.0 ? 2.0 * cutoff : sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+		if (count > 1) {
+			double x = 2.0 * M_PI * n / (count - 1);
+			h *= 0.42 - 0.5 * cos(x) + 0.08 * cos(2.0 * x);
+		}
+		taps[n] = (float)h;
+		sum += h;
+	}
+	for (size_t n = 0; n < count; n++)
+		taps[n] = (float)(taps[n] / sum);
+}
+
+int imuFirInit(ImuFir_t *f, const float *taps, size_t count, uint32_t decimation) {
+	if (!count || count > IMU_FIR_MAX_TAPS || !decimation)
+		return -1;
+	memset(f->history, 0, sizeof(f->history));
+	// Reversed, so that taps[0] meets the oldest frame of the window.
+	for (size_t k = 0; k < count; k++)
+		f->taps[k] = taps[count - 1 - k];
+	f->count = count;
+	f->pos = 0;
+	f->decimation = decimation;
+	f->phase = 0;
+	ImuIsa_t isa = imuIsaActive();
+	f->kernel = isa >= IMU_ISA_AVX512 ? FIR_FLOAT_AVX512 : isa >= IMU_ISA_AVX2 ? FIR_FLOAT_AVX2 : firFloatBaseline;
+	return 0;
+}
+
+size_t imuFirPush(ImuFir_t *f, const ImuProt_t *packets, size_t count, ImuSample_t *out, size_t max,
+	size_t *written) {
+	size_t n = 0, i = 0;
+	for (; i < count; i++) {
+		if (f->phase + 1 >= f->decimation && n == max)
+			break;
+		const ImuProt_t *p = &packets[i];
+		float *a = f->history[f->pos];
+		float *b = f->history[f->pos + f->count];
+		for (int c = 0; c < 3; c++) {
+			a[c] = b[c] = floatData(p->data.gyro[c]);
+			a[c + 3] = b[c + 3] = floatData(p->data.accl[c]);
+		}
+		f->pos = f->pos + 1 == f->count ? 0 : f->pos + 1;
+		if (++f->phase < f->decimation)
+			continue;
+		f->phase = 0;
+
+		float y[IMU_FIR_LANES];
+		f->kernel(f->history[f->pos], f->taps, f->count, y);
+		ImuSample_t *s = &out[n++];
+		memcpy(s->gyro, y, sizeof(s->gyro));
+		memcpy(s->accl, y + 3, sizeof(s->accl));
+		s->temperature = tempFromKelvin(p->data.temperature);
+		s->flags = p->data.flags;
+		s->sequencer = p->sequencer;
+	}
+	*written = n;
+	return i;
+}
+
+int imuFirFixedInit(ImuFirFixed_t *f, const float *taps, size_t count, uint32_t decimation) {
+	if (!count || count > IMU_FIR_MAX_TAPS || !decimation)
+		return -1;
+	double magnitude = 0.0;
+	for (size_t k = 0; k < count; k++)
+		magnitude += fabs(taps[k]);
+	if (magnitude >= 64.0)
+		return -1;
+	memset(f->history, 0, sizeof(f->history));
+	for (size_t k = 0; k < count; k++)
+		f->taps[k] = (int32_t)lround(taps[count - 1 - k] * (double)(1 << IMU_FIR_FIXED_BITS));
+	f->count = count;
+	f->pos = 0;
+	f->decimation = decimation;
+	f->phase = 0;
+	ImuIsa_t isa = imuIsaActive();
+	f->kernel = isa >= IMU_ISA_AVX512 ? FIR_FIXED_AVX512 : isa >= IMU_ISA_AVX2 ? FIR_FIXED_AVX2 : firFixedBaseline;
+	return 0;
+}
+
+size_t imuFirFixedPush(ImuFirFixed_t *f, const ImuProt_t *packets, size_t count, ImuData_t *out, size_t max,
+	size_t *written) {
+	size_t n = 0, i = 0;
+	for (; i < count; i++) {
+		if (f->phase + 1 >= f->decimation && n == max)
+			break;
+		const ImuProt_t *p = &packets[i];
+		int32_t *a = f->history[f->pos];
+		int32_t *b = f->history[f->pos + f->count];
+		for (int c = 0; c < 3; c++) {
+			a[c] = b[c] = p->data.gyro[c];
+			a[c + 3] = b[c + 3] = p->data.accl[c];
+		}
+		f->pos = f->pos + 1 == f->count ? 0 : f->pos + 1;
+		if (++f->phase < f->decimation)
+			continue;
+		f->phase = 0;
+
+		int32_t y[IMU_FIR_LANES];
+		f->kernel(f->history[f->pos], f->taps, f->count, y);
+		ImuData_t *d = &out[n++];
+		d->mux = p->data.mux;
+		d->flags = p->data.flags;
+		d->temperature = p->data.temperature;
+		for (int c = 0; c < 3; c++) {
+			d->gyro[c] = y[c];
+			d->accl[c] = y[c + 3];
+		}
+	}
+	*written = n;
+	return i;
+}
@@ -0,0 +1,143 @@
+/**
+ * Multi-Channel Decimating FIR Filter.
+ *
+ * Low-pass filters and decimates the six `gyro` and `accl` axes together,
+ * e.g. 2000 Hz packets to 200 or 400 Hz with anti-aliasing. The filter is
+ * evaluated in polyphase form: only every `decimation`-th output is
+ * computed, so each input costs one store and each output one pass over
+ * the taps.
+ *
+ * The history holds one frame of IMU_FIR_LANES values per input, the six
+ * axes padded to a SIMD vector, so every tap is one vector multiply-add
+ * over all axes at once. It is stored twice in a row, so the taps always
+ * meet a contiguous window without wrapping. The kernels are compiled per
+ * ISA level and follow the level selected in `ImuProtIsa.h` at init time.
+ *
+ * Two variants share the design:
+ *
+ * - `ImuFir_t` filters in single precision and outputs `ImuSample_t`.
+ * - `ImuFirFixed_t` filters the FP1.15.16 `int32_t` readings directly with
+ *   Q24 taps and 64-bit accumulators and outputs `ImuData_t` in the same
+ *   format, bit-exact on every ISA level.
+ *
+ * Both are streaming and allocation-free: all state lives in the structure,
+ * which must be 64-byte aligned (use `aligned_alloc` on the heap).
+ */
+
+#ifndef ImuProtFir_h_included__
+#define ImuProtFir_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtSample.h"
+
+/** Filtered axes: gyro X, Y, Z, accl X, Y, Z. */
+#define IMU_FIR_CHANNELS (6)
+
+/** Values per history frame, the axes padded to a vector. */
+#define IMU_FIR_LANES (8)
+
+/** Maximum number of taps. */
+#define IMU_FIR_MAX_TAPS (256)
+
+/** Fraction bits of the fixed-point taps. */
+#define IMU_FIR_FIXED_BITS (24)
+
+/**
+ * Floating-point filter state. All fields are private.
+ */
+typedef struct {
+	_Alignas(64) float history[2 * IMU_FIR_MAX_TAPS][IMU_FIR_LANES];
+	_Alignas(64) float taps[IMU_FIR_MAX_TAPS];
+	void (*kernel)(const float *history, const float *taps, size_t count, float *out);
+	size_t count;
+	size_t pos;
+	uint32_t decimation;
+	uint32_t phase;
+} ImuFir_t;
+
+/**
+ * Fixed-point filter state. All fields are private.
+ */
+typedef struct {
+	_Alignas(64) int32_t history[2 * IMU_FIR_MAX_TAPS][IMU_FIR_LANES];
+	_Alignas(64) int32_t taps[IMU_FIR_MAX_TAPS];
+	void (*kernel)(const int32_t *history, const int32_t *taps, size_t count, int32_t *out);
+	size_t count;
+	size_t pos;
+	uint32_t decimation;
+	uint32_t phase;
+} ImuFirFixed_t;
+
+/**
+ * @brief Designs a linear-phase low-pass filter (Blackman-windowed sinc) with unit DC gain.
+ *
+ * @param taps      Output coefficients.
+ * @param count     Number of taps, at most IMU_FIR_MAX_TAPS.
+ * @param cutoff    Cutoff frequency as a fraction of the input rate, below 0.5.
+ */
+void imuFirDesign(float *taps, size_t count, double cutoff);
+
+/**
+ * @brief Initializes the floating-point filter.
+ *
+ * @param f             State to initialize.
+ * @param taps          Coefficients, copied.
+ * @param count         Number of taps, 1 to IMU_FIR_MAX_TAPS.
+ * @param decimation    Inputs per output, at least 1.
+ * @return int 0 on success, -1 if an argument is out of range.
+ */
+int imuFirInit(ImuFir_t *f, const float *taps, size_t count, uint32_t decimation);
+
+/**
+ * @brief Filters consecutive validated packets.
+ *
+ * @param f         State.
+ * @param packets   Packets.
+ * @param count     Number of packets.
+ * @param out       Receives the outputs; temperature, flags and sequencer come
+ *                  from the newest packet of each output.
+ * @param max       Capacity of `out`.
+ * @param written   Receives the number of outputs written.
+ * @return size_t Number of packets consumed; all of them unless `out` filled up.
+ */
+size_t imuFirPush(ImuFir_t *f, const ImuProt_t *packets, size_t count, ImuSample_t *out, size_t max,
+	size_t *written);
+
+/**
+ * @brief Initializes the fixed-point filter.
+ *
+ * @param f             State to initialize.
+ * @param taps          Coefficients, rounded to Q24; the sum of their magnitudes must stay below 64.
+ * @param count         Number of taps, 1 to IMU_FIR_MAX_TAPS.
+ * @param decimation    Inputs per output, at least 1.
+ * @return int 0 on success, -1 if an argument is out of range.
+ */
+int imuFirFixedInit(ImuFirFixed_t *f, const float *taps, size_t count, uint32_t decimation);
+
+/**
+ * @brief Filters consecutive validated packets in fixed point.
+ *
+ * @param f         State.
+ * @param packets   Packets.
+ * @param count     Number of packets.
+ * @param out       Receives the outputs; mux, flags and temperature come from
+ *                  the newest packet of each output.
+ * @param max       Capacity of `out`.
+ * @param written   Receives the number of outputs written.
+ * @return size_t Number of packets consumed; all of them unless `out` filled up.
+ */
+size_t imuFirFixedPush(ImuFirFixed_t *f, const ImuProt_t *packets, size_t count, ImuData_t *out, size_t max,
+	size_t *written);
+
+/**
+ * @brief Returns the group delay of the linear-phase filter in input samples.
+ */
+static inline double imuFirDelay(size_t count)
+{
+	return (double)(count - 1) / 2;
+}
+
+#endif
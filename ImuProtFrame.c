@@ -0,0 +1,89 @@
+#include <string.h>
+
+#include "ImuProtFrame.h"
+#include "ImuProtIsa.h"
+
+#define FRAME_HEADER_LO ((uint8_t)(IMU_PROT_HEADER & 0xFF))
+#define FRAME_HEADER_HI ((uint8_t)(IMU_PROT_HEADER >> 8))
+
+/**
+ * @brief Scans `buf` for packets starting before `limit`.
+ *
+ * @param shift Added to positions in `buf` to get offsets within the caller's chunk.
+ * @return size_t Position where scanning stopped.
+ */
+static size_t frameScan(ImuFramer_t *f, const uint8_t *buf, size_t len, size_t pos, size_t limit,
+	ptrdiff_t shift, ImuProt_t *packets, size_t *endOffsets, size_t max, size_t *count) {
+	size_t end = limit < len ? limit : len;
+	while (pos < end && pos + sizeof(ImuProt_t) <= len && *count < max) {
+		const uint8_t *p = buf + pos;
+		if (p[0] == FRAME_HEADER_LO && p[1] == FRAME_HEADER_HI) {
+			ImuProtError_t error = imuFrameCheck(p);
+			if (error == IMU_PROT_OK) {
+				memcpy(&packets[*count], p, sizeof(ImuProt_t));
+				if (endOffsets)
+					endOffsets[*count] = (size_t)((ptrdiff_t)(pos + sizeof(ImuProt_t)) + shift);
+				(*count)++;
+				f->stats.packets++;
+				f->synced = 1;
+				pos += sizeof(ImuProt_t);
+				continue;
+			}
+			f->stats.errors[error]++;
+		} else if (f->synced) {
+			f->stats.errors[IMU_PROT_BAD_HEADER]++;
+		}
+
+		if (f->synced) {
+			f->synced = 0;
+			f->stats.resyncs++;
+		}
+		size_t skip = pos + 1 < end ? pos + 1 + imuFindHeader(p + 1, end - pos - 1) : end;
+		f->stats.discarded += skip - pos;
+		pos = skip;
+	}
+	return pos;
+}
+
+void imuFramerInit(ImuFramer_t *f) {
+	memset(f, 0, sizeof(*f));
+}
+
+size_t imuFramerPush(ImuFramer_t *f, const uint8_t *data, size_t len, ImuProt_t *packets,
+	size_t *endOffsets, size_t max, size_t *consumed) {
+	size_t count = 0, pos = 0;
+
+	if (f->carryLen) {
+		// Only a packet starting in the carried bytes is looked for here; it
+		// ends within the first sizeof(ImuProt_t) bytes of `data`.
+		size_t carryLen = f->carryLen;
+		size_t take = len < sizeof(ImuProt_t) ? len : sizeof(ImuProt_t);
+		memcpy(f->carry + carryLen, data, take);
+		size_t stop = frameScan(f, f->carry, carryLen + take, 0, carryLen, -(ptrdiff_t)carryLen,
+			packets, endOffsets, max, &count);
+		if (stop < carryLen) {
+			// Not enough data yet to complete the candidate: keep everything.
+			memmove(f->carry, f->carry + stop, carryLen + take - stop);
+			f->carryLen = carryLen + take - stop;
+			f->stats.bytes += take;
+			*consumed = take;
+			return count;
+		}
+		f->carryLen = 0;
+		pos = stop - carryLen;
+	}
+
+	pos = frameScan(f, data, len, pos, len, 0, packets, endOffsets, max, &count);
+	if (count == max && pos < len) {
+		f->stats.bytes += pos;
+		*consumed = pos;
+		return count;
+	}
+
+	// Fewer than sizeof(ImuProt_t) bytes are left: they may start the next packet.
+	memcpy(f->carry, data + pos, len - pos);
+	f->carryLen = len - pos;
+	f->stats.bytes += len;
+	*consumed = len;
+	return count;
+}
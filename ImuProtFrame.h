@@ -0,0 +1,107 @@
+/**
+ * Streaming Packet Deframer.
+ *
+ * Cuts an arbitrary byte stream (serial reads, raw capture files) into
+ * `ImuProt_t` packets. Every candidate starting with IMU_PROT_HEADER is
+ * checked with `checkImuProtBuffer`; on failure the deframer slides one byte
+ * and searches for the next header, so it resynchronizes after line noise
+ * or dropped bytes. A packet split between two reads is completed from the
+ * bytes carried over from the previous call.
+ *
+ * For every packet the offset just past its last byte within the current
+ * chunk is reported, which is what `imuTimePacket` needs.
+ */
+
+#ifndef ImuProtFrame_h_included__
+#define ImuProtFrame_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ImuProt.h"
+#include "ImuProtCrc.h"
+
+/**
+ * Deframer counters.
+ *
+ * @field packets   Valid packets.
+ * @field bytes     Bytes fed to the deframer.
+ * @field discarded Bytes skipped while searching for a valid packet.
+ * @field resyncs   Times the deframer lost synchronization.
+ * @field errors    Rejected candidates, indexed by ImuProtError_t; IMU_PROT_BAD_HEADER
+ *                  counts positions where a packet was expected after a valid one.
+ */
+typedef struct {
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t discarded;
+	uint64_t resyncs;
+	uint64_t errors[IMU_PROT_BAD_CRC + 1];
+} ImuFrameStats_t;
+
+/**
+ * Deframer state. All fields are private.
+ */
+typedef struct {
+	uint8_t carry[2 * sizeof(ImuProt_t)];
+	size_t carryLen;
+	int synced;
+	ImuFrameStats_t stats;
+} ImuFramer_t;
+
+/**
+ * @brief Same verdict as `checkImuProtBuffer`, with the table-driven packet CRC.
+ *
+ * @param p Candidate, at least sizeof(ImuProt_t) bytes, any alignment.
+ * @return ImuProtError_t IMU_PROT_OK if the candidate is a valid packet.
+ */
+static inline ImuProtError_t imuFrameCheck(const uint8_t *p)
+{
+	ImuProt_t packet;
+	memcpy(&packet, p, sizeof(packet));
+	if (packet.header != IMU_PROT_HEADER)
+		return IMU_PROT_BAD_HEADER;
+	const uint8_t sequencer = ~packet.ff_sequencer;
+	if (packet.sequencer != sequencer)
+		return IMU_PROT_BAD_SEQUENCER;
+	if (imuPacketCrc32(&packet) != packet.crc32)
+		return IMU_PROT_BAD_CRC;
+	return IMU_PROT_OK;
+}
+
+/**
+ * @brief Initializes the deframer.
+ *
+ * @param f Deframer.
+ */
+void imuFramerInit(ImuFramer_t *f);
+
+/**
+ * @brief Extracts the packets of the next chunk of the stream.
+ *
+ * Stops early when `max` packets were found; call again with the remaining
+ * bytes (`data + *consumed`). Bytes of an incomplete packet at the end of the
+ * chunk are kept and completed by the next call.
+ *
+ * @param f             Deframer.
+ * @param data          Next bytes of the stream.
+ * @param len           Number of bytes.
+ * @param packets       Output packets.
+ * @param endOffsets    Optional, receives the offset just past every packet within `data`.
+ * @param max           Capacity of the output arrays, at least 1.
+ * @param consumed      Receives the number of bytes of `data` processed.
+ * @return size_t Number of packets found.
+ */
+size_t imuFramerPush(ImuFramer_t *f, const uint8_t *data, size_t len, ImuProt_t *packets,
+	size_t *endOffsets, size_t max, size_t *consumed);
+
+/**
+ * @brief Returns the deframer counters.
+ */
+static inline const ImuFrameStats_t *imuFramerStats(const ImuFramer_t *f)
+{
+	return &f->stats;
+}
+
+#endif
@@ -0,0 +1,327 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ImuProtHex.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMU_HEX_X86 1
+#include <immintrin.h>
+#endif
+
+#define HEX_BAD 0x100
+
+// Nibble value of every character; HEX_BAD marks characters that are not hex digits.
+static uint16_t hexNibble[256];
+
+static void hexInitTable(void) {
+	for (int c = 0; c < 256; c++) {
+		if (c >= '0' && c <= '9')
+			hexNibble[c] = (uint16_t)(c - '0');
+		else if (c >= 'A' && c <= 'F')
+			hexNibble[c] = (uint16_t)(c - 'A' + 10);
+		else if (c >= 'a' && c <= 'f')
+			hexNibble[c] = (uint16_t)(c - 'a' + 10);
+		else
+			hexNibble[c] = HEX_BAD;
+	}
+}
+
+/**
+ * @brief Finds the first character that is not a hex digit.
+ *
+ * Only called on the error path, after a kernel reported a problem.
+ */
+static size_t hexFindBad(const char *hex, size_t len) {
+	size_t i;
+	for (i = 0; i < len; i++) {
+		if (hexNibble[(uint8_t)hex[i]] & HEX_BAD)
+			break;
+	}
+	return i;
+}
+
+/**
+ * @brief Table-driven decoder of `n` byte pairs.
+ *
+ * Errors are accumulated into a single OR so that the loop has no branches.
+ *
+ * @return int Non-zero if any character was invalid.
+ */
+static int hexDecodePairs(const uint8_t *in, size_t n, uint8_t *out) {
+	uint16_t bad = 0;
+	for (size_t i = 0; i < n; i++) {
+		uint16_t hi = hexNibble[in[2 * i]];
+		uint16_t lo = hexNibble[in[2 * i + 1]];
+		bad |= hi | lo;
+		out[i] = (uint8_t)((hi << 4) | lo);
+	}
+	return bad & HEX_BAD;
+}
+
+#ifdef IMU_HEX_X86
+/**
+ * @brief 128-bit decoder body: 16 characters into 8 bytes per step.
+ *
+ * Digits and letters are classified with unsigned range checks, then pairs of
+ * nibbles are merged with a single multiply-add (hi * 16 + lo). Always inlined
+ * so that the AVX2 kernel gets a VEX encoded tail without SSE/AVX transitions.
+ */
+__attribute__((target("ssse3"), always_inline))
+static inline int hexDecode128(const uint8_t *in, size_t n, uint8_t *out) {
+	const __m128i c0 = _mm_set1_epi8('0');
+	const __m128i ca = _mm_set1_epi8('a');
+	const __m128i lower = _mm_set1_epi8(0x20);
+	const __m128i nine = _mm_set1_epi8(9);
+	const __m128i five = _mm_set1_epi8(5);
+	const __m128i ten = _mm_set1_epi8(10);
+	const __m128i merge = _mm_set1_epi16(0x0110);
+	size_t i = 0;
+
+	for (; i + 8 <= n; i += 8) {
+		__m128i c = _mm_loadu_si128((const __m128i *)(in + 2 * i));
+		__m128i d = _mm_sub_epi8(c, c0);
+		__m128i l = _mm_sub_epi8(_mm_or_si128(c, lower), ca);
+		__m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+		__m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(l, five), l);
+		if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xFFFF)
+			return 1;
+		__m128i v = _mm_or_si128(_mm_and_si128(isDigit, d),
+			_mm_andnot_si128(isDigit, _mm_add_epi8(l, ten)));
+		__m128i w = _mm_maddubs_epi16(v, merge);
+		_mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(w, w));
+	}
+	return hexDecodePairs(in + 2 * i, n - i, out + i);
+}
+
+/**
+ * @brief SSSE3 decoder.
+ */
+__attribute__((target("ssse3")))
+static int hexDecodeSsse3(const uint8_t *in, size_t n, uint8_t *out) {
+	return hexDecode128(in, n, out);
+}
+
+/**
+ * @brief AVX2 decoder: 32 characters into 16 bytes per step.
+ */
+__attribute__((target("avx2")))
+static int hexDecodeAvx2(const uint8_t *in, size_t n, uint8_t *out) {
+	const __m256i c0 = _mm256_set1_epi8('0');
+	const __m256i ca = _mm256_set1_epi8('a');
+	const __m256i lower = _mm256_set1_epi8(0x20);
+	const __m256i nine = _mm256_set1_epi8(9);
+	const __m256i five = _mm256_set1_epi8(5);
+	const __m256i ten = _mm256_set1_epi8(10);
+	const __m256i merge = _mm256_set1_epi16(0x0110);
+	size_t i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m256i c = _mm256_loadu_si256((const __m256i *)(in + 2 * i));
+		__m256i d = _mm256_sub_epi8(c, c0);
+		__m256i l = _mm256_sub_epi8(_mm256_or_si256(c, lower), ca);
+		__m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(d, nine), d);
+		__m256i isAlpha = _mm256_cmpeq_epi8(_mm256_min_epu8(l, five), l);
+		if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isAlpha)) != -1)
+			return 1;
+		__m256i v = _mm256_blendv_epi8(_mm256_add_epi8(l, ten), d, isDigit);
+		__m256i w = _mm256_maddubs_epi16(v, merge);
+		// packus works per 128-bit lane, gather the two useful quadwords together.
+		__m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(w, w), 0x08);
+		_mm_storeu_si128((__m128i *)(out + i), _mm256_castsi256_si128(p));
+	}
+	return hexDecode128(in + 2 * i, n - i, out + i);
+}
+#endif
+
+typedef int (*HexKernel_t)(const uint8_t *in, size_t n, uint8_t *out);
+
+static HexKernel_t hexKernel;
+static const char *hexKernelName;
+
+__attribute__((constructor))
+static void hexSelectKernel(void) {
+	hexInitTable();
+	hexKernel = hexDecodePairs;
+	hexKernelName = "scalar";
+#ifdef IMU_HEX_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		hexKernel = hexDecodeAvx2;
+		hexKernelName = "avx2";
+	} else if (__builtin_cpu_supports("ssse3")) {
+		hexKernel = hexDecodeSsse3;
+		hexKernelName = "ssse3";
+	}
+#endif
+}
+
+const char *imuHexKernelName(void) {
+	return hexKernelName;
+}
+
+static ImuHexError_t hexDecodeWith(HexKernel_t kernel, const char *hex, size_t len,
+	uint8_t *out, size_t *errorOffset) {
+	if (len & 1) {
+		if (errorOffset)
+			*errorOffset = len - 1;
+		return IMU_HEX_ODD_LENGTH;
+	}
+	if (kernel((const uint8_t *)hex, len / 2, out)) {
+		if (errorOffset)
+			*errorOffset = hexFindBad(hex, len);
+		return IMU_HEX_BAD_CHAR;
+	}
+	return IMU_HEX_OK;
+}
+
+ImuHexError_t imuHexDecode(const char *hex, size_t len, uint8_t *out, size_t *errorOffset) {
+	return hexDecodeWith(hexKernel, hex, len, out, errorOffset);
+}
+
+ImuHexError_t imuHexDecodeScalar(const char *hex, size_t len, uint8_t *out, size_t *errorOffset) {
+	return hexDecodeWith(hexDecodePairs, hex, len, out, errorOffset);
+}
+
+#define HEX_OUT_BATCH 4096
+
+ImuHexError_t imuHexConvertBuffer(const char *text, size_t len, FILE *out, unsigned options,
+	ImuHexReport_t report, void *ctx, ImuHexStats_t *stats) {
+	ImuHexStats_t local = { 0 };
+	HexKernel_t kernel = hexKernel;
+	const char *p = text;
+	const char *end = text + len;
+	uint64_t lineNo = 0;
+	size_t count = 0;
+	ImuHexError_t result = IMU_HEX_OK;
+
+	ImuProt_t *batch = malloc(HEX_OUT_BATCH * sizeof(ImuProt_t));
+	if (!batch)
+		return IMU_HEX_IO_ERROR;
+
+	while (p < end) {
+		const char *eol = memchr(p, '\n', (size_t)(end - p));
+		const char *next = eol ? eol + 1 : end;
+		size_t lineLen = (size_t)((eol ? eol : end) - p);
+		lineNo++;
+
+		if (lineLen && p[lineLen - 1] == '\r')
+			lineLen--;
+		if (!lineLen) {
+			p = next;
+			continue;
+		}
+		local.lines++;
+
+		if (lineLen != IMU_HEX_PACKET_CHARS) {
+			local.badLength++;
+			if (report)
+				report(ctx, lineNo, 0, IMU_HEX_BAD_LENGTH, IMU_PROT_OK);
+			p = next;
+			continue;
+		}
+
+		uint8_t *packet = (uint8_t *)&batch[count];
+		if (kernel((const uint8_t *)p, sizeof(ImuProt_t), packet)) {
+			local.badChars++;
+			if (report)
+				report(ctx, lineNo, hexFindBad(p, lineLen) + 1, IMU_HEX_BAD_CHAR, IMU_PROT_OK);
+			p = next;
+			continue;
+		}
+
+		ImuProtError_t check = checkImuProtBuffer(packet);
+		local.protErrors[check]++;
+		if (check != IMU_PROT_OK && report)
+			report(ctx, lineNo, 0, IMU_HEX_OK, check);
+
+		if (check == IMU_PROT_OK || (options & IMU_HEX_KEEP_INVALID)) {
+			if (++count == HEX_OUT_BATCH) {
+				if (fwrite(batch, sizeof(ImuProt_t), count, out) != count) {
+					result = IMU_HEX_IO_ERROR;
+					break;
+				}
+				local.packets += count;
+				count = 0;
+			}
+		}
+		p = next;
+	}
+
+	if (result == IMU_HEX_OK && count) {
+		if (fwrite(batch, sizeof(ImuProt_t), count, out) != count)
+			result = IMU_HEX_IO_ERROR;
+		else
+			local.packets += count;
+	}
+	local.bytesIn = (uint64_t)(p - text);
+	free(batch);
+
+	if (stats) {
+		stats->lines += local.lines;
+		stats->packets += local.packets;
+		stats->badChars += local.badChars;
+		stats->badLength += local.badLength;
+		for (int i = 0; i < 4; i++)
+			stats->protErrors[i] += local.protErrors[i];
+		stats->bytesIn += local.bytesIn;
+	}
+	return result;
+}
+
+ImuHexError_t imuHexConvertFile(const char *inPath, const char *outPath, unsigned options,
+	ImuHexReport_t report, void *ctx, ImuHexStats_t *stats) {
+	int fd = open(inPath, O_RDONLY);
+	if (fd < 0)
+		return IMU_HEX_IO_ERROR;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return IMU_HEX_IO_ERROR;
+	}
+
+	FILE *out = fopen(outPath, "wb");
+	if (!out) {
+		close(fd);
+		return IMU_HEX_IO_ERROR;
+	}
+
+	ImuHexError_t result = IMU_HEX_OK;
+	if (st.st_size > 0) {
+		void *text = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (text == MAP_FAILED) {
+			result = IMU_HEX_IO_ERROR;
+		} else {
+			posix_madvise(text, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+			result = imuHexConvertBuffer(text, (size_t)st.st_size, out, options, report, ctx, stats);
+			munmap(text, (size_t)st.st_size);
+		}
+	}
+	close(fd);
+
+	if (fclose(out) != 0 && result == IMU_HEX_OK)
+		result = IMU_HEX_IO_ERROR;
+	return result;
+}
+
+const char *imuHexErrorToString(ImuHexError_t error) {
+	switch (error) {
+		case IMU_HEX_OK:
+			return "OK.";
+		case IMU_HEX_BAD_CHAR:
+			return "Invalid hex character!";
+		case IMU_HEX_ODD_LENGTH:
+			return "Odd number of hex characters!";
+		case IMU_HEX_BAD_LENGTH:
+			return "Line is not a single packet!";
+		case IMU_HEX_IO_ERROR:
+			return "I/O error!";
+	}
+	return "Unknown error.";
+}
@@ -0,0 +1,142 @@
+/**
+ * IMU Protocol Hex Log Decoder.
+ *
+ * Field logs keep IMU packets as text, one packet per line, written as the
+ * hexadecimal dump of the raw `ImuProt_t` bytes (80 characters per line).
+ * This module converts such logs back into binary packets.
+ *
+ * The decoder is table driven and has SSSE3 and AVX2 paths that are selected
+ * at run time on x86 CPUs. Unlike `strtol`, malformed characters are reported
+ * with their position instead of silently turning into zero.
+ */
+
+#ifndef ImuProtHex_h_included__
+#define ImuProtHex_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ImuProt.h"
+
+/** Number of hex characters in one textual packet line. */
+#define IMU_HEX_PACKET_CHARS (2 * sizeof(ImuProt_t))
+
+/** Keep packets that fail `checkImuProtBuffer` in the binary output. */
+#define IMU_HEX_KEEP_INVALID (1u << 0)
+
+/**
+ * @enum ImuHexError_t
+ * @brief Error codes reported by the hex decoder.
+ */
+typedef enum {
+	IMU_HEX_OK = 0,             // Input decoded successfully.
+	IMU_HEX_BAD_CHAR = 1,       // A character is not a hexadecimal digit.
+	IMU_HEX_ODD_LENGTH = 2,     // The number of hex characters is odd.
+	IMU_HEX_BAD_LENGTH = 3,     // A line does not hold exactly one packet.
+	IMU_HEX_IO_ERROR = 4        // Reading the input or writing the output failed.
+} ImuHexError_t;
+
+/**
+ * Statistics collected while converting a hex log.
+ *
+ * @field lines         Number of non-empty lines seen.
+ * @field packets       Number of packets written to the output.
+ * @field badChars      Lines rejected because of a non-hex character.
+ * @field badLength     Lines rejected because of a wrong length.
+ * @field protErrors    Decoded packets per `ImuProtError_t` result.
+ * @field bytesIn       Number of text bytes consumed.
+ */
+typedef struct {
+	uint64_t lines;
+	uint64_t packets;
+	uint64_t badChars;
+	uint64_t badLength;
+	uint64_t protErrors[4];
+	uint64_t bytesIn;
+} ImuHexStats_t;
+
+/**
+ * @brief Callback used to report a rejected line.
+ *
+ * @param ctx       User context passed to the converter.
+ * @param line      1-based line number in the input.
+ * @param column    1-based column of the offending character (0 if not applicable).
+ * @param error     Decoder error, or IMU_HEX_OK if the line decoded but failed validation.
+ * @param protError Packet validation result (IMU_PROT_OK when not validated).
+ */
+typedef void (*ImuHexReport_t)(void *ctx, uint64_t line, size_t column,
+	ImuHexError_t error, ImuProtError_t protError);
+
+/**
+ * @brief Decodes a string of hexadecimal characters into bytes.
+ *
+ * Both upper and lower case digits are accepted. `len / 2` bytes are written
+ * to `out`.
+ *
+ * @param hex           Pointer to the hexadecimal characters (not necessarily terminated).
+ * @param len           Number of characters, must be even.
+ * @param out           Output buffer of at least `len / 2` bytes.
+ * @param errorOffset   Optional, receives the offset of the first invalid character.
+ * @return ImuHexError_t IMU_HEX_OK, IMU_HEX_ODD_LENGTH or IMU_HEX_BAD_CHAR.
+ */
+ImuHexError_t imuHexDecode(const char *hex, size_t len, uint8_t *out, size_t *errorOffset);
+
+/**
+ * @brief Scalar, table-driven variant of `imuHexDecode`.
+ *
+ * Always available; used as reference and on CPUs without SIMD support.
+ */
+ImuHexError_t imuHexDecodeScalar(const char *hex, size_t len, uint8_t *out, size_t *errorOffset);
+
+/**
+ * @brief Returns the name of the decoder kernel selected for this CPU.
+ *
+ * @return const char* "avx2", "ssse3" or "scalar".
+ */
+const char *imuHexKernelName(void);
+
+/**
+ * @brief Converts a buffer of newline-separated packet hex into binary packets.
+ *
+ * Every line is decoded and validated with `checkImuProtBuffer`. Valid packets
+ * are written to `out`; invalid ones are dropped unless IMU_HEX_KEEP_INVALID is
+ * set. Empty lines and trailing carriage returns are ignored.
+ *
+ * @param text      Input text.
+ * @param len       Length of the input text in bytes.
+ * @param out       Output stream receiving binary packets.
+ * @param options   Bitwise OR of IMU_HEX_* option flags.
+ * @param report    Optional callback for rejected lines.
+ * @param ctx       User context for `report`.
+ * @param stats     Optional statistics, accumulated (not cleared).
+ * @return ImuHexError_t IMU_HEX_OK, or IMU_HEX_IO_ERROR if writing failed.
+ */
+ImuHexError_t imuHexConvertBuffer(const char *text, size_t len, FILE *out, unsigned options,
+	ImuHexReport_t report, void *ctx, ImuHexStats_t *stats);
+
+/**
+ * @brief Converts a hex log file into a binary packet file.
+ *
+ * The input file is memory mapped and processed with `imuHexConvertBuffer`.
+ *
+ * @param inPath    Path of the hex text log.
+ * @param outPath   Path of the binary packet file to create.
+ * @param options   Bitwise OR of IMU_HEX_* option flags.
+ * @param report    Optional callback for rejected lines.
+ * @param ctx       User context for `report`.
+ * @param stats     Optional statistics, accumulated (not cleared).
+ * @return ImuHexError_t IMU_HEX_OK, or IMU_HEX_IO_ERROR on file errors.
+ */
+ImuHexError_t imuHexConvertFile(const char *inPath, const char *outPath, unsigned options,
+	ImuHexReport_t report, void *ctx, ImuHexStats_t *stats);
+
+/**
+ * @brief Converts an ImuHexError_t error code to its string representation.
+ *
+ * @param error The ImuHexError_t error code.
+ * @return A string that describes the error.
+ */
+const char *imuHexErrorToString(ImuHexError_t error);
+
+#endif
@@ -0,0 +1,76 @@
+#include <string.h>
+
+#include "ImuProtHist.h"
+
+/**
+ * @brief Returns the highest value counted in a bucket.
+ */
+static uint64_t histBucketHigh(size_t bucket) {
+	if (bucket < 2 * IMU_HIST_SUB_BUCKETS)
+		return bucket;
+	unsigned shift = (unsigned)(bucket >> IMU_HIST_SUB_BITS) - 1;
+	uint64_t low = (uint64_t)(bucket - ((size_t)shift << IMU_HIST_SUB_BITS)) << shift;
+	return low + ((uint64_t)1 << shift) - 1;
+}
+
+void imuHistInit(ImuHist_t *h) {
+	memset(h, 0, sizeof(*h));
+	atomic_store_explicit(&h->min, UINT64_MAX, memory_order_relaxed);
+}
+
+void imuHistMerge(ImuHist_t *to, const ImuHist_t *from) {
+	for (size_t i = 0; i < IMU_HIST_BUCKETS; i++) {
+		uint64_t n = atomic_load_explicit(&from->buckets[i], memory_order_relaxed);
+		if (n)
+			imuHistBump(&to->buckets[i], n);
+	}
+	imuHistBump(&to->count, atomic_load_explicit(&from->count, memory_order_relaxed));
+	imuHistBump(&to->sum, atomic_load_explicit(&from->sum, memory_order_relaxed));
+	uint64_t min = atomic_load_explicit(&from->min, memory_order_relaxed);
+	if (min < atomic_load_explicit(&to->min, memory_order_relaxed))
+		atomic_store_explicit(&to->min, min, memory_order_relaxed);
+	uint64_t max = atomic_load_explicit(&from->max, memory_order_relaxed);
+	if (max > atomic_load_explicit(&to->max, memory_order_relaxed))
+		atomic_store_explicit(&to->max, max, memory_order_relaxed);
+}
+
+uint64_t imuHistPercentile(const ImuHist_t *h, double percentile) {
+	// Use the bucket sum, not `count`: both may be read mid-update.
+	uint64_t total = 0;
+	for (size_t i = 0; i < IMU_HIST_BUCKETS; i++)
+		total += atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+	if (!total)
+		return 0;
+
+	uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+	if (rank < 1)
+		rank = 1;
+	if (rank > total)
+		rank = total;
+	uint64_t max = atomic_load_explicit(&h->max, memory_order_relaxed);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < IMU_HIST_BUCKETS; i++) {
+		seen += atomic_load_explicit(&h->buckets[i], memory_order_relaxed);
+		if (seen >= rank) {
+			uint64_t high = histBucketHigh(i);
+			return high < max ? high : max;
+		}
+	}
+	return max;
+}
+
+void imuHistPrint(const ImuHist_t *h, FILE *out, const char *label, double divisor) {
+	uint64_t count = imuHistCount(h);
+	if (!count) {
+		fprintf(out, "%s no samples\n", label);
+		return;
+	}
+	double mean = (double)atomic_load_explicit(&h->sum, memory_order_relaxed) / (double)count;
+	fprintf(out, "%s n %llu  min %.1f  mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  p99.99 %.1f  max %.1f\n",
+		label, (unsigned long long)count,
+		atomic_load_explicit(&h->min, memory_order_relaxed) / divisor, mean / divisor,
+		imuHistPercentile(h, 50.0) / divisor, imuHistPercentile(h, 90.0) / divisor,
+		imuHistPercentile(h, 99.0) / divisor, imuHistPercentile(h, 99.9) / divisor,
+		imuHistPercentile(h, 99.99) / divisor,
+		atomic_load_explicit(&h->max, memory_order_relaxed) / divisor);
+}
@@ -0,0 +1,128 @@
+/**
+ * Log-Bucketed Latency Histogram.
+ *
+ * HDR-style histogram of 64-bit values, typically latencies in nanoseconds.
+ * Values below 2 * IMU_HIST_SUB_BUCKETS are counted exactly; above that every
+ * power of two is split into IMU_HIST_SUB_BUCKETS linear sub-buckets, so any
+ * recorded value is known to within 1 / IMU_HIST_SUB_BUCKETS (about 3 %)
+ * over the whole 64-bit range with a fixed 15 KiB of counters.
+ *
+ * Recording is lock-free and meant for one writer thread per histogram: the
+ * writer only stores relaxed atomics, which compiles to plain increments,
+ * while any other thread may merge the histogram into its own copy at any
+ * time with `imuHistMerge` and read percentiles from that copy.
+ */
+
+#ifndef ImuProtHist_h_included__
+#define ImuProtHist_h_included__
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** log2 of the number of sub-buckets per power of two. */
+#define IMU_HIST_SUB_BITS (5)
+
+/** Number of sub-buckets per power of two. */
+#define IMU_HIST_SUB_BUCKETS (1u << IMU_HIST_SUB_BITS)
+
+/** Number of buckets covering all 64-bit values. */
+#define IMU_HIST_BUCKETS ((64 - IMU_HIST_SUB_BITS + 1) << IMU_HIST_SUB_BITS)
+
+/**
+ * Histogram. All fields are private.
+ */
+typedef struct {
+	_Atomic uint64_t count;
+	_Atomic uint64_t sum;
+	_Atomic uint64_t min;
+	_Atomic uint64_t max;
+	_Atomic uint64_t buckets[IMU_HIST_BUCKETS];
+} ImuHist_t;
+
+/**
+ * @brief Returns the bucket of a value.
+ */
+static inline size_t imuHistBucket(uint64_t value)
+{
+	if (value < 2 * IMU_HIST_SUB_BUCKETS)
+		return (size_t)value;
+	unsigned shift = (unsigned)(63 - __builtin_clzll(value)) - IMU_HIST_SUB_BITS;
+	return ((size_t)shift << IMU_HIST_SUB_BITS) + (size_t)(value >> shift);
+}
+
+/**
+ * @brief Adds `delta` to a counter without a locked instruction. Only the owner thread may call it.
+ */
+static inline void imuHistBump(_Atomic uint64_t *counter, uint64_t delta)
+{
+	atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + delta,
+		memory_order_relaxed);
+}
+
+/**
+ * @brief Records a value. Only the thread owning the histogram may call it.
+ *
+ * @param h     Histogram.
+ * @param value Value to record.
+ */
+static inline void imuHistRecord(ImuHist_t *h, uint64_t value)
+{
+	imuHistBump(&h->buckets[imuHistBucket(value)], 1);
+	imuHistBump(&h->count, 1);
+	imuHistBump(&h->sum, value);
+	if (value < atomic_load_explicit(&h->min, memory_order_relaxed))
+		atomic_store_explicit(&h->min, value, memory_order_relaxed);
+	if (value > atomic_load_explicit(&h->max, memory_order_relaxed))
+		atomic_store_explicit(&h->max, value, memory_order_relaxed);
+}
+
+/**
+ * @brief Initializes an empty histogram.
+ *
+ * @param h Histogram.
+ */
+void imuHistInit(ImuHist_t *h);
+
+/**
+ * @brief Adds the counts of `from` to `to`.
+ *
+ * `from` may be recorded into concurrently by its owner; every counter is
+ * then read at a slightly different moment, which only matters for the few
+ * values recorded during the call. `to` must not be used by another thread.
+ *
+ * @param to    Destination histogram.
+ * @param from  Histogram to add.
+ */
+void imuHistMerge(ImuHist_t *to, const ImuHist_t *from);
+
+/**
+ * @brief Returns the number of recorded values.
+ */
+static inline uint64_t imuHistCount(const ImuHist_t *h)
+{
+	return atomic_load_explicit(&h->count, memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the value below which the given fraction of values lies.
+ *
+ * @param h         Histogram.
+ * @param percentile Percentile, 0 to 100.
+ * @return uint64_t Highest value of the bucket holding the percentile, clamped to
+ *                  the recorded maximum; 0 if the histogram is empty.
+ */
+uint64_t imuHistPercentile(const ImuHist_t *h, double percentile);
+
+/**
+ * @brief Prints count, minimum, mean, p50, p90, p99, p99.9, p99.99 and maximum on one line.
+ *
+ * @param h         Histogram.
+ * @param out       Output stream.
+ * @param label     Printed first.
+ * @param divisor   Values are divided by it, e.g. 1000 to print nanoseconds as microseconds.
+ */
+void imuHistPrint(const ImuHist_t *h, FILE *out, const char *label, double divisor);
+
+#endif
@@ -0,0 +1,332 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ImuProtCrc.h"
+#include "ImuProtIsa.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define ISA_X86 1
+#else
+#define ISA_X86 0
+#endif
+
+#define ISA_INLINE static inline __attribute__((always_inline))
+#define ISA_TARGET(t) static __attribute__((target(t)))
+
+#define ISA_HEADER_LO ((uint8_t)(IMU_PROT_HEADER & 0xFF))
+#define ISA_HEADER_HI ((uint8_t)(IMU_PROT_HEADER >> 8))
+#define ISA_CRC_BYTES (sizeof(ImuProt_t) - sizeof(uint32_t))
+#define ISA_GYRO_OFFSET (offsetof(ImuProt_t, data) + offsetof(ImuData_t, gyro))
+
+/**
+ * Kernels of one level.
+ */
+typedef struct {
+	void (*crcPackets)(const ImuProt_t *packets, size_t count, uint32_t *crcs);
+	size_t (*findHeader)(const uint8_t *data, size_t len);
+	void (*decodeSamples)(const ImuProt_t *packets, size_t packetStride, ImuSample_t *samples,
+		size_t sampleStride, size_t count);
+} IsaKernels_t;
+
+/*
+ * Portable bodies. They are inlined into the per-level wrappers below, so
+ * every level gets its own compilation of them.
+ */
+
+ISA_INLINE void crcPacketsGeneric(const ImuProt_t *packets, size_t count, uint32_t *crcs) {
+	uint32_t zero;
+	const uint32_t *table = imuPacketCrcTables(&zero);
+	for (size_t k = 0; k < count; k++) {
+		const uint8_t *p = (const uint8_t *)&packets[k];
+		uint32_t crc = zero;
+		for (size_t i = 0; i < ISA_CRC_BYTES; i++)
+			crc ^= table[i * 256 + p[i]];
+		crcs[k] = crc;
+	}
+}
+
+ISA_INLINE size_t findHeaderGeneric(const uint8_t *data, size_t pos, size_t len) {
+	for (; pos < len; pos++) {
+		if (data[pos] == ISA_HEADER_LO && (pos + 1 == len || data[pos + 1] == ISA_HEADER_HI))
+			return pos;
+	}
+	return len;
+}
+
+ISA_INLINE void decodeSamplesGeneric(const ImuProt_t *packets, size_t packetStride, ImuSample_t *samples,
+	size_t sampleStride, size_t count) {
+	for (size_t k = 0; k < count; k++)
+		imuDecodeSample((const ImuProt_t *)((const uint8_t *)packets + k * packetStride),
+			(ImuSample_t *)((uint8_t *)samples + k * sampleStride));
+}
+
+/**
+ * @brief Fills the fields that are not vectorized.
+ */
+ISA_INLINE void decodeScalarFields(const ImuProt_t *packet, ImuSample_t *sample) {
+	sample->temperature = tempFromKelvin(packet->data.temperature);
+	sample->flags = packet->data.flags;
+	sample->sequencer = packet->sequencer;
+}
+
+static void crcPacketsBaseline(const ImuProt_t *packets, size_t count, uint32_t *crcs) {
+	crcPacketsGeneric(packets, count, crcs);
+}
+
+static void decodeSamplesBaseline(const ImuProt_t *packets, size_t packetStride, ImuSample_t *samples,
+	size_t sampleStride, size_t count) {
+	decodeSamplesGeneric(packets, packetStride, samples, sampleStride, count);
+}
+
+#if ISA_X86
+
+/*
+ * x86-64 baseline and x86-64-v2: 16-byte header scan with SSE2.
+ */
+
+ISA_INLINE size_t findHeaderSse2Body(const uint8_t *data, size_t len) {
+	const __m128i lo = _mm_set1_epi8((char)ISA_HEADER_LO);
+	const __m128i hi = _mm_set1_epi8((char)ISA_HEADER_HI);
+	size_t pos = 0;
+	for (; pos + 17 <= len; pos += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(data + pos));
+		__m128i b = _mm_loadu_si128((const __m128i *)(data + pos + 1));
+		unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, lo), _mm_cmpeq_epi8(b, hi)));
+		if (mask)
+			return pos + (size_t)__builtin_ctz(mask);
+	}
+	return findHeaderGeneric(data, pos, len);
+}
+
+static size_t findHeaderBaseline(const uint8_t *data, size_t len) {
+	return findHeaderSse2Body(data, len);
+}
+
+/*
+ * x86-64-v2 and up, with PCLMULQDQ: carry-less multiply CRC.
+ *
+ * The CRC register starts from zero for the table part of the packet CRC,
+ * so leading zero bytes leave it unchanged: the 36 checksummed bytes are
+ * taken as a 48-byte message led by 12 zero bytes, folded 16 bytes at a time
+ * and Barrett-reduced to 32 bits, with the bit-reflected constants of Intel's
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ".
+ */
+
+ISA_INLINE __attribute__((target("sse4.1,pclmul"))) void crcPacketsClmulBody(const ImuProt_t *packets, size_t count, uint32_t *crcs) {
+	uint32_t zero;
+	imuPacketCrcTables(&zero);
+	const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+	const __m128i k5k0 = _mm_set_epi64x(0, 0x0163cd6124);
+	const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+	const __m128i low32 = _mm_setr_epi32(-1, 0, -1, 0);
+	for (size_t k = 0; k < count; k++) {
+		const uint8_t *p = (const uint8_t *)&packets[k];
+		int32_t head;
+		memcpy(&head, p, sizeof(head));
+		__m128i x = _mm_slli_si128(_mm_cvtsi32_si128(head), 12);
+		for (size_t pos = 4; pos < ISA_CRC_BYTES; pos += 16) {
+			__m128i lo = _mm_clmulepi64_si128(x, k3k4, 0x00);
+			__m128i hi = _mm_clmulepi64_si128(x, k3k4, 0x11);
+			x = _mm_xor_si128(_mm_xor_si128(lo, hi), _mm_loadu_si128((const __m128i *)(p + pos)));
+		}
+		// 128 to 64 bits.
+		x = _mm_xor_si128(_mm_srli_si128(x, 8), _mm_clmulepi64_si128(x, k3k4, 0x10));
+		x = _mm_xor_si128(_mm_srli_si128(x, 4), _mm_clmulepi64_si128(_mm_and_si128(x, low32), k5k0, 0x00));
+		// Barrett reduction to 32 bits.
+		__m128i t = _mm_clmulepi64_si128(_mm_and_si128(x, low32), poly, 0x10);
+		t = _mm_clmulepi64_si128(_mm_and_si128(t, low32), poly, 0x00);
+		crcs[k] = zero ^ (uint32_t)_mm_extract_epi32(_mm_xor_si128(x, t), 1);
+	}
+}
+
+ISA_TARGET("arch=x86-64-v2,pclmul") void crcPacketsSse42(const ImuProt_t *packets, size_t count,
+	uint32_t *crcs) {
+	crcPacketsClmulBody(packets, count, crcs);
+}
+
+ISA_TARGET("arch=x86-64-v2") size_t findHeaderSse42(const uint8_t *data, size_t len) {
+	return findHeaderSse2Body(data, len);
+}
+
+ISA_TARGET("arch=x86-64-v2") void decodeSamplesSse42(const ImuProt_t *packets, size_t packetStride,
+	ImuSample_t *samples, size_t sampleStride, size_t count) {
+	decodeSamplesGeneric(packets, packetStride, samples, sampleStride, count);
+}
+
+/*
+ * x86-64-v3: AVX2.
+ */
+
+ISA_TARGET("arch=x86-64-v3,pclmul") void crcPacketsAvx2(const ImuProt_t *packets, size_t count,
+	uint32_t *crcs) {
+	crcPacketsClmulBody(packets, count, crcs);
+}
+
+ISA_TARGET("arch=x86-64-v3") size_t findHeaderAvx2(const uint8_t *data, size_t len) {
+	const __m256i lo = _mm256_set1_epi8((char)ISA_HEADER_LO);
+	const __m256i hi = _mm256_set1_epi8((char)ISA_HEADER_HI);
+	size_t pos = 0;
+	for (; pos + 33 <= len; pos += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(data + pos));
+		__m256i b = _mm256_loadu_si256((const __m256i *)(data + pos + 1));
+		unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, lo),
+			_mm256_cmpeq_epi8(b, hi)));
+		if (mask)
+			return pos + (size_t)__builtin_ctz(mask);
+	}
+	return findHeaderGeneric(data, pos, len);
+}
+
+ISA_TARGET("arch=x86-64-v3") void decodeSamplesAvx2(const ImuProt_t *packets, size_t packetStride,
+	ImuSample_t *samples, size_t sampleStride, size_t count) {
+	// gyro[3] and accl[3] are adjacent in both the packet and the sample.
+	const __m256i six = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+	const __m256 scale = _mm256_set1_ps(IMU_PROT_SCALE);
+	for (size_t k = 0; k < count; k++) {
+		const ImuProt_t *packet = (const ImuProt_t *)((const uint8_t *)packets + k * packetStride);
+		ImuSample_t *sample = (ImuSample_t *)((uint8_t *)samples + k * sampleStride);
+		__m256i raw = _mm256_maskload_epi32((const int *)((const uint8_t *)packet + ISA_GYRO_OFFSET), six);
+		_mm256_maskstore_ps(sample->gyro, six, _mm256_mul_ps(_mm256_cvtepi32_ps(raw), scale));
+		decodeScalarFields(packet, sample);
+	}
+}
+
+/*
+ * x86-64-v4: AVX-512.
+ */
+
+ISA_TARGET("arch=x86-64-v4,pclmul") void crcPacketsAvx512(const ImuProt_t *packets, size_t count,
+	uint32_t *crcs) {
+	crcPacketsClmulBody(packets, count, crcs);
+}
+
+ISA_TARGET("arch=x86-64-v4") size_t findHeaderAvx512(const uint8_t *data, size_t len) {
+	const __m512i lo = _mm512_set1_epi8((char)ISA_HEADER_LO);
+	const __m512i hi = _mm512_set1_epi8((char)ISA_HEADER_HI);
+	size_t pos = 0;
+	for (; pos + 65 <= len; pos += 64) {
+		__m512i a = _mm512_loadu_si512((const void *)(data + pos));
+		__m512i b = _mm512_loadu_si512((const void *)(data + pos + 1));
+		__mmask64 mask = _mm512_cmpeq_epi8_mask(a, lo) & _mm512_cmpeq_epi8_mask(b, hi);
+		if (mask)
+			return pos + (size_t)__builtin_ctzll(mask);
+	}
+	return findHeaderAvx2(data + pos, len - pos) + pos;
+}
+
+ISA_TARGET("arch=x86-64-v4") void decodeSamplesAvx512(const ImuProt_t *packets, size_t packetStride,
+	ImuSample_t *samples, size_t sampleStride, size_t count) {
+	const __m256 scale = _mm256_set1_ps(IMU_PROT_SCALE);
+	for (size_t k = 0; k < count; k++) {
+		const ImuProt_t *packet = (const ImuProt_t *)((const uint8_t *)packets + k * packetStride);
+		ImuSample_t *sample = (ImuSample_t *)((uint8_t *)samples + k * sampleStride);
+		__m256i raw = _mm256_maskz_loadu_epi32(0x3F, (const uint8_t *)packet + ISA_GYRO_OFFSET);
+		_mm256_mask_storeu_ps(sample->gyro, 0x3F, _mm256_mul_ps(_mm256_cvtepi32_ps(raw), scale));
+		decodeScalarFields(packet, sample);
+	}
+}
+
+static const IsaKernels_t isaTable[IMU_ISA_COUNT] = {
+	{ crcPacketsBaseline, findHeaderBaseline, decodeSamplesBaseline },
+	{ crcPacketsSse42, findHeaderSse42, decodeSamplesSse42 },
+	{ crcPacketsAvx2, findHeaderAvx2, decodeSamplesAvx2 },
+	{ crcPacketsAvx512, findHeaderAvx512, decodeSamplesAvx512 },
+};
+
+static int isaSupported(ImuIsa_t isa) {
+	__builtin_cpu_init();
+	switch (isa) {
+	case IMU_ISA_BASELINE:
+		return 1;
+	case IMU_ISA_SSE42:
+		return __builtin_cpu_supports("x86-64-v2") && __builtin_cpu_supports("pclmul");
+	case IMU_ISA_AVX2:
+		return __builtin_cpu_supports("x86-64-v3") && __builtin_cpu_supports("pclmul");
+	case IMU_ISA_AVX512:
+		return __builtin_cpu_supports("x86-64-v4") && __builtin_cpu_supports("pclmul");
+	default:
+		return 0;
+	}
+}
+
+#else
+
+static size_t findHeaderBaseline(const uint8_t *data, size_t len) {
+	return findHeaderGeneric(data, 0, len);
+}
+
+static const IsaKernels_t isaTable[1] = {
+	{ crcPacketsBaseline, findHeaderBaseline, decodeSamplesBaseline },
+};
+
+static int isaSupported(ImuIsa_t isa) {
+	return isa == IMU_ISA_BASELINE;
+}
+
+#endif
+
+static const char *const isaNames[IMU_ISA_COUNT] = { "baseline", "sse4.2", "avx2", "avx512" };
+
+static const IsaKernels_t *isaKernels = &isaTable[0];
+static ImuIsa_t isaActive = IMU_ISA_BASELINE;
+
+__attribute__((constructor))
+static void isaInit(void) {
+	ImuIsa_t isa = imuIsaDetect();
+	const char *name = getenv("IMU_ISA");
+	ImuIsa_t pinned;
+	if (name && imuIsaParse(name, &pinned) == 0 && isaSupported(pinned))
+		isa = pinned;
+	imuIsaSelect(isa);
+}
+
+void imuCrcPackets(const ImuProt_t *packets, size_t count, uint32_t *crcs) {
+	isaKernels->crcPackets(packets, count, crcs);
+}
+
+size_t imuFindHeader(const uint8_t *data, size_t len) {
+	return isaKernels->findHeader(data, len);
+}
+
+void imuDecodeSamples(const ImuProt_t *packets, size_t packetStride, ImuSample_t *samples,
+	size_t sampleStride, size_t count) {
+	isaKernels->decodeSamples(packets, packetStride, samples, sampleStride, count);
+}
+
+ImuIsa_t imuIsaDetect(void) {
+	ImuIsa_t best = IMU_ISA_BASELINE;
+	for (int isa = IMU_ISA_BASELINE + 1; isa < IMU_ISA_COUNT; isa++) {
+		if (isaSupported((ImuIsa_t)isa))
+			best = (ImuIsa_t)isa;
+	}
+	return best;
+}
+
+ImuIsa_t imuIsaActive(void) {
+	return isaActive;
+}
+
+int imuIsaSelect(ImuIsa_t isa) {
+	if ((unsigned)isa >= IMU_ISA_COUNT || !isaSupported(isa))
+		return -1;
+	isaKernels = &isaTable[isa];
+	isaActive = isa;
+	return 0;
+}
+
+const char *imuIsaName(ImuIsa_t isa) {
+	return (unsigned)isa < IMU_ISA_COUNT ? isaNames[isa] : "unknown";
+}
+
+int imuIsaParse(const char *name, ImuIsa_t *isa) {
+	for (int i = 0; i < IMU_ISA_COUNT; i++) {
+		if (!strcmp(name, isaNames[i])) {
+			*isa = (ImuIsa_t)i;
+			return 0;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,113 @@
+/**
+ * Per-ISA Kernels with Runtime Dispatch.
+ *
+ * The hot kernels are compiled several times in one binary, once per x86-64
+ * ISA level, with function target attributes instead of global compiler
+ * flags, so one build runs on every CPU generation of a fleet:
+ *
+ * - IMU_ISA_BASELINE: x86-64 (SSE2), also the only level on other CPUs.
+ * - IMU_ISA_SSE42:    x86-64-v2 (SSE4.2, POPCNT) and PCLMULQDQ: packet CRC
+ *                     by carry-less multiplication.
+ * - IMU_ISA_AVX2:     x86-64-v3 (AVX2, BMI, BMI2, FMA, F16C, LZCNT, MOVBE)
+ *                     and PCLMULQDQ: 32-byte header scan, masked decode.
+ * - IMU_ISA_AVX512:   x86-64-v4 (AVX-512 F/BW/CD/DQ/VL) and PCLMULQDQ:
+ *                     64-byte header scan.
+ *
+ * The best level supported by the CPU is chosen once at startup and the
+ * kernels are called through a dispatch table. The IMU_ISA environment
+ * variable ("baseline", "sse4.2", "avx2", "avx512") or `imuIsaSelect`
+ * (`--isa` of the tools) pins a lower level for benchmarking or
+ * troubleshooting. All levels return identical results.
+ */
+
+#ifndef ImuProtIsa_h_included__
+#define ImuProtIsa_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtSample.h"
+
+/**
+ * @enum ImuIsa_t
+ * @brief Instruction set levels of the kernels.
+ */
+typedef enum {
+	IMU_ISA_BASELINE = 0,   // x86-64 baseline, or portable C.
+	IMU_ISA_SSE42 = 1,      // x86-64-v2 and PCLMULQDQ.
+	IMU_ISA_AVX2 = 2,       // x86-64-v3 and PCLMULQDQ.
+	IMU_ISA_AVX512 = 3,     // x86-64-v4 and PCLMULQDQ.
+	IMU_ISA_COUNT = 4
+} ImuIsa_t;
+
+/**
+ * @brief Computes the CRC32 field of many packets, same result as `imuPacketCrc32`.
+ *
+ * @param packets   Packets whose first 36 bytes are checksummed.
+ * @param count     Number of packets.
+ * @param crcs      Output, one CRC per packet.
+ */
+void imuCrcPackets(const ImuProt_t *packets, size_t count, uint32_t *crcs);
+
+/**
+ * @brief Finds the next IMU_PROT_HEADER in a byte stream.
+ *
+ * A header low byte in the last position counts as a match, since the
+ * high byte may follow in the next chunk.
+ *
+ * @param data  Bytes to search.
+ * @param len   Number of bytes.
+ * @return size_t Offset of the first header, `len` if there is none.
+ */
+size_t imuFindHeader(const uint8_t *data, size_t len);
+
+/**
+ * @brief Decodes many packets, same result as `imuDecodeSample`.
+ *
+ * Strides allow decoding packets and samples embedded in larger items.
+ *
+ * @param packets       First packet.
+ * @param packetStride  Bytes from one packet to the next.
+ * @param samples       First output sample.
+ * @param sampleStride  Bytes from one sample to the next.
+ * @param count         Number of packets.
+ */
+void imuDecodeSamples(const ImuProt_t *packets, size_t packetStride, ImuSample_t *samples,
+	size_t sampleStride, size_t count);
+
+/**
+ * @brief Returns the best level supported by the CPU.
+ */
+ImuIsa_t imuIsaDetect(void);
+
+/**
+ * @brief Returns the level the kernels currently run at.
+ */
+ImuIsa_t imuIsaActive(void);
+
+/**
+ * @brief Switches the kernels to another level.
+ *
+ * Not thread-safe: call it at startup, before other threads use the kernels.
+ *
+ * @param isa Level.
+ * @return int 0 on success, -1 if the CPU or the build does not support the level.
+ */
+int imuIsaSelect(ImuIsa_t isa);
+
+/**
+ * @brief Returns the name of a level, e.g. "avx2".
+ */
+const char *imuIsaName(ImuIsa_t isa);
+
+/**
+ * @brief Parses a level name as returned by `imuIsaName`.
+ *
+ * @param name  Name.
+ * @param isa   Receives the level.
+ * @return int 0 on success, -1 if the name is unknown.
+ */
+int imuIsaParse(const char *name, ImuIsa_t *isa);
+
+#endif
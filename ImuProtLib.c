@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ImuProtIsa.h"
+#include "ImuProtLib.h"
+
+#define LIB_HEADER_LO ((uint8_t)(IMU_PROT_HEADER & 0xFF))
+#define LIB_HEADER_HI ((uint8_t)(IMU_PROT_HEADER >> 8))
+
+/** Packets validated per CRC kernel call. */
+#define LIB_BATCH (256)
+
+struct ImuLibFramer {
+	ImuFramer_t framer;
+};
+
+struct ImuLibRecorder {
+	ImuRecWriter_t writer;
+};
+
+struct ImuLibReader {
+	ImuRecReader_t reader;
+};
+
+uint32_t imuLibVersion(void) {
+	return IMU_LIB_VERSION;
+}
+
+const char *imuLibIsa(void) {
+	return imuIsaName(imuIsaActive());
+}
+
+size_t imuLibValidate(const void *packets, size_t count, uint8_t *errors) {
+	const uint8_t *bytes = packets;
+	const ImuProt_t *batch = packets;
+	uint32_t crcs[LIB_BATCH];
+	size_t valid = 0;
+	for (size_t i = 0; i < count; i += LIB_BATCH) {
+		size_t n = count - i < LIB_BATCH ? count - i : LIB_BATCH;
+		imuCrcPackets(batch + i, n, crcs);
+		for (size_t k = 0; k < n; k++) {
+			const uint8_t *p = bytes + (i + k) * sizeof(ImuProt_t);
+			ImuProtError_t error = IMU_PROT_OK;
+			uint8_t sequencer = (uint8_t)~p[offsetof(ImuProt_t, ff_sequencer)];
+			uint32_t crc;
+			memcpy(&crc, p + offsetof(ImuProt_t, crc32), sizeof(crc));
+			if (p[0] != LIB_HEADER_LO || p[1] != LIB_HEADER_HI)
+				error = IMU_PROT_BAD_HEADER;
+			else if (p[offsetof(ImuProt_t, sequencer)] != sequencer)
+				error = IMU_PROT_BAD_SEQUENCER;
+			else if (crc != crcs[k])
+				error = IMU_PROT_BAD_CRC;
+			if (errors)
+				errors[i + k] = (uint8_t)error;
+			valid += error == IMU_PROT_OK;
+		}
+	}
+	return valid;
+}
+
+void imuLibDecode(const void *packets, size_t count, ImuSample_t *samples) {
+	imuDecodeSamples(packets, sizeof(ImuProt_t), samples, sizeof(ImuSample_t), count);
+}
+
+ImuLibFramer_t *imuLibFramerCreate(void) {
+	ImuLibFramer_t *f = malloc(sizeof(*f));
+	if (f)
+		imuFramerInit(&f->framer);
+	return f;
+}
+
+size_t imuLibFramerPush(ImuLibFramer_t *f, const uint8_t *data, size_t len, ImuProt_t *packets,
+	size_t *endOffsets, size_t max, size_t *consumed) {
+	return imuFramerPush(&f->framer, data, len, packets, endOffsets, max, consumed);
+}
+
+void imuLibFramerStats(const ImuLibFramer_t *f, ImuFrameStats_t *stats) {
+	*stats = *imuFramerStats(&f->framer);
+}
+
+void imuLibFramerDestroy(ImuLibFramer_t *f) {
+	free(f);
+}
+
+ImuRecError_t imuLibRecorderOpen(const char *path, uint32_t chunkRecords, ImuLibRecorder_t **r) {
+	*r = malloc(sizeof(**r));
+	if (!*r)
+		return IMU_REC_NO_MEMORY;
+	ImuRecError_t result = imuRecWriterOpen(&(*r)->writer, path, chunkRecords);
+	if (result != IMU_REC_OK) {
+		free(*r);
+		*r = NULL;
+	}
+	return result;
+}
+
+ImuRecError_t imuLibRecorderWrite(ImuLibRecorder_t *r, const ImuProt_t *packets, const uint64_t *rxTimeNs,
+	size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		ImuRecError_t result = imuRecWrite(&r->writer, &packets[i], rxTimeNs[i]);
+		if (result != IMU_REC_OK)
+			return result;
+	}
+	return IMU_REC_OK;
+}
+
+ImuRecError_t imuLibRecorderClose(ImuLibRecorder_t *r) {
+	if (!r)
+		return IMU_REC_OK;
+	ImuRecError_t result = imuRecWriterClose(&r->writer);
+	free(r);
+	return result;
+}
+
+ImuRecError_t imuLibReaderOpen(const char *path, ImuLibReader_t **r) {
+	*r = malloc(sizeof(**r));
+	if (!*r)
+		return IMU_REC_NO_MEMORY;
+	ImuRecError_t result = imuRecReaderOpen(&(*r)->reader, path);
+	if (result != IMU_REC_OK) {
+		free(*r);
+		*r = NULL;
+	}
+	return result;
+}
+
+uint64_t imuLibReaderCount(const ImuLibReader_t *r) {
+	return imuRecCount(&r->reader);
+}
+
+uint64_t imuLibReaderFindTime(const ImuLibReader_t *r, uint64_t timeNs) {
+	return imuRecFindTime(&r->reader, timeNs);
+}
+
+size_t imuLibReaderRead(const ImuLibReader_t *r, uint64_t index, ImuRecRecord_t *records, size_t max) {
+	ImuRecCursor_t cursor;
+	imuRecSeek(&r->reader, &cursor, index);
+	size_t copied = 0;
+	while (copied < max) {
+		size_t n;
+		const ImuRecRecord_t *run = imuRecNextRun(&r->reader, &cursor, max - copied, &n);
+		if (!run)
+			break;
+		memcpy(records + copied, run, n * sizeof(ImuRecRecord_t));
+		copied += n;
+	}
+	return copied;
+}
+
+void imuLibReaderClose(ImuLibReader_t *r) {
+	if (!r)
+		return;
+	imuRecReaderClose(&r->reader);
+	free(r);
+}
+
+const char *imuLibErrorToString(ImuRecError_t error) {
+	return imuRecErrorToString(error);
+}
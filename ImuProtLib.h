@@ -0,0 +1,174 @@
+/**
+ * Stable C ABI of libimuprot.
+ *
+ * `libimuprot.so` exports only the functions of this header, under the
+ * symbol version IMUPROT_1.0 (see `libimuprot.map`). State lives behind
+ * opaque handles, so internal structures may change between releases, and
+ * the validation and decoding kernels run through the runtime ISA dispatch
+ * of `ImuProtIsa.h`. Installing a newer `libimuprot.so.1` therefore upgrades
+ * every service linked against it without a rebuild.
+ *
+ * The structures passed by value or pointer here (`ImuProt_t`,
+ * `ImuSample_t`, `ImuFrameStats_t`, `ImuRecRecord_t`) are frozen for ABI
+ * version 1. Incompatible changes get a new symbol version; existing
+ * versions keep their behavior.
+ *
+ * `libimuprot.a` contains the same functions plus the full internal API
+ * of the other headers.
+ */
+
+#ifndef ImuProtLib_h_included__
+#define ImuProtLib_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtFrame.h"
+#include "ImuProtRec.h"
+#include "ImuProtSample.h"
+
+#define IMU_LIB_VERSION_MAJOR (1)
+#define IMU_LIB_VERSION_MINOR (0)
+
+/** Version this header describes, compare with `imuLibVersion`. */
+#define IMU_LIB_VERSION ((IMU_LIB_VERSION_MAJOR << 16) | IMU_LIB_VERSION_MINOR)
+
+/** Opaque streaming deframer. */
+typedef struct ImuLibFramer ImuLibFramer_t;
+
+/** Opaque recording writer. */
+typedef struct ImuLibRecorder ImuLibRecorder_t;
+
+/** Opaque recording reader. */
+typedef struct ImuLibReader ImuLibReader_t;
+
+/**
+ * @brief Returns the version of the loaded library, major in the high 16 bits.
+ *
+ * A consumer built against IMU_LIB_VERSION runs with any library of the
+ * same major version and an equal or higher minor version.
+ */
+uint32_t imuLibVersion(void);
+
+/**
+ * @brief Returns the ISA level the kernels run at, e.g. "avx2".
+ */
+const char *imuLibIsa(void);
+
+/**
+ * @brief Validates consecutive packets, same verdict as `checkImuProtBuffer`.
+ *
+ * @param packets   `count` packets of sizeof(ImuProt_t) bytes, any alignment.
+ * @param count     Number of packets.
+ * @param errors    Optional, receives the ImuProtError_t of every packet.
+ * @return size_t Number of valid packets.
+ */
+size_t imuLibValidate(const void *packets, size_t count, uint8_t *errors);
+
+/**
+ * @brief Decodes consecutive packets, same result as `imuDecodeSample`.
+ *
+ * @param packets   `count` packets, any alignment.
+ * @param count     Number of packets.
+ * @param samples   Output, `count` samples.
+ */
+void imuLibDecode(const void *packets, size_t count, ImuSample_t *samples);
+
+/**
+ * @brief Creates a deframer, see `ImuProtFrame.h`.
+ *
+ * @return ImuLibFramer_t* The deframer, NULL if out of memory.
+ */
+ImuLibFramer_t *imuLibFramerCreate(void);
+
+/**
+ * @brief Extracts the packets of the next chunk of the stream, see `imuFramerPush`.
+ */
+size_t imuLibFramerPush(ImuLibFramer_t *f, const uint8_t *data, size_t len, ImuProt_t *packets,
+	size_t *endOffsets, size_t max, size_t *consumed);
+
+/**
+ * @brief Copies the deframer counters.
+ *
+ * @param f     Deframer.
+ * @param stats Output.
+ */
+void imuLibFramerStats(const ImuLibFramer_t *f, ImuFrameStats_t *stats);
+
+/**
+ * @brief Destroys a deframer. NULL is ignored.
+ */
+void imuLibFramerDestroy(ImuLibFramer_t *f);
+
+/**
+ * @brief Creates a recording, see `imuRecWriterOpen`.
+ *
+ * @param path          Path of the file, truncated if it exists.
+ * @param chunkRecords  Records per chunk, 0 for the default.
+ * @param r             Receives the writer.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuLibRecorderOpen(const char *path, uint32_t chunkRecords, ImuLibRecorder_t **r);
+
+/**
+ * @brief Appends packets to a recording.
+ *
+ * @param r         Writer.
+ * @param packets   Packets.
+ * @param rxTimeNs  Receive time of every packet, non-decreasing.
+ * @param count     Number of packets.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuLibRecorderWrite(ImuLibRecorder_t *r, const ImuProt_t *packets, const uint64_t *rxTimeNs,
+	size_t count);
+
+/**
+ * @brief Writes the index and closes a recording. NULL is ignored.
+ *
+ * @param r Writer.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuLibRecorderClose(ImuLibRecorder_t *r);
+
+/**
+ * @brief Opens a recording for reading, see `imuRecReaderOpen`.
+ *
+ * @param path  Path of the file.
+ * @param r     Receives the reader.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuLibReaderOpen(const char *path, ImuLibReader_t **r);
+
+/**
+ * @brief Returns the number of records.
+ */
+uint64_t imuLibReaderCount(const ImuLibReader_t *r);
+
+/**
+ * @brief Finds the first record received at or after the given time, `imuLibReaderCount` if none.
+ */
+uint64_t imuLibReaderFindTime(const ImuLibReader_t *r, uint64_t timeNs);
+
+/**
+ * @brief Copies consecutive records.
+ *
+ * @param r         Reader.
+ * @param index     Global index of the first record.
+ * @param records   Output.
+ * @param max       Capacity of `records`.
+ * @return size_t Number of records copied, less than `max` at the end of the recording.
+ */
+size_t imuLibReaderRead(const ImuLibReader_t *r, uint64_t index, ImuRecRecord_t *records, size_t max);
+
+/**
+ * @brief Closes a reader. NULL is ignored.
+ */
+void imuLibReaderClose(ImuLibReader_t *r);
+
+/**
+ * @brief Converts an ImuRecError_t error code to its string representation.
+ */
+const char *imuLibErrorToString(ImuRecError_t error);
+
+#endif
@@ -0,0 +1,604 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ImuProtCrc.h"
+#include "ImuProtIsa.h"
+#include "ImuProtLog.h"
+
+_Static_assert(sizeof(ImuLogFileHeader_t) == 16, "file header layout");
+_Static_assert(sizeof(ImuLogBlockHeader_t) == 56, "block header layout");
+
+// Column mode byte: predictor in bit 0, packing in bit 1.
+#define MODE_DELTA 0x00
+#define MODE_FOR 0x01
+#define MODE_VARINT 0x00
+#define MODE_BITPACK 0x02
+
+static inline uint32_t zigzag(uint32_t d) {
+	return (d << 1) ^ (uint32_t)-(int32_t)(d >> 31);
+}
+
+static inline uint32_t unzigzag(uint32_t z) {
+	return (z >> 1) ^ (uint32_t)-(int32_t)(z & 1);
+}
+
+static inline size_t varintSize(uint32_t v) {
+	return v < (1u << 7) ? 1 : v < (1u << 14) ? 2 : v < (1u << 21) ? 3 : v < (1u << 28) ? 4 : 5;
+}
+
+static inline unsigned bitWidth(uint32_t v) {
+	return v ? 32 - (unsigned)__builtin_clz(v) : 0;
+}
+
+static uint8_t *putVarint(uint8_t *p, uint32_t v) {
+	while (v >= 0x80) {
+		*p++ = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (uint8_t)v;
+	return p;
+}
+
+/**
+ * @brief Decodes `n` varints, returns the position after the last one or NULL on overrun.
+ */
+static const uint8_t *getVarints(const uint8_t *p, const uint8_t *end, uint32_t *v, size_t n) {
+	size_t i = 0;
+	while (i < n) {
+		// Fast path: eight single-byte varints in a row.
+		if (n - i >= 8 && end - p >= 8) {
+			uint64_t w;
+			memcpy(&w, p, sizeof(w));
+			if (!(w & 0x8080808080808080ull)) {
+				for (int k = 0; k < 8; k++)
+					v[i + k] = (uint8_t)(w >> (8 * k));
+				i += 8;
+				p += 8;
+				continue;
+			}
+		}
+
+		uint32_t x = 0;
+		unsigned shift = 0;
+		for (;;) {
+			if (p == end || shift > 28)
+				return NULL;
+			uint8_t b = *p++;
+			x |= (uint32_t)(b & 0x7F) << shift;
+			if (!(b & 0x80))
+				break;
+			shift += 7;
+		}
+		v[i++] = x;
+	}
+	return p;
+}
+
+static uint8_t *packBits(uint8_t *p, const uint32_t *v, size_t n, unsigned width) {
+	uint64_t acc = 0;
+	unsigned bits = 0;
+	if (!width)
+		return p;
+	for (size_t i = 0; i < n; i++) {
+		acc |= (uint64_t)v[i] << bits;
+		bits += width;
+		while (bits >= 8) {
+			*p++ = (uint8_t)acc;
+			acc >>= 8;
+			bits -= 8;
+		}
+	}
+	if (bits)
+		*p++ = (uint8_t)acc;
+	return p;
+}
+
+/**
+ * @brief Unpacks `n` values of `width` bits; `bytes` must cover all of them.
+ *
+ * Every value is extracted from an unaligned 64-bit window, only the last few
+ * values near the end of the buffer fall back to a partial load.
+ */
+static void unpackBits(const uint8_t *p, size_t bytes, uint32_t *v, size_t n, unsigned width) {
+	const uint64_t mask = width == 32 ? 0xFFFFFFFFu : (((uint64_t)1 << width) - 1);
+	size_t bit = 0, i = 0;
+	if (!width) {
+		memset(v, 0, n * sizeof(*v));
+		return;
+	}
+	for (; i < n && (bit >> 3) + 8 <= bytes; i++, bit += width) {
+		uint64_t w;
+		memcpy(&w, p + (bit >> 3), sizeof(w));
+		v[i] = (uint32_t)((w >> (bit & 7)) & mask);
+	}
+	for (; i < n; i++, bit += width) {
+		uint64_t w = 0;
+		memcpy(&w, p + (bit >> 3), bytes - (bit >> 3));
+		v[i] = (uint32_t)((w >> (bit & 7)) & mask);
+	}
+}
+
+/**
+ * @brief Extracts the raw values of one column.
+ */
+static void extractColumn(const ImuProt_t *packets, size_t n, int column, uint32_t *v) {
+	size_t i;
+	switch (column) {
+		case IMU_LOG_COL_SEQUENCER:
+			for (i = 0; i < n; i++)
+				v[i] = packets[i].sequencer;
+			break;
+		case IMU_LOG_COL_MUX:
+			for (i = 0; i < n; i++)
+				v[i] = packets[i].data.mux;
+			break;
+		case IMU_LOG_COL_FLAGS:
+			for (i = 0; i < n; i++)
+				v[i] = packets[i].data.flags;
+			break;
+		case IMU_LOG_COL_TEMPERATURE:
+			for (i = 0; i < n; i++)
+				v[i] = packets[i].data.temperature;
+			break;
+		case IMU_LOG_COL_GYRO_X:
+		case IMU_LOG_COL_GYRO_Y:
+		case IMU_LOG_COL_GYRO_Z:
+			for (i = 0; i < n; i++)
+				v[i] = (uint32_t)packets[i].data.gyro[column - IMU_LOG_COL_GYRO_X];
+			break;
+		default:
+			for (i = 0; i < n; i++)
+				v[i] = (uint32_t)packets[i].data.accl[column - IMU_LOG_COL_ACCL_X];
+			break;
+	}
+}
+
+/**
+ * @brief Replaces raw values by zigzagged prediction residuals.
+ *
+ * @param column    Column being encoded.
+ * @param v         Raw values in, residuals out.
+ * @param seq       Raw sequencer column, used by the mux predictor.
+ */
+static void predictDelta(int column, uint32_t *v, size_t n, const uint32_t *seq) {
+	size_t i;
+	if (column == IMU_LOG_COL_SEQUENCER) {
+		uint32_t prev = 0xFF;
+		for (i = 0; i < n; i++) {
+			uint32_t cur = v[i];
+			v[i] = zigzag((uint32_t)(int32_t)(int8_t)(uint8_t)(cur - prev - 1));
+			prev = cur;
+		}
+	} else if (column == IMU_LOG_COL_MUX) {
+		uint32_t last[IMU_LOG_MUX_SLOTS] = { 0 };
+		for (i = 0; i < n; i++) {
+			uint32_t slot = seq[i] % IMU_LOG_MUX_SLOTS;
+			uint32_t cur = v[i];
+			v[i] = zigzag(cur - last[slot]);
+			last[slot] = cur;
+		}
+	} else {
+		uint32_t prev = 0;
+		for (i = 0; i < n; i++) {
+			uint32_t cur = v[i];
+			v[i] = zigzag(cur - prev);
+			prev = cur;
+		}
+	}
+}
+
+/**
+ * @brief Inverse of `predictDelta`.
+ */
+static void reconstructDelta(int column, uint32_t *v, size_t n, const uint32_t *seq) {
+	size_t i;
+	if (column == IMU_LOG_COL_SEQUENCER) {
+		uint32_t prev = 0xFF;
+		for (i = 0; i < n; i++)
+			v[i] = prev = (uint8_t)(prev + 1 + unzigzag(v[i]));
+	} else if (column == IMU_LOG_COL_MUX) {
+		uint32_t last[IMU_LOG_MUX_SLOTS] = { 0 };
+		for (i = 0; i < n; i++) {
+			uint32_t slot = seq[i] % IMU_LOG_MUX_SLOTS;
+			v[i] = last[slot] = last[slot] + unzigzag(v[i]);
+		}
+	} else {
+		uint32_t prev = 0;
+		for (i = 0; i < n; i++)
+			v[i] = prev = prev + unzigzag(v[i]);
+	}
+}
+
+/**
+ * @brief Sizes of the varint and bit packed encodings of a residual array.
+ */
+static void measure(const uint32_t *v, size_t n, size_t *varintBytes, unsigned *width) {
+	size_t bytes = 0;
+	uint32_t all = 0;
+	for (size_t i = 0; i < n; i++) {
+		bytes += varintSize(v[i]);
+		all |= v[i];
+	}
+	*varintBytes = bytes;
+	*width = bitWidth(all);
+}
+
+/**
+ * @brief Writes one column with the smallest predictor and packing.
+ *
+ * @param raw   Raw values of the column, destroyed.
+ * @param tmp   Work area of `n` words.
+ */
+static uint8_t *encodeColumn(uint8_t *p, int column, uint32_t *raw, size_t n, const uint32_t *seq, uint32_t *tmp) {
+	// Frame of reference: residuals relative to the (signed) block minimum.
+	int32_t min = (int32_t)raw[0];
+	for (size_t i = 1; i < n; i++) {
+		if ((int32_t)raw[i] < min)
+			min = (int32_t)raw[i];
+	}
+	for (size_t i = 0; i < n; i++)
+		tmp[i] = raw[i] - (uint32_t)min;
+
+	predictDelta(column, raw, n, seq);
+
+	size_t deltaVarint, forVarint;
+	unsigned deltaWidth, forWidth;
+	measure(raw, n, &deltaVarint, &deltaWidth);
+	measure(tmp, n, &forVarint, &forWidth);
+
+	size_t forHeader = varintSize(zigzag((uint32_t)min));
+	size_t sizes[4] = {
+		deltaVarint,
+		1 + (n * deltaWidth + 7) / 8,
+		forHeader + forVarint,
+		forHeader + 1 + (n * forWidth + 7) / 8,
+	};
+	int best = 0;
+	for (int i = 1; i < 4; i++) {
+		if (sizes[i] < sizes[best])
+			best = i;
+	}
+
+	const uint32_t *v = best < 2 ? raw : tmp;
+	unsigned width = best < 2 ? deltaWidth : forWidth;
+	*p++ = (uint8_t)((best < 2 ? MODE_DELTA : MODE_FOR) | (best & 1 ? MODE_BITPACK : MODE_VARINT));
+	if (best >= 2)
+		p = putVarint(p, zigzag((uint32_t)min));
+	if (best & 1) {
+		*p++ = (uint8_t)width;
+		return packBits(p, v, n, width);
+	}
+	for (size_t i = 0; i < n; i++)
+		p = putVarint(p, v[i]);
+	return p;
+}
+
+/**
+ * @brief Decodes one column into raw values.
+ *
+ * @return int 0 on success, -1 if the column data is damaged.
+ */
+static int decodeColumn(const uint8_t *p, size_t bytes, int column, uint32_t *v, size_t n, const uint32_t *seq) {
+	const uint8_t *end = p + bytes;
+	uint32_t min = 0;
+	if (p == end)
+		return -1;
+	uint8_t mode = *p++;
+	if (mode & ~(MODE_FOR | MODE_BITPACK))
+		return -1;
+	if (mode & MODE_FOR) {
+		if (!(p = getVarints(p, end, &min, 1)))
+			return -1;
+		min = unzigzag(min);
+	}
+
+	if (mode & MODE_BITPACK) {
+		if (p == end)
+			return -1;
+		unsigned width = *p++;
+		if (width > 32 || (size_t)(end - p) != (n * width + 7) / 8)
+			return -1;
+		unpackBits(p, (size_t)(end - p), v, n, width);
+	} else {
+		if (getVarints(p, end, v, n) != end)
+			return -1;
+	}
+
+	if (mode & MODE_FOR) {
+		for (size_t i = 0; i < n; i++)
+			v[i] += min;
+	} else {
+		reconstructDelta(column, v, n, seq);
+	}
+	return 0;
+}
+
+size_t imuLogBlockBound(size_t count) {
+	return sizeof(ImuLogBlockHeader_t) + IMU_LOG_COLUMNS * (12 + 5 * count);
+}
+
+size_t imuLogEncodeBlock(const ImuProt_t *packets, size_t count, uint8_t *out, uint32_t *scratch) {
+	uint32_t *owned = NULL;
+	if (!scratch) {
+		scratch = owned = malloc(3 * count * sizeof(uint32_t));
+		if (!scratch)
+			return 0;
+	}
+
+	// Keep the raw sequencer column aside, the mux predictor needs it.
+	uint32_t *seq = scratch;
+	uint32_t *raw = scratch + count;
+	uint32_t *tmp = scratch + 2 * count;
+	extractColumn(packets, count, IMU_LOG_COL_SEQUENCER, seq);
+
+	ImuLogBlockHeader_t header;
+	memset(&header, 0, sizeof(header));
+	uint8_t *payload = out + sizeof(header);
+	uint8_t *p = payload;
+	for (int c = 0; c < IMU_LOG_COLUMNS; c++) {
+		uint8_t *start = p;
+		if (c == IMU_LOG_COL_SEQUENCER)
+			memcpy(raw, seq, count * sizeof(uint32_t));
+		else
+			extractColumn(packets, count, c, raw);
+		p = encodeColumn(p, c, raw, count, seq, tmp);
+		header.columnBytes[c] = (uint32_t)(p - start);
+	}
+
+	header.magic = IMU_LOG_BLOCK_MAGIC;
+	header.count = (uint32_t)count;
+	header.payloadBytes = (uint32_t)(p - payload);
+	header.payloadCrc = imuCrc32(payload, header.payloadBytes);
+	memcpy(out, &header, sizeof(header));
+
+	free(owned);
+	return (size_t)(p - out);
+}
+
+/**
+ * @brief Builds packets from decoded columns, rebuilding header, inverted sequencer and CRC.
+ *
+ * @param col   Column arrays, `col[c]` holds `n` raw values of column `c`.
+ */
+static void assemblePackets(ImuProt_t *packets, size_t n, uint32_t *const col[IMU_LOG_COLUMNS]) {
+	for (size_t i = 0; i < n; i++) {
+		ImuProt_t *p = &packets[i];
+		p->header = IMU_PROT_HEADER;
+		p->sequencer = (uint8_t)col[IMU_LOG_COL_SEQUENCER][i];
+		p->ff_sequencer = (uint8_t)~p->sequencer;
+		p->data.mux = col[IMU_LOG_COL_MUX][i];
+		p->data.flags = (uint16_t)col[IMU_LOG_COL_FLAGS][i];
+		p->data.temperature = (uint16_t)col[IMU_LOG_COL_TEMPERATURE][i];
+		for (int a = 0; a < 3; a++) {
+			p->data.gyro[a] = (int32_t)col[IMU_LOG_COL_GYRO_X + a][i];
+			p->data.accl[a] = (int32_t)col[IMU_LOG_COL_ACCL_X + a][i];
+		}
+	}
+
+	uint32_t crcs[64];
+	for (size_t i = 0; i < n; i += 64) {
+		size_t chunk = n - i < 64 ? n - i : 64;
+		imuCrcPackets(packets + i, chunk, crcs);
+		for (size_t k = 0; k < chunk; k++)
+			packets[i + k].crc32 = crcs[k];
+	}
+}
+
+ImuLogError_t imuLogDecodeBlock(const uint8_t *block, size_t size, ImuProt_t *packets,
+	size_t maxCount, uint32_t *scratch, size_t *count) {
+	ImuLogBlockHeader_t header;
+	if (size < sizeof(header))
+		return IMU_LOG_BAD_FORMAT;
+	memcpy(&header, block, sizeof(header));
+	if (header.magic != IMU_LOG_BLOCK_MAGIC || !header.count || header.count > maxCount ||
+		header.payloadBytes > size - sizeof(header))
+		return IMU_LOG_BAD_FORMAT;
+
+	const uint8_t *payload = block + sizeof(header);
+	if (imuCrc32(payload, header.payloadBytes) != header.payloadCrc)
+		return IMU_LOG_BAD_FORMAT;
+
+	uint64_t total = 0;
+	for (int c = 0; c < IMU_LOG_COLUMNS; c++)
+		total += header.columnBytes[c];
+	if (total != header.payloadBytes)
+		return IMU_LOG_BAD_FORMAT;
+
+	uint32_t *owned = NULL;
+	if (!scratch) {
+		scratch = owned = malloc(IMU_LOG_COLUMNS * (size_t)header.count * sizeof(uint32_t));
+		if (!scratch)
+			return IMU_LOG_NO_MEMORY;
+	}
+
+	// Columns are decoded in storage order, the sequencer comes first for the mux predictor.
+	uint32_t *col[IMU_LOG_COLUMNS];
+	const uint8_t *p = payload;
+	for (int c = 0; c < IMU_LOG_COLUMNS; c++) {
+		col[c] = scratch + (size_t)c * header.count;
+		if (decodeColumn(p, header.columnBytes[c], c, col[c], header.count, col[IMU_LOG_COL_SEQUENCER]) != 0) {
+			free(owned);
+			return IMU_LOG_BAD_FORMAT;
+		}
+		p += header.columnBytes[c];
+	}
+
+	assemblePackets(packets, header.count, col);
+	free(owned);
+	*count = header.count;
+	return IMU_LOG_OK;
+}
+
+ImuLogError_t imuLogWriterOpen(ImuLogWriter_t *w, const char *path, uint32_t blockPackets) {
+	memset(w, 0, sizeof(*w));
+	w->blockPackets = blockPackets ? blockPackets : IMU_LOG_BLOCK_PACKETS;
+	w->packets = malloc((size_t)w->blockPackets * sizeof(ImuProt_t));
+	w->scratch = malloc(3 * (size_t)w->blockPackets * sizeof(uint32_t));
+	w->block = malloc(imuLogBlockBound(w->blockPackets));
+	if (!w->packets || !w->scratch || !w->block) {
+		imuLogWriterClose(w);
+		return IMU_LOG_NO_MEMORY;
+	}
+
+	w->file = fopen(path, "wb");
+	if (!w->file) {
+		imuLogWriterClose(w);
+		return IMU_LOG_IO_ERROR;
+	}
+
+	ImuLogFileHeader_t header;
+	memcpy(header.magic, IMU_LOG_MAGIC, sizeof(header.magic));
+	header.version = IMU_LOG_VERSION;
+	header.blockPackets = w->blockPackets;
+	if (fwrite(&header, sizeof(header), 1, w->file) != 1) {
+		imuLogWriterClose(w);
+		return IMU_LOG_IO_ERROR;
+	}
+	w->bytes = sizeof(header);
+	return IMU_LOG_OK;
+}
+
+ImuLogError_t imuLogFlush(ImuLogWriter_t *w) {
+	if (w->failed)
+		return IMU_LOG_IO_ERROR;
+	if (!w->count)
+		return IMU_LOG_OK;
+
+	size_t size = imuLogEncodeBlock(w->packets, w->count, w->block, w->scratch);
+	size_t done = fwrite(w->block, 1, size, w->file);
+	if (done != size) {
+		// Part of the block is in the file and a retry would append a second
+		// copy after it, so the writer stops here with a truncated last block.
+		if (done)
+			w->failed = 1;
+		return IMU_LOG_IO_ERROR;
+	}
+	w->written += w->count;
+	w->bytes += size;
+	w->count = 0;
+	return IMU_LOG_OK;
+}
+
+ImuLogError_t imuLogWrite(ImuLogWriter_t *w, const ImuProt_t *packet) {
+	if (w->failed)
+		return IMU_LOG_IO_ERROR;
+	if (checkImuProtBuffer(packet) != IMU_PROT_OK)
+		return IMU_LOG_INVALID_PACKET;
+
+	if (w->count == w->blockPackets) {
+		ImuLogError_t result = imuLogFlush(w);
+		if (result != IMU_LOG_OK)
+			return result;
+	}
+	memcpy(&w->packets[w->count], packet, sizeof(ImuProt_t));
+	if (++w->count == w->blockPackets)
+		return imuLogFlush(w);
+	return IMU_LOG_OK;
+}
+
+ImuLogError_t imuLogWriterClose(ImuLogWriter_t *w) {
+	ImuLogError_t result = IMU_LOG_OK;
+	if (w->file) {
+		result = imuLogFlush(w);
+		if (fclose(w->file) != 0 && result == IMU_LOG_OK)
+			result = IMU_LOG_IO_ERROR;
+	}
+	free(w->packets);
+	free(w->scratch);
+	free(w->block);
+	memset(w, 0, sizeof(*w));
+	return result;
+}
+
+ImuLogError_t imuLogReaderOpen(ImuLogReader_t *r, const char *path) {
+	memset(r, 0, sizeof(*r));
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return IMU_LOG_IO_ERROR;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return IMU_LOG_IO_ERROR;
+	}
+	if ((size_t)st.st_size < sizeof(ImuLogFileHeader_t)) {
+		close(fd);
+		return IMU_LOG_BAD_FORMAT;
+	}
+
+	void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return IMU_LOG_IO_ERROR;
+	r->map = map;
+	r->size = (size_t)st.st_size;
+	posix_madvise(map, r->size, POSIX_MADV_SEQUENTIAL);
+
+	ImuLogFileHeader_t header;
+	memcpy(&header, map, sizeof(header));
+	if (memcmp(header.magic, IMU_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != IMU_LOG_VERSION || !header.blockPackets) {
+		imuLogReaderClose(r);
+		return IMU_LOG_BAD_FORMAT;
+	}
+
+	r->blockPackets = header.blockPackets;
+	r->offset = sizeof(header);
+	r->packets = malloc((size_t)r->blockPackets * sizeof(ImuProt_t));
+	r->scratch = malloc(IMU_LOG_COLUMNS * (size_t)r->blockPackets * sizeof(uint32_t));
+	if (!r->packets || !r->scratch) {
+		imuLogReaderClose(r);
+		return IMU_LOG_NO_MEMORY;
+	}
+	return IMU_LOG_OK;
+}
+
+ImuLogError_t imuLogNextBlock(ImuLogReader_t *r, const ImuProt_t **packets, size_t *count) {
+	*count = 0;
+	if (r->offset == r->size)
+		return IMU_LOG_END;
+
+	ImuLogError_t result = imuLogDecodeBlock(r->map + r->offset, r->size - r->offset,
+		r->packets, r->blockPackets, r->scratch, count);
+	if (result != IMU_LOG_OK)
+		return result;
+
+	ImuLogBlockHeader_t header;
+	memcpy(&header, r->map + r->offset, sizeof(header));
+	r->offset += sizeof(header) + header.payloadBytes;
+	*packets = r->packets;
+	return IMU_LOG_OK;
+}
+
+void imuLogReaderClose(ImuLogReader_t *r) {
+	if (r->map)
+		munmap((void *)r->map, r->size);
+	free(r->packets);
+	free(r->scratch);
+	memset(r, 0, sizeof(*r));
+}
+
+const char *imuLogErrorToString(ImuLogError_t error) {
+	switch (error) {
+		case IMU_LOG_OK:
+			return "OK.";
+		case IMU_LOG_END:
+			return "End of log.";
+		case IMU_LOG_IO_ERROR:
+			return "I/O error!";
+		case IMU_LOG_BAD_FORMAT:
+			return "Not a log file or damaged block!";
+		case IMU_LOG_NO_MEMORY:
+			return "Out of memory!";
+		case IMU_LOG_INVALID_PACKET:
+			return "Packet failed validation!";
+	}
+	return "Unknown error.";
+}
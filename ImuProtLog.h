@@ -0,0 +1,255 @@
+/**
+ * Compressed Column-Wise IMU Log Format.
+ *
+ * Validated packets are split into columns (sequencer, mux, flags,
+ * temperature and the six gyro/accl axes) and stored in independent blocks.
+ * Within a block every column is transformed with a predictor and packed:
+ *
+ * - Predictors: delta to the previous sample (the sequencer predicts +1, the
+ *   mux predicts the value seen 32 packets earlier in the same mux slot) or
+ *   frame of reference (value minus the block minimum).
+ * - Packing: zigzag LEB128 varints or fixed-width bit packing.
+ *
+ * The encoder picks the smallest combination per column and block. The CRC,
+ * header and inverted sequencer are not stored; the reader rebuilds them, so
+ * decoded packets are bit-exact copies of the validated input.
+ *
+ * File layout:
+ *
+ *   file header | block header | column data ... | block header | column data ...
+ */
+
+#ifndef ImuProtLog_h_included__
+#define ImuProtLog_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ImuProt.h"
+
+#define IMU_LOG_MAGIC "IMULOG01"
+#define IMU_LOG_BLOCK_MAGIC (0x4B4C4249UL)   // "IBLK"
+#define IMU_LOG_VERSION (1)
+
+/** Default number of packets per block. */
+#define IMU_LOG_BLOCK_PACKETS (4096)
+
+/** Number of mux words, the mux predictor works per word. */
+#define IMU_LOG_MUX_SLOTS (32)
+
+/**
+ * @enum ImuLogColumn_t
+ * @brief Columns of a block, in storage order.
+ */
+typedef enum {
+	IMU_LOG_COL_SEQUENCER = 0,
+	IMU_LOG_COL_MUX,
+	IMU_LOG_COL_FLAGS,
+	IMU_LOG_COL_TEMPERATURE,
+	IMU_LOG_COL_GYRO_X,
+	IMU_LOG_COL_GYRO_Y,
+	IMU_LOG_COL_GYRO_Z,
+	IMU_LOG_COL_ACCL_X,
+	IMU_LOG_COL_ACCL_Y,
+	IMU_LOG_COL_ACCL_Z,
+	IMU_LOG_COLUMNS
+} ImuLogColumn_t;
+
+/**
+ * File header, at offset 0.
+ *
+ * @field magic         IMU_LOG_MAGIC.
+ * @field version       IMU_LOG_VERSION.
+ * @field blockPackets  Maximum number of packets per block.
+ */
+typedef struct PACK_IT
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t blockPackets;
+} ImuLogFileHeader_t;
+
+/**
+ * Block header, followed by the column data.
+ *
+ * @field magic         IMU_LOG_BLOCK_MAGIC.
+ * @field count         Number of packets in the block.
+ * @field payloadBytes  Size of the column data following the header.
+ * @field payloadCrc    CRC32 of the column data.
+ * @field columnBytes   Size of every column, so columns can be decoded selectively.
+ */
+typedef struct PACK_IT
+{
+	uint32_t magic;
+	uint32_t count;
+	uint32_t payloadBytes;
+	uint32_t payloadCrc;
+	uint32_t columnBytes[IMU_LOG_COLUMNS];
+} ImuLogBlockHeader_t;
+
+/**
+ * @enum ImuLogError_t
+ * @brief Error codes of the compressed log API.
+ */
+typedef enum {
+	IMU_LOG_OK = 0,                 // Success.
+	IMU_LOG_END = 1,                // No more blocks.
+	IMU_LOG_IO_ERROR = 2,           // A system call failed, see errno.
+	IMU_LOG_BAD_FORMAT = 3,         // Not a log file, or a block is damaged.
+	IMU_LOG_NO_MEMORY = 4,          // Memory allocation failed.
+	IMU_LOG_INVALID_PACKET = 5      // The packet did not pass `checkImuProtBuffer`.
+} ImuLogError_t;
+
+/**
+ * Compressed log writer. All fields are private.
+ */
+typedef struct {
+	FILE *file;
+	uint32_t blockPackets;
+	uint32_t count;
+	ImuProt_t *packets;
+	uint32_t *scratch;
+	uint8_t *block;
+	uint64_t written;
+	uint64_t bytes;
+	int failed;
+} ImuLogWriter_t;
+
+/**
+ * Memory mapped compressed log reader. All fields are private.
+ */
+typedef struct {
+	const uint8_t *map;
+	size_t size;
+	size_t offset;
+	uint32_t blockPackets;
+	ImuProt_t *packets;
+	uint32_t *scratch;
+} ImuLogReader_t;
+
+/**
+ * @brief Returns an upper bound of the encoded size of a block.
+ *
+ * @param count Number of packets in the block.
+ * @return size_t Bytes needed by `imuLogEncodeBlock`, header included.
+ */
+size_t imuLogBlockBound(size_t count);
+
+/**
+ * @brief Encodes validated packets into a single block.
+ *
+ * @param packets   Packets to encode; they are assumed to be valid.
+ * @param count     Number of packets, at least 1.
+ * @param out       Output buffer of at least `imuLogBlockBound(count)` bytes.
+ * @param scratch   Work area of `3 * count` words, or NULL to allocate.
+ * @return size_t Number of bytes written, 0 if memory could not be allocated.
+ */
+size_t imuLogEncodeBlock(const ImuProt_t *packets, size_t count, uint8_t *out, uint32_t *scratch);
+
+/**
+ * @brief Decodes a block back into packets, rebuilding header and CRC.
+ *
+ * @param block     Block header followed by the column data.
+ * @param size      Number of readable bytes at `block`.
+ * @param packets   Output array of at least `count` packets of the block.
+ * @param maxCount  Capacity of `packets`.
+ * @param scratch   Work area of `IMU_LOG_COLUMNS * maxCount` words, or NULL to allocate.
+ * @param count     Receives the number of decoded packets.
+ * @return ImuLogError_t IMU_LOG_OK, or IMU_LOG_BAD_FORMAT for a damaged block.
+ */
+ImuLogError_t imuLogDecodeBlock(const uint8_t *block, size_t size, ImuProt_t *packets,
+	size_t maxCount, uint32_t *scratch, size_t *count);
+
+/**
+ * @brief Creates a compressed log file.
+ *
+ * @param w             Writer to initialize.
+ * @param path          Path of the file.
+ * @param blockPackets  Packets per block, 0 for IMU_LOG_BLOCK_PACKETS.
+ * @return ImuLogError_t IMU_LOG_OK on success.
+ */
+ImuLogError_t imuLogWriterOpen(ImuLogWriter_t *w, const char *path, uint32_t blockPackets);
+
+/**
+ * @brief Appends a packet to the log.
+ *
+ * Only packets that pass `checkImuProtBuffer` are stored, since the CRC is
+ * recomputed on decoding.
+ *
+ * @param w         Writer.
+ * @param packet    Validated packet.
+ * @return ImuLogError_t IMU_LOG_OK, or IMU_LOG_INVALID_PACKET for a packet that was not stored.
+ */
+ImuLogError_t imuLogWrite(ImuLogWriter_t *w, const ImuProt_t *packet);
+
+/**
+ * @brief Encodes and writes the current partial block.
+ *
+ * A write that fails before any byte reached the file may be retried. One
+ * that fails after writing part of the block fails the writer for good:
+ * every further call returns IMU_LOG_IO_ERROR and the file ends with a
+ * truncated block, which readers report as damaged after the complete ones.
+ *
+ * @param w Writer.
+ * @return ImuLogError_t IMU_LOG_OK on success.
+ */
+ImuLogError_t imuLogFlush(ImuLogWriter_t *w);
+
+/**
+ * @brief Flushes pending packets and closes the file.
+ *
+ * @param w Writer.
+ * @return ImuLogError_t IMU_LOG_OK on success.
+ */
+ImuLogError_t imuLogWriterClose(ImuLogWriter_t *w);
+
+/**
+ * @brief Returns the number of packets written and the compressed size so far.
+ *
+ * @param w         Writer.
+ * @param bytes     Optional, receives the number of bytes written to the file.
+ * @return uint64_t Number of packets written.
+ */
+static inline uint64_t imuLogWritten(const ImuLogWriter_t *w, uint64_t *bytes)
+{
+	if (bytes)
+		*bytes = w->bytes;
+	return w->written;
+}
+
+/**
+ * @brief Maps a compressed log for reading.
+ *
+ * @param r     Reader to initialize.
+ * @param path  Path of the file.
+ * @return ImuLogError_t IMU_LOG_OK on success.
+ */
+ImuLogError_t imuLogReaderOpen(ImuLogReader_t *r, const char *path);
+
+/**
+ * @brief Decodes the next block.
+ *
+ * @param r         Reader.
+ * @param packets   Receives a pointer to the decoded packets, valid until the next call.
+ * @param count     Receives the number of packets.
+ * @return ImuLogError_t IMU_LOG_OK, IMU_LOG_END after the last block, or IMU_LOG_BAD_FORMAT.
+ */
+ImuLogError_t imuLogNextBlock(ImuLogReader_t *r, const ImuProt_t **packets, size_t *count);
+
+/**
+ * @brief Unmaps the log.
+ *
+ * @param r Reader.
+ */
+void imuLogReaderClose(ImuLogReader_t *r);
+
+/**
+ * @brief Converts an ImuLogError_t error code to its string representation.
+ *
+ * @param error The ImuLogError_t error code.
+ * @return A string that describes the error.
+ */
+const char *imuLogErrorToString(ImuLogError_t error);
+
+#endif
@@ -0,0 +1,211 @@
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "ImuProtIsa.h"
+#include "ImuProtMoments.h"
+
+#define MOM_INLINE static inline __attribute__((always_inline))
+
+/** Packets per block of the block update. */
+#define MOM_BLOCK (128)
+
+typedef int32_t MomInt_t __attribute__((vector_size(4 * sizeof(int32_t))));
+
+/**
+ * @brief Reorders the channel words of a packet into lane order.
+ *
+ * `flags`, `temperature`, `gyro` and `accl` are adjacent 32-bit words
+ * followed by the CRC, so two loads and two shuffles bring them in channel
+ * order; the temperature is shifted down and the padding lane cleared.
+ */
+MOM_INLINE void momWords(const ImuProt_t *p, int32_t words[IMU_MOMENTS_LANES]) {
+	const uint8_t *raw = (const uint8_t *)p + offsetof(ImuProt_t, data) + offsetof(ImuData_t, flags);
+	MomInt_t lo, hi;
+	memcpy(&lo, raw, sizeof(lo));
+	memcpy(&hi, raw + sizeof(lo), sizeof(hi));
+	MomInt_t a = __builtin_shuffle(lo, hi, (MomInt_t){ 1, 2, 3, 4 });
+	MomInt_t b = __builtin_shuffle(lo, hi, (MomInt_t){ 5, 6, 0, 7 });
+	b = (b >> (MomInt_t){ 0, 0, 16, 0 }) & (MomInt_t){ -1, -1, 0xffff, 0 };
+	memcpy(words, &a, sizeof(a));
+	memcpy(words + 4, &b, sizeof(b));
+}
+
+/**
+ * @brief Folds a block (or another state) into the running state.
+ */
+static inline void momCombine(ImuMoments_t *m, uint64_t count, const double *mean, const double *m2) {
+	double total = (double)(m->count + count);
+	double wMean = (double)count / total, wM2 = (double)m->count * (double)count / total;
+	for (int c = 0; c < IMU_MOMENTS_LANES; c++) {
+		double delta = mean[c] - m->mean[c];
+		m->mean[c] += delta * wMean;
+		m->m2[c] += m2[c] + delta * delta * wM2;
+	}
+	m->count += count;
+}
+
+/*
+ * Block update on vectors of W lanes, the state being IMU_MOMENTS_LANES / W
+ * vectors. Expanded per vector width, since the compiler keeps a vector of
+ * the native width in registers but spills wider ones.
+ */
+#define MOM_DEFINE(W)                                                                                  \
+                                                                                                       \
+typedef double MomVec##W##_t __attribute__((vector_size(W * sizeof(double))));                         \
+typedef int64_t MomMask##W##_t __attribute__((vector_size(W * sizeof(int64_t))));                      \
+typedef int32_t MomInt##W##_t __attribute__((vector_size(W * sizeof(int32_t))));                       \
+                                                                                                       \
+MOM_INLINE void momPushBlocks##W(ImuMoments_t *m, const uint8_t *packets, size_t stride, size_t count) { \
+	enum { V = IMU_MOMENTS_LANES / W };                                                                \
+	MomVec##W##_t x[MOM_BLOCK][V], lo[V], hi[V], scale[V], offset[V];                                  \
+	double lanes[2][IMU_MOMENTS_LANES] = {                                                             \
+		{ IMU_PROT_SCALE, IMU_PROT_SCALE, IMU_PROT_SCALE, IMU_PROT_SCALE, IMU_PROT_SCALE,              \
+			IMU_PROT_SCALE, 0.01, 0.0 },                                                               \
+		{ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, -(double)KELVIN, 0.0 } };                                      \
+	memcpy(scale, lanes[0], sizeof(scale));                                                            \
+	memcpy(offset, lanes[1], sizeof(offset));                                                          \
+	memcpy(lo, m->min, sizeof(lo));                                                                    \
+	memcpy(hi, m->max, sizeof(hi));                                                                    \
+	for (size_t pos = 0; pos < count; pos += MOM_BLOCK) {                                              \
+		size_t n = count - pos < MOM_BLOCK ? count - pos : MOM_BLOCK;                                  \
+		MomVec##W##_t sum[V], mean[V], m2[V];                                                          \
+		memset(sum, 0, sizeof(sum));                                                                   \
+		memset(m2, 0, sizeof(m2));                                                                     \
+		for (size_t i = 0; i < n; i++) {                                                               \
+			int32_t words[IMU_MOMENTS_LANES];                                                          \
+			momWords((const ImuProt_t *)(packets + (pos + i) * stride), words);                        \
+			for (int v = 0; v < V; v++) {                                                              \
+				MomInt##W##_t w;                                                                       \
+				memcpy(&w, words + v * W, sizeof(w));                                                  \
+				MomVec##W##_t y = __builtin_convertvector(w, MomVec##W##_t) * scale[v] + offset[v];    \
+				MomMask##W##_t less = y < lo[v], more = y > hi[v];                                     \
+				lo[v] = (MomVec##W##_t)((less & (MomMask##W##_t)y) | (~less & (MomMask##W##_t)lo[v])); \
+				hi[v] = (MomVec##W##_t)((more & (MomMask##W##_t)y) | (~more & (MomMask##W##_t)hi[v])); \
+				sum[v] += y;                                                                           \
+				x[i][v] = y;                                                                           \
+			}                                                                                          \
+		}                                                                                              \
+		for (int v = 0; v < V; v++)                                                                    \
+			mean[v] = sum[v] / (double)n;                                                              \
+		for (size_t i = 0; i < n; i++) {                                                               \
+			for (int v = 0; v < V; v++) {                                                              \
+				MomVec##W##_t d = x[i][v] - mean[v];                                                   \
+				m2[v] += d * d;                                                                        \
+			}                                                                                          \
+		}                                                                                              \
+		momCombine(m, n, (const double *)mean, (const double *)m2);                                    \
+	}                                                                                                  \
+	memcpy(m->min, lo, sizeof(lo));                                                                    \
+	memcpy(m->max, hi, sizeof(hi));                                                                    \
+}
+
+MOM_DEFINE(2)
+MOM_DEFINE(4)
+
+static void momPushBaseline(ImuMoments_t *m, const ImuProt_t *packets, size_t packetStride, size_t count) {
+	momPushBlocks2(m, (const uint8_t *)packets, packetStride, count);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#define MOM_TARGET(t) static __attribute__((target(t)))
+
+MOM_TARGET("arch=x86-64-v3") void momPushAvx2(ImuMoments_t *m, const ImuProt_t *packets, size_t packetStride, size_t count) {
+	momPushBlocks4(m, (const uint8_t *)packets, packetStride, count);
+}
+
+MOM_TARGET("arch=x86-64-v4") void momPushAvx512(ImuMoments_t *m, const ImuProt_t *packets, size_t packetStride, size_t count) {
+	momPushBlocks4(m, (const uint8_t *)packets, packetStride, count);
+}
+
+#define MOM_PUSH_AVX2 momPushAvx2
+#define MOM_PUSH_AVX512 momPushAvx512
+
+#else
+
+#define MOM_PUSH_AVX2 momPushBaseline
+#define MOM_PUSH_AVX512 momPushBaseline
+
+#endif
+
+void imuMomentsInit(ImuMoments_t *m) {
+	memset(m, 0, sizeof(*m));
+	for (int c = 0; c < IMU_MOMENTS_LANES; c++) {
+		m->min[c] = INFINITY;
+		m->max[c] = -INFINITY;
+	}
+}
+
+void imuMomentsPush(ImuMoments_t *m, const ImuProt_t *packets, size_t packetStride, size_t count) {
+	ImuIsa_t isa = imuIsaActive();
+	if (isa >= IMU_ISA_AVX512)
+		MOM_PUSH_AVX512(m, packets, packetStride, count);
+	else if (isa >= IMU_ISA_AVX2)
+		MOM_PUSH_AVX2(m, packets, packetStride, count);
+	else
+		momPushBaseline(m, packets, packetStride, count);
+}
+
+void imuMomentsMerge(ImuMoments_t *to, const ImuMoments_t *from) {
+	if (!from->count)
+		return;
+	for (int c = 0; c < IMU_MOMENTS_LANES; c++) {
+		to->min[c] = fmin(to->min[c], from->min[c]);
+		to->max[c] = fmax(to->max[c], from->max[c]);
+	}
+	momCombine(to, from->count, from->mean, from->m2);
+}
+
+void imuMomentsSummary(const ImuMoments_t *m, ImuMomentsSummary_t *out) {
+	memset(out, 0, sizeof(*out));
+	out->count = m->count;
+	if (!m->count)
+		return;
+	for (int c = 0; c < IMU_MOMENTS_CHANNELS; c++) {
+		out->mean[c] = m->mean[c];
+		out->variance[c] = m->count > 1 ? m->m2[c] / (double)(m->count - 1) : 0.0;
+		out->min[c] = m->min[c];
+		out->max[c] = m->max[c];
+		out->rms[c] = sqrt(m->mean[c] * m->mean[c] + m->m2[c] / (double)m->count);
+	}
+}
+
+int imuMomentsWindowInit(ImuMomentsWindow_t *w, uint64_t window) {
+	if (window < IMU_MOMENTS_BLOCKS)
+		return -1;
+	for (int b = 0; b < IMU_MOMENTS_BLOCKS; b++)
+		imuMomentsInit(&w->blocks[b]);
+	imuMomentsInit(&w->current);
+	w->blockSize = window / IMU_MOMENTS_BLOCKS;
+	w->head = 0;
+	w->filled = 0;
+	return 0;
+}
+
+void imuMomentsWindowPush(ImuMomentsWindow_t *w, const ImuProt_t *packets, size_t packetStride, size_t count) {
+	while (count) {
+		uint64_t room = w->blockSize - w->current.count;
+		size_t n = count < room ? count : (size_t)room;
+		imuMomentsPush(&w->current, packets, packetStride, n);
+		packets = (const ImuProt_t *)((const uint8_t *)packets + n * packetStride);
+		count -= n;
+		if (w->current.count < w->blockSize)
+			break;
+		w->blocks[w->head] = w->current;
+		w->head = w->head + 1 == IMU_MOMENTS_BLOCKS ? 0 : w->head + 1;
+		if (w->filled < IMU_MOMENTS_BLOCKS)
+			w->filled++;
+		imuMomentsInit(&w->current);
+	}
+}
+
+void imuMomentsWindowView(const ImuMomentsWindow_t *w, ImuMoments_t *out) {
+	imuMomentsInit(out);
+	uint32_t b = (w->head + IMU_MOMENTS_BLOCKS - w->filled) % IMU_MOMENTS_BLOCKS;
+	for (uint32_t i = 0; i < w->filled; i++) {
+		imuMomentsMerge(out, &w->blocks[b]);
+		b = b + 1 == IMU_MOMENTS_BLOCKS ? 0 : b + 1;
+	}
+	imuMomentsMerge(out, &w->current);
+}
@@ -0,0 +1,156 @@
+/**
+ * Online Per-Axis Statistics.
+ *
+ * Running count, mean, variance, minimum, maximum and RMS of the six `gyro`
+ * and `accl` axes and the temperature of validated packets, cumulative
+ * (`ImuMoments_t`) or over a sliding window (`ImuMomentsWindow_t`).
+ *
+ * The seven channels are padded to IMU_MOMENTS_LANES lanes and updated
+ * together in native-width vectors, no per-channel loop. Packets are taken
+ * in blocks: the block mean and sum of squared deviations are computed in
+ * two vector passes over the converted block, then folded into the running
+ * state with the pairwise update of Chan et al.:
+ *
+ *   delta = mean_b - mean_a
+ *   mean  = mean_a + delta * n_b / n
+ *   M2    = M2_a + M2_b + delta^2 * n_a * n_b / n
+ *
+ * This is Welford's algorithm with a block instead of a single sample, as
+ * stable as the per-sample form but without a division per packet. The
+ * same update merges two states, so partial states of segments scanned on
+ * different threads combine into the state of the whole, in any order.
+ * The kernels are compiled per ISA level and follow `ImuProtIsa.h`.
+ *
+ * Values are in the units of `floatData` for `gyro` and `accl` and in
+ * degrees Celsius for the temperature.
+ */
+
+#ifndef ImuProtMoments_h_included__
+#define ImuProtMoments_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+
+/** Channels: gyro X, Y, Z, accl X, Y, Z, temperature. */
+#define IMU_MOMENTS_CHANNELS (7)
+
+/** Values per state vector, the channels padded to a SIMD vector. */
+#define IMU_MOMENTS_LANES (8)
+
+/** Blocks of a sliding window. */
+#define IMU_MOMENTS_BLOCKS (16)
+
+/**
+ * Running state. All fields are private.
+ */
+typedef struct {
+	double mean[IMU_MOMENTS_LANES];
+	double m2[IMU_MOMENTS_LANES];
+	double min[IMU_MOMENTS_LANES];
+	double max[IMU_MOMENTS_LANES];
+	uint64_t count;
+} ImuMoments_t;
+
+/**
+ * Sliding window state. All fields are private.
+ */
+typedef struct {
+	ImuMoments_t blocks[IMU_MOMENTS_BLOCKS];
+	ImuMoments_t current;
+	uint64_t blockSize;
+	uint32_t head;
+	uint32_t filled;
+} ImuMomentsWindow_t;
+
+/**
+ * Statistics of each channel.
+ *
+ * @field count     Packets.
+ * @field mean      Mean.
+ * @field variance  Sample variance (divided by count - 1), 0 below two packets.
+ * @field min       Minimum.
+ * @field max       Maximum.
+ * @field rms       Root mean square.
+ */
+typedef struct {
+	uint64_t count;
+	double mean[IMU_MOMENTS_CHANNELS];
+	double variance[IMU_MOMENTS_CHANNELS];
+	double min[IMU_MOMENTS_CHANNELS];
+	double max[IMU_MOMENTS_CHANNELS];
+	double rms[IMU_MOMENTS_CHANNELS];
+} ImuMomentsSummary_t;
+
+/**
+ * @brief Initializes an empty state.
+ */
+void imuMomentsInit(ImuMoments_t *m);
+
+/**
+ * @brief Adds validated packets.
+ *
+ * @param m             State.
+ * @param packets       First packet.
+ * @param packetStride  Bytes from one packet to the next, e.g. `sizeof(ImuRecRecord_t)`.
+ * @param count         Number of packets.
+ */
+void imuMomentsPush(ImuMoments_t *m, const ImuProt_t *packets, size_t packetStride, size_t count);
+
+/**
+ * @brief Adds the packets of another state, e.g. of another segment or thread.
+ *
+ * @param to    State to add to.
+ * @param from  State to add.
+ */
+void imuMomentsMerge(ImuMoments_t *to, const ImuMoments_t *from);
+
+/**
+ * @brief Computes the statistics of a state.
+ *
+ * @param m     State.
+ * @param out   Receives the statistics.
+ */
+void imuMomentsSummary(const ImuMoments_t *m, ImuMomentsSummary_t *out);
+
+/**
+ * @brief Returns the number of packets added.
+ */
+static inline uint64_t imuMomentsCount(const ImuMoments_t *m)
+{
+	return m->count;
+}
+
+/**
+ * @brief Initializes a sliding window.
+ *
+ * The window is kept as IMU_MOMENTS_BLOCKS completed blocks of
+ * `window / IMU_MOMENTS_BLOCKS` packets and the block being filled, so once
+ * full it covers the last `window` packets to within one block.
+ *
+ * @param w         State to initialize.
+ * @param window    Window length in packets, at least IMU_MOMENTS_BLOCKS.
+ * @return int 0 on success, -1 if the window is too short.
+ */
+int imuMomentsWindowInit(ImuMomentsWindow_t *w, uint64_t window);
+
+/**
+ * @brief Adds validated packets to a sliding window.
+ *
+ * @param w             State.
+ * @param packets       First packet.
+ * @param packetStride  Bytes from one packet to the next.
+ * @param count         Number of packets.
+ */
+void imuMomentsWindowPush(ImuMomentsWindow_t *w, const ImuProt_t *packets, size_t packetStride, size_t count);
+
+/**
+ * @brief Merges the blocks of the window into one state.
+ *
+ * @param w     Window.
+ * @param out   Receives the state of the packets in the window.
+ */
+void imuMomentsWindowView(const ImuMomentsWindow_t *w, ImuMoments_t *out);
+
+#endif
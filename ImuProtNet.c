@@ -0,0 +1,237 @@
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ImuProtNet.h"
+
+_Static_assert(sizeof(ImuNetHeader_t) == 24, "datagram header layout");
+_Static_assert(sizeof(ImuNetDatagram_t) <= 1472, "datagram exceeds the Ethernet MTU");
+
+/** Socket buffer requested on both sides, absorbs bursts of a few batches. */
+#define NET_SOCKET_BUFFER (4 << 20)
+
+ImuNetError_t imuNetSenderOpen(ImuNetSender_t *s, const char *address, uint16_t port, const char *iface,
+	int ttl, uint32_t streamId, uint32_t perDatagram) {
+	memset(s, 0, sizeof(*s));
+	s->fd = -1;
+	s->dest.sin_family = AF_INET;
+	s->dest.sin_port = htons(port);
+	if (inet_pton(AF_INET, address, &s->dest.sin_addr) != 1)
+		return IMU_NET_BAD_ADDRESS;
+
+	struct in_addr ifaceAddr = { .s_addr = htonl(INADDR_ANY) };
+	if (iface && inet_pton(AF_INET, iface, &ifaceAddr) != 1)
+		return IMU_NET_BAD_ADDRESS;
+
+	s->fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (s->fd < 0)
+		return IMU_NET_IO_ERROR;
+
+	int buffer = NET_SOCKET_BUFFER;
+	unsigned char mttl = (unsigned char)ttl, loop = 1;
+	setsockopt(s->fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+	if (IN_MULTICAST(ntohl(s->dest.sin_addr.s_addr))
+		&& (setsockopt(s->fd, IPPROTO_IP, IP_MULTICAST_TTL, &mttl, sizeof(mttl)) != 0
+		|| setsockopt(s->fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0
+		|| (iface && setsockopt(s->fd, IPPROTO_IP, IP_MULTICAST_IF, &ifaceAddr, sizeof(ifaceAddr)) != 0))) {
+		close(s->fd);
+		s->fd = -1;
+		return IMU_NET_IO_ERROR;
+	}
+
+	s->streamId = streamId;
+	s->perDatagram = perDatagram && perDatagram <= IMU_NET_DATAGRAM_PACKETS ? perDatagram : IMU_NET_DATAGRAM_PACKETS;
+	return IMU_NET_OK;
+}
+
+ImuNetError_t imuNetSend(ImuNetSender_t *s, const ImuProt_t *packet, uint64_t rxTimeNs) {
+	ImuNetDatagram_t *d = &s->datagrams[s->queued];
+	if (d->header.count == 0) {
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		d->header.magic = IMU_NET_MAGIC;
+		d->header.streamId = s->streamId;
+		d->header.datagramSeq = s->datagramSeq++;
+		d->header.version = IMU_NET_VERSION;
+		d->header.reserved = 0;
+		d->header.sendTimeNs = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+	}
+
+	d->records[d->header.count].rxTimeNs = rxTimeNs;
+	d->records[d->header.count].packet = *packet;
+	if (++d->header.count < s->perDatagram)
+		return IMU_NET_OK;
+
+	if (++s->queued < IMU_NET_BATCH)
+		return IMU_NET_OK;
+	return imuNetFlush(s);
+}
+
+ImuNetError_t imuNetFlush(ImuNetSender_t *s) {
+	uint32_t count = s->queued + (s->queued < IMU_NET_BATCH && s->datagrams[s->queued].header.count != 0);
+	struct mmsghdr msgs[IMU_NET_BATCH];
+	struct iovec iov[IMU_NET_BATCH];
+
+	for (uint32_t i = 0; i < count; i++) {
+		iov[i].iov_base = &s->datagrams[i];
+		iov[i].iov_len = sizeof(ImuNetHeader_t) + s->datagrams[i].header.count * sizeof(ImuRecRecord_t);
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_name = &s->dest;
+		msgs[i].msg_hdr.msg_namelen = sizeof(s->dest);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	ImuNetError_t result = IMU_NET_OK;
+	uint32_t sent = 0;
+	while (sent < count) {
+		int n = sendmmsg(s->fd, msgs + sent, count - sent, 0);
+		s->stats.syscalls++;
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			result = IMU_NET_IO_ERROR;
+			break;
+		}
+		for (int i = 0; i < n; i++)
+			s->stats.packets += s->datagrams[sent + i].header.count;
+		s->stats.datagrams += (uint64_t)n;
+		sent += (uint32_t)n;
+	}
+
+	// Datagrams that could not be sent are dropped, like the network would.
+	for (uint32_t i = 0; i < count; i++)
+		s->datagrams[i].header.count = 0;
+	s->queued = 0;
+	return result;
+}
+
+ImuNetError_t imuNetSenderClose(ImuNetSender_t *s) {
+	ImuNetError_t result = IMU_NET_OK;
+	if (s->fd >= 0) {
+		result = imuNetFlush(s);
+		close(s->fd);
+	}
+	s->fd = -1;
+	return result;
+}
+
+ImuNetError_t imuNetReceiverOpen(ImuNetReceiver_t *r, const char *address, uint16_t port, const char *iface,
+	uint32_t streamId, int timeoutMs) {
+	memset(r, 0, sizeof(*r));
+	r->fd = -1;
+	r->streamId = streamId;
+
+	struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(port) };
+	struct ip_mreq mreq = { .imr_interface.s_addr = htonl(INADDR_ANY) };
+	if (inet_pton(AF_INET, address, &mreq.imr_multiaddr) != 1)
+		return IMU_NET_BAD_ADDRESS;
+	if (iface && inet_pton(AF_INET, iface, &mreq.imr_interface) != 1)
+		return IMU_NET_BAD_ADDRESS;
+	int multicast = IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr));
+	local.sin_addr = mreq.imr_multiaddr;
+
+	r->fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (r->fd < 0)
+		return IMU_NET_IO_ERROR;
+
+	int one = 1, buffer = NET_SOCKET_BUFFER;
+	struct timeval timeout = { .tv_sec = timeoutMs / 1000, .tv_usec = (timeoutMs % 1000) * 1000 };
+	setsockopt(r->fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+	if (setsockopt(r->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0
+		|| setsockopt(r->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0
+		|| bind(r->fd, (struct sockaddr *)&local, sizeof(local)) != 0
+		|| (multicast && setsockopt(r->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0)) {
+		close(r->fd);
+		r->fd = -1;
+		return IMU_NET_IO_ERROR;
+	}
+	return IMU_NET_OK;
+}
+
+/**
+ * @brief Checks a received datagram and appends its valid packets to the record array.
+ */
+static size_t netUnpack(ImuNetReceiver_t *r, const ImuNetDatagram_t *d, size_t len, size_t count) {
+	const ImuNetHeader_t *h = &d->header;
+	if (len < sizeof(*h) || h->magic != IMU_NET_MAGIC || h->version != IMU_NET_VERSION
+		|| h->count > IMU_NET_DATAGRAM_PACKETS || len != sizeof(*h) + h->count * sizeof(ImuRecRecord_t)) {
+		r->stats.badDatagrams++;
+		return count;
+	}
+	if (r->streamId && h->streamId != r->streamId)
+		return count;
+
+	// Reordered or duplicated datagrams count as a restart, not as a huge gap.
+	if (r->synced && h->datagramSeq != r->nextSeq && (int32_t)(h->datagramSeq - r->nextSeq) > 0)
+		r->stats.lostDatagrams += h->datagramSeq - r->nextSeq;
+	r->synced = 1;
+	r->nextSeq = h->datagramSeq + 1;
+	r->stats.datagrams++;
+
+	for (uint16_t i = 0; i < h->count; i++) {
+		if (checkImuProtBuffer(&d->records[i].packet) != IMU_PROT_OK) {
+			r->stats.invalid++;
+			continue;
+		}
+		r->records[count++] = d->records[i];
+	}
+	return count;
+}
+
+ImuNetError_t imuNetReceive(ImuNetReceiver_t *r, const ImuRecRecord_t **records, size_t *count) {
+	struct mmsghdr msgs[IMU_NET_BATCH];
+	struct iovec iov[IMU_NET_BATCH];
+	for (int i = 0; i < IMU_NET_BATCH; i++) {
+		iov[i].iov_base = &r->datagrams[i];
+		iov[i].iov_len = sizeof(ImuNetDatagram_t);
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	*records = r->records;
+	*count = 0;
+	int n;
+	do {
+		n = recvmmsg(r->fd, msgs, IMU_NET_BATCH, MSG_WAITFORONE, NULL);
+		r->stats.syscalls++;
+	} while (n < 0 && errno == EINTR);
+	if (n < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK ? IMU_NET_TIMEOUT : IMU_NET_IO_ERROR;
+
+	size_t valid = 0;
+	for (int i = 0; i < n; i++) {
+		size_t len = msgs[i].msg_hdr.msg_flags & MSG_TRUNC ? 0 : msgs[i].msg_len;
+		valid = netUnpack(r, &r->datagrams[i], len, valid);
+	}
+	r->stats.packets += valid;
+	*count = valid;
+	return IMU_NET_OK;
+}
+
+void imuNetReceiverClose(ImuNetReceiver_t *r) {
+	if (r->fd >= 0)
+		close(r->fd);
+	r->fd = -1;
+}
+
+const char *imuNetErrorToString(ImuNetError_t error) {
+	switch (error) {
+		case IMU_NET_OK:
+			return "OK.";
+		case IMU_NET_IO_ERROR:
+			return "I/O error!";
+		case IMU_NET_BAD_ADDRESS:
+			return "Invalid IPv4 address!";
+		case IMU_NET_TIMEOUT:
+			return "Timeout!";
+	}
+	return "Unknown error.";
+}
@@ -0,0 +1,224 @@
+/**
+ * UDP Packet Republisher.
+ *
+ * Fans validated packets out to other machines over UDP multicast (or
+ * unicast). Packets are grouped into datagrams that carry a small header and
+ * the packets with their receive times as `ImuRecRecord_t`. The sender queues
+ * datagrams and hands a whole batch to the kernel with one `sendmmsg` call;
+ * the receiver collects a batch with one `recvmmsg` call and validates every
+ * packet with `checkImuProtBuffer`.
+ *
+ * Datagram layout:
+ *
+ *   datagram header | record | record ...
+ */
+
+#ifndef ImuProtNet_h_included__
+#define ImuProtNet_h_included__
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtRec.h"
+
+#define IMU_NET_MAGIC (0x44554D49UL)    // "IMUD"
+#define IMU_NET_VERSION (1)
+
+/** Maximum packets per datagram, so that a datagram fits an Ethernet MTU of 1500 bytes. */
+#define IMU_NET_DATAGRAM_PACKETS (30)
+
+/** Datagrams handed to the kernel per `sendmmsg` / `recvmmsg` call. */
+#define IMU_NET_BATCH (32)
+
+/**
+ * Datagram header.
+ *
+ * @field magic         IMU_NET_MAGIC.
+ * @field streamId      Identifier of the publishing stream.
+ * @field datagramSeq   Datagram counter of the stream, used to detect lost datagrams.
+ * @field count         Number of records following the header.
+ * @field version       IMU_NET_VERSION.
+ * @field reserved      Zero.
+ * @field sendTimeNs    Time the datagram was queued for sending (CLOCK_REALTIME).
+ */
+typedef struct PACK_IT
+{
+	uint32_t magic;
+	uint32_t streamId;
+	uint32_t datagramSeq;
+	uint16_t count;
+	uint8_t version;
+	uint8_t reserved;
+	uint64_t sendTimeNs;
+} ImuNetHeader_t;
+
+/**
+ * A complete datagram.
+ */
+typedef struct PACK_IT
+{
+	ImuNetHeader_t header;
+	ImuRecRecord_t records[IMU_NET_DATAGRAM_PACKETS];
+} ImuNetDatagram_t;
+
+/**
+ * @enum ImuNetError_t
+ * @brief Error codes of the UDP republisher.
+ */
+typedef enum {
+	IMU_NET_OK = 0,             // Success.
+	IMU_NET_IO_ERROR = 1,       // A system call failed, see errno.
+	IMU_NET_BAD_ADDRESS = 2,    // The address is not a valid IPv4 address.
+	IMU_NET_TIMEOUT = 3         // No datagram arrived before the timeout.
+} ImuNetError_t;
+
+/**
+ * Transfer counters.
+ *
+ * @field packets       Packets sent, or valid packets received.
+ * @field datagrams     Datagrams sent or received.
+ * @field syscalls      `sendmmsg` / `recvmmsg` calls.
+ * @field invalid       Received packets rejected by `checkImuProtBuffer`.
+ * @field badDatagrams  Received datagrams with a wrong header or size.
+ * @field lostDatagrams Gaps in the datagram counter of the received stream.
+ */
+typedef struct {
+	uint64_t packets;
+	uint64_t datagrams;
+	uint64_t syscalls;
+	uint64_t invalid;
+	uint64_t badDatagrams;
+	uint64_t lostDatagrams;
+} ImuNetStats_t;
+
+/**
+ * Sender. All fields are private.
+ */
+typedef struct {
+	int fd;
+	struct sockaddr_in dest;
+	uint32_t streamId;
+	uint32_t datagramSeq;
+	uint32_t perDatagram;
+	uint32_t queued;
+	ImuNetDatagram_t datagrams[IMU_NET_BATCH];
+	ImuNetStats_t stats;
+} ImuNetSender_t;
+
+/**
+ * Receiver. All fields are private.
+ */
+typedef struct {
+	int fd;
+	uint32_t streamId;
+	int synced;
+	uint32_t nextSeq;
+	ImuNetDatagram_t datagrams[IMU_NET_BATCH];
+	ImuRecRecord_t records[IMU_NET_BATCH * IMU_NET_DATAGRAM_PACKETS];
+	ImuNetStats_t stats;
+} ImuNetReceiver_t;
+
+/**
+ * @brief Opens a sender.
+ *
+ * @param s             Sender to initialize.
+ * @param address       Destination IPv4 address, multicast or unicast.
+ * @param port          Destination UDP port.
+ * @param iface         Address of the outgoing interface for multicast, or NULL.
+ * @param ttl           Multicast time to live, 1 to stay on the local network.
+ * @param streamId      Identifier stored in every datagram.
+ * @param perDatagram   Packets per datagram, 0 for IMU_NET_DATAGRAM_PACKETS.
+ * @return ImuNetError_t IMU_NET_OK on success.
+ */
+ImuNetError_t imuNetSenderOpen(ImuNetSender_t *s, const char *address, uint16_t port, const char *iface,
+	int ttl, uint32_t streamId, uint32_t perDatagram);
+
+/**
+ * @brief Queues a validated packet, sending the batch once IMU_NET_BATCH datagrams are full.
+ *
+ * @param s         Sender.
+ * @param packet    Validated packet.
+ * @param rxTimeNs  Receive time of the packet.
+ * @return ImuNetError_t IMU_NET_OK on success.
+ */
+ImuNetError_t imuNetSend(ImuNetSender_t *s, const ImuProt_t *packet, uint64_t rxTimeNs);
+
+/**
+ * @brief Sends all queued datagrams, including a partially filled one.
+ *
+ * Call it when the input goes idle so that packets do not wait for the batch to fill.
+ *
+ * @param s Sender.
+ * @return ImuNetError_t IMU_NET_OK on success.
+ */
+ImuNetError_t imuNetFlush(ImuNetSender_t *s);
+
+/**
+ * @brief Flushes queued packets and closes the socket.
+ *
+ * @param s Sender.
+ * @return ImuNetError_t IMU_NET_OK on success.
+ */
+ImuNetError_t imuNetSenderClose(ImuNetSender_t *s);
+
+/**
+ * @brief Returns the sender counters.
+ */
+static inline const ImuNetStats_t *imuNetSenderStats(const ImuNetSender_t *s)
+{
+	return &s->stats;
+}
+
+/**
+ * @brief Opens a receiver, joining the group if the address is multicast.
+ *
+ * @param r         Receiver to initialize.
+ * @param address   Group address, or a local unicast address to bind.
+ * @param port      UDP port.
+ * @param iface     Address of the interface to join the group on, or NULL.
+ * @param streamId  Stream to accept, 0 for any.
+ * @param timeoutMs Receive timeout, 0 to wait forever.
+ * @return ImuNetError_t IMU_NET_OK on success.
+ */
+ImuNetError_t imuNetReceiverOpen(ImuNetReceiver_t *r, const char *address, uint16_t port, const char *iface,
+	uint32_t streamId, int timeoutMs);
+
+/**
+ * @brief Receives a batch of datagrams and returns their valid packets.
+ *
+ * Blocks for the first datagram and takes whatever else is already queued,
+ * all in one `recvmmsg` call.
+ *
+ * @param r         Receiver.
+ * @param records   Receives a pointer to the valid records, valid until the next call.
+ * @param count     Receives the number of records.
+ * @return ImuNetError_t IMU_NET_OK, IMU_NET_TIMEOUT, or IMU_NET_IO_ERROR.
+ */
+ImuNetError_t imuNetReceive(ImuNetReceiver_t *r, const ImuRecRecord_t **records, size_t *count);
+
+/**
+ * @brief Returns the receiver counters.
+ */
+static inline const ImuNetStats_t *imuNetReceiverStats(const ImuNetReceiver_t *r)
+{
+	return &r->stats;
+}
+
+/**
+ * @brief Closes the receiver socket.
+ *
+ * @param r Receiver.
+ */
+void imuNetReceiverClose(ImuNetReceiver_t *r);
+
+/**
+ * @brief Converts an ImuNetError_t error code to its string representation.
+ *
+ * @param error The ImuNetError_t error code.
+ * @return A string that describes the error.
+ */
+const char *imuNetErrorToString(ImuNetError_t error);
+
+#endif
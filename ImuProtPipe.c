@@ -0,0 +1,443 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ImuProtIsa.h"
+#include "ImuProtPipe.h"
+
+/** Bytes requested per read by the ingest thread. */
+#define PIPE_READ_SIZE (4096)
+
+/** Poll timeout of the ingest thread, bounds the reaction to `imuPipeStop`. */
+#define PIPE_POLL_MS (100)
+
+/**
+ * @brief Pins the calling thread, if a CPU was configured.
+ */
+static void pipePin(int cpu) {
+	if (cpu < 0)
+		return;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/**
+ * @brief Waits a little longer on every call: spin, then yield, then sleep.
+ */
+static void pipeBackoff(unsigned *spins) {
+	if (*spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	} else if (*spins < 128) {
+		sched_yield();
+	} else {
+		struct timespec ts = { .tv_sec = 0, .tv_nsec = 50000 };
+		nanosleep(&ts, NULL);
+	}
+	(*spins)++;
+}
+
+static uint64_t pipeNowNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Returns the statistics block of the ingest counters.
+ */
+static ImuStatsBlock_t *pipeStatsBlock(ImuPipe_t *p) {
+	return p->config.stats ? p->config.stats : &p->ownStats;
+}
+
+static int pipeLinkInit(ImuPipeLink_t *link, size_t capacity, ImuPipePolicy_t policy) {
+	link->policy = policy;
+	atomic_init(&link->closed, 0);
+	atomic_init(&link->passed, 0);
+	atomic_init(&link->droppedNewest, 0);
+	atomic_init(&link->droppedOldest, 0);
+	return imuRingInitItems(&link->ring, capacity, sizeof(ImuPipeItem_t));
+}
+
+/**
+ * @brief Producer side of a link: copies the items in, applying the link policy when full.
+ */
+static void pipePush(ImuPipe_t *p, ImuPipeLink_t *link, const ImuPipeItem_t *items, size_t count) {
+	unsigned spins = 0;
+	while (count) {
+		void *slots;
+		size_t n = imuRingReserveItems(&link->ring, &slots, count);
+		if (n) {
+			memcpy(slots, items, n * sizeof(ImuPipeItem_t));
+			imuRingCommit(&link->ring, n);
+			atomic_fetch_add_explicit(&link->passed, n, memory_order_relaxed);
+			items += n;
+			count -= n;
+			spins = 0;
+			continue;
+		}
+		// Blocking gives up once stopping, in case the consumer is stuck in a sink.
+		if (link->policy == IMU_PIPE_BLOCK && !atomic_load_explicit(&p->stop, memory_order_relaxed)) {
+			pipeBackoff(&spins);
+			continue;
+		}
+		atomic_fetch_add_explicit(&link->droppedNewest, count, memory_order_relaxed);
+		return;
+	}
+}
+
+/**
+ * @brief Consumer side of a link: returns the next batch, skipping the backlog for drop-oldest links.
+ */
+static size_t pipePeek(ImuPipeLink_t *link, const ImuPipeItem_t **items, size_t batch) {
+	if (link->policy == IMU_PIPE_DROP_OLDEST && imuRingSize(&link->ring) > imuRingCapacity(&link->ring) / 2) {
+		size_t skipped = imuRingDiscard(&link->ring, batch);
+		atomic_fetch_add_explicit(&link->droppedOldest, skipped, memory_order_relaxed);
+	}
+	return imuRingPeekItems(&link->ring, (const void **)items, batch);
+}
+
+/**
+ * @brief Returns non-zero once the producer closed the link and it is empty.
+ */
+static int pipeDrained(ImuPipeLink_t *link) {
+	return atomic_load_explicit(&link->closed, memory_order_acquire) && imuRingSize(&link->ring) == 0;
+}
+
+static void *pipeIngest(void *arg) {
+	ImuPipe_t *p = arg;
+	pipePin(p->config.ingestCpu);
+
+	uint8_t buffer[PIPE_READ_SIZE];
+	ImuProt_t packets[IMU_PIPE_BATCH];
+	size_t endOffsets[IMU_PIPE_BATCH];
+	ImuPipeItem_t items[IMU_PIPE_BATCH];
+	memset(items, 0, sizeof(items));
+
+	while (!atomic_load_explicit(&p->stop, memory_order_relaxed)) {
+		struct pollfd pfd = { .fd = p->config.fd, .events = POLLIN };
+		int ready = poll(&pfd, 1, PIPE_POLL_MS);
+		if (ready == 0 || (ready < 0 && errno == EINTR))
+			continue;
+		ssize_t len = ready > 0 ? read(p->config.fd, buffer, sizeof(buffer)) : -1;
+		if (len == 0)
+			break;
+		if (len < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			p->readErrno = errno;
+			break;
+		}
+
+		// One clock read per chunk; packets are placed by their byte offset.
+		uint64_t readTimeNs = pipeNowNs();
+		imuTimeChunk(&p->stamper, (size_t)len, readTimeNs);
+		size_t offset = 0;
+		while (offset < (size_t)len) {
+			size_t consumed;
+			size_t n = imuFramerPush(&p->framer, buffer + offset, (size_t)len - offset, packets, endOffsets,
+				p->config.batch, &consumed);
+			for (size_t i = 0; i < n; i++) {
+				imuStatsSequencer(p->statsSlot, packets[i].sequencer);
+				items[i].rxTimeNs = imuTimePacket(&p->stamper, offset + endOffsets[i],
+					imuTimePeriods(p->lastSequencer, packets[i].sequencer));
+				p->lastSequencer = packets[i].sequencer;
+				items[i].readTimeNs = readTimeNs;
+				items[i].packet = packets[i];
+			}
+			pipePush(p, &p->decodeLink, items, n);
+			offset += consumed;
+		}
+		imuStatsFrame(p->statsSlot, imuFramerStats(&p->framer));
+	}
+
+	atomic_store_explicit(&p->decodeLink.closed, 1, memory_order_release);
+	return NULL;
+}
+
+static void *pipeDecode(void *arg) {
+	ImuPipe_t *p = arg;
+	pipePin(p->config.decodeCpu);
+
+	ImuPipeItem_t items[IMU_PIPE_BATCH];
+	unsigned spins = 0;
+	for (;;) {
+		const ImuPipeItem_t *in;
+		size_t n = pipePeek(&p->decodeLink, &in, p->config.batch);
+		if (!n) {
+			if (pipeDrained(&p->decodeLink))
+				break;
+			pipeBackoff(&spins);
+			continue;
+		}
+		spins = 0;
+		for (size_t i = 0; i < n; i++) {
+			items[i].rxTimeNs = in[i].rxTimeNs;
+			items[i].readTimeNs = in[i].readTimeNs;
+			items[i].packet = in[i].packet;
+		}
+		imuDecodeSamples(&items[0].packet, sizeof(ImuPipeItem_t), &items[0].sample, sizeof(ImuPipeItem_t), n);
+		imuRingConsume(&p->decodeLink.ring, n);
+		for (size_t s = 0; s < p->sinkCount; s++)
+			pipePush(p, &p->sinkLinks[s], items, n);
+	}
+
+	for (size_t s = 0; s < p->sinkCount; s++)
+		atomic_store_explicit(&p->sinkLinks[s].closed, 1, memory_order_release);
+	return NULL;
+}
+
+static void *pipeSink(void *arg) {
+	ImuPipe_t *p = ((ImuPipeSinkArg_t *)arg)->pipe;
+	size_t index = ((ImuPipeSinkArg_t *)arg)->index;
+	ImuPipeSink_t *sink = &p->sinks[index];
+	ImuPipeLink_t *link = &p->sinkLinks[index];
+	pipePin(sink->cpu);
+
+	unsigned spins = 0;
+	int idle = 1;
+	for (;;) {
+		const ImuPipeItem_t *items;
+		size_t n = pipePeek(link, &items, p->config.batch);
+		if (!n) {
+			if (!idle && sink->idle)
+				sink->idle(sink->ctx);
+			idle = 1;
+			if (pipeDrained(link))
+				break;
+			pipeBackoff(&spins);
+			continue;
+		}
+		spins = 0;
+		idle = 0;
+		size_t failed = sink->write(sink->ctx, items, n);
+		if (failed)
+			atomic_fetch_add_explicit(&link->failed, failed, memory_order_relaxed);
+		uint64_t now = pipeNowNs();
+		for (size_t i = 0; i < n; i++)
+			imuHistRecord(&p->latency[index], now > items[i].readTimeNs ? now - items[i].readTimeNs : 0);
+		imuRingConsume(&link->ring, n);
+	}
+	return NULL;
+}
+
+void imuPipeConfigInit(ImuPipeConfig_t *config, int fd) {
+	memset(config, 0, sizeof(*config));
+	config->fd = fd;
+	config->ingestCpu = -1;
+	config->decodeCpu = -1;
+	config->policy = IMU_PIPE_BLOCK;
+}
+
+ImuPipeError_t imuPipeStart(ImuPipe_t *p, const ImuPipeConfig_t *config, const ImuPipeSink_t *sinks,
+	size_t sinkCount) {
+	memset(p, 0, sizeof(*p));
+	if (sinkCount > IMU_PIPE_MAX_SINKS)
+		return IMU_PIPE_BAD_ARGUMENT;
+	p->config = *config;
+	if (!p->config.ringCapacity)
+		p->config.ringCapacity = IMU_PIPE_RING_CAPACITY;
+	if (!p->config.batch || p->config.batch > IMU_PIPE_BATCH)
+		p->config.batch = IMU_PIPE_BATCH;
+	if (p->config.ringCapacity < 2 * p->config.batch
+		|| (p->config.ringCapacity & (p->config.ringCapacity - 1)) != 0)
+		return IMU_PIPE_BAD_ARGUMENT;
+	p->sinkCount = sinkCount;
+	memcpy(p->sinks, sinks, sinkCount * sizeof(*sinks));
+	atomic_init(&p->stop, 0);
+	imuFramerInit(&p->framer);
+	imuTimeInit(&p->stamper, p->config.baudRate, p->config.periodNs);
+	for (size_t s = 0; s < sinkCount; s++)
+		imuHistInit(&p->latency[s]);
+	imuStatsInit(&p->ownStats);
+	p->statsSlot = imuStatsAcquire(pipeStatsBlock(p));
+	if (!p->statsSlot)
+		return IMU_PIPE_BAD_ARGUMENT;
+
+	size_t links = 0;
+	ImuPipeError_t result = IMU_PIPE_OK;
+	if (pipeLinkInit(&p->decodeLink, p->config.ringCapacity, p->config.policy) != 0) {
+		imuStatsRelease(pipeStatsBlock(p), p->statsSlot);
+		return IMU_PIPE_NO_MEMORY;
+	}
+	for (; links < sinkCount; links++) {
+		if (pipeLinkInit(&p->sinkLinks[links], p->config.ringCapacity, sinks[links].policy) != 0) {
+			result = IMU_PIPE_NO_MEMORY;
+			break;
+		}
+	}
+
+	// Downstream first, so that no stage pushes into a ring nobody reads.
+	size_t started = 0;
+	while (result == IMU_PIPE_OK && started < sinkCount) {
+		ImuPipeSinkArg_t *arg = &p->sinkArgs[started];
+		arg->pipe = p;
+		arg->index = started;
+		if (pthread_create(&p->sinkThreads[started], NULL, pipeSink, arg) != 0)
+			result = IMU_PIPE_THREAD_ERROR;
+		else
+			started++;
+	}
+	if (result == IMU_PIPE_OK && pthread_create(&p->decodeThread, NULL, pipeDecode, p) != 0)
+		result = IMU_PIPE_THREAD_ERROR;
+	if (result == IMU_PIPE_OK && pthread_create(&p->ingestThread, NULL, pipeIngest, p) != 0) {
+		atomic_store(&p->decodeLink.closed, 1);
+		pthread_join(p->decodeThread, NULL);
+		result = IMU_PIPE_THREAD_ERROR;
+	}
+	if (result == IMU_PIPE_OK)
+		return IMU_PIPE_OK;
+
+	for (size_t s = 0; s < started; s++) {
+		atomic_store(&p->sinkLinks[s].closed, 1);
+		pthread_join(p->sinkThreads[s], NULL);
+	}
+	for (size_t s = 0; s < links; s++)
+		imuRingFree(&p->sinkLinks[s].ring);
+	imuRingFree(&p->decodeLink.ring);
+	imuStatsRelease(pipeStatsBlock(p), p->statsSlot);
+	return result;
+}
+
+void imuPipeStop(ImuPipe_t *p) {
+	atomic_store_explicit(&p->stop, 1, memory_order_relaxed);
+}
+
+void imuPipeStats(ImuPipe_t *p, ImuPipeStats_t *stats) {
+	memset(stats, 0, sizeof(*stats));
+	ImuStatsSnapshot_t ingest;
+	memset(&ingest, 0, sizeof(ingest));
+	imuStatsSlotAdd(p->statsSlot, &ingest);
+	stats->frame.packets = ingest.packets;
+	stats->frame.bytes = ingest.bytes;
+	stats->frame.discarded = ingest.discarded;
+	stats->frame.resyncs = ingest.resyncs;
+	memcpy(stats->frame.errors, ingest.errors, sizeof(stats->frame.errors));
+	stats->gaps = ingest.gaps;
+	stats->lost = ingest.lost;
+	stats->muxCycles = ingest.muxCycles;
+	stats->ingested = atomic_load_explicit(&p->decodeLink.passed, memory_order_relaxed);
+	stats->dropped = atomic_load_explicit(&p->decodeLink.droppedNewest, memory_order_relaxed)
+		+ atomic_load_explicit(&p->decodeLink.droppedOldest, memory_order_relaxed);
+	stats->decoded = stats->ingested - atomic_load_explicit(&p->decodeLink.droppedOldest, memory_order_relaxed)
+		- imuRingSize(&p->decodeLink.ring);
+	stats->sinkCount = p->sinkCount;
+	for (size_t s = 0; s < p->sinkCount; s++) {
+		ImuPipeLink_t *link = &p->sinkLinks[s];
+		uint64_t oldest = atomic_load_explicit(&link->droppedOldest, memory_order_relaxed);
+		stats->sinkDropped[s] = atomic_load_explicit(&link->droppedNewest, memory_order_relaxed) + oldest;
+		stats->sinkFailed[s] = atomic_load_explicit(&link->failed, memory_order_relaxed);
+		stats->delivered[s] = atomic_load_explicit(&link->passed, memory_order_relaxed) - oldest
+			- imuRingSize(&link->ring) - stats->sinkFailed[s];
+	}
+}
+
+void imuPipeLatency(ImuPipe_t *p, size_t sink, ImuHist_t *hist) {
+	if (sink < p->sinkCount)
+		imuHistMerge(hist, &p->latency[sink]);
+}
+
+ImuPipeError_t imuPipeJoin(ImuPipe_t *p, ImuPipeStats_t *stats) {
+	pthread_join(p->ingestThread, NULL);
+	pthread_join(p->decodeThread, NULL);
+	for (size_t s = 0; s < p->sinkCount; s++)
+		pthread_join(p->sinkThreads[s], NULL);
+
+	if (stats)
+		imuPipeStats(p, stats);
+	imuStatsRelease(pipeStatsBlock(p), p->statsSlot);
+	p->statsSlot = NULL;
+	for (size_t s = 0; s < p->sinkCount; s++)
+		imuRingFree(&p->sinkLinks[s].ring);
+	imuRingFree(&p->decodeLink.ring);
+
+	if (p->readErrno) {
+		errno = p->readErrno;
+		return IMU_PIPE_IO_ERROR;
+	}
+	return IMU_PIPE_OK;
+}
+
+static size_t pipeRecWrite(void *ctx, const ImuPipeItem_t *items, size_t count) {
+	size_t failed = 0;
+	for (size_t i = 0; i < count; i++)
+		failed += imuRecWrite(ctx, &items[i].packet, items[i].rxTimeNs) != IMU_REC_OK;
+	return failed;
+}
+
+static void pipeRecIdle(void *ctx) {
+	imuRecFlush(ctx);
+}
+
+void imuPipeRecSink(ImuPipeSink_t *sink, ImuRecWriter_t *writer) {
+	sink->name = "rec";
+	sink->write = pipeRecWrite;
+	sink->idle = pipeRecIdle;
+	sink->ctx = writer;
+	sink->policy = IMU_PIPE_BLOCK;
+	sink->cpu = -1;
+}
+
+static size_t pipeShmWrite(void *ctx, const ImuPipeItem_t *items, size_t count) {
+	ImuProt_t packets[IMU_PIPE_BATCH];
+	uint64_t rxTimesNs[IMU_PIPE_BATCH];
+	for (size_t i = 0; i < count; i++) {
+		packets[i] = items[i].packet;
+		rxTimesNs[i] = items[i].rxTimeNs;
+	}
+	imuShmPublish(ctx, packets, rxTimesNs, count);
+	return 0;
+}
+
+void imuPipeShmSink(ImuPipeSink_t *sink, ImuShmWriter_t *writer) {
+	sink->name = "shm";
+	sink->write = pipeShmWrite;
+	sink->idle = NULL;
+	sink->ctx = writer;
+	sink->policy = IMU_PIPE_DROP_OLDEST;
+	sink->cpu = -1;
+}
+
+static size_t pipeNetWrite(void *ctx, const ImuPipeItem_t *items, size_t count) {
+	size_t failed = 0;
+	for (size_t i = 0; i < count; i++)
+		failed += imuNetSend(ctx, &items[i].packet, items[i].rxTimeNs) != IMU_NET_OK;
+	return failed;
+}
+
+static void pipeNetIdle(void *ctx) {
+	imuNetFlush(ctx);
+}
+
+void imuPipeNetSink(ImuPipeSink_t *sink, ImuNetSender_t *sender) {
+	sink->name = "net";
+	sink->write = pipeNetWrite;
+	sink->idle = pipeNetIdle;
+	sink->ctx = sender;
+	sink->policy = IMU_PIPE_DROP_OLDEST;
+	sink->cpu = -1;
+}
+
+const char *imuPipeErrorToString(ImuPipeError_t error) {
+	switch (error) {
+		case IMU_PIPE_OK:
+			return "OK.";
+		case IMU_PIPE_BAD_ARGUMENT:
+			return "Invalid pipeline configuration!";
+		case IMU_PIPE_NO_MEMORY:
+			return "Out of memory!";
+		case IMU_PIPE_THREAD_ERROR:
+			return "Thread creation failed!";
+		case IMU_PIPE_IO_ERROR:
+			return "I/O error!";
+	}
+	return "Unknown error.";
+}
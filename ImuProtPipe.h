@@ -0,0 +1,296 @@
+/**
+ * Multi-Stage Packet Pipeline.
+ *
+ * Runs the receive chain on dedicated, optionally CPU-pinned threads:
+ *
+ *   ingest (read, deframe, timestamp) -> decode -> sink, sink, ...
+ *
+ * - Ingest reads the input descriptor, cuts the stream into validated packets
+ *   with `imuFramerPush` and stamps them with `imuTimePacket` (CLOCK_MONOTONIC).
+ * - Decode converts gyro, accl and temperature with `floatData` and
+ *   `tempFromKelvin` and hands every batch to each sink.
+ * - Each sink runs on its own thread, e.g. a recording, the shared memory
+ *   ring or the UDP republisher, so a slow sink never delays the others or
+ *   the ingest thread.
+ *
+ * Every sink thread records, per packet, the time from the read that
+ * returned its last byte until the sink's `write` returned in a histogram
+ * (`imuPipeLatency`), at the cost of one clock read per batch.
+ *
+ * Stages are connected by lock-free SPSC rings (`ImuProtRing.h`) and hand
+ * over batches. What happens when a ring is full is chosen per ring:
+ *
+ * - IMU_PIPE_BLOCK: the upstream stage waits. Lossless, but a stalled sink
+ *   eventually stalls the upstream stages.
+ * - IMU_PIPE_DROP_NEWEST: items that do not fit are dropped upstream.
+ * - IMU_PIPE_DROP_OLDEST: the downstream stage discards its backlog, keeping
+ *   one batch, whenever it finds the ring more than half full, so it always
+ *   works on recent data. Items that still do not fit are dropped upstream.
+ */
+
+#ifndef ImuProtPipe_h_included__
+#define ImuProtPipe_h_included__
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtFrame.h"
+#include "ImuProtHist.h"
+#include "ImuProtNet.h"
+#include "ImuProtRec.h"
+#include "ImuProtRing.h"
+#include "ImuProtSample.h"
+#include "ImuProtShm.h"
+#include "ImuProtStats.h"
+#include "ImuProtTime.h"
+
+/** Maximum number of sinks. */
+#define IMU_PIPE_MAX_SINKS (8)
+
+/** Default ring capacity between stages. */
+#define IMU_PIPE_RING_CAPACITY (4096)
+
+/** Default and maximum number of items handed over at once. */
+#define IMU_PIPE_BATCH (64)
+
+/**
+ * Item passed between the stages.
+ *
+ * @field rxTimeNs      Receive time of the packet, see `imuTimePacket`.
+ * @field readTimeNs    Time the read returning the last byte of the packet returned.
+ * @field packet        Validated packet.
+ * @field sample        Decoded sample, filled by the decode stage.
+ */
+typedef struct {
+	uint64_t rxTimeNs;
+	uint64_t readTimeNs;
+	ImuProt_t packet;
+	ImuSample_t sample;
+} ImuPipeItem_t;
+
+/**
+ * @enum ImuPipePolicy_t
+ * @brief What a stage does when the ring to the next stage is full.
+ */
+typedef enum {
+	IMU_PIPE_BLOCK = 0,         // Wait for space.
+	IMU_PIPE_DROP_OLDEST = 1,   // The next stage skips its backlog.
+	IMU_PIPE_DROP_NEWEST = 2    // Drop the items that do not fit.
+} ImuPipePolicy_t;
+
+/**
+ * @enum ImuPipeError_t
+ * @brief Error codes of the pipeline.
+ */
+typedef enum {
+	IMU_PIPE_OK = 0,            // Success.
+	IMU_PIPE_BAD_ARGUMENT = 1,  // Too many sinks or an invalid ring capacity.
+	IMU_PIPE_NO_MEMORY = 2,     // Memory allocation failed.
+	IMU_PIPE_THREAD_ERROR = 3,  // A thread could not be created.
+	IMU_PIPE_IO_ERROR = 4       // Reading the input failed, see the saved errno.
+} ImuPipeError_t;
+
+/**
+ * A sink.
+ *
+ * @field name      Name used in statistics.
+ * @field write     Called on the sink thread with every batch, returns the number of
+ *                  items it failed to write.
+ * @field idle      Optional, called once when the sink runs out of items, e.g. to flush.
+ * @field ctx       Passed to `write` and `idle`.
+ * @field policy    Policy of the ring feeding the sink.
+ * @field cpu       CPU to pin the sink thread to, -1 for none.
+ */
+typedef struct {
+	const char *name;
+	size_t (*write)(void *ctx, const ImuPipeItem_t *items, size_t count);
+	void (*idle)(void *ctx);
+	void *ctx;
+	ImuPipePolicy_t policy;
+	int cpu;
+} ImuPipeSink_t;
+
+/**
+ * Pipeline configuration.
+ *
+ * @field fd            Input descriptor: serial port, pipe, socket or file.
+ * @field baudRate      Line rate for timestamps, 0 for IMO_PROT_BAUDRATE.
+ * @field periodNs      Packet period for timestamps, 0 for back to back frames.
+ * @field ingestCpu     CPU of the ingest thread, -1 for none.
+ * @field decodeCpu     CPU of the decode thread, -1 for none.
+ * @field policy        Policy of the ring between ingest and decode.
+ * @field ringCapacity  Capacity of every ring, a power of two, 0 for IMU_PIPE_RING_CAPACITY.
+ * @field batch         Items per hand-over, 0 or more than IMU_PIPE_BATCH for IMU_PIPE_BATCH.
+ * @field stats         Optional block, e.g. in shared memory, receiving the ingest counters.
+ */
+typedef struct {
+	int fd;
+	uint32_t baudRate;
+	uint64_t periodNs;
+	int ingestCpu;
+	int decodeCpu;
+	ImuPipePolicy_t policy;
+	size_t ringCapacity;
+	size_t batch;
+	ImuStatsBlock_t *stats;
+} ImuPipeConfig_t;
+
+/**
+ * Ring between two stages. All fields are private.
+ */
+typedef struct {
+	ImuRing_t ring;
+	ImuPipePolicy_t policy;
+	_Atomic int closed;
+	_Atomic uint64_t passed;
+	_Atomic uint64_t droppedNewest;
+	_Atomic uint64_t droppedOldest;
+	_Atomic uint64_t failed;
+} ImuPipeLink_t;
+
+/**
+ * Pipeline counters.
+ *
+ * @field frame         Deframer counters, published after every read.
+ * @field gaps          Sequencer gaps.
+ * @field lost          Packets missing according to the sequencer.
+ * @field muxCycles     Complete mux cycles.
+ * @field ingested      Packets handed to the decode stage.
+ * @field decoded       Packets decoded.
+ * @field dropped       Packets dropped between ingest and decode.
+ * @field sinkCount     Number of sinks.
+ * @field delivered     Packets written by every sink.
+ * @field sinkDropped   Packets dropped before every sink.
+ * @field sinkFailed    Packets every sink failed to write.
+ */
+typedef struct {
+	ImuFrameStats_t frame;
+	uint64_t gaps;
+	uint64_t lost;
+	uint64_t muxCycles;
+	uint64_t ingested;
+	uint64_t decoded;
+	uint64_t dropped;
+	size_t sinkCount;
+	uint64_t delivered[IMU_PIPE_MAX_SINKS];
+	uint64_t sinkDropped[IMU_PIPE_MAX_SINKS];
+	uint64_t sinkFailed[IMU_PIPE_MAX_SINKS];
+} ImuPipeStats_t;
+
+/**
+ * Argument of a sink thread. All fields are private.
+ */
+typedef struct {
+	void *pipe;
+	size_t index;
+} ImuPipeSinkArg_t;
+
+/**
+ * Pipeline. All fields are private.
+ */
+typedef struct {
+	ImuPipeConfig_t config;
+	ImuPipeLink_t decodeLink;
+	ImuPipeLink_t sinkLinks[IMU_PIPE_MAX_SINKS];
+	ImuPipeSink_t sinks[IMU_PIPE_MAX_SINKS];
+	size_t sinkCount;
+	pthread_t ingestThread;
+	pthread_t decodeThread;
+	pthread_t sinkThreads[IMU_PIPE_MAX_SINKS];
+	ImuPipeSinkArg_t sinkArgs[IMU_PIPE_MAX_SINKS];
+	ImuFramer_t framer;
+	ImuTimeStamper_t stamper;
+	uint8_t lastSequencer;
+	ImuHist_t latency[IMU_PIPE_MAX_SINKS];
+	ImuStatsBlock_t ownStats;
+	ImuStatsSlot_t *statsSlot;
+	_Atomic int stop;
+	int readErrno;
+} ImuPipe_t;
+
+/**
+ * @brief Initializes a configuration with defaults: no pinning, blocking, default ring and batch.
+ *
+ * @param config    Configuration to initialize.
+ * @param fd        Input descriptor.
+ */
+void imuPipeConfigInit(ImuPipeConfig_t *config, int fd);
+
+/**
+ * @brief Starts all pipeline threads.
+ *
+ * @param p         Pipeline to start.
+ * @param config    Configuration.
+ * @param sinks     Sinks, copied.
+ * @param sinkCount Number of sinks, at most IMU_PIPE_MAX_SINKS.
+ * @return ImuPipeError_t IMU_PIPE_OK on success, IMU_PIPE_BAD_ARGUMENT if the
+ *         statistics block has no free slot.
+ */
+ImuPipeError_t imuPipeStart(ImuPipe_t *p, const ImuPipeConfig_t *config, const ImuPipeSink_t *sinks,
+	size_t sinkCount);
+
+/**
+ * @brief Asks the ingest thread to stop; the other stages drain their rings and stop.
+ *
+ * Safe to call from a signal handler.
+ *
+ * @param p Pipeline.
+ */
+void imuPipeStop(ImuPipe_t *p);
+
+/**
+ * @brief Reads the counters while the pipeline runs, or after it stopped.
+ *
+ * @param p     Pipeline.
+ * @param stats Output.
+ */
+void imuPipeStats(ImuPipe_t *p, ImuPipeStats_t *stats);
+
+/**
+ * @brief Adds the read-to-delivery latencies of a sink, in nanoseconds, to a histogram.
+ *
+ * May be called periodically while the pipeline runs, or after it stopped.
+ *
+ * @param p     Pipeline.
+ * @param sink  Index of the sink.
+ * @param hist  Histogram initialized with `imuHistInit`, owned by the caller.
+ */
+void imuPipeLatency(ImuPipe_t *p, size_t sink, ImuHist_t *hist);
+
+/**
+ * @brief Waits until the input ends or the pipeline was stopped, and frees it.
+ *
+ * @param p     Pipeline.
+ * @param stats Optional, receives the final counters.
+ * @return ImuPipeError_t IMU_PIPE_OK, or IMU_PIPE_IO_ERROR if reading the input failed.
+ */
+ImuPipeError_t imuPipeJoin(ImuPipe_t *p, ImuPipeStats_t *stats);
+
+/**
+ * @brief Sink writing every packet to a recording with `imuRecWrite`, flushing when idle.
+ * Blocking policy. Packets for which `imuRecWrite` fails are counted in `sinkFailed`.
+ */
+void imuPipeRecSink(ImuPipeSink_t *sink, ImuRecWriter_t *writer);
+
+/**
+ * @brief Sink publishing every batch with `imuShmPublish`. Drop-oldest policy.
+ */
+void imuPipeShmSink(ImuPipeSink_t *sink, ImuShmWriter_t *writer);
+
+/**
+ * @brief Sink republishing packets with `imuNetSend`, flushing when idle. Drop-oldest policy.
+ */
+void imuPipeNetSink(ImuPipeSink_t *sink, ImuNetSender_t *sender);
+
+/**
+ * @brief Converts an ImuPipeError_t error code to its string representation.
+ *
+ * @param error The ImuPipeError_t error code.
+ * @return A string that describes the error.
+ */
+const char *imuPipeErrorToString(ImuPipeError_t error);
+
+#endif
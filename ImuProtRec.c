@@ -0,0 +1,421 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ImuProtRec.h"
+
+_Static_assert(sizeof(ImuRecRecord_t) == 48, "record layout");
+_Static_assert(sizeof(ImuRecFileHeader_t) == 64, "file header layout");
+_Static_assert(sizeof(ImuRecChunkHeader_t) == 64, "chunk header layout");
+_Static_assert(sizeof(ImuRecIndexEntry_t) == 40, "index entry layout");
+
+#define CHUNK_CRC_BYTES (sizeof(ImuRecChunkHeader_t) - sizeof(uint32_t))
+
+/**
+ * @brief Writes the whole buffer, retrying on short writes.
+ */
+static int recWriteAll(int fd, const void *data, size_t len) {
+	const uint8_t *p = data;
+	while (len) {
+		ssize_t n = write(fd, p, len);
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= (size_t)n;
+	}
+	return 0;
+}
+
+ImuRecError_t imuRecWriterOpen(ImuRecWriter_t *w, const char *path, uint32_t chunkRecords) {
+	memset(w, 0, sizeof(*w));
+	w->fd = -1;
+	w->capacity = chunkRecords ? chunkRecords : IMU_REC_CHUNK_RECORDS;
+	w->records = malloc((size_t)w->capacity * sizeof(ImuRecRecord_t));
+	if (!w->records)
+		return IMU_REC_NO_MEMORY;
+
+	w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (w->fd < 0) {
+		free(w->records);
+		w->records = NULL;
+		return IMU_REC_IO_ERROR;
+	}
+
+	ImuRecFileHeader_t header;
+	struct timespec ts;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, IMU_REC_MAGIC, sizeof(header.magic));
+	header.version = IMU_REC_VERSION;
+	header.recordSize = sizeof(ImuRecRecord_t);
+	header.chunkCapacity = w->capacity;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	header.createdNs = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+
+	if (recWriteAll(w->fd, &header, sizeof(header)) != 0) {
+		close(w->fd);
+		free(w->records);
+		w->fd = -1;
+		w->records = NULL;
+		return IMU_REC_IO_ERROR;
+	}
+	w->offset = sizeof(header);
+	return IMU_REC_OK;
+}
+
+ImuRecError_t imuRecFlush(ImuRecWriter_t *w) {
+	if (w->failed)
+		return IMU_REC_IO_ERROR;
+	if (!w->count)
+		return IMU_REC_OK;
+
+	if (w->indexCount == w->indexCapacity) {
+		size_t capacity = w->indexCapacity ? 2 * w->indexCapacity : 256;
+		ImuRecIndexEntry_t *index = realloc(w->index, capacity * sizeof(*index));
+		if (!index)
+			return IMU_REC_NO_MEMORY;
+		w->index = index;
+		w->indexCapacity = capacity;
+	}
+
+	ImuRecChunkHeader_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = IMU_REC_CHUNK_MAGIC;
+	header.count = w->count;
+	header.firstIndex = w->nextIndex;
+	header.firstTimeNs = w->records[0].rxTimeNs;
+	header.lastTimeNs = w->records[w->count - 1].rxTimeNs;
+	header.headerCrc = protCRC32((const uint8_t *)&header, CHUNK_CRC_BYTES);
+
+	// Header and records go out in a single system call.
+	struct iovec iov[2] = {
+		{ &header, sizeof(header) },
+		{ w->records, (size_t)w->count * sizeof(ImuRecRecord_t) },
+	};
+	size_t total = iov[0].iov_len + iov[1].iov_len;
+	ssize_t n = writev(w->fd, iov, 2);
+	if (n < 0)
+		return IMU_REC_IO_ERROR;  // Nothing written, the flush may be retried.
+	if ((size_t)n != total) {
+		// Short write: finish the remainder piece by piece. If that fails, part
+		// of the chunk is in the file and a retry would misplace the rest, so
+		// the writer stops here and the file ends with a truncated chunk.
+		size_t done = (size_t)n;
+		if (done < sizeof(header)) {
+			if (recWriteAll(w->fd, (const uint8_t *)&header + done, sizeof(header) - done) != 0) {
+				w->failed = 1;
+				return IMU_REC_IO_ERROR;
+			}
+			done = sizeof(header);
+		}
+		if (recWriteAll(w->fd, (const uint8_t *)w->records + (done - sizeof(header)), total - done) != 0) {
+			w->failed = 1;
+			return IMU_REC_IO_ERROR;
+		}
+	}
+
+	ImuRecIndexEntry_t *entry = &w->index[w->indexCount++];
+	memset(entry, 0, sizeof(*entry));
+	entry->offset = w->offset;
+	entry->firstIndex = header.firstIndex;
+	entry->firstTimeNs = header.firstTimeNs;
+	entry->lastTimeNs = header.lastTimeNs;
+	entry->count = header.count;
+
+	w->offset += total;
+	w->nextIndex += w->count;
+	w->count = 0;
+	return IMU_REC_OK;
+}
+
+ImuRecError_t imuRecWrite(ImuRecWriter_t *w, const ImuProt_t *packet, uint64_t rxTimeNs) {
+	if (w->failed)
+		return IMU_REC_IO_ERROR;
+	// A previous flush of the full chunk failed, retry before overwriting anything.
+	if (w->count == w->capacity) {
+		ImuRecError_t result = imuRecFlush(w);
+		if (result != IMU_REC_OK)
+			return result;
+	}
+
+	if (rxTimeNs < w->lastTimeNs)
+		rxTimeNs = w->lastTimeNs;
+	w->lastTimeNs = rxTimeNs;
+
+	ImuRecRecord_t *record = &w->records[w->count];
+	record->rxTimeNs = rxTimeNs;
+	memcpy(&record->packet, packet, sizeof(ImuProt_t));
+
+	if (++w->count == w->capacity)
+		return imuRecFlush(w);
+	return IMU_REC_OK;
+}
+
+ImuRecError_t imuRecWriterClose(ImuRecWriter_t *w) {
+	ImuRecError_t result = IMU_REC_OK;
+	if (w->fd < 0)
+		return IMU_REC_BAD_ARGUMENT;
+
+	result = imuRecFlush(w);
+	if (result == IMU_REC_OK) {
+		ImuRecTrailer_t trailer;
+		trailer.indexOffset = w->offset;
+		trailer.entries = (uint32_t)w->indexCount;
+		trailer.magic = IMU_REC_INDEX_MAGIC;
+		if (recWriteAll(w->fd, w->index, w->indexCount * sizeof(ImuRecIndexEntry_t)) != 0 ||
+			recWriteAll(w->fd, &trailer, sizeof(trailer)) != 0)
+			result = IMU_REC_IO_ERROR;
+	}
+	if (close(w->fd) != 0 && result == IMU_REC_OK)
+		result = IMU_REC_IO_ERROR;
+
+	free(w->records);
+	free(w->index);
+	memset(w, 0, sizeof(*w));
+	w->fd = -1;
+	return result;
+}
+
+/**
+ * @brief Checks that a chunk header at `offset` is intact and fits in the file.
+ */
+static int recChunkValid(const ImuRecReader_t *r, uint64_t offset, const ImuRecChunkHeader_t **out) {
+	if (offset + sizeof(ImuRecChunkHeader_t) > r->size)
+		return 0;
+	const ImuRecChunkHeader_t *h = (const ImuRecChunkHeader_t *)(r->map + offset);
+	if (h->magic != IMU_REC_CHUNK_MAGIC || !h->count)
+		return 0;
+	if (protCRC32((const uint8_t *)h, CHUNK_CRC_BYTES) != h->headerCrc)
+		return 0;
+	if (offset + sizeof(*h) + (uint64_t)h->count * sizeof(ImuRecRecord_t) > r->size)
+		return 0;
+	*out = h;
+	return 1;
+}
+
+/**
+ * @brief Uses the trailer index if the file was closed cleanly.
+ *
+ * Every entry must describe an intact chunk header, and the chunks must
+ * follow each other from the file header up to the index, so that a damaged
+ * index falls back to a rebuild instead of sending readers out of the chunks.
+ */
+static int recLoadIndex(ImuRecReader_t *r) {
+	if (r->size < sizeof(ImuRecFileHeader_t) + sizeof(ImuRecTrailer_t))
+		return 0;
+	const ImuRecTrailer_t *t = (const ImuRecTrailer_t *)(r->map + r->size - sizeof(*t));
+	if (t->magic != IMU_REC_INDEX_MAGIC)
+		return 0;
+	if (t->indexOffset < sizeof(ImuRecFileHeader_t) || t->indexOffset > r->size - sizeof(*t)
+		|| r->size - sizeof(*t) - t->indexOffset != (uint64_t)t->entries * sizeof(ImuRecIndexEntry_t))
+		return 0;
+
+	const ImuRecIndexEntry_t *index = (const ImuRecIndexEntry_t *)(r->map + t->indexOffset);
+	uint64_t offset = sizeof(ImuRecFileHeader_t), next = 0;
+	for (uint32_t i = 0; i < t->entries; i++) {
+		const ImuRecIndexEntry_t *e = &index[i];
+		const ImuRecChunkHeader_t *h;
+		if (e->offset != offset || e->firstIndex != next || !recChunkValid(r, offset, &h))
+			return 0;
+		if (h->count != e->count || h->firstIndex != e->firstIndex || h->firstTimeNs != e->firstTimeNs
+			|| h->lastTimeNs != e->lastTimeNs)
+			return 0;
+		offset += sizeof(*h) + (uint64_t)h->count * sizeof(ImuRecRecord_t);
+		next += h->count;
+	}
+	if (offset != t->indexOffset)
+		return 0;
+
+	r->index = index;
+	r->indexCount = t->entries;
+	return 1;
+}
+
+/**
+ * @brief Rebuilds the index by walking the chunk headers.
+ *
+ * Only headers are touched, so this costs one page per chunk, not a parse
+ * of the records. Walking stops at the first damaged or truncated chunk.
+ */
+static ImuRecError_t recRebuildIndex(ImuRecReader_t *r) {
+	size_t capacity = 0;
+	uint64_t offset = sizeof(ImuRecFileHeader_t);
+	const ImuRecChunkHeader_t *h;
+
+	while (recChunkValid(r, offset, &h)) {
+		if (r->indexCount == capacity) {
+			capacity = capacity ? 2 * capacity : 256;
+			ImuRecIndexEntry_t *index = realloc(r->ownedIndex, capacity * sizeof(*index));
+			if (!index)
+				return IMU_REC_NO_MEMORY;
+			r->ownedIndex = index;
+		}
+		ImuRecIndexEntry_t *e = &r->ownedIndex[r->indexCount++];
+		memset(e, 0, sizeof(*e));
+		e->offset = offset;
+		e->firstIndex = h->firstIndex;
+		e->firstTimeNs = h->firstTimeNs;
+		e->lastTimeNs = h->lastTimeNs;
+		e->count = h->count;
+		offset += sizeof(*h) + (uint64_t)h->count * sizeof(ImuRecRecord_t);
+	}
+	r->index = r->ownedIndex;
+	r->recovered = 1;
+	return IMU_REC_OK;
+}
+
+ImuRecError_t imuRecReaderOpen(ImuRecReader_t *r, const char *path) {
+	memset(r, 0, sizeof(*r));
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return IMU_REC_IO_ERROR;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return IMU_REC_IO_ERROR;
+	}
+	if ((size_t)st.st_size < sizeof(ImuRecFileHeader_t)) {
+		close(fd);
+		return IMU_REC_BAD_FORMAT;
+	}
+
+	void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return IMU_REC_IO_ERROR;
+	r->map = map;
+	r->size = (size_t)st.st_size;
+
+	const ImuRecFileHeader_t *header = map;
+	if (memcmp(header->magic, IMU_REC_MAGIC, sizeof(header->magic)) != 0 ||
+		header->version != IMU_REC_VERSION || header->recordSize != sizeof(ImuRecRecord_t)) {
+		imuRecReaderClose(r);
+		return IMU_REC_BAD_FORMAT;
+	}
+
+	if (!recLoadIndex(r)) {
+		ImuRecError_t result = recRebuildIndex(r);
+		if (result != IMU_REC_OK) {
+			imuRecReaderClose(r);
+			return result;
+		}
+	}
+
+	if (r->indexCount) {
+		const ImuRecIndexEntry_t *last = &r->index[r->indexCount - 1];
+		r->records = last->firstIndex + last->count;
+	}
+	return IMU_REC_OK;
+}
+
+void imuRecReaderClose(ImuRecReader_t *r) {
+	if (r->map)
+		munmap((void *)r->map, r->size);
+	free(r->ownedIndex);
+	memset(r, 0, sizeof(*r));
+}
+
+static inline const ImuRecRecord_t *recChunkRecords(const ImuRecReader_t *r, size_t chunk) {
+	return (const ImuRecRecord_t *)(r->map + r->index[chunk].offset + sizeof(ImuRecChunkHeader_t));
+}
+
+/**
+ * @brief Finds the chunk containing a global record index.
+ */
+static size_t recFindChunk(const ImuRecReader_t *r, uint64_t index) {
+	size_t lo = 0, hi = r->indexCount;
+	while (hi - lo > 1) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (r->index[mid].firstIndex <= index)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+const ImuRecRecord_t *imuRecGet(const ImuRecReader_t *r, uint64_t index) {
+	if (index >= r->records)
+		return NULL;
+	size_t chunk = recFindChunk(r, index);
+	return recChunkRecords(r, chunk) + (index - r->index[chunk].firstIndex);
+}
+
+uint64_t imuRecFindTime(const ImuRecReader_t *r, uint64_t timeNs) {
+	// First chunk whose last record is not earlier than the requested time.
+	size_t lo = 0, hi = r->indexCount;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (r->index[mid].lastTimeNs < timeNs)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == r->indexCount)
+		return r->records;
+
+	const ImuRecRecord_t *records = recChunkRecords(r, lo);
+	uint32_t first = 0, last = r->index[lo].count;
+	while (first < last) {
+		uint32_t mid = first + (last - first) / 2;
+		if (records[mid].rxTimeNs < timeNs)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+	return r->index[lo].firstIndex + first;
+}
+
+void imuRecSeek(const ImuRecReader_t *r, ImuRecCursor_t *c, uint64_t index) {
+	if (index >= r->records) {
+		c->chunk = r->indexCount;
+		c->record = 0;
+		return;
+	}
+	c->chunk = recFindChunk(r, index);
+	c->record = (uint32_t)(index - r->index[c->chunk].firstIndex);
+}
+
+const ImuRecRecord_t *imuRecNextRun(const ImuRecReader_t *r, ImuRecCursor_t *c,
+	size_t maxCount, size_t *count) {
+	if (c->chunk >= r->indexCount || !maxCount) {
+		*count = 0;
+		return NULL;
+	}
+
+	size_t available = r->index[c->chunk].count - c->record;
+	size_t n = available < maxCount ? available : maxCount;
+	const ImuRecRecord_t *run = recChunkRecords(r, c->chunk) + c->record;
+
+	c->record += (uint32_t)n;
+	if (c->record == r->index[c->chunk].count) {
+		c->chunk++;
+		c->record = 0;
+	}
+	*count = n;
+	return run;
+}
+
+const char *imuRecErrorToString(ImuRecError_t error) {
+	switch (error) {
+		case IMU_REC_OK:
+			return "OK.";
+		case IMU_REC_IO_ERROR:
+			return "I/O error!";
+		case IMU_REC_BAD_FORMAT:
+			return "Not a recording or unsupported version!";
+		case IMU_REC_NO_MEMORY:
+			return "Out of memory!";
+		case IMU_REC_BAD_ARGUMENT:
+			return "Invalid argument!";
+	}
+	return "Unknown error.";
+}
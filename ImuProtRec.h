@@ -0,0 +1,308 @@
+/**
+ * IMU Packet Recording Format.
+ *
+ * Append-only binary capture of raw `ImuProt_t` packets with their receive
+ * timestamps. The file is organized as follows:
+ *
+ *   file header | chunk header | records ... | chunk header | records ... | index | trailer
+ *
+ * Each chunk holds up to `chunkCapacity` fixed-size records and a header with
+ * the global index and the time range of its first and last record. When the
+ * writer is closed a sparse index with one entry per chunk and a trailer are
+ * appended. Readers memory map the file, binary search the index to seek by
+ * time or by packet index in O(log n) and iterate records without copying.
+ * If the trailer is missing (the recorder was killed) or the index does not
+ * match the chunk headers, the index is rebuilt from the chunk headers and a
+ * truncated last chunk is ignored.
+ */
+
+#ifndef ImuProtRec_h_included__
+#define ImuProtRec_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+
+#define IMU_REC_MAGIC "IMUREC01"
+#define IMU_REC_CHUNK_MAGIC (0x4B4E4843UL)   // "CHNK"
+#define IMU_REC_INDEX_MAGIC (0x31584449UL)   // "IDX1"
+#define IMU_REC_VERSION (1)
+
+/** Default number of records per chunk. */
+#define IMU_REC_CHUNK_RECORDS (4096)
+
+/**
+ * A recorded packet.
+ *
+ * @field rxTimeNs  Receive time of the packet in nanoseconds.
+ * @field packet    Raw packet as received from the IMU.
+ */
+typedef struct PACK_IT
+{
+	uint64_t rxTimeNs;
+	ImuProt_t packet;
+} ImuRecRecord_t;
+
+/**
+ * File header, at offset 0.
+ *
+ * @field magic         IMU_REC_MAGIC.
+ * @field version       IMU_REC_VERSION.
+ * @field recordSize    Size of `ImuRecRecord_t`.
+ * @field chunkCapacity Maximum number of records per chunk.
+ * @field createdNs     Creation time of the recording (CLOCK_REALTIME).
+ */
+typedef struct PACK_IT
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t chunkCapacity;
+	uint32_t reserved0;
+	uint64_t createdNs;
+	uint8_t reserved[32];
+} ImuRecFileHeader_t;
+
+/**
+ * Chunk header, followed by `count` records.
+ *
+ * @field magic         IMU_REC_CHUNK_MAGIC.
+ * @field count         Number of records in the chunk.
+ * @field firstIndex    Global index of the first record.
+ * @field firstTimeNs   Receive time of the first record.
+ * @field lastTimeNs    Receive time of the last record.
+ * @field headerCrc     CRC32 of the header bytes preceding this field.
+ */
+typedef struct PACK_IT
+{
+	uint32_t magic;
+	uint32_t count;
+	uint64_t firstIndex;
+	uint64_t firstTimeNs;
+	uint64_t lastTimeNs;
+	uint8_t reserved[28];
+	uint32_t headerCrc;
+} ImuRecChunkHeader_t;
+
+/**
+ * Sparse index entry, one per chunk.
+ *
+ * @field offset        File offset of the chunk header.
+ * @field firstIndex    Global index of the first record.
+ * @field firstTimeNs   Receive time of the first record.
+ * @field lastTimeNs    Receive time of the last record.
+ * @field count         Number of records in the chunk.
+ */
+typedef struct PACK_IT
+{
+	uint64_t offset;
+	uint64_t firstIndex;
+	uint64_t firstTimeNs;
+	uint64_t lastTimeNs;
+	uint32_t count;
+	uint32_t reserved;
+} ImuRecIndexEntry_t;
+
+/**
+ * Trailer, the last bytes of a cleanly closed file.
+ *
+ * @field indexOffset   File offset of the first index entry.
+ * @field entries       Number of index entries.
+ * @field magic         IMU_REC_INDEX_MAGIC.
+ */
+typedef struct PACK_IT
+{
+	uint64_t indexOffset;
+	uint32_t entries;
+	uint32_t magic;
+} ImuRecTrailer_t;
+
+/**
+ * @enum ImuRecError_t
+ * @brief Error codes of the recording API.
+ */
+typedef enum {
+	IMU_REC_OK = 0,             // Success.
+	IMU_REC_IO_ERROR = 1,       // A system call failed, see errno.
+	IMU_REC_BAD_FORMAT = 2,     // The file is not a recording or has an unsupported version.
+	IMU_REC_NO_MEMORY = 3,      // Memory allocation failed.
+	IMU_REC_BAD_ARGUMENT = 4    // An argument is out of range.
+} ImuRecError_t;
+
+/**
+ * Recording writer. All fields are private.
+ */
+typedef struct {
+	int fd;
+	uint32_t capacity;
+	uint32_t count;
+	uint64_t nextIndex;
+	uint64_t offset;
+	uint64_t lastTimeNs;
+	ImuRecRecord_t *records;
+	ImuRecIndexEntry_t *index;
+	size_t indexCount;
+	size_t indexCapacity;
+	int failed;
+} ImuRecWriter_t;
+
+/**
+ * Memory mapped recording reader. All fields are private.
+ */
+typedef struct {
+	const uint8_t *map;
+	size_t size;
+	const ImuRecIndexEntry_t *index;
+	size_t indexCount;
+	ImuRecIndexEntry_t *ownedIndex;
+	uint64_t records;
+	int recovered;
+} ImuRecReader_t;
+
+/**
+ * Position of a reader cursor.
+ *
+ * @field chunk     Index entry of the current chunk.
+ * @field record    Record within the chunk.
+ */
+typedef struct {
+	size_t chunk;
+	uint32_t record;
+} ImuRecCursor_t;
+
+/**
+ * @brief Creates a new recording, truncating an existing file.
+ *
+ * @param w             Writer to initialize.
+ * @param path          Path of the file.
+ * @param chunkRecords  Records per chunk, 0 for IMU_REC_CHUNK_RECORDS.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuRecWriterOpen(ImuRecWriter_t *w, const char *path, uint32_t chunkRecords);
+
+/**
+ * @brief Appends a packet to the recording.
+ *
+ * Receive times must not go backwards; an earlier time is clamped to the
+ * previous one so that the file stays searchable by time.
+ *
+ * @param w         Writer.
+ * @param packet    Packet to store, 40 bytes.
+ * @param rxTimeNs  Receive time in nanoseconds.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuRecWrite(ImuRecWriter_t *w, const ImuProt_t *packet, uint64_t rxTimeNs);
+
+/**
+ * @brief Writes the current partial chunk so that readers can see it.
+ *
+ * A write that fails before any byte reached the file may be retried. One
+ * that fails after writing part of the chunk fails the writer for good: every
+ * further call returns IMU_REC_IO_ERROR, no index is written on close, and
+ * readers recover the complete chunks from their headers.
+ *
+ * @param w Writer.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuRecFlush(ImuRecWriter_t *w);
+
+/**
+ * @brief Flushes pending records, writes the index and closes the file.
+ *
+ * @param w Writer.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuRecWriterClose(ImuRecWriter_t *w);
+
+/**
+ * @brief Maps a recording for reading.
+ *
+ * @param r     Reader to initialize.
+ * @param path  Path of the file.
+ * @return ImuRecError_t IMU_REC_OK on success.
+ */
+ImuRecError_t imuRecReaderOpen(ImuRecReader_t *r, const char *path);
+
+/**
+ * @brief Unmaps the recording.
+ *
+ * @param r Reader.
+ */
+void imuRecReaderClose(ImuRecReader_t *r);
+
+/**
+ * @brief Returns the number of records in the recording.
+ */
+static inline uint64_t imuRecCount(const ImuRecReader_t *r)
+{
+	return r->records;
+}
+
+/**
+ * @brief Returns the number of chunks in the recording.
+ */
+static inline size_t imuRecChunks(const ImuRecReader_t *r)
+{
+	return r->indexCount;
+}
+
+/**
+ * @brief Tells whether the index had to be rebuilt because the trailer was missing.
+ */
+static inline int imuRecRecovered(const ImuRecReader_t *r)
+{
+	return r->recovered;
+}
+
+/**
+ * @brief Returns a pointer to the record with the given global index.
+ *
+ * @param r     Reader.
+ * @param index Global record index.
+ * @return const ImuRecRecord_t* Record inside the mapping, or NULL if out of range.
+ */
+const ImuRecRecord_t *imuRecGet(const ImuRecReader_t *r, uint64_t index);
+
+/**
+ * @brief Finds the first record received at or after the given time.
+ *
+ * @param r         Reader.
+ * @param timeNs    Time to look for.
+ * @return uint64_t Global index of the record, `imuRecCount(r)` if none.
+ */
+uint64_t imuRecFindTime(const ImuRecReader_t *r, uint64_t timeNs);
+
+/**
+ * @brief Positions a cursor at a global record index.
+ *
+ * @param r     Reader.
+ * @param c     Cursor to initialize.
+ * @param index Global record index; past the end yields an exhausted cursor.
+ */
+void imuRecSeek(const ImuRecReader_t *r, ImuRecCursor_t *c, uint64_t index);
+
+/**
+ * @brief Returns the next contiguous run of records and advances the cursor.
+ *
+ * Records of a run are adjacent in the mapping, so a whole chunk can be
+ * processed without copying.
+ *
+ * @param r         Reader.
+ * @param c         Cursor.
+ * @param maxCount  Maximum number of records to return.
+ * @param count     Receives the number of records in the run (0 at the end).
+ * @return const ImuRecRecord_t* First record of the run, NULL at the end.
+ */
+const ImuRecRecord_t *imuRecNextRun(const ImuRecReader_t *r, ImuRecCursor_t *c,
+	size_t maxCount, size_t *count);
+
+/**
+ * @brief Converts an ImuRecError_t error code to its string representation.
+ *
+ * @param error The ImuRecError_t error code.
+ * @return A string that describes the error.
+ */
+const char *imuRecErrorToString(ImuRecError_t error);
+
+#endif
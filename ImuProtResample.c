@@ -0,0 +1,312 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ImuProtIsa.h"
+#include "ImuProtResample.h"
+
+#define RES_INLINE static inline __attribute__((always_inline))
+
+/*
+ * Kernel: the weighted sums of all devices, frame[c][d] = sum over k of
+ * weights[k][d] * taps[k][c][d], on vectors of W devices. Expanded per
+ * vector width, since the compiler keeps a vector of the native width in
+ * registers but spills wider ones.
+ */
+#define RES_DEFINE(W)                                                                                  \
+                                                                                                       \
+typedef float ResVec##W##_t __attribute__((vector_size(W * sizeof(float))));                           \
+                                                                                                       \
+RES_INLINE void resWeigh##W(ImuResample_t *r) {                                                        \
+	const uint32_t stride = r->stride;                                                                 \
+	for (int c = 0; c < 6; c++) {                                                                      \
+		ResVec##W##_t *out = (ResVec##W##_t *)(r->frame + (size_t)c * stride);                         \
+		for (uint32_t d = 0; d < stride / W; d++) {                                                    \
+			ResVec##W##_t acc = { 0 };                                                                 \
+			for (uint32_t k = 0; k < r->tapCount; k++) {                                               \
+				const ResVec##W##_t *w = (const ResVec##W##_t *)(r->weights + (size_t)k * stride);     \
+				const ResVec##W##_t *v = (const ResVec##W##_t *)(r->taps + ((size_t)k * 6 + c) * stride); \
+				acc += w[d] * v[d];                                                                    \
+			}                                                                                          \
+			out[d] = acc;                                                                              \
+		}                                                                                              \
+	}                                                                                                  \
+}
+
+RES_DEFINE(4)
+RES_DEFINE(8)
+
+static void resWeighBaseline(ImuResample_t *r) {
+	resWeigh4(r);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#define RES_TARGET(t) static __attribute__((target(t)))
+
+RES_TARGET("arch=x86-64-v3") void resWeighAvx2(ImuResample_t *r) {
+	resWeigh8(r);
+}
+
+#define RES_WEIGH_AVX2 resWeighAvx2
+
+#else
+
+#define RES_WEIGH_AVX2 resWeighBaseline
+
+#endif
+
+/**
+ * @brief Allocates `size` bytes aligned for the vector loads, zeroed.
+ */
+static void *resAlloc(size_t size) {
+	size = (size + 63) & ~(size_t)63;
+	void *p = aligned_alloc(64, size);
+	if (p)
+		memset(p, 0, size);
+	return p;
+}
+
+int imuResampleInit(ImuResample_t *r, uint32_t devices, uint64_t periodNs, uint32_t depth, ImuResampleMode_t mode,
+	uint64_t maxWaitNs) {
+	memset(r, 0, sizeof(*r));
+	if (!devices || !periodNs || depth < 8 || (depth & (depth - 1)) || mode > IMU_RESAMPLE_HERMITE)
+		return -1;
+	const uint32_t stride = (devices + IMU_RESAMPLE_LANES - 1) / IMU_RESAMPLE_LANES * IMU_RESAMPLE_LANES;
+	r->rings = calloc(devices, sizeof(ImuResampleRing_t));
+	r->taps = resAlloc((size_t)IMU_RESAMPLE_TAPS * 6 * stride * sizeof(float));
+	r->weights = resAlloc((size_t)IMU_RESAMPLE_TAPS * stride * sizeof(float));
+	r->frame = resAlloc((size_t)IMU_RESAMPLE_CHANNELS * stride * sizeof(float));
+	r->flags = calloc(devices, sizeof(uint16_t));
+	r->valid = calloc(devices, 1);
+	r->devices = devices;
+	if (!r->rings || !r->taps || !r->weights || !r->frame || !r->flags || !r->valid) {
+		imuResampleFree(r);
+		return -1;
+	}
+	for (uint32_t d = 0; d < devices; d++) {
+		r->rings[d].nodes = malloc(depth * sizeof(ImuResampleNode_t));
+		if (!r->rings[d].nodes) {
+			imuResampleFree(r);
+			return -1;
+		}
+	}
+
+	r->mode = mode;
+	r->periodNs = periodNs;
+	r->maxWaitNs = maxWaitNs;
+	r->stride = stride;
+	r->depth = depth;
+	r->tapCount = mode == IMU_RESAMPLE_HERMITE ? IMU_RESAMPLE_TAPS : 2;
+	r->kernel = imuIsaActive() >= IMU_ISA_AVX2 ? RES_WEIGH_AVX2 : resWeighBaseline;
+	return 0;
+}
+
+void imuResampleFree(ImuResample_t *r) {
+	if (r->rings) {
+		for (uint32_t d = 0; d < r->devices; d++)
+			free(r->rings[d].nodes);
+	}
+	free(r->rings);
+	free(r->taps);
+	free(r->weights);
+	free(r->frame);
+	free(r->flags);
+	free(r->valid);
+	memset(r, 0, sizeof(*r));
+}
+
+size_t imuResamplePush(ImuResample_t *r, uint32_t device, const uint64_t *timesNs, const ImuSample_t *samples,
+	size_t count) {
+	ImuResampleRing_t *g = &r->rings[device];
+	const uint64_t mask = r->depth - 1;
+	size_t accepted = 0;
+	for (size_t i = 0; i < count; i++) {
+		const ImuResampleNode_t *last = g->head ? &g->nodes[(g->head - 1) & mask] : NULL;
+		if (last && timesNs[i] <= last->timeNs) {
+			r->stats.late++;
+			continue;
+		}
+		if (g->head - g->tail == r->depth) {
+			g->tail++;
+			r->stats.overruns++;
+		}
+		ImuResampleNode_t *n = &g->nodes[g->head & mask];
+		const double h = last ? (double)(timesNs[i] - last->timeNs) * 1e-9 : 0.0;
+		for (int c = 0; c < 3; c++) {
+			n->value[c] = samples[i].gyro[c];
+			n->value[c + 3] = samples[i].accl[c];
+		}
+		// Running integral of the readings as means over the intervals ending at them.
+		for (int c = 0; c < 6; c++)
+			n->prefix[c] = (last ? last->prefix[c] : 0.0) + h * n->value[c];
+		n->timeNs = timesNs[i];
+		n->temperature = samples[i].temperature;
+		n->flags = samples[i].flags;
+		g->head++;
+		accepted++;
+		if (timesNs[i] > r->newestNs)
+			r->newestNs = timesNs[i];
+		if (!r->started) {
+			// First frame on the grid after the first sample, one period later for the integral.
+			r->nextNs = (timesNs[i] / r->periodNs + 1 + (r->mode == IMU_RESAMPLE_HERMITE)) * r->periodNs;
+			r->started = 1;
+		}
+	}
+	return accepted;
+}
+
+/**
+ * @brief Returns the node of a device at an absolute index.
+ */
+static inline const ImuResampleNode_t *resNode(const ImuResample_t *r, const ImuResampleRing_t *g, uint64_t index) {
+	return &g->nodes[index & (r->depth - 1)];
+}
+
+/**
+ * @brief Returns 1 if the newest samples of a device reach past time `t`.
+ *
+ * Linear interpolation needs one sample after `t`, the spline two.
+ */
+static int resCovers(const ImuResample_t *r, const ImuResampleRing_t *g, uint64_t t) {
+	const uint64_t after = r->mode == IMU_RESAMPLE_HERMITE ? 2 : 1;
+	return g->head - g->tail >= after && resNode(r, g, g->head - after)->timeNs > t;
+}
+
+/**
+ * @brief Finds the interval [t_i, t_i+1) holding time `t`, scanning from index `from`.
+ *
+ * @return int 1 with the index of its first sample in `index`, 0 if the
+ *             samples do not reach both sides or the interval is a gap longer than `maxWaitNs`.
+ */
+static int resFind(const ImuResample_t *r, const ImuResampleRing_t *g, uint64_t from, uint64_t t, uint64_t *index) {
+	if (from >= g->head || resNode(r, g, from)->timeNs > t)
+		return 0;
+	uint64_t i = from;
+	while (i + 1 < g->head && resNode(r, g, i + 1)->timeNs <= t)
+		i++;
+	if (i + 1 == g->head || resNode(r, g, i + 1)->timeNs - resNode(r, g, i)->timeNs > r->maxWaitNs)
+		return 0;
+	*index = i;
+	return 1;
+}
+
+/**
+ * @brief Adds the weights of the spline integral from sample `i` to time `t` to taps `k` to `k + 2`.
+ *
+ * With H = t_i+1 - t_i and u = (t - t_i) / H, the Hermite integral over
+ * [t_i, t] is H * (h10(u) * m_i + h01(u) * x_i+1 + h11(u) * m_i+1), the
+ * slopes m_i being the interval means on either side of sample i weighted
+ * by the length of the opposite interval.
+ */
+static void resSpline(ImuResample_t *r, const ImuResampleRing_t *g, uint32_t device, uint64_t i, uint64_t t,
+	uint32_t k, double scale) {
+	const double t0 = (double)resNode(r, g, i - 1)->timeNs, t1 = (double)resNode(r, g, i)->timeNs;
+	const double t2 = (double)resNode(r, g, i + 1)->timeNs, t3 = (double)resNode(r, g, i + 2)->timeNs;
+	const double h = t2 - t1, u = ((double)t - t1) / h;
+	const double alpha = (t1 - t0) / (t2 - t0), beta = h / (t3 - t1);
+	const double h10 = u * (1.0 - u) * (1.0 - u), h01 = u * u * (3.0 - 2.0 * u), h11 = u * u * (u - 1.0);
+	const double w[3] = { h10 * (1.0 - alpha), h10 * alpha + h01 + h11 * (1.0 - beta), h11 * beta };
+	scale *= h * 1e-9;
+	for (int j = 0; j < 3; j++) {
+		const ImuResampleNode_t *n = resNode(r, g, i + j);
+		r->weights[(size_t)(k + j) * r->stride + device] = (float)(w[j] * scale);
+		for (int c = 0; c < 6; c++)
+			r->taps[((size_t)(k + j) * 6 + c) * r->stride + device] = n->value[c];
+	}
+}
+
+/**
+ * @brief Finds the samples of a device for the frame and sets its taps and weights.
+ *
+ * @return int 1 if the device has the samples, 0 if it is invalid in the frame.
+ */
+static int resGather(ImuResample_t *r, uint32_t device) {
+	const ImuResampleRing_t *g = &r->rings[device];
+	const uint64_t t = r->nextNs;
+	const uint32_t stride = r->stride;
+	uint64_t a = 0, b = 0;
+	if (r->mode == IMU_RESAMPLE_HERMITE) {
+		// The slopes also take the intervals before a and after b + 1, which must not be gaps either.
+		if (!resFind(r, g, g->tail + 1, t - r->periodNs, &a) || !resFind(r, g, a, t, &b) || b + 2 >= g->head
+			|| resNode(r, g, a)->timeNs - resNode(r, g, a - 1)->timeNs > r->maxWaitNs
+			|| resNode(r, g, b + 2)->timeNs - resNode(r, g, b + 1)->timeNs > r->maxWaitNs)
+			return 0;
+	} else if (!resFind(r, g, g->tail, t, &b)) {
+		return 0;
+	}
+
+	const ImuResampleNode_t *n0 = resNode(r, g, b), *n1 = resNode(r, g, b + 1);
+	const double u = (double)(t - n0->timeNs) / (double)(n1->timeNs - n0->timeNs);
+	r->frame[6 * (size_t)stride + device] = (float)(n0->temperature + u * (n1->temperature - n0->temperature));
+	r->flags[device] = n0->flags | n1->flags;
+	if (r->mode == IMU_RESAMPLE_LINEAR) {
+		r->weights[device] = (float)(1.0 - u);
+		r->weights[stride + device] = (float)u;
+		for (int c = 0; c < 6; c++) {
+			r->taps[(size_t)c * stride + device] = n0->value[c];
+			r->taps[(size_t)(6 + c) * stride + device] = n1->value[c];
+		}
+		return 1;
+	}
+
+	// Mean over the period: integral to t, minus integral to t - period, over the period.
+	const double scale = 1e9 / (double)r->periodNs;
+	resSpline(r, g, device, b, t, 0, scale);
+	resSpline(r, g, device, a, t - r->periodNs, 3, -scale);
+	const ImuResampleNode_t *na = resNode(r, g, a);
+	r->weights[6 * (size_t)stride + device] = (float)scale;
+	for (int c = 0; c < 6; c++)
+		r->taps[(size_t)(36 + c) * stride + device] = (float)(n0->prefix[c] - na->prefix[c]);
+	return 1;
+}
+
+/**
+ * @brief Clears the taps and weights of a device that is invalid in the frame.
+ */
+static void resClear(ImuResample_t *r, uint32_t device) {
+	const uint32_t stride = r->stride;
+	for (uint32_t k = 0; k < r->tapCount; k++) {
+		r->weights[(size_t)k * stride + device] = 0.0f;
+		for (int c = 0; c < 6; c++)
+			r->taps[((size_t)k * 6 + c) * stride + device] = 0.0f;
+	}
+	r->frame[6 * (size_t)stride + device] = 0.0f;
+	r->flags[device] = 0;
+}
+
+int imuResampleNext(ImuResample_t *r) {
+	if (!r->started)
+		return 0;
+	const uint64_t t = r->nextNs;
+	if (r->newestNs < t + r->maxWaitNs) {
+		for (uint32_t d = 0; d < r->devices; d++) {
+			if (!resCovers(r, &r->rings[d], t))
+				return 0;
+		}
+	}
+
+	for (uint32_t d = 0; d < r->devices; d++) {
+		r->valid[d] = (uint8_t)resGather(r, d);
+		if (!r->valid[d]) {
+			resClear(r, d);
+			r->stats.missing++;
+		}
+	}
+	r->kernel(r);
+
+	// Drop the samples no later frame needs.
+	const uint64_t keep = r->mode == IMU_RESAMPLE_HERMITE ? 2 : 1;
+	for (uint32_t d = 0; d < r->devices; d++) {
+		ImuResampleRing_t *g = &r->rings[d];
+		while (g->tail + keep < g->head && resNode(r, g, g->tail + keep)->timeNs <= t)
+			g->tail++;
+	}
+
+	r->timeNs = t;
+	r->nextNs = t + r->periodNs;
+	r->stats.frames++;
+	r->stats.latencyNs = r->newestNs > t ? r->newestNs - t : 0;
+	if (r->stats.latencyNs > r->stats.maxLatencyNs)
+		r->stats.maxLatencyNs = r->stats.latencyNs;
+	return 1;
+}
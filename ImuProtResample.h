@@ -0,0 +1,220 @@
+/**
+ * Uniform-Time Resampler for Multi-IMU Alignment.
+ *
+ * Brings the decoded samples of several IMUs, each on its own clock, onto a
+ * common time grid t_k = k * period. Samples are pushed per device with their
+ * timestamps on a common time base, e.g. from `ImuProtClock.h`, and frames
+ * come out holding the interpolated `gyro`, `accl` and temperature of every
+ * device at the same instant.
+ *
+ * Two interpolations are provided:
+ *
+ * - IMU_RESAMPLE_LINEAR takes readings as instantaneous values and
+ *   interpolates them linearly at t_k.
+ *
+ * - IMU_RESAMPLE_HERMITE takes each reading as the mean over the interval
+ *   since the previous reading, as delivered by sensors that filter or
+ *   integrate internally. Its running integral (angle, velocity) is known
+ *   exactly at the sample times; the resampler interpolates it with a cubic
+ *   Hermite spline, whose slope at each sample is the three-point estimate
+ *   from the adjacent readings, and outputs the mean over (t_k - period, t_k].
+ *   Angle and velocity increments are therefore preserved across the
+ *   resampling, whatever the ratio of the rates.
+ *
+ * In both cases the value of a device is a weighted sum of a few of its
+ * samples (and, for the integral, one prefix sum difference). A scalar pass
+ * per device finds those samples and their weights; the weighted sums of all
+ * devices are then evaluated together in one pass over structure-of-arrays
+ * buffers, one vector lane per device. The kernels are compiled per ISA level
+ * and follow `ImuProtIsa.h` at init time.
+ *
+ * Each device buffers at most `depth` samples; when full, the oldest sample
+ * is dropped and counted. A frame is emitted as soon as every device has the
+ * samples it needs, or once the newest sample of any device is `maxWaitNs`
+ * past the frame time, in which case the devices still lagging are marked
+ * invalid in that frame. The latency, from the frame time to the newest
+ * sample when it was emitted, is reported per frame.
+ *
+ * Buffers are allocated by `imuResampleInit`; pushing and resampling do not
+ * allocate.
+ */
+
+#ifndef ImuProtResample_h_included__
+#define ImuProtResample_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProtSample.h"
+
+/** Channels per device: gyro X, Y, Z, accl X, Y, Z, temperature. */
+#define IMU_RESAMPLE_CHANNELS (7)
+
+/** Devices per SIMD vector; the device count is padded to a multiple. */
+#define IMU_RESAMPLE_LANES (8)
+
+/** Most samples weighted per device and frame. */
+#define IMU_RESAMPLE_TAPS (7)
+
+/**
+ * Interpolations.
+ */
+typedef enum {
+	IMU_RESAMPLE_LINEAR = 0,    // Readings interpolated linearly.
+	IMU_RESAMPLE_HERMITE = 1,   // Integrals interpolated with a cubic Hermite spline.
+} ImuResampleMode_t;
+
+/**
+ * Buffered sample of a device. Private.
+ */
+typedef struct {
+	double prefix[6];
+	uint64_t timeNs;
+	float value[6];
+	float temperature;
+	uint16_t flags;
+} ImuResampleNode_t;
+
+/**
+ * Sample buffer of a device. Private.
+ */
+typedef struct {
+	ImuResampleNode_t *nodes;
+	uint64_t head;
+	uint64_t tail;
+} ImuResampleRing_t;
+
+/**
+ * Counters.
+ *
+ * @field frames        Frames emitted.
+ * @field missing       Device entries emitted invalid, the device lacking samples.
+ * @field overruns      Samples dropped from full buffers.
+ * @field late          Samples dropped for a timestamp not after the previous one.
+ * @field latencyNs     Latency of the last frame.
+ * @field maxLatencyNs  Highest latency so far.
+ */
+typedef struct {
+	uint64_t frames;
+	uint64_t missing;
+	uint64_t overruns;
+	uint64_t late;
+	uint64_t latencyNs;
+	uint64_t maxLatencyNs;
+} ImuResampleStats_t;
+
+/**
+ * Resampler state. All fields are private.
+ */
+typedef struct ImuResample {
+	ImuResampleRing_t *rings;
+	float *taps;
+	float *weights;
+	float *frame;
+	uint16_t *flags;
+	uint8_t *valid;
+	void (*kernel)(struct ImuResample *r);
+	ImuResampleStats_t stats;
+	ImuResampleMode_t mode;
+	uint64_t periodNs;
+	uint64_t maxWaitNs;
+	uint64_t nextNs;
+	uint64_t newestNs;
+	uint64_t timeNs;
+	uint32_t devices;
+	uint32_t stride;
+	uint32_t depth;
+	uint32_t tapCount;
+	int started;
+} ImuResample_t;
+
+/**
+ * @brief Initializes the resampler and allocates its buffers.
+ *
+ * @param r             State to initialize.
+ * @param devices       Number of devices, at least 1.
+ * @param periodNs      Output period in nanoseconds.
+ * @param depth         Samples buffered per device, a power of two of at least 8,
+ *                      enough for `maxWaitNs` plus two output periods.
+ * @param mode          Interpolation.
+ * @param maxWaitNs     Longest wait for a lagging device before it is marked invalid.
+ * @return int 0 on success, -1 if an argument is out of range or allocation failed.
+ */
+int imuResampleInit(ImuResample_t *r, uint32_t devices, uint64_t periodNs, uint32_t depth, ImuResampleMode_t mode,
+	uint64_t maxWaitNs);
+
+/**
+ * @brief Frees the buffers of the resampler.
+ */
+void imuResampleFree(ImuResample_t *r);
+
+/**
+ * @brief Adds consecutive decoded samples of one device.
+ *
+ * @param r         State.
+ * @param device    Device index, below the count given to `imuResampleInit`.
+ * @param timesNs   Timestamp of each sample on the common time base.
+ * @param samples   Samples, e.g. from `imuDecodeSamples`.
+ * @param count     Number of samples.
+ * @return size_t Number of samples accepted; samples not after the previous
+ *                one of the device are dropped and counted as late.
+ */
+size_t imuResamplePush(ImuResample_t *r, uint32_t device, const uint64_t *timesNs, const ImuSample_t *samples,
+	size_t count);
+
+/**
+ * @brief Emits the next frame if it is due.
+ *
+ * Call after pushing, until it returns 0.
+ *
+ * @param r     State.
+ * @return int 1 if a frame was emitted, which the accessors then return, 0 if not due yet.
+ */
+int imuResampleNext(ImuResample_t *r);
+
+/**
+ * @brief Returns the time of the last frame.
+ */
+static inline uint64_t imuResampleTime(const ImuResample_t *r)
+{
+	return r->timeNs;
+}
+
+/**
+ * @brief Returns one channel of the last frame, one value per device.
+ *
+ * Values of invalid devices are 0.
+ *
+ * @param r         State.
+ * @param channel   0 to 2 for gyro X, Y, Z, 3 to 5 for accl X, Y, Z, 6 for the temperature.
+ */
+static inline const float *imuResampleChannel(const ImuResample_t *r, int channel)
+{
+	return r->frame + (size_t)channel * r->stride;
+}
+
+/**
+ * @brief Returns 1 if the device had samples for the last frame.
+ */
+static inline int imuResampleValid(const ImuResample_t *r, uint32_t device)
+{
+	return r->valid[device];
+}
+
+/**
+ * @brief Returns the status flags of the samples the last frame was interpolated from, one per device.
+ */
+static inline const uint16_t *imuResampleFlags(const ImuResample_t *r)
+{
+	return r->flags;
+}
+
+/**
+ * @brief Returns the counters.
+ */
+static inline const ImuResampleStats_t *imuResampleStats(const ImuResample_t *r)
+{
+	return &r->stats;
+}
+
+#endif
@@ -0,0 +1,128 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ImuProtRing.h"
+
+_Static_assert(offsetof(ImuRing_t, consumer) - offsetof(ImuRing_t, producer) >= IMU_RING_CACHE_LINE,
+	"producer and consumer indices share a cache line");
+
+int imuRingInitItems(ImuRing_t *r, size_t capacity, size_t itemSize) {
+	memset(r, 0, sizeof(*r));
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0 || itemSize == 0)
+		return -1;
+
+	void *items;
+	if (posix_memalign(&items, IMU_RING_CACHE_LINE, capacity * itemSize) != 0)
+		return -1;
+	r->items = items;
+	r->itemSize = itemSize;
+	r->mask = capacity - 1;
+	atomic_init(&r->producer.head, 0);
+	atomic_init(&r->consumer.tail, 0);
+	return 0;
+}
+
+int imuRingInit(ImuRing_t *r, size_t capacity) {
+	return imuRingInitItems(r, capacity, sizeof(ImuProt_t));
+}
+
+void imuRingFree(ImuRing_t *r) {
+	free(r->items);
+	r->items = NULL;
+}
+
+size_t imuRingReserveItems(ImuRing_t *r, void **items, size_t max) {
+	size_t head = atomic_load_explicit(&r->producer.head, memory_order_relaxed);
+	size_t capacity = r->mask + 1;
+	size_t space = capacity - (head - r->producer.cachedTail);
+	if (space < max) {
+		r->producer.cachedTail = atomic_load_explicit(&r->consumer.tail, memory_order_acquire);
+		space = capacity - (head - r->producer.cachedTail);
+	}
+
+	size_t index = head & r->mask;
+	size_t run = capacity - index;
+	if (run > space)
+		run = space;
+	if (run > max)
+		run = max;
+	*items = r->items + index * r->itemSize;
+	return run;
+}
+
+size_t imuRingReserve(ImuRing_t *r, ImuProt_t **slots, size_t max) {
+	return imuRingReserveItems(r, (void **)slots, max);
+}
+
+void imuRingCommit(ImuRing_t *r, size_t count) {
+	size_t head = atomic_load_explicit(&r->producer.head, memory_order_relaxed);
+	atomic_store_explicit(&r->producer.head, head + count, memory_order_release);
+}
+
+size_t imuRingPeekItems(ImuRing_t *r, const void **items, size_t max) {
+	size_t tail = atomic_load_explicit(&r->consumer.tail, memory_order_relaxed);
+	size_t used = r->consumer.cachedHead - tail;
+	if (used < max) {
+		r->consumer.cachedHead = atomic_load_explicit(&r->producer.head, memory_order_acquire);
+		used = r->consumer.cachedHead - tail;
+	}
+
+	size_t index = tail & r->mask;
+	size_t run = r->mask + 1 - index;
+	if (run > used)
+		run = used;
+	if (run > max)
+		run = max;
+	*items = r->items + index * r->itemSize;
+	return run;
+}
+
+size_t imuRingPeek(ImuRing_t *r, const ImuProt_t **slots, size_t max) {
+	return imuRingPeekItems(r, (const void **)slots, max);
+}
+
+void imuRingConsume(ImuRing_t *r, size_t count) {
+	size_t tail = atomic_load_explicit(&r->consumer.tail, memory_order_relaxed);
+	atomic_store_explicit(&r->consumer.tail, tail + count, memory_order_release);
+}
+
+size_t imuRingDiscard(ImuRing_t *r, size_t keep) {
+	size_t tail = atomic_load_explicit(&r->consumer.tail, memory_order_relaxed);
+	r->consumer.cachedHead = atomic_load_explicit(&r->producer.head, memory_order_acquire);
+	size_t used = r->consumer.cachedHead - tail;
+	if (used <= keep)
+		return 0;
+	atomic_store_explicit(&r->consumer.tail, tail + used - keep, memory_order_release);
+	return used - keep;
+}
+
+size_t imuRingPush(ImuRing_t *r, const ImuProt_t *packets, size_t count) {
+	size_t done = 0;
+	while (done < count) {
+		ImuProt_t *slots;
+		size_t n = imuRingReserve(r, &slots, count - done);
+		if (!n)
+			break;
+		memcpy(slots, packets + done, n * sizeof(ImuProt_t));
+		done += n;
+		// One release store per wrap-around run, not per packet.
+		imuRingCommit(r, n);
+	}
+	return done;
+}
+
+size_t imuRingPop(ImuRing_t *r, ImuProt_t *packets, size_t max) {
+	size_t done = 0;
+	while (done < max) {
+		const ImuProt_t *slots;
+		size_t n = imuRingPeek(r, &slots, max - done);
+		if (!n)
+			break;
+		memcpy(packets + done, slots, n * sizeof(ImuProt_t));
+		done += n;
+		imuRingConsume(r, n);
+	}
+	return done;
+}
@@ -0,0 +1,164 @@
+/**
+ * Lock-Free Single-Producer Single-Consumer Packet Ring.
+ *
+ * Hands `ImuProt_t` packets from one thread to another without locks. The
+ * producer owns the head index and the consumer the tail index; each index
+ * sits on its own cache line next to the owner's cached copy of the other
+ * index, so the shared line is only read when the cached copy says the ring
+ * looks full (producer) or empty (consumer). Batch operations publish many
+ * packets with a single release store.
+ *
+ * Besides the copying `imuRingPush` / `imuRingPop`, the zero-copy pairs
+ * `imuRingReserve` / `imuRingCommit` and `imuRingPeek` / `imuRingConsume`
+ * expose contiguous runs of slots. A ring created with `imuRingInitItems`
+ * carries items of any fixed size through `imuRingReserveItems` and
+ * `imuRingPeekItems` instead.
+ */
+
+#ifndef ImuProtRing_h_included__
+#define ImuProtRing_h_included__
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+
+#define IMU_RING_CACHE_LINE (64)
+
+/**
+ * Ring state. All fields are private.
+ */
+typedef struct {
+	struct {
+		_Alignas(IMU_RING_CACHE_LINE) _Atomic size_t head;
+		size_t cachedTail;
+	} producer;
+	struct {
+		_Alignas(IMU_RING_CACHE_LINE) _Atomic size_t tail;
+		size_t cachedHead;
+	} consumer;
+	_Alignas(IMU_RING_CACHE_LINE) size_t mask;
+	size_t itemSize;
+	uint8_t *items;
+} ImuRing_t;
+
+/**
+ * @brief Allocates the ring.
+ *
+ * @param r         Ring to initialize.
+ * @param capacity  Number of slots, a power of two.
+ * @return int 0 on success, -1 if the capacity is invalid or memory could not be allocated.
+ */
+int imuRingInit(ImuRing_t *r, size_t capacity);
+
+/**
+ * @brief Allocates a ring of fixed-size items other than `ImuProt_t`.
+ *
+ * @param r         Ring to initialize.
+ * @param capacity  Number of slots, a power of two.
+ * @param itemSize  Size of an item in bytes.
+ * @return int 0 on success, -1 if the capacity is invalid or memory could not be allocated.
+ */
+int imuRingInitItems(ImuRing_t *r, size_t capacity, size_t itemSize);
+
+/**
+ * @brief Frees the ring. Neither thread may use it any more.
+ *
+ * @param r Ring.
+ */
+void imuRingFree(ImuRing_t *r);
+
+/**
+ * @brief Producer: returns a contiguous run of free slots.
+ *
+ * @param r     Ring.
+ * @param slots Receives the first free slot.
+ * @param max   Maximum number of slots wanted.
+ * @return size_t Number of slots available at `*slots`, 0 if the ring is full.
+ */
+size_t imuRingReserve(ImuRing_t *r, ImuProt_t **slots, size_t max);
+
+/**
+ * @brief Producer: `imuRingReserve` for rings of any item size.
+ */
+size_t imuRingReserveItems(ImuRing_t *r, void **items, size_t max);
+
+/**
+ * @brief Producer: publishes `count` slots filled after `imuRingReserve`.
+ *
+ * @param r     Ring.
+ * @param count Number of slots filled.
+ */
+void imuRingCommit(ImuRing_t *r, size_t count);
+
+/**
+ * @brief Consumer: returns a contiguous run of published packets.
+ *
+ * @param r     Ring.
+ * @param slots Receives the first packet.
+ * @param max   Maximum number of packets wanted.
+ * @return size_t Number of packets at `*slots`, 0 if the ring is empty.
+ */
+size_t imuRingPeek(ImuRing_t *r, const ImuProt_t **slots, size_t max);
+
+/**
+ * @brief Consumer: `imuRingPeek` for rings of any item size.
+ */
+size_t imuRingPeekItems(ImuRing_t *r, const void **items, size_t max);
+
+/**
+ * @brief Consumer: frees `count` packets returned by `imuRingPeek`.
+ *
+ * @param r     Ring.
+ * @param count Number of packets consumed.
+ */
+void imuRingConsume(ImuRing_t *r, size_t count);
+
+/**
+ * @brief Consumer: discards the oldest items so that at most `keep` remain.
+ *
+ * @param r     Ring.
+ * @param keep  Number of newest items to keep.
+ * @return size_t Number of items discarded.
+ */
+size_t imuRingDiscard(ImuRing_t *r, size_t keep);
+
+/**
+ * @brief Producer: copies up to `count` packets into the ring.
+ *
+ * @param r         Ring.
+ * @param packets   Packets to push.
+ * @param count     Number of packets.
+ * @return size_t Number of packets pushed, less than `count` if the ring filled up.
+ */
+size_t imuRingPush(ImuRing_t *r, const ImuProt_t *packets, size_t count);
+
+/**
+ * @brief Consumer: copies up to `max` packets out of the ring.
+ *
+ * @param r         Ring.
+ * @param packets   Output packets.
+ * @param max       Capacity of `packets`.
+ * @return size_t Number of packets popped.
+ */
+size_t imuRingPop(ImuRing_t *r, ImuProt_t *packets, size_t max);
+
+/**
+ * @brief Returns the number of packets in the ring. Exact only when called by one of the two threads.
+ */
+static inline size_t imuRingSize(const ImuRing_t *r)
+{
+	return atomic_load_explicit(&r->producer.head, memory_order_acquire)
+		- atomic_load_explicit(&r->consumer.tail, memory_order_acquire);
+}
+
+/**
+ * @brief Returns the number of slots.
+ */
+static inline size_t imuRingCapacity(const ImuRing_t *r)
+{
+	return r->mask + 1;
+}
+
+#endif
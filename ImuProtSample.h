@@ -0,0 +1,56 @@
+/**
+ * Decoded IMU Samples.
+ *
+ * Engineering-unit view of a packet shared by the processing stages: the
+ * pipeline decode stage, the batch decoders of `ImuProtIsa.h` and the
+ * navigation and calibration modules built on top of them.
+ */
+
+#ifndef ImuProtSample_h_included__
+#define ImuProtSample_h_included__
+
+#include <stdint.h>
+
+#include "ImuProt.h"
+
+/** Default conversion of `gyro` values (degrees per second) to rad/s. */
+#define IMU_GYRO_TO_RAD (0.017453292519943295)
+
+/** Default conversion of `accl` values (m/s^2) to m/s^2. */
+#define IMU_ACCL_TO_MPS2 (1.0)
+
+/**
+ * Decoded sample.
+ *
+ * @field gyro          Angular rates, converted with `floatData`.
+ * @field accl          Accelerations, converted with `floatData`.
+ * @field temperature   Temperature in Celsius, converted with `tempFromKelvin`.
+ * @field flags         Status flags of the packet.
+ * @field sequencer     Packet sequencer.
+ */
+typedef struct {
+	float gyro[3];
+	float accl[3];
+	float temperature;
+	uint16_t flags;
+	uint8_t sequencer;
+} ImuSample_t;
+
+/**
+ * @brief Decodes the fields of a packet.
+ *
+ * @param packet    Validated packet.
+ * @param sample    Output sample.
+ */
+static inline void imuDecodeSample(const ImuProt_t *packet, ImuSample_t *sample)
+{
+	for (int i = 0; i < 3; i++) {
+		sample->gyro[i] = floatData(packet->data.gyro[i]);
+		sample->accl[i] = floatData(packet->data.accl[i]);
+	}
+	sample->temperature = tempFromKelvin(packet->data.temperature);
+	sample->flags = packet->data.flags;
+	sample->sequencer = packet->sequencer;
+}
+
+#endif
@@ -0,0 +1,305 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ImuProtShm.h"
+
+_Static_assert(sizeof(ImuShmSlot_t) == IMU_SHM_CACHE_LINE, "slot layout");
+_Static_assert(sizeof(ImuShmCursor_t) == IMU_SHM_CACHE_LINE, "cursor layout");
+_Static_assert(sizeof(ImuShmHeader_t) % IMU_SHM_CACHE_LINE == 0, "header layout");
+
+/**
+ * @brief Hints the CPU that the caller is spinning.
+ */
+static inline void shmRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+/**
+ * @brief Futex operations on the shared word. The object is shared between
+ * processes, so FUTEX_PRIVATE_FLAG must not be used.
+ */
+static int shmFutexWait(_Atomic uint32_t *word, uint32_t expected, const struct timespec *timeout) {
+	return (int)syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+static void shmFutexWake(_Atomic uint32_t *word) {
+	syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/**
+ * @brief Returns CLOCK_MONOTONIC in nanoseconds, the clock FUTEX_WAIT measures its timeout with.
+ */
+static uint64_t shmNowNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+ImuShmError_t imuShmCreate(ImuShmWriter_t *w, const char *name, uint32_t capacity) {
+	memset(w, 0, sizeof(*w));
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0 || strlen(name) >= sizeof(w->name))
+		return IMU_SHM_BAD_ARGUMENT;
+
+	// A fresh object: readers still mapping an old ring are not confused by a reset head.
+	shm_unlink(name);
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0)
+		return IMU_SHM_IO_ERROR;
+
+	size_t mapSize = sizeof(ImuShmHeader_t) + (size_t)capacity * sizeof(ImuShmSlot_t);
+	if (ftruncate(fd, (off_t)mapSize) != 0) {
+		close(fd);
+		shm_unlink(name);
+		return IMU_SHM_IO_ERROR;
+	}
+	void *map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		shm_unlink(name);
+		return IMU_SHM_IO_ERROR;
+	}
+
+	// ftruncate zero-fills: every slot starts with seq 0, which the reader
+	// only accepts once head says packet 0 was published.
+	w->shm = map;
+	w->slots = (ImuShmSlot_t *)((uint8_t *)map + sizeof(ImuShmHeader_t));
+	w->mapSize = mapSize;
+	w->mask = capacity - 1;
+	strcpy(w->name, name);
+
+	w->shm->version = IMU_SHM_VERSION;
+	w->shm->capacity = capacity;
+	w->shm->slotSize = sizeof(ImuShmSlot_t);
+	atomic_store_explicit(&w->shm->magic, IMU_SHM_MAGIC, memory_order_release);
+	return IMU_SHM_OK;
+}
+
+void imuShmPublish(ImuShmWriter_t *w, const ImuProt_t *packets, const uint64_t *rxTimesNs, size_t count) {
+	if (!count)
+		return;
+
+	for (size_t i = 0; i < count; i++) {
+		ImuShmSlot_t *slot = &w->slots[w->head & w->mask];
+		atomic_store_explicit(&slot->seq, IMU_SHM_SLOT_BUSY, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		slot->rxTimeNs = rxTimesNs ? rxTimesNs[i] : 0;
+		slot->packet = packets[i];
+		atomic_store_explicit(&slot->seq, w->head, memory_order_release);
+		w->head++;
+	}
+
+	// Sequentially consistent store and load pair with the ones in imuShmWait:
+	// either the reader sees the new head or the writer sees the waiter.
+	atomic_store(&w->shm->head, w->head);
+	if (atomic_load(&w->shm->waiters)) {
+		atomic_fetch_add(&w->shm->futex, 1);
+		shmFutexWake(&w->shm->futex);
+	}
+}
+
+void imuShmWriterClose(ImuShmWriter_t *w, int unlink) {
+	if (w->shm)
+		munmap(w->shm, w->mapSize);
+	if (unlink && w->name[0])
+		shm_unlink(w->name);
+	memset(w, 0, sizeof(*w));
+}
+
+/**
+ * @brief Claims a free cursor, or one left behind by a process that no longer exists.
+ */
+static ImuShmCursor_t *shmRegister(ImuShmHeader_t *shm) {
+	int32_t self = (int32_t)getpid();
+	for (int k = 0; k < IMU_SHM_MAX_READERS; k++) {
+		ImuShmCursor_t *c = &shm->readers[k];
+		int32_t owner = atomic_load(&c->pid);
+		if (owner != 0 && (kill(owner, 0) == 0 || errno != ESRCH))
+			continue;
+		if (atomic_compare_exchange_strong(&c->pid, &owner, self))
+			return c;
+	}
+	return NULL;
+}
+
+ImuShmError_t imuShmOpen(ImuShmReader_t *r, const char *name, int start) {
+	memset(r, 0, sizeof(*r));
+	int fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+		return IMU_SHM_IO_ERROR;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return IMU_SHM_IO_ERROR;
+	}
+	if ((size_t)st.st_size < sizeof(ImuShmHeader_t)) {
+		close(fd);
+		return IMU_SHM_BAD_FORMAT;
+	}
+	void *map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return IMU_SHM_IO_ERROR;
+
+	ImuShmHeader_t *shm = map;
+	uint32_t capacity = shm->capacity;
+	if (atomic_load_explicit(&shm->magic, memory_order_acquire) != IMU_SHM_MAGIC
+		|| shm->version != IMU_SHM_VERSION || shm->slotSize != sizeof(ImuShmSlot_t)
+		|| capacity == 0 || (capacity & (capacity - 1)) != 0
+		|| (size_t)st.st_size < sizeof(ImuShmHeader_t) + (size_t)capacity * sizeof(ImuShmSlot_t)) {
+		munmap(map, (size_t)st.st_size);
+		return IMU_SHM_BAD_FORMAT;
+	}
+
+	r->registration = shmRegister(shm);
+	if (!r->registration) {
+		munmap(map, (size_t)st.st_size);
+		return IMU_SHM_NO_READER_SLOT;
+	}
+
+	r->shm = shm;
+	r->slots = (ImuShmSlot_t *)((uint8_t *)map + sizeof(ImuShmHeader_t));
+	r->mapSize = (size_t)st.st_size;
+	r->mask = capacity - 1;
+
+	uint64_t head = atomic_load_explicit(&shm->head, memory_order_acquire);
+	if (start == IMU_SHM_FROM_OLDEST)
+		r->cursor = head > capacity ? head - capacity : 0;
+	else
+		r->cursor = head;
+	atomic_store_explicit(&r->registration->cursor, r->cursor, memory_order_relaxed);
+	atomic_store_explicit(&r->registration->lost, 0, memory_order_relaxed);
+	return IMU_SHM_OK;
+}
+
+/**
+ * @brief Advances the cursor past a packet that was lost and publishes the cursor.
+ */
+static void shmAdvance(ImuShmReader_t *r, uint64_t lost) {
+	r->cursor++;
+	r->lost += lost;
+	atomic_store_explicit(&r->registration->cursor, r->cursor, memory_order_relaxed);
+	if (lost)
+		atomic_store_explicit(&r->registration->lost, r->lost, memory_order_relaxed);
+}
+
+const ImuProt_t *imuShmPeek(ImuShmReader_t *r, uint64_t *rxTimeNs) {
+	for (;;) {
+		uint64_t head = atomic_load_explicit(&r->shm->head, memory_order_acquire);
+		if (r->cursor == head)
+			return NULL;
+
+		// Skip whatever the writer has already lapped.
+		uint64_t capacity = (uint64_t)r->mask + 1;
+		if (head - r->cursor > capacity) {
+			r->lost += head - capacity - r->cursor;
+			r->cursor = head - capacity;
+			atomic_store_explicit(&r->registration->lost, r->lost, memory_order_relaxed);
+		}
+
+		const ImuShmSlot_t *slot = &r->slots[r->cursor & r->mask];
+		if (atomic_load_explicit(&slot->seq, memory_order_acquire) == r->cursor) {
+			if (rxTimeNs)
+				*rxTimeNs = slot->rxTimeNs;
+			return &slot->packet;
+		}
+		// Being overwritten, or already holding a later packet.
+		shmAdvance(r, 1);
+	}
+}
+
+int imuShmRelease(ImuShmReader_t *r) {
+	const ImuShmSlot_t *slot = &r->slots[r->cursor & r->mask];
+	atomic_thread_fence(memory_order_acquire);
+	int intact = atomic_load_explicit(&slot->seq, memory_order_relaxed) == r->cursor;
+	shmAdvance(r, !intact);
+	return intact;
+}
+
+size_t imuShmRead(ImuShmReader_t *r, ImuProt_t *packets, uint64_t *rxTimesNs, size_t maxCount) {
+	size_t count = 0;
+	while (count < maxCount) {
+		uint64_t rxTimeNs;
+		const ImuProt_t *packet = imuShmPeek(r, &rxTimeNs);
+		if (!packet)
+			break;
+		packets[count] = *packet;
+		if (rxTimesNs)
+			rxTimesNs[count] = rxTimeNs;
+		count += imuShmRelease(r);
+	}
+	return count;
+}
+
+ImuShmError_t imuShmWait(ImuShmReader_t *r, uint32_t spin, uint64_t timeoutNs) {
+	for (uint32_t i = 0; i < spin; i++) {
+		if (atomic_load_explicit(&r->shm->head, memory_order_acquire) != r->cursor)
+			return IMU_SHM_OK;
+		shmRelax();
+	}
+
+	// Wake-ups for other readers, spurious ones and signals restart the wait
+	// with the time left until the deadline.
+	uint64_t deadline = timeoutNs ? shmNowNs() + timeoutNs : 0;
+	int available;
+	atomic_fetch_add(&r->shm->waiters, 1);
+	for (;;) {
+		uint32_t word = atomic_load(&r->shm->futex);
+		available = atomic_load(&r->shm->head) != r->cursor;
+		if (available)
+			break;
+		if (!timeoutNs) {
+			shmFutexWait(&r->shm->futex, word, NULL);
+			continue;
+		}
+		uint64_t now = shmNowNs();
+		if (now >= deadline)
+			break;
+		struct timespec timeout = {
+			.tv_sec = (time_t)((deadline - now) / 1000000000u),
+			.tv_nsec = (long)((deadline - now) % 1000000000u)
+		};
+		shmFutexWait(&r->shm->futex, word, &timeout);
+	}
+	atomic_fetch_sub(&r->shm->waiters, 1);
+	return available ? IMU_SHM_OK : IMU_SHM_TIMEOUT;
+}
+
+void imuShmReaderClose(ImuShmReader_t *r) {
+	if (r->registration)
+		atomic_store(&r->registration->pid, 0);
+	if (r->shm)
+		munmap(r->shm, r->mapSize);
+	memset(r, 0, sizeof(*r));
+}
+
+const char *imuShmErrorToString(ImuShmError_t error) {
+	switch (error) {
+		case IMU_SHM_OK:
+			return "OK.";
+		case IMU_SHM_IO_ERROR:
+			return "I/O error!";
+		case IMU_SHM_BAD_FORMAT:
+			return "Not a packet ring!";
+		case IMU_SHM_BAD_ARGUMENT:
+			return "Invalid ring name or capacity!";
+		case IMU_SHM_NO_READER_SLOT:
+			return "No free reader slot!";
+		case IMU_SHM_TIMEOUT:
+			return "Timeout!";
+	}
+	return "Unknown error.";
+}
@@ -0,0 +1,242 @@
+/**
+ * Shared Memory Packet Ring.
+ *
+ * Publishes validated `ImuProt_t` packets from one producer process to any
+ * number of reader processes through a POSIX shared memory object. The
+ * producer never waits for readers: every packet is written once into a
+ * cache-line sized slot and readers access the slots in place.
+ *
+ * Each slot carries the sequence number of the packet it holds. A reader
+ * compares it before and after using the slot, so a reader that falls more
+ * than `capacity` packets behind detects the overrun, counts the lost
+ * packets and skips to the oldest packet still available.
+ *
+ * Readers register a cursor in the shared header so that their lag can be
+ * monitored, and either busy-poll or sleep on a futex until new packets
+ * are published.
+ */
+
+#ifndef ImuProtShm_h_included__
+#define ImuProtShm_h_included__
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+
+#define IMU_SHM_MAGIC (0x52534D49UL)    // "IMSR"
+#define IMU_SHM_VERSION (1)
+#define IMU_SHM_CACHE_LINE (64)
+
+/** Maximum number of registered readers. */
+#define IMU_SHM_MAX_READERS (16)
+
+/** Sequence value of a slot being written. */
+#define IMU_SHM_SLOT_BUSY (~(uint64_t)0)
+
+/**
+ * A ring slot, one cache line.
+ *
+ * @field seq       Index of the packet held by the slot, IMU_SHM_SLOT_BUSY while written.
+ * @field rxTimeNs  Receive time of the packet.
+ * @field packet    Validated packet.
+ */
+typedef struct {
+	_Alignas(IMU_SHM_CACHE_LINE) _Atomic uint64_t seq;
+	uint64_t rxTimeNs;
+	ImuProt_t packet;
+} ImuShmSlot_t;
+
+/**
+ * Registered reader cursor, one cache line.
+ *
+ * @field pid       Process owning the cursor, 0 if free.
+ * @field cursor    Index of the next packet the reader will consume.
+ * @field lost      Packets lost by the reader because of overruns.
+ */
+typedef struct {
+	_Alignas(IMU_SHM_CACHE_LINE) _Atomic int32_t pid;
+	_Atomic uint64_t cursor;
+	_Atomic uint64_t lost;
+} ImuShmCursor_t;
+
+/**
+ * Shared header, followed by `capacity` slots.
+ *
+ * Fields written by different parties live on separate cache lines.
+ *
+ * @field magic         IMU_SHM_MAGIC, written last during creation.
+ * @field capacity      Number of slots, a power of two.
+ * @field head          Number of packets published so far.
+ * @field futex         Futex word, incremented on every wake-up.
+ * @field waiters       Number of readers sleeping on `futex`.
+ * @field readers       Registered reader cursors.
+ */
+typedef struct {
+	_Alignas(IMU_SHM_CACHE_LINE) _Atomic uint32_t magic;
+	uint32_t version;
+	uint32_t capacity;
+	uint32_t slotSize;
+	_Alignas(IMU_SHM_CACHE_LINE) _Atomic uint64_t head;
+	_Alignas(IMU_SHM_CACHE_LINE) _Atomic uint32_t futex;
+	_Atomic uint32_t waiters;
+	ImuShmCursor_t readers[IMU_SHM_MAX_READERS];
+} ImuShmHeader_t;
+
+/**
+ * @enum ImuShmError_t
+ * @brief Error codes of the shared memory ring.
+ */
+typedef enum {
+	IMU_SHM_OK = 0,             // Success.
+	IMU_SHM_IO_ERROR = 1,       // A system call failed, see errno.
+	IMU_SHM_BAD_FORMAT = 2,     // The object is not a ring or has another version.
+	IMU_SHM_BAD_ARGUMENT = 3,   // Capacity is not a power of two.
+	IMU_SHM_NO_READER_SLOT = 4, // All reader cursors are in use.
+	IMU_SHM_TIMEOUT = 5         // No packet arrived before the timeout.
+} ImuShmError_t;
+
+/**
+ * Producer side of the ring. All fields are private.
+ */
+typedef struct {
+	ImuShmHeader_t *shm;
+	ImuShmSlot_t *slots;
+	size_t mapSize;
+	uint64_t head;
+	uint32_t mask;
+	char name[64];
+} ImuShmWriter_t;
+
+/**
+ * Reader side of the ring. All fields are private.
+ */
+typedef struct {
+	ImuShmHeader_t *shm;
+	ImuShmSlot_t *slots;
+	size_t mapSize;
+	ImuShmCursor_t *registration;
+	uint64_t cursor;
+	uint64_t lost;
+	uint32_t mask;
+} ImuShmReader_t;
+
+/** Start reading with the next packet published. */
+#define IMU_SHM_FROM_NEWEST (0)
+/** Start reading with the oldest packet still held by the ring. */
+#define IMU_SHM_FROM_OLDEST (1)
+
+/**
+ * @brief Creates (or recreates) a ring and maps it for publishing.
+ *
+ * @param w         Writer to initialize.
+ * @param name      Shared memory object name, e.g. "/imu0".
+ * @param capacity  Number of slots, a power of two.
+ * @return ImuShmError_t IMU_SHM_OK on success.
+ */
+ImuShmError_t imuShmCreate(ImuShmWriter_t *w, const char *name, uint32_t capacity);
+
+/**
+ * @brief Publishes a batch of validated packets.
+ *
+ * Each packet is copied once into its slot. Sleeping readers are woken once
+ * per batch, and only if there are any.
+ *
+ * @param w         Writer.
+ * @param packets   Packets to publish.
+ * @param rxTimesNs Receive times, or NULL to store zero.
+ * @param count     Number of packets.
+ */
+void imuShmPublish(ImuShmWriter_t *w, const ImuProt_t *packets, const uint64_t *rxTimesNs, size_t count);
+
+/**
+ * @brief Unmaps the ring and optionally removes the shared memory object.
+ *
+ * @param w         Writer.
+ * @param unlink    Non-zero to remove the object name.
+ */
+void imuShmWriterClose(ImuShmWriter_t *w, int unlink);
+
+/**
+ * @brief Maps an existing ring and registers a reader cursor.
+ *
+ * @param r     Reader to initialize.
+ * @param name  Shared memory object name.
+ * @param start IMU_SHM_FROM_NEWEST or IMU_SHM_FROM_OLDEST.
+ * @return ImuShmError_t IMU_SHM_OK on success.
+ */
+ImuShmError_t imuShmOpen(ImuShmReader_t *r, const char *name, int start);
+
+/**
+ * @brief Returns the next packet in place, without consuming it.
+ *
+ * The packet must be released with `imuShmRelease`, which tells whether the
+ * producer overwrote the slot while it was being used.
+ *
+ * @param r         Reader.
+ * @param rxTimeNs  Optional, receives the receive time.
+ * @return const ImuProt_t* Packet inside the ring, NULL if none is available.
+ */
+const ImuProt_t *imuShmPeek(ImuShmReader_t *r, uint64_t *rxTimeNs);
+
+/**
+ * @brief Consumes the packet returned by `imuShmPeek`.
+ *
+ * @param r Reader.
+ * @return int 1 if the packet was intact, 0 if it was overwritten (and counted as lost).
+ */
+int imuShmRelease(ImuShmReader_t *r);
+
+/**
+ * @brief Copies up to `maxCount` packets out of the ring.
+ *
+ * Convenience for readers that keep packets beyond their processing; torn
+ * slots are detected and counted as lost.
+ *
+ * @param r         Reader.
+ * @param packets   Output packets.
+ * @param rxTimesNs Optional output receive times.
+ * @param maxCount  Capacity of the output arrays.
+ * @return size_t Number of packets copied.
+ */
+size_t imuShmRead(ImuShmReader_t *r, ImuProt_t *packets, uint64_t *rxTimesNs, size_t maxCount);
+
+/**
+ * @brief Waits until a packet is available.
+ *
+ * Busy-polls `spin` times, then sleeps on the futex. Wake-ups that bring no
+ * packet for this reader go back to sleep until `timeoutNs` has elapsed on
+ * CLOCK_MONOTONIC.
+ *
+ * @param r         Reader.
+ * @param spin      Number of polls before sleeping; use a large value to busy-poll only.
+ * @param timeoutNs Maximum sleep, 0 to wait forever.
+ * @return ImuShmError_t IMU_SHM_OK if a packet is available, IMU_SHM_TIMEOUT otherwise.
+ */
+ImuShmError_t imuShmWait(ImuShmReader_t *r, uint32_t spin, uint64_t timeoutNs);
+
+/**
+ * @brief Returns the number of packets this reader lost to overruns.
+ */
+static inline uint64_t imuShmLost(const ImuShmReader_t *r)
+{
+	return r->lost;
+}
+
+/**
+ * @brief Unregisters the reader cursor and unmaps the ring.
+ *
+ * @param r Reader.
+ */
+void imuShmReaderClose(ImuShmReader_t *r);
+
+/**
+ * @brief Converts an ImuShmError_t error code to its string representation.
+ *
+ * @param error The ImuShmError_t error code.
+ * @return A string that describes the error.
+ */
+const char *imuShmErrorToString(ImuShmError_t error);
+
+#endif
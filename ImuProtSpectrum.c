@@ -0,0 +1,224 @@
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ImuProtIsa.h"
+#include "ImuProtSpectrum.h"
+
+#define SPEC_INLINE static inline __attribute__((always_inline))
+
+typedef float SpecVec_t __attribute__((vector_size(IMU_SPECTRUM_LANES * sizeof(float))));
+
+/*
+ * Kernel: one segment from the history window `x` into the accumulated
+ * power. The work buffer holds `size / 2` complex values as pairs of
+ * vectors, real parts then imaginary parts, one lane per axis.
+ */
+
+SPEC_INLINE void specSegment(ImuSpectrum_t *s, const float (*x)[IMU_SPECTRUM_LANES]) {
+	const uint32_t n = s->size, half = n / 2;
+	const SpecVec_t *in = (const SpecVec_t *)x;
+	SpecVec_t *w = (SpecVec_t *)s->work;
+	SpecVec_t *acc = (SpecVec_t *)s->acc;
+	const float *tw = s->twiddle;
+
+	// Packed as z[i] = x[2i] + j x[2i + 1], in bit-reversed order for the in-place FFT.
+	SpecVec_t mean = { 0 };
+	for (uint32_t i = 0; i < n; i++)
+		mean += in[i];
+	mean *= 1.0f / n;
+	for (uint32_t i = 0; i < half; i++) {
+		uint32_t r = s->reverse[i];
+		w[2 * r] = (in[2 * i] - mean) * s->window[2 * i];
+		w[2 * r + 1] = (in[2 * i + 1] - mean) * s->window[2 * i + 1];
+	}
+
+	uint32_t m = 1;
+	if (__builtin_ctz(half) & 1) {
+		for (uint32_t k = 0; k < half; k += 2) {
+			SpecVec_t ar = w[2 * k], ai = w[2 * k + 1], br = w[2 * k + 2], bi = w[2 * k + 3];
+			w[2 * k] = ar + br;
+			w[2 * k + 1] = ai + bi;
+			w[2 * k + 2] = ar - br;
+			w[2 * k + 3] = ai - bi;
+		}
+		m = 2;
+	}
+	// Radix-4 passes: two radix-2 stages (lengths 2m and 4m) per pass over the data.
+	for (; m < half; m *= 4) {
+		const uint32_t step1 = half / (2 * m), step2 = half / (4 * m);
+		for (uint32_t k = 0; k < half; k += 4 * m) {
+			for (uint32_t j = 0; j < m; j++) {
+				const float c1 = tw[2 * j * step1], s1 = tw[2 * j * step1 + 1];
+				const float c2 = tw[2 * j * step2], s2 = tw[2 * j * step2 + 1];
+				SpecVec_t *p0 = &w[2 * (k + j)], *p1 = p0 + 2 * m, *p2 = p1 + 2 * m, *p3 = p2 + 2 * m;
+				SpecVec_t tr = c1 * p1[0] - s1 * p1[1], ti = c1 * p1[1] + s1 * p1[0];
+				SpecVec_t b0r = p0[0] + tr, b0i = p0[1] + ti, b1r = p0[0] - tr, b1i = p0[1] - ti;
+				tr = c1 * p3[0] - s1 * p3[1];
+				ti = c1 * p3[1] + s1 * p3[0];
+				SpecVec_t b2r = p2[0] + tr, b2i = p2[1] + ti, b3r = p2[0] - tr, b3i = p2[1] - ti;
+				tr = c2 * b2r - s2 * b2i;
+				ti = c2 * b2i + s2 * b2r;
+				p0[0] = b0r + tr;
+				p0[1] = b0i + ti;
+				p2[0] = b0r - tr;
+				p2[1] = b0i - ti;
+				// Twiddle of the odd half: -j times that of the even half.
+				tr = c2 * b3i + s2 * b3r;
+				ti = s2 * b3i - c2 * b3r;
+				p1[0] = b1r + tr;
+				p1[1] = b1i + ti;
+				p3[0] = b1r - tr;
+				p3[1] = b1i - ti;
+			}
+		}
+	}
+
+	// Split into the spectrum of the real signal: X(k) = E(k) + e^(-2 pi j k / n) O(k).
+	for (uint32_t k = 0; k <= half; k++) {
+		const SpecVec_t *a = &w[2 * (k & (half - 1))], *b = &w[2 * ((half - k) & (half - 1))];
+		SpecVec_t er = 0.5f * (a[0] + b[0]), ei = 0.5f * (a[1] - b[1]);
+		SpecVec_t qr = 0.5f * (a[1] + b[1]), qi = 0.5f * (b[0] - a[0]);
+		const float c = s->split[2 * k], sn = s->split[2 * k + 1];
+		SpecVec_t xr = er + c * qr - sn * qi, xi = ei + c * qi + sn * qr;
+		acc[k] += xr * xr + xi * xi;
+	}
+}
+
+static void specBaseline(ImuSpectrum_t *s, const float (*x)[IMU_SPECTRUM_LANES]) {
+	specSegment(s, x);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+#define SPEC_TARGET(t) static __attribute__((target(t)))
+
+SPEC_TARGET("arch=x86-64-v3") void specAvx2(ImuSpectrum_t *s, const float (*x)[IMU_SPECTRUM_LANES]) {
+	specSegment(s, x);
+}
+
+#define SPEC_AVX2 specAvx2
+
+#else
+
+#define SPEC_AVX2 specBaseline
+
+#endif
+
+/**
+ * @brief Allocates `size` bytes aligned for the vector loads, zeroed.
+ */
+static void *specAlloc(size_t size) {
+	size = (size + 63) & ~(size_t)63;
+	void *p = aligned_alloc(64, size);
+	if (p)
+		memset(p, 0, size);
+	return p;
+}
+
+int imuSpectrumInit(ImuSpectrum_t *s, uint32_t packetRate, uint32_t size, uint32_t hop, uint32_t averages,
+	ImuSpectrumWindow_t window) {
+	memset(s, 0, sizeof(*s));
+	if (!packetRate || size < IMU_SPECTRUM_MIN_SIZE || size > IMU_SPECTRUM_MAX_SIZE || (size & (size - 1))
+		|| !hop || !averages || window > IMU_SPECTRUM_BLACKMAN)
+		return -1;
+	const uint32_t half = size / 2;
+	const size_t row = IMU_SPECTRUM_LANES * sizeof(float);
+	s->history = specAlloc(2 * (size_t)size * row);
+	s->work = specAlloc(2 * (size_t)half * row);
+	s->acc = specAlloc(((size_t)half + 1) * row);
+	s->psd = specAlloc(((size_t)half + 1) * row);
+	s->window = specAlloc(size * sizeof(float));
+	s->twiddle = specAlloc(half * sizeof(float));
+	s->split = specAlloc(2 * ((size_t)half + 1) * sizeof(float));
+	s->reverse = specAlloc(half * sizeof(uint32_t));
+	if (!s->history || !s->work || !s->acc || !s->psd || !s->window || !s->twiddle || !s->split || !s->reverse) {
+		imuSpectrumFree(s);
+		return -1;
+	}
+
+	double power = 0.0;
+	for (uint32_t i = 0; i < size; i++) {
+		double x = 2.0 * M_PI * i / size;
+		double v = window == IMU_SPECTRUM_HANN ? 0.5 - 0.5 * cos(x)
+			: window == IMU_SPECTRUM_BLACKMAN ? 0.42 - 0.5 * cos(x) + 0.08 * cos(2.0 * x) : 1.0;
+		s->window[i] = (float)v;
+		power += v * v;
+	}
+	for (uint32_t j = 0; j < half / 2; j++) {
+		s->twiddle[2 * j] = (float)cos(2.0 * M_PI * j / half);
+		s->twiddle[2 * j + 1] = (float)-sin(2.0 * M_PI * j / half);
+	}
+	for (uint32_t k = 0; k <= half; k++) {
+		s->split[2 * k] = (float)cos(2.0 * M_PI * k / size);
+		s->split[2 * k + 1] = (float)-sin(2.0 * M_PI * k / size);
+	}
+	const int bits = __builtin_ctz(half);
+	for (uint32_t i = 0; i < half; i++) {
+		uint32_t r = 0;
+		for (int b = 0; b < bits; b++)
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		s->reverse[i] = r;
+	}
+
+	s->packetRate = packetRate;
+	s->scale = (float)(1.0 / (packetRate * power * averages));
+	s->size = size;
+	s->hop = hop;
+	s->averages = averages;
+	s->countdown = size;
+	s->kernel = imuIsaActive() >= IMU_ISA_AVX2 ? SPEC_AVX2 : specBaseline;
+	return 0;
+}
+
+void imuSpectrumFree(ImuSpectrum_t *s) {
+	free(s->history);
+	free(s->work);
+	free(s->acc);
+	free(s->psd);
+	free(s->window);
+	free(s->twiddle);
+	free(s->split);
+	free(s->reverse);
+	memset(s, 0, sizeof(*s));
+}
+
+/**
+ * @brief Scales the accumulated power into the PSD frame and clears it.
+ */
+static void specEmit(ImuSpectrum_t *s) {
+	const uint32_t half = s->size / 2;
+	for (uint32_t k = 0; k <= half; k++) {
+		float scale = k == 0 || k == half ? s->scale : 2.0f * s->scale;
+		for (int c = 0; c < IMU_SPECTRUM_LANES; c++)
+			s->psd[k][c] = s->acc[k][c] * scale;
+	}
+	memset(s->acc, 0, ((size_t)half + 1) * sizeof(s->acc[0]));
+	s->segments = 0;
+	s->frames++;
+	s->ready = 1;
+}
+
+size_t imuSpectrumPush(ImuSpectrum_t *s, const ImuSample_t *samples, size_t count) {
+	s->ready = 0;
+	for (size_t i = 0; i < count; i++) {
+		float *a = s->history[s->pos];
+		float *b = s->history[s->pos + s->size];
+		for (int c = 0; c < 3; c++) {
+			a[c] = b[c] = samples[i].gyro[c];
+			a[c + 3] = b[c + 3] = samples[i].accl[c];
+		}
+		s->pos = (s->pos + 1) & (s->size - 1);
+		if (--s->countdown)
+			continue;
+		s->countdown = s->hop;
+		s->kernel(s, (const float (*)[IMU_SPECTRUM_LANES])s->history + s->pos);
+		if (++s->segments == s->averages) {
+			specEmit(s);
+			return i + 1;
+		}
+	}
+	return count;
+}
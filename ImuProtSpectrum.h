@@ -0,0 +1,155 @@
+/**
+ * Streaming Vibration Spectrum Analyzer.
+ *
+ * Estimates the power spectral density of the six `gyro` and `accl` axes
+ * with Welch's method: segments of `size` samples starting every `hop`
+ * samples (overlapping when `hop < size`) have their mean removed, are
+ * windowed and transformed, and the squared magnitudes of `averages`
+ * consecutive segments are averaged into one PSD frame:
+ *
+ *   PSD(k) = c_k / (fs * sum(w^2) * averages) * sum |X(k)|^2
+ *
+ * with c_k = 2 for the bins between DC and Nyquist (one-sided) and 1
+ * otherwise, in (units of the readings)^2 / Hz. Frames come out at
+ * fs / (hop * averages).
+ *
+ * The transform is a self-contained real FFT: the `size` real samples are
+ * packed into `size / 2` complex values, transformed by an iterative
+ * radix-4 FFT (with one radix-2 pass when log2(size / 2) is odd) and split
+ * into the spectrum of the real signal. All six axes go through the FFT
+ * together as the lanes of one SIMD vector, so every butterfly is a handful
+ * of vector operations with broadcast twiddles and no shuffles. The kernels
+ * are compiled per ISA level and follow `ImuProtIsa.h` at init time.
+ *
+ * Buffers are allocated by `imuSpectrumInit`; pushing samples does not
+ * allocate.
+ */
+
+#ifndef ImuProtSpectrum_h_included__
+#define ImuProtSpectrum_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProtSample.h"
+
+/** Analyzed axes: gyro X, Y, Z, accl X, Y, Z. */
+#define IMU_SPECTRUM_CHANNELS (6)
+
+/** Values per frame, the axes padded to a SIMD vector. */
+#define IMU_SPECTRUM_LANES (8)
+
+/** Smallest and largest segment size, powers of two. */
+#define IMU_SPECTRUM_MIN_SIZE (16)
+#define IMU_SPECTRUM_MAX_SIZE (65536)
+
+/**
+ * Window functions.
+ */
+typedef enum {
+	IMU_SPECTRUM_RECT = 0,      // No window.
+	IMU_SPECTRUM_HANN = 1,      // Hann, the usual choice with 50 % overlap.
+	IMU_SPECTRUM_BLACKMAN = 2,  // Blackman, lower leakage for wide dynamic range.
+} ImuSpectrumWindow_t;
+
+/**
+ * Analyzer state. All fields are private.
+ */
+typedef struct ImuSpectrum {
+	float (*history)[IMU_SPECTRUM_LANES];
+	float (*work)[IMU_SPECTRUM_LANES];
+	float (*acc)[IMU_SPECTRUM_LANES];
+	float (*psd)[IMU_SPECTRUM_LANES];
+	float *window;
+	float *twiddle;
+	float *split;
+	uint32_t *reverse;
+	void (*kernel)(struct ImuSpectrum *s, const float (*x)[IMU_SPECTRUM_LANES]);
+	double packetRate;
+	float scale;
+	uint32_t size;
+	uint32_t hop;
+	uint32_t averages;
+	uint32_t pos;
+	uint32_t countdown;
+	uint32_t segments;
+	int ready;
+	uint64_t frames;
+} ImuSpectrum_t;
+
+/**
+ * @brief Initializes the analyzer and allocates its buffers.
+ *
+ * @param s             State to initialize.
+ * @param packetRate    Sample rate in Hz.
+ * @param size          Segment size, a power of two from IMU_SPECTRUM_MIN_SIZE
+ *                      to IMU_SPECTRUM_MAX_SIZE; the bin spacing is packetRate / size.
+ * @param hop           Samples from one segment to the next, e.g. size / 2 for 50 % overlap.
+ * @param averages      Segments averaged per PSD frame, at least 1.
+ * @param window        Window function.
+ * @return int 0 on success, -1 if an argument is out of range or allocation failed.
+ */
+int imuSpectrumInit(ImuSpectrum_t *s, uint32_t packetRate, uint32_t size, uint32_t hop, uint32_t averages,
+	ImuSpectrumWindow_t window);
+
+/**
+ * @brief Frees the buffers of the analyzer.
+ */
+void imuSpectrumFree(ImuSpectrum_t *s);
+
+/**
+ * @brief Adds consecutive decoded samples, up to the completion of the next PSD frame.
+ *
+ * @param s         State.
+ * @param samples   Samples, e.g. from `imuDecodeSamples`.
+ * @param count     Number of samples.
+ * @return size_t Number of samples consumed; fewer than `count` only if a
+ *                frame completed, which `imuSpectrumReady` then reports.
+ */
+size_t imuSpectrumPush(ImuSpectrum_t *s, const ImuSample_t *samples, size_t count);
+
+/**
+ * @brief Returns 1 if the last `imuSpectrumPush` completed a PSD frame.
+ */
+static inline int imuSpectrumReady(const ImuSpectrum_t *s)
+{
+	return s->ready;
+}
+
+/**
+ * @brief Returns the last PSD frame.
+ *
+ * The frame holds `imuSpectrumBins` rows of IMU_SPECTRUM_LANES values: the
+ * PSD of axis `c` at bin `k` is `frame[k * IMU_SPECTRUM_LANES + c]`. It stays
+ * valid until the next frame completes.
+ */
+static inline const float *imuSpectrumFrame(const ImuSpectrum_t *s)
+{
+	return s->psd[0];
+}
+
+/**
+ * @brief Returns the number of frequency bins, size / 2 + 1 from DC to Nyquist.
+ */
+static inline uint32_t imuSpectrumBins(const ImuSpectrum_t *s)
+{
+	return s->size / 2 + 1;
+}
+
+/**
+ * @brief Returns the frequency of a bin in Hz.
+ */
+static inline double imuSpectrumBinHz(const ImuSpectrum_t *s, uint32_t bin)
+{
+	return bin * s->packetRate / s->size;
+}
+
+/**
+ * @brief Returns the number of PSD frames completed.
+ */
+static inline uint64_t imuSpectrumFrames(const ImuSpectrum_t *s)
+{
+	return s->frames;
+}
+
+#endif
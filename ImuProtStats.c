@@ -0,0 +1,183 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ImuProtStats.h"
+
+_Static_assert(sizeof(ImuStatsSlot_t) % IMU_STATS_CACHE_LINE == 0, "slot layout");
+
+/**
+ * @brief Zeroes the counters and sequencer tracking of a slot.
+ */
+static void statsClear(ImuStatsSlot_t *s) {
+	imuStatsSet(&s->packets, 0);
+	imuStatsSet(&s->bytes, 0);
+	imuStatsSet(&s->discarded, 0);
+	imuStatsSet(&s->resyncs, 0);
+	for (size_t i = 0; i <= IMU_PROT_BAD_CRC; i++)
+		imuStatsSet(&s->errors[i], 0);
+	imuStatsSet(&s->gaps, 0);
+	imuStatsSet(&s->lost, 0);
+	imuStatsSet(&s->muxCycles, 0);
+	s->lastSeq = -1;
+	s->muxRun = 0;
+}
+
+/**
+ * @brief Fills the header and slots; the magic is written last.
+ */
+static void statsFormat(ImuStatsBlock_t *b) {
+	memset(b, 0, sizeof(*b));
+	b->version = IMU_STATS_VERSION;
+	b->slotSize = sizeof(ImuStatsSlot_t);
+	for (size_t i = 0; i < IMU_STATS_SLOTS; i++)
+		statsClear(&b->slots[i]);
+	atomic_store_explicit(&b->magic, IMU_STATS_MAGIC, memory_order_release);
+}
+
+void imuStatsInit(ImuStatsBlock_t *b) {
+	statsFormat(b);
+}
+
+ImuStatsError_t imuStatsCreate(const char *name, ImuStatsBlock_t **b) {
+	*b = NULL;
+	shm_unlink(name);
+	int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0)
+		return IMU_STATS_IO_ERROR;
+	if (ftruncate(fd, (off_t)sizeof(ImuStatsBlock_t)) != 0) {
+		close(fd);
+		shm_unlink(name);
+		return IMU_STATS_IO_ERROR;
+	}
+	void *map = mmap(NULL, sizeof(ImuStatsBlock_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		shm_unlink(name);
+		return IMU_STATS_IO_ERROR;
+	}
+	statsFormat(map);
+	*b = map;
+	return IMU_STATS_OK;
+}
+
+ImuStatsError_t imuStatsOpen(const char *name, const ImuStatsBlock_t **b) {
+	*b = NULL;
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return IMU_STATS_IO_ERROR;
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return IMU_STATS_IO_ERROR;
+	}
+	if ((size_t)st.st_size != sizeof(ImuStatsBlock_t)) {
+		close(fd);
+		return IMU_STATS_BAD_FORMAT;
+	}
+	void *map = mmap(NULL, sizeof(ImuStatsBlock_t), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return IMU_STATS_IO_ERROR;
+
+	const ImuStatsBlock_t *block = map;
+	if (atomic_load_explicit(&block->magic, memory_order_acquire) != IMU_STATS_MAGIC
+		|| block->version != IMU_STATS_VERSION || block->slotSize != sizeof(ImuStatsSlot_t)) {
+		munmap(map, sizeof(ImuStatsBlock_t));
+		return IMU_STATS_BAD_FORMAT;
+	}
+	*b = block;
+	return IMU_STATS_OK;
+}
+
+void imuStatsClose(const ImuStatsBlock_t *b, const char *name) {
+	if (b)
+		munmap((void *)b, sizeof(ImuStatsBlock_t));
+	if (name)
+		shm_unlink(name);
+}
+
+ImuStatsSlot_t *imuStatsAcquire(ImuStatsBlock_t *b) {
+	for (size_t i = 0; i < IMU_STATS_SLOTS; i++) {
+		uint32_t expected = 0;
+		if (atomic_compare_exchange_strong_explicit(&b->slots[i].owned, &expected, 1, memory_order_acquire,
+			memory_order_relaxed))
+			return &b->slots[i];
+	}
+	return NULL;
+}
+
+void imuStatsRelease(ImuStatsBlock_t *b, ImuStatsSlot_t *s) {
+	if (!s)
+		return;
+	// Odd while the slot moves into the retired totals; concurrent releases wait.
+	uint32_t seq;
+	do {
+		seq = atomic_load_explicit(&b->retireSeq, memory_order_relaxed) & ~1u;
+	} while (!atomic_compare_exchange_weak_explicit(&b->retireSeq, &seq, seq + 1, memory_order_acquire,
+		memory_order_relaxed));
+	atomic_thread_fence(memory_order_release);
+
+	ImuStatsSlot_t *r = &b->retired;
+	imuStatsAdd(&r->packets, atomic_load_explicit(&s->packets, memory_order_relaxed));
+	imuStatsAdd(&r->bytes, atomic_load_explicit(&s->bytes, memory_order_relaxed));
+	imuStatsAdd(&r->discarded, atomic_load_explicit(&s->discarded, memory_order_relaxed));
+	imuStatsAdd(&r->resyncs, atomic_load_explicit(&s->resyncs, memory_order_relaxed));
+	for (size_t i = 0; i <= IMU_PROT_BAD_CRC; i++)
+		imuStatsAdd(&r->errors[i], atomic_load_explicit(&s->errors[i], memory_order_relaxed));
+	imuStatsAdd(&r->gaps, atomic_load_explicit(&s->gaps, memory_order_relaxed));
+	imuStatsAdd(&r->lost, atomic_load_explicit(&s->lost, memory_order_relaxed));
+	imuStatsAdd(&r->muxCycles, atomic_load_explicit(&s->muxCycles, memory_order_relaxed));
+	statsClear(s);
+	atomic_store_explicit(&s->owned, 0, memory_order_relaxed);
+
+	atomic_store_explicit(&b->retireSeq, seq + 2, memory_order_release);
+}
+
+void imuStatsSlotAdd(const ImuStatsSlot_t *s, ImuStatsSnapshot_t *snapshot) {
+	snapshot->packets += atomic_load_explicit(&s->packets, memory_order_relaxed);
+	snapshot->bytes += atomic_load_explicit(&s->bytes, memory_order_relaxed);
+	snapshot->discarded += atomic_load_explicit(&s->discarded, memory_order_relaxed);
+	snapshot->resyncs += atomic_load_explicit(&s->resyncs, memory_order_relaxed);
+	for (size_t i = 0; i <= IMU_PROT_BAD_CRC; i++)
+		snapshot->errors[i] += atomic_load_explicit(&s->errors[i], memory_order_relaxed);
+	snapshot->gaps += atomic_load_explicit(&s->gaps, memory_order_relaxed);
+	snapshot->lost += atomic_load_explicit(&s->lost, memory_order_relaxed);
+	snapshot->muxCycles += atomic_load_explicit(&s->muxCycles, memory_order_relaxed);
+}
+
+void imuStatsSnapshot(const ImuStatsBlock_t *b, ImuStatsSnapshot_t *snapshot) {
+	for (;;) {
+		uint32_t seq = atomic_load_explicit(&b->retireSeq, memory_order_acquire);
+		if (seq & 1)
+			continue;
+		memset(snapshot, 0, sizeof(*snapshot));
+		imuStatsSlotAdd(&b->retired, snapshot);
+		for (size_t k = 0; k < IMU_STATS_SLOTS; k++) {
+			if (!atomic_load_explicit(&b->slots[k].owned, memory_order_acquire))
+				continue;
+			snapshot->writers++;
+			imuStatsSlotAdd(&b->slots[k], snapshot);
+		}
+		// A slot released meanwhile may have been counted twice or not at all.
+		atomic_thread_fence(memory_order_acquire);
+		if (atomic_load_explicit(&b->retireSeq, memory_order_relaxed) == seq)
+			return;
+	}
+}
+
+const char *imuStatsErrorToString(ImuStatsError_t error) {
+	switch (error) {
+		case IMU_STATS_OK:
+			return "OK.";
+		case IMU_STATS_IO_ERROR:
+			return "I/O error!";
+		case IMU_STATS_BAD_FORMAT:
+			return "Not a statistics block!";
+	}
+	return "Unknown error.";
+}
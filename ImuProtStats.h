@@ -0,0 +1,242 @@
+/**
+ * Per-Stream Hot-Path Counters.
+ *
+ * A statistics block holds one counter slot per writer thread. Every slot
+ * sits on its own cache lines and is written only by the thread that
+ * acquired it, with relaxed loads and stores and no locked instructions,
+ * so counting costs the hot path no more than plain increments and never
+ * bounces a cache line between writers.
+ *
+ * `imuStatsSnapshot` sums all slots. It may run at any time on any thread,
+ * or in another process when the block was created in shared memory with
+ * `imuStatsCreate` and mapped there with `imuStatsOpen`. Counters only grow,
+ * so rates are differences between snapshots.
+ *
+ * A writer claims a slot with `imuStatsAcquire` and hands it back with
+ * `imuStatsRelease` when it stops. The release moves the counters of the
+ * slot into block-wide retired totals, which every snapshot includes, and
+ * clears the slot for the next writer, so totals keep growing across
+ * writers coming and going. Releases are rare and serialized by a sequence
+ * number; a snapshot that overlaps one is retried.
+ *
+ * Counted per stream: packets, bytes, rejected candidates per error class,
+ * resync events, discarded bytes, sequencer gaps with the packets lost in
+ * them, and completed mux cycles (32 consecutive packets covering mux words
+ * 0 to 31, i.e. one complete `ImuDataMux_t`).
+ */
+
+#ifndef ImuProtStats_h_included__
+#define ImuProtStats_h_included__
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtFrame.h"
+
+#define IMU_STATS_MAGIC (0x54534D49UL)  // "IMST"
+#define IMU_STATS_VERSION (2)
+#define IMU_STATS_CACHE_LINE (64)
+
+/** Maximum number of writer threads per block. */
+#define IMU_STATS_SLOTS (16)
+
+/** Number of mux words in a complete cycle. */
+#define IMU_STATS_MUX_WORDS (32)
+
+/**
+ * @enum ImuStatsError_t
+ * @brief Error codes of the shared statistics block.
+ */
+typedef enum {
+	IMU_STATS_OK = 0,           // Success.
+	IMU_STATS_IO_ERROR = 1,     // shm_open, ftruncate or mmap failed, see errno.
+	IMU_STATS_BAD_FORMAT = 2    // The object is not a statistics block of this version.
+} ImuStatsError_t;
+
+/**
+ * Counters of one writer thread. All fields are private.
+ */
+typedef struct {
+	_Alignas(IMU_STATS_CACHE_LINE) _Atomic uint64_t packets;
+	_Atomic uint64_t bytes;
+	_Atomic uint64_t discarded;
+	_Atomic uint64_t resyncs;
+	_Atomic uint64_t errors[IMU_PROT_BAD_CRC + 1];
+	_Atomic uint64_t gaps;
+	_Atomic uint64_t lost;
+	_Atomic uint64_t muxCycles;
+	_Atomic uint32_t owned;
+	int32_t lastSeq;
+	uint32_t muxRun;
+} ImuStatsSlot_t;
+
+/**
+ * Statistics block, in process memory or in shared memory. All fields are private.
+ */
+typedef struct {
+	_Atomic uint32_t magic;
+	uint32_t version;
+	uint32_t slotSize;
+	_Atomic uint32_t retireSeq;
+	ImuStatsSlot_t retired;
+	ImuStatsSlot_t slots[IMU_STATS_SLOTS];
+} ImuStatsBlock_t;
+
+/**
+ * Sum of all slots and of the released ones.
+ *
+ * @field writers   Slots owned.
+ * @field packets   Valid packets.
+ * @field bytes     Bytes received.
+ * @field discarded Bytes skipped while searching for a valid packet.
+ * @field resyncs   Times synchronization was lost.
+ * @field errors    Rejected candidates, indexed by ImuProtError_t.
+ * @field gaps      Valid packets whose sequencer does not follow the previous one.
+ * @field lost      Packets missing according to the sequencer, modulo 256 per gap.
+ * @field muxCycles Complete mux cycles received.
+ */
+typedef struct {
+	uint32_t writers;
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t discarded;
+	uint64_t resyncs;
+	uint64_t errors[IMU_PROT_BAD_CRC + 1];
+	uint64_t gaps;
+	uint64_t lost;
+	uint64_t muxCycles;
+} ImuStatsSnapshot_t;
+
+/**
+ * @brief Sets a counter owned by the calling thread, without a locked instruction.
+ */
+static inline void imuStatsSet(_Atomic uint64_t *counter, uint64_t value)
+{
+	atomic_store_explicit(counter, value, memory_order_relaxed);
+}
+
+/**
+ * @brief Adds to a counter owned by the calling thread, without a locked instruction.
+ */
+static inline void imuStatsAdd(_Atomic uint64_t *counter, uint64_t delta)
+{
+	imuStatsSet(counter, atomic_load_explicit(counter, memory_order_relaxed) + delta);
+}
+
+/**
+ * @brief Counts a valid packet: sequencer gaps and completed mux cycles.
+ *
+ * Only the thread owning the slot may call it.
+ *
+ * @param s         Slot.
+ * @param sequencer Sequencer of the packet.
+ */
+static inline void imuStatsSequencer(ImuStatsSlot_t *s, uint8_t sequencer)
+{
+	if (s->lastSeq >= 0 && sequencer != (uint8_t)(s->lastSeq + 1)) {
+		imuStatsAdd(&s->gaps, 1);
+		imuStatsAdd(&s->lost, (uint8_t)(sequencer - s->lastSeq - 1));
+		s->muxRun = 0;
+	}
+	s->lastSeq = sequencer;
+	s->muxRun++;
+	if ((sequencer & (IMU_STATS_MUX_WORDS - 1)) == IMU_STATS_MUX_WORDS - 1 && s->muxRun >= IMU_STATS_MUX_WORDS)
+		imuStatsAdd(&s->muxCycles, 1);
+}
+
+/**
+ * @brief Publishes the cumulative counters of a deframer owned by the calling thread.
+ *
+ * Cheap enough to call after every read.
+ *
+ * @param s     Slot.
+ * @param frame Deframer counters, e.g. `imuFramerStats`.
+ */
+static inline void imuStatsFrame(ImuStatsSlot_t *s, const ImuFrameStats_t *frame)
+{
+	imuStatsSet(&s->packets, frame->packets);
+	imuStatsSet(&s->bytes, frame->bytes);
+	imuStatsSet(&s->discarded, frame->discarded);
+	imuStatsSet(&s->resyncs, frame->resyncs);
+	for (size_t i = 0; i <= IMU_PROT_BAD_CRC; i++)
+		imuStatsSet(&s->errors[i], frame->errors[i]);
+}
+
+/**
+ * @brief Initializes a block in process memory.
+ *
+ * @param b Block.
+ */
+void imuStatsInit(ImuStatsBlock_t *b);
+
+/**
+ * @brief Creates a block in POSIX shared memory, replacing an existing one.
+ *
+ * @param name  Shared memory object name, e.g. "/imu0.stats".
+ * @param b     Receives the mapped block.
+ * @return ImuStatsError_t IMU_STATS_OK on success.
+ */
+ImuStatsError_t imuStatsCreate(const char *name, ImuStatsBlock_t **b);
+
+/**
+ * @brief Maps a block created by another process, read-only.
+ *
+ * @param name  Shared memory object name.
+ * @param b     Receives the mapped block.
+ * @return ImuStatsError_t IMU_STATS_OK on success.
+ */
+ImuStatsError_t imuStatsOpen(const char *name, const ImuStatsBlock_t **b);
+
+/**
+ * @brief Unmaps a block returned by `imuStatsCreate` or `imuStatsOpen`.
+ *
+ * @param b     Block.
+ * @param name  If not NULL, the shared memory object is removed too.
+ */
+void imuStatsClose(const ImuStatsBlock_t *b, const char *name);
+
+/**
+ * @brief Claims a free slot for the calling thread.
+ *
+ * @param b Block.
+ * @return ImuStatsSlot_t* The slot, or NULL if all IMU_STATS_SLOTS are owned.
+ */
+ImuStatsSlot_t *imuStatsAcquire(ImuStatsBlock_t *b);
+
+/**
+ * @brief Adds the counters of a slot to the retired totals and frees the slot for reuse.
+ *
+ * The owner must not write the slot afterwards.
+ *
+ * @param b Block the slot was acquired from.
+ * @param s Slot, or NULL.
+ */
+void imuStatsRelease(ImuStatsBlock_t *b, ImuStatsSlot_t *s);
+
+/**
+ * @brief Adds the counters of one slot to a snapshot. Safe on any thread while the owner runs.
+ *
+ * @param s         Slot.
+ * @param snapshot  Snapshot to add to.
+ */
+void imuStatsSlotAdd(const ImuStatsSlot_t *s, ImuStatsSnapshot_t *snapshot);
+
+/**
+ * @brief Sums the owned slots and the retired totals. Safe on any thread or process while the writers run.
+ *
+ * @param b         Block.
+ * @param snapshot  Output.
+ */
+void imuStatsSnapshot(const ImuStatsBlock_t *b, ImuStatsSnapshot_t *snapshot);
+
+/**
+ * @brief Converts an ImuStatsError_t error code to its string representation.
+ *
+ * @param error The ImuStatsError_t error code.
+ * @return A string that describes the error.
+ */
+const char *imuStatsErrorToString(ImuStatsError_t error);
+
+#endif
@@ -0,0 +1,45 @@
+#include "ImuProtTime.h"
+
+void imuTimeInit(ImuTimeStamper_t *t, uint32_t baudRate, uint64_t periodNs) {
+	uint64_t baud = baudRate ? baudRate : IMO_PROT_BAUDRATE;
+	t->byteNs = IMU_TIME_BITS_PER_BYTE * 1000000000ull / baud;
+	t->periodNs = periodNs ? periodNs : t->byteNs * sizeof(ImuProt_t);
+	t->readTimeNs = 0;
+	t->chunkLen = 0;
+	t->modelNs = 0;
+	t->lastNs = 0;
+	t->resyncs = 0;
+	t->synced = 0;
+}
+
+uint64_t imuTimePacket(ImuTimeStamper_t *t, size_t endOffset, uint32_t periods) {
+	int64_t raw = (int64_t)imuTimeRaw(t, endOffset);
+	int64_t predicted = t->modelNs + (int64_t)periods * (int64_t)t->periodNs;
+	int64_t residual = raw - predicted;
+	int64_t limit = (int64_t)(IMU_TIME_RESYNC_PERIODS * t->periodNs);
+
+	if (!t->synced || residual > limit || residual < -limit) {
+		// First packet, or the IMU paused or the host clock jumped.
+		t->resyncs += t->synced;
+		t->synced = 1;
+		t->modelNs = raw;
+	} else if (residual < 0) {
+		// Latency never makes a packet look early: the model was late.
+		t->modelNs = raw;
+	} else {
+		t->modelNs = predicted + (residual >> IMU_TIME_GAIN_SHIFT);
+	}
+
+	uint64_t out = (uint64_t)t->modelNs;
+	if (out <= t->lastNs)
+		out = t->lastNs + 1;
+	t->lastNs = out;
+	return out;
+}
+
+void imuTimeStampChunk(ImuTimeStamper_t *t, size_t chunkLen, uint64_t readTimeNs,
+	const size_t *endOffsets, const uint32_t *periods, size_t count, uint64_t *timesNs) {
+	imuTimeChunk(t, chunkLen, readTimeNs);
+	for (size_t i = 0; i < count; i++)
+		timesNs[i] = imuTimePacket(t, endOffsets[i], periods ? periods[i] : 1);
+}
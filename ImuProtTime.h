@@ -0,0 +1,137 @@
+/**
+ * Per-Packet Receive Timestamps.
+ *
+ * A single `read()` often returns several packets, and stamping all of them
+ * with the read completion time loses the sub-millisecond spacing between
+ * them. On the wire every byte takes a fixed time (10 bits at
+ * IMO_PROT_BAUDRATE, so 400 us per 40-byte frame), which lets the arrival of
+ * each packet be computed back from the completion time and the number of
+ * bytes received after it:
+ *
+ *   raw = readTimeNs - (chunkLen - endOffset) * byteNs
+ *
+ * The raw times still carry the read latency, which is always positive. A
+ * clock model predicts the next packet as many periods after the previous
+ * one as have elapsed according to the sequencer, so lost or rejected
+ * packets do not shift it, and follows the lower envelope of the raw times:
+ * a raw time earlier than the prediction is adopted immediately, a later one
+ * only pulls the model by a small fraction. Timestamps are strictly
+ * increasing. The stage needs no system calls beyond the caller's
+ * `clock_gettime` after each read.
+ */
+
+#ifndef ImuProtTime_h_included__
+#define ImuProtTime_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+
+/** Bits per byte on the wire: start bit, 8 data bits, stop bit. */
+#define IMU_TIME_BITS_PER_BYTE (10)
+
+/** Shift of the gain pulling the model towards later raw times (1/256). */
+#define IMU_TIME_GAIN_SHIFT (8)
+
+/** Raw times further than this many periods from the prediction restart the model. */
+#define IMU_TIME_RESYNC_PERIODS (8)
+
+/**
+ * Timestamping state. All fields are private.
+ */
+typedef struct {
+	uint64_t byteNs;
+	uint64_t periodNs;
+	uint64_t readTimeNs;
+	size_t chunkLen;
+	int64_t modelNs;
+	uint64_t lastNs;
+	uint64_t resyncs;
+	int synced;
+} ImuTimeStamper_t;
+
+/**
+ * @brief Initializes the timestamping stage.
+ *
+ * @param t         State to initialize.
+ * @param baudRate  Line rate, 0 for IMO_PROT_BAUDRATE.
+ * @param periodNs  Packet period, 0 when the IMU sends back to back (the frame time).
+ */
+void imuTimeInit(ImuTimeStamper_t *t, uint32_t baudRate, uint64_t periodNs);
+
+/**
+ * @brief Starts a chunk returned by a single read.
+ *
+ * @param t             State.
+ * @param chunkLen      Number of bytes returned by the read.
+ * @param readTimeNs    Time taken right after the read returned.
+ */
+static inline void imuTimeChunk(ImuTimeStamper_t *t, size_t chunkLen, uint64_t readTimeNs)
+{
+	t->chunkLen = chunkLen;
+	t->readTimeNs = readTimeNs;
+}
+
+/**
+ * @brief Returns the arrival time of a packet of the current chunk.
+ *
+ * The arrival time is the time its last byte was received. Packets must be
+ * passed in stream order.
+ *
+ * @param t         State.
+ * @param endOffset Offset just past the last byte of the packet within the chunk.
+ * @param periods   Packet periods since the previous packet, 1 unless packets were lost,
+ *                  e.g. from `imuTimePeriods`.
+ * @return uint64_t Smoothed, strictly increasing timestamp in nanoseconds.
+ */
+uint64_t imuTimePacket(ImuTimeStamper_t *t, size_t endOffset, uint32_t periods);
+
+/**
+ * @brief Returns the packet periods between two packets from their sequencers.
+ *
+ * @param previous  Sequencer of the previous packet.
+ * @param sequencer Sequencer of the packet.
+ * @return uint32_t 1 for consecutive packets, one more per packet lost, modulo 256.
+ */
+static inline uint32_t imuTimePeriods(uint8_t previous, uint8_t sequencer)
+{
+	return (uint8_t)(sequencer - previous);
+}
+
+/**
+ * @brief Returns the unsmoothed arrival time of a packet of the current chunk.
+ *
+ * @param t         State.
+ * @param endOffset Offset just past the last byte of the packet within the chunk.
+ * @return uint64_t Read time minus the wire time of the bytes that followed the packet.
+ */
+static inline uint64_t imuTimeRaw(const ImuTimeStamper_t *t, size_t endOffset)
+{
+	return t->readTimeNs - (uint64_t)(t->chunkLen - endOffset) * t->byteNs;
+}
+
+/**
+ * @brief Timestamps the packets found in one chunk.
+ *
+ * @param t             State.
+ * @param chunkLen      Number of bytes returned by the read.
+ * @param readTimeNs    Time taken right after the read returned.
+ * @param endOffsets    Offset just past every packet completed in the chunk.
+ * @param periods       Packet periods since the previous packet for every packet,
+ *                      or NULL if none were lost.
+ * @param count         Number of packets.
+ * @param timesNs       Output timestamps.
+ */
+void imuTimeStampChunk(ImuTimeStamper_t *t, size_t chunkLen, uint64_t readTimeNs,
+	const size_t *endOffsets, const uint32_t *periods, size_t count, uint64_t *timesNs);
+
+/**
+ * @brief Returns how many times the model restarted after a gap in the stream.
+ */
+static inline uint64_t imuTimeResyncs(const ImuTimeStamper_t *t)
+{
+	return t->resyncs;
+}
+
+#endif
@@ -0,0 +1,648 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ImuProt.h"
+#include "ImuProtAllan.h"
+#include "ImuProtHex.h"
+#include "ImuProtIsa.h"
+#include "ImuProtLog.h"
+#include "ImuProtMoments.h"
+#include "ImuProtPipe.h"
+#include "ImuProtStats.h"
+#include "ImuProtVerify.h"
+#include "ImuProtRec.h"
+
+typedef struct {
+	const char *name;
+	const char *usage;
+	int (*run)(int argc, char **argv);
+} ToolCommand_t;
+
+static int cmdHexToBin(int argc, char **argv);
+static int cmdBinToRec(int argc, char **argv);
+static int cmdRecInfo(int argc, char **argv);
+static int cmdRecDump(int argc, char **argv);
+static int cmdBinToLog(int argc, char **argv);
+static int cmdLogToBin(int argc, char **argv);
+static int cmdCapture(int argc, char **argv);
+static int cmdVerify(int argc, char **argv);
+static int cmdStats(int argc, char **argv);
+static int cmdAllan(int argc, char **argv);
+static int cmdMoments(int argc, char **argv);
+
+static const ToolCommand_t commands[] = {
+	{ "hex2bin", "hex2bin <log.txt> <packets.bin> [--keep-invalid] [--quiet]", cmdHexToBin },
+	{ "bin2rec", "bin2rec <packets.bin> <capture.rec> [rate Hz] [start ns]", cmdBinToRec },
+	{ "recinfo", "recinfo <capture.rec>", cmdRecInfo },
+	{ "recdump", "recdump <capture.rec> [from ns] [count]", cmdRecDump },
+	{ "bin2log", "bin2log <packets.bin> <packets.imulog>", cmdBinToLog },
+	{ "log2bin", "log2bin <packets.imulog> <packets.bin>", cmdLogToBin },
+	{ "capture", "capture <device|file|-> <capture.rec> [--shm name] [--net address port] [--stats name]", cmdCapture },
+	{ "verify", "verify <packets.bin> [threads] [chunk MiB]", cmdVerify },
+	{ "stats", "stats <name> [interval s] [count]", cmdStats },
+	{ "allan", "allan <capture.rec> [rate Hz] [threads]", cmdAllan },
+	{ "moments", "moments <capture.rec> [window packets]", cmdMoments },
+};
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+int main(int argc, char **argv) {
+	if (argc >= 3 && !strcmp(argv[1], "--isa")) {
+		ImuIsa_t isa;
+		if (imuIsaParse(argv[2], &isa) != 0 || imuIsaSelect(isa) != 0) {
+			fprintf(stderr, "Unsupported ISA level: %s\n", argv[2]);
+			return 2;
+		}
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc >= 2) {
+		for (size_t i = 0; i < COMMAND_COUNT; i++) {
+			if (!strcmp(argv[1], commands[i].name))
+				return commands[i].run(argc - 2, argv + 2);
+		}
+	}
+
+	fprintf(stderr, "Usage: %s [--isa baseline|sse4.2|avx2|avx512] <command> [arguments]\n", argv[0]);
+	for (size_t i = 0; i < COMMAND_COUNT; i++)
+		fprintf(stderr, "  %s\n", commands[i].usage);
+	return 2;
+}
+
+/**
+ * @brief Prints a rejected line of a hex log.
+ */
+static void hexReport(void *ctx, uint64_t line, size_t column, ImuHexError_t error, ImuProtError_t protError) {
+	const char *path = ctx;
+	if (error != IMU_HEX_OK)
+		fprintf(stderr, "%s:%llu:%zu: %s\n", path, (unsigned long long)line, column, imuHexErrorToString(error));
+	else
+		fprintf(stderr, "%s:%llu: %s\n", path, (unsigned long long)line, ImuProtErrorToString(protError));
+}
+
+/**
+ * @brief Converts a hex text log into a binary packet file.
+ */
+static int cmdHexToBin(int argc, char **argv) {
+	unsigned options = 0;
+	int quiet = 0;
+	const char *paths[2];
+	int pathCount = 0;
+
+	for (int i = 0; i < argc; i++) {
+		if (!strcmp(argv[i], "--keep-invalid"))
+			options |= IMU_HEX_KEEP_INVALID;
+		else if (!strcmp(argv[i], "--quiet"))
+			quiet = 1;
+		else if (pathCount < 2)
+			paths[pathCount++] = argv[i];
+	}
+	if (pathCount != 2) {
+		fprintf(stderr, "Usage: %s\n", commands[0].usage);
+		return 2;
+	}
+
+	ImuHexStats_t stats = { 0 };
+	ImuHexError_t result = imuHexConvertFile(paths[0], paths[1], options,
+		quiet ? NULL : hexReport, (void *)paths[0], &stats);
+	if (result != IMU_HEX_OK) {
+		fprintf(stderr, "%s: %s\n", paths[0], imuHexErrorToString(result));
+		return 1;
+	}
+
+	printf("lines %llu, written %llu, bad chars %llu, bad length %llu, "
+	       "bad header %llu, bad sequencer %llu, bad crc %llu\n",
+		(unsigned long long)stats.lines, (unsigned long long)stats.packets,
+		(unsigned long long)stats.badChars, (unsigned long long)stats.badLength,
+		(unsigned long long)stats.protErrors[IMU_PROT_BAD_HEADER],
+		(unsigned long long)stats.protErrors[IMU_PROT_BAD_SEQUENCER],
+		(unsigned long long)stats.protErrors[IMU_PROT_BAD_CRC]);
+	return 0;
+}
+
+/**
+ * @brief Converts a binary packet file into a recording with nominal timestamps.
+ */
+static int cmdBinToRec(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s\n", commands[1].usage);
+		return 2;
+	}
+	double rate = argc > 2 ? strtod(argv[2], NULL) : 2500.0;
+	uint64_t timeNs = argc > 3 ? strtoull(argv[3], NULL, 0) : 0;
+	if (rate <= 0) {
+		fprintf(stderr, "Invalid rate\n");
+		return 2;
+	}
+
+	FILE *in = fopen(argv[0], "rb");
+	if (!in) {
+		perror(argv[0]);
+		return 1;
+	}
+
+	ImuRecWriter_t writer;
+	ImuRecError_t result = imuRecWriterOpen(&writer, argv[1], 0);
+	if (result != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", argv[1], imuRecErrorToString(result));
+		fclose(in);
+		return 1;
+	}
+
+	ImuProt_t packets[1024];
+	size_t n;
+	uint64_t count = 0;
+	while (result == IMU_REC_OK && (n = fread(packets, sizeof(ImuProt_t), 1024, in)) > 0) {
+		for (size_t i = 0; i < n && result == IMU_REC_OK; i++, count++)
+			result = imuRecWrite(&writer, &packets[i], timeNs + (uint64_t)(count * 1e9 / rate));
+	}
+	fclose(in);
+
+	ImuRecError_t closeResult = imuRecWriterClose(&writer);
+	if (result == IMU_REC_OK)
+		result = closeResult;
+	if (result != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", argv[1], imuRecErrorToString(result));
+		return 1;
+	}
+	printf("recorded %llu packets\n", (unsigned long long)count);
+	return 0;
+}
+
+/**
+ * @brief Prints a summary of a recording.
+ */
+static int cmdRecInfo(int argc, char **argv) {
+	if (argc < 1) {
+		fprintf(stderr, "Usage: %s\n", commands[2].usage);
+		return 2;
+	}
+
+	ImuRecReader_t reader;
+	ImuRecError_t result = imuRecReaderOpen(&reader, argv[0]);
+	if (result != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", argv[0], imuRecErrorToString(result));
+		return 1;
+	}
+
+	uint64_t count = imuRecCount(&reader);
+	printf("records %llu, chunks %zu%s\n", (unsigned long long)count, imuRecChunks(&reader),
+		imuRecRecovered(&reader) ? " (index rebuilt, file was not closed)" : "");
+	if (count) {
+		uint64_t first = imuRecGet(&reader, 0)->rxTimeNs;
+		uint64_t last = imuRecGet(&reader, count - 1)->rxTimeNs;
+		printf("time %llu .. %llu ns (%.3f s)\n", (unsigned long long)first,
+			(unsigned long long)last, (last - first) * 1e-9);
+	}
+	imuRecReaderClose(&reader);
+	return 0;
+}
+
+/**
+ * @brief Prints the records of a recording starting at a given time.
+ */
+static int cmdRecDump(int argc, char **argv) {
+	if (argc < 1) {
+		fprintf(stderr, "Usage: %s\n", commands[3].usage);
+		return 2;
+	}
+	uint64_t from = argc > 1 ? strtoull(argv[1], NULL, 0) : 0;
+	size_t limit = argc > 2 ? strtoul(argv[2], NULL, 0) : 20;
+
+	ImuRecReader_t reader;
+	ImuRecError_t result = imuRecReaderOpen(&reader, argv[0]);
+	if (result != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", argv[0], imuRecErrorToString(result));
+		return 1;
+	}
+
+	ImuRecCursor_t cursor;
+	uint64_t index = imuRecFindTime(&reader, from);
+	const ImuRecRecord_t *run;
+	size_t n;
+	imuRecSeek(&reader, &cursor, index);
+	while (limit && (run = imuRecNextRun(&reader, &cursor, limit, &n)) != NULL) {
+		for (size_t i = 0; i < n; i++, index++) {
+			const ImuProt_t *p = &run[i].packet;
+			printf("%10llu %16llu 0x%02X % 8.2f  % 10.3f % 10.3f % 10.3f % 10.3f % 10.3f % 10.3f  %s\n",
+				(unsigned long long)index, (unsigned long long)run[i].rxTimeNs, p->sequencer,
+				tempFromKelvin(p->data.temperature),
+				floatData(p->data.gyro[0]), floatData(p->data.gyro[1]), floatData(p->data.gyro[2]),
+				floatData(p->data.accl[0]), floatData(p->data.accl[1]), floatData(p->data.accl[2]),
+				ImuProtErrorToString(checkImuProtBuffer(p)));
+		}
+		limit -= n;
+	}
+	imuRecReaderClose(&reader);
+	return 0;
+}
+
+/**
+ * @brief Compresses a binary packet file; invalid packets are skipped.
+ */
+static int cmdBinToLog(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s\n", commands[4].usage);
+		return 2;
+	}
+
+	FILE *in = fopen(argv[0], "rb");
+	if (!in) {
+		perror(argv[0]);
+		return 1;
+	}
+
+	ImuLogWriter_t writer;
+	ImuLogError_t result = imuLogWriterOpen(&writer, argv[1], 0);
+	if (result != IMU_LOG_OK) {
+		fprintf(stderr, "%s: %s\n", argv[1], imuLogErrorToString(result));
+		fclose(in);
+		return 1;
+	}
+
+	ImuProt_t packets[1024];
+	size_t n;
+	uint64_t skipped = 0;
+	while (result == IMU_LOG_OK && (n = fread(packets, sizeof(ImuProt_t), 1024, in)) > 0) {
+		for (size_t i = 0; i < n && result == IMU_LOG_OK; i++) {
+			result = imuLogWrite(&writer, &packets[i]);
+			if (result == IMU_LOG_INVALID_PACKET) {
+				skipped++;
+				result = IMU_LOG_OK;
+			}
+		}
+	}
+	fclose(in);
+
+	if (result == IMU_LOG_OK)
+		result = imuLogFlush(&writer);
+	uint64_t bytes;
+	uint64_t count = imuLogWritten(&writer, &bytes);
+	ImuLogError_t closeResult = imuLogWriterClose(&writer);
+	if (result == IMU_LOG_OK)
+		result = closeResult;
+	if (result != IMU_LOG_OK) {
+		fprintf(stderr, "%s: %s\n", argv[1], imuLogErrorToString(result));
+		return 1;
+	}
+	printf("packets %llu, skipped %llu, %llu bytes (%.2f bytes per packet)\n",
+		(unsigned long long)count, (unsigned long long)skipped, (unsigned long long)bytes,
+		count ? (double)bytes / count : 0.0);
+	return 0;
+}
+
+/**
+ * @brief Decompresses a log back into a binary packet file.
+ */
+static int cmdLogToBin(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s\n", commands[5].usage);
+		return 2;
+	}
+
+	ImuLogReader_t reader;
+	ImuLogError_t result = imuLogReaderOpen(&reader, argv[0]);
+	if (result != IMU_LOG_OK) {
+		fprintf(stderr, "%s: %s\n", argv[0], imuLogErrorToString(result));
+		return 1;
+	}
+
+	FILE *out = fopen(argv[1], "wb");
+	if (!out) {
+		perror(argv[1]);
+		imuLogReaderClose(&reader);
+		return 1;
+	}
+
+	const ImuProt_t *packets;
+	size_t n;
+	uint64_t count = 0;
+	while ((result = imuLogNextBlock(&reader, &packets, &n)) == IMU_LOG_OK) {
+		if (fwrite(packets, sizeof(ImuProt_t), n, out) != n) {
+			result = IMU_LOG_IO_ERROR;
+			break;
+		}
+		count += n;
+	}
+	imuLogReaderClose(&reader);
+	if (fclose(out) != 0 && result == IMU_LOG_END)
+		result = IMU_LOG_IO_ERROR;
+
+	if (result != IMU_LOG_END) {
+		fprintf(stderr, "%s: %s\n", argv[0], imuLogErrorToString(result));
+		return 1;
+	}
+	printf("packets %llu\n", (unsigned long long)count);
+	return 0;
+}
+
+static ImuPipe_t capturePipe;
+
+static void captureStop(int signal) {
+	(void)signal;
+	imuPipeStop(&capturePipe);
+}
+
+/**
+ * @brief Records a raw byte stream through the pipeline, optionally republishing it.
+ *
+ * The serial port must already be configured, e.g. with `stty`.
+ */
+static int cmdCapture(int argc, char **argv) {
+	const char *shmName = NULL, *netAddress = NULL, *statsName = NULL;
+	uint16_t netPort = 0;
+	const char *paths[2];
+	int pathCount = 0;
+	for (int i = 0; i < argc; i++) {
+		if (!strcmp(argv[i], "--shm") && i + 1 < argc)
+			shmName = argv[++i];
+		else if (!strcmp(argv[i], "--stats") && i + 1 < argc)
+			statsName = argv[++i];
+		else if (!strcmp(argv[i], "--net") && i + 2 < argc) {
+			netAddress = argv[++i];
+			netPort = (uint16_t)strtoul(argv[++i], NULL, 0);
+		} else if (pathCount < 2)
+			paths[pathCount++] = argv[i];
+	}
+	if (pathCount != 2) {
+		fprintf(stderr, "Usage: %s\n", commands[6].usage);
+		return 2;
+	}
+
+	int fd = strcmp(paths[0], "-") ? open(paths[0], O_RDONLY | O_NOCTTY) : STDIN_FILENO;
+	if (fd < 0) {
+		perror(paths[0]);
+		return 1;
+	}
+
+	ImuPipeSink_t sinks[3];
+	size_t sinkCount = 0;
+	ImuRecWriter_t rec;
+	ImuShmWriter_t shm;
+	static ImuNetSender_t net;
+	ImuRecError_t recResult = imuRecWriterOpen(&rec, paths[1], 0);
+	if (recResult != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", paths[1], imuRecErrorToString(recResult));
+		return 1;
+	}
+	imuPipeRecSink(&sinks[sinkCount++], &rec);
+	if (shmName) {
+		ImuShmError_t result = imuShmCreate(&shm, shmName, 65536);
+		if (result != IMU_SHM_OK) {
+			fprintf(stderr, "%s: %s\n", shmName, imuShmErrorToString(result));
+			return 1;
+		}
+		imuPipeShmSink(&sinks[sinkCount++], &shm);
+	}
+	if (netAddress) {
+		ImuNetError_t result = imuNetSenderOpen(&net, netAddress, netPort, NULL, 1, 1, 0);
+		if (result != IMU_NET_OK) {
+			fprintf(stderr, "%s: %s\n", netAddress, imuNetErrorToString(result));
+			return 1;
+		}
+		imuPipeNetSink(&sinks[sinkCount++], &net);
+	}
+
+	ImuPipeConfig_t config;
+	imuPipeConfigInit(&config, fd);
+	ImuStatsBlock_t *statsBlock = NULL;
+	if (statsName) {
+		ImuStatsError_t statsResult = imuStatsCreate(statsName, &statsBlock);
+		if (statsResult != IMU_STATS_OK) {
+			fprintf(stderr, "%s: %s\n", statsName, imuStatsErrorToString(statsResult));
+			return 1;
+		}
+		config.stats = statsBlock;
+	}
+	ImuPipeError_t result = imuPipeStart(&capturePipe, &config, sinks, sinkCount);
+	if (result != IMU_PIPE_OK) {
+		fprintf(stderr, "pipeline: %s\n", imuPipeErrorToString(result));
+		return 1;
+	}
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = captureStop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	ImuPipeStats_t stats;
+	result = imuPipeJoin(&capturePipe, &stats);
+	if (result != IMU_PIPE_OK)
+		perror(paths[0]);
+	if (fd != STDIN_FILENO)
+		close(fd);
+	recResult = imuRecWriterClose(&rec);
+	if (recResult != IMU_REC_OK)
+		fprintf(stderr, "%s: %s\n", paths[1], imuRecErrorToString(recResult));
+	if (shmName)
+		imuShmWriterClose(&shm, 1);
+	if (netAddress)
+		imuNetSenderClose(&net);
+	if (statsBlock)
+		imuStatsClose(statsBlock, statsName);
+
+	printf("captured %llu packets, %llu bytes discarded, %llu resyncs, %llu bad header, %llu bad sequencer, %llu bad CRC\n",
+		(unsigned long long)stats.frame.packets, (unsigned long long)stats.frame.discarded,
+		(unsigned long long)stats.frame.resyncs, (unsigned long long)stats.frame.errors[IMU_PROT_BAD_HEADER],
+		(unsigned long long)stats.frame.errors[IMU_PROT_BAD_SEQUENCER],
+		(unsigned long long)stats.frame.errors[IMU_PROT_BAD_CRC]);
+	printf("%llu sequencer gaps, %llu packets lost, %llu mux cycles\n", (unsigned long long)stats.gaps,
+		(unsigned long long)stats.lost, (unsigned long long)stats.muxCycles);
+	for (size_t s = 0; s < stats.sinkCount; s++)
+		printf("%-8s %llu delivered, %llu dropped, %llu failed\n", sinks[s].name,
+			(unsigned long long)stats.delivered[s], (unsigned long long)stats.sinkDropped[s],
+			(unsigned long long)stats.sinkFailed[s]);
+	static ImuHist_t latency;
+	for (size_t s = 0; s < stats.sinkCount; s++) {
+		char label[32];
+		snprintf(label, sizeof(label), "%-8s latency us", sinks[s].name);
+		imuHistInit(&latency);
+		imuPipeLatency(&capturePipe, s, &latency);
+		imuHistPrint(&latency, stdout, label, 1000.0);
+	}
+	return result != IMU_PIPE_OK || recResult != IMU_REC_OK;
+}
+
+/**
+ * @brief Verifies a raw capture on all CPUs and prints the merged counters.
+ */
+static int cmdVerify(int argc, char **argv) {
+	if (argc < 1) {
+		fprintf(stderr, "Usage: %s\n", commands[7].usage);
+		return 2;
+	}
+	unsigned threads = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 0) : 0;
+	size_t chunkSize = argc > 2 ? strtoul(argv[2], NULL, 0) << 20 : 0;
+
+	ImuVerifyStats_t stats;
+	ImuVerifyError_t result = imuVerifyFile(argv[0], threads, chunkSize, &stats);
+	if (result != IMU_VERIFY_OK) {
+		perror(argv[0]);
+		return 1;
+	}
+	printf("bytes          %llu\n", (unsigned long long)stats.frame.bytes);
+	printf("valid packets  %llu\n", (unsigned long long)stats.frame.packets);
+	printf("bad header     %llu\n", (unsigned long long)stats.frame.errors[IMU_PROT_BAD_HEADER]);
+	printf("bad sequencer  %llu\n", (unsigned long long)stats.frame.errors[IMU_PROT_BAD_SEQUENCER]);
+	printf("bad CRC        %llu\n", (unsigned long long)stats.frame.errors[IMU_PROT_BAD_CRC]);
+	printf("resyncs        %llu\n", (unsigned long long)stats.frame.resyncs);
+	printf("discarded      %llu bytes\n", (unsigned long long)stats.frame.discarded);
+	printf("sequencer gaps %llu (%llu packets lost)\n", (unsigned long long)stats.gaps,
+		(unsigned long long)stats.lost);
+	return stats.frame.errors[IMU_PROT_BAD_HEADER] || stats.frame.errors[IMU_PROT_BAD_SEQUENCER]
+		|| stats.frame.errors[IMU_PROT_BAD_CRC] || stats.frame.discarded || stats.gaps;
+}
+
+/**
+ * @brief Prints the counters published by `capture --stats` in another process, with rates.
+ */
+static int cmdStats(int argc, char **argv) {
+	if (argc < 1) {
+		fprintf(stderr, "Usage: %s\n", commands[8].usage);
+		return 2;
+	}
+	double interval = argc > 1 ? atof(argv[1]) : 0.0;
+	unsigned long count = argc > 2 ? strtoul(argv[2], NULL, 0) : 0;
+
+	const ImuStatsBlock_t *block;
+	ImuStatsError_t result = imuStatsOpen(argv[0], &block);
+	if (result != IMU_STATS_OK) {
+		fprintf(stderr, "%s: %s\n", argv[0], imuStatsErrorToString(result));
+		return 1;
+	}
+
+	ImuStatsSnapshot_t last, now;
+	memset(&last, 0, sizeof(last));
+	for (unsigned long i = 0; ; i++) {
+		imuStatsSnapshot(block, &now);
+		printf("packets %llu (+%llu), bytes %llu, discarded %llu (+%llu), resyncs %llu (+%llu), "
+			"bad header %llu, bad sequencer %llu, bad CRC %llu (+%llu), gaps %llu (+%llu), lost %llu, "
+			"mux cycles %llu\n",
+			(unsigned long long)now.packets, (unsigned long long)(now.packets - last.packets),
+			(unsigned long long)now.bytes,
+			(unsigned long long)now.discarded, (unsigned long long)(now.discarded - last.discarded),
+			(unsigned long long)now.resyncs, (unsigned long long)(now.resyncs - last.resyncs),
+			(unsigned long long)now.errors[IMU_PROT_BAD_HEADER],
+			(unsigned long long)now.errors[IMU_PROT_BAD_SEQUENCER],
+			(unsigned long long)now.errors[IMU_PROT_BAD_CRC],
+			(unsigned long long)(now.errors[IMU_PROT_BAD_CRC] - last.errors[IMU_PROT_BAD_CRC]),
+			(unsigned long long)now.gaps, (unsigned long long)(now.gaps - last.gaps),
+			(unsigned long long)now.lost, (unsigned long long)now.muxCycles);
+		fflush(stdout);
+		last = now;
+		if (interval <= 0.0 || (count && i + 1 >= count))
+			break;
+		struct timespec ts = { (time_t)interval, (long)((interval - (time_t)interval) * 1e9) };
+		nanosleep(&ts, NULL);
+	}
+	imuStatsClose(block, NULL);
+	return 0;
+}
+
+/**
+ * @brief Prints the Allan deviation of a recording, rate estimated from the receive times unless given.
+ */
+static int cmdAllan(int argc, char **argv) {
+	if (argc < 1) {
+		fprintf(stderr, "Usage: %s\n", commands[9].usage);
+		return 2;
+	}
+	uint32_t rate = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 0;
+	unsigned threads = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 0) : 0;
+
+	ImuAllan_t *allan = malloc(sizeof(*allan));
+	if (!allan) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	ImuRecError_t result = imuAllanFile(argv[0], threads, rate, allan);
+	if (result != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", argv[0], imuRecErrorToString(result));
+		free(allan);
+		return 1;
+	}
+
+	ImuAllanPoint_t points[IMU_ALLAN_LEVELS];
+	size_t count = imuAllanResult(allan, points, IMU_ALLAN_LEVELS);
+	printf("samples %llu, rate %u Hz\n", (unsigned long long)imuAllanSamples(allan), allan->packetRate);
+	printf("%12s %12s %12s %12s %12s %12s %12s %10s\n", "tau s", "gyro x", "gyro y", "gyro z",
+		"accl x", "accl y", "accl z", "terms");
+	for (size_t i = 0; i < count; i++) {
+		const ImuAllanPoint_t *p = &points[i];
+		printf("%12.6g %12.6g %12.6g %12.6g %12.6g %12.6g %12.6g %10llu\n", p->tau, p->adev[0], p->adev[1],
+			p->adev[2], p->adev[3], p->adev[4], p->adev[5], (unsigned long long)p->terms);
+	}
+	free(allan);
+	return 0;
+}
+
+/**
+ * @brief Prints the statistics of one state, a row per channel.
+ */
+static void momentsPrint(const char *title, const ImuMoments_t *m) {
+	static const char *const names[IMU_MOMENTS_CHANNELS] = { "gyro x", "gyro y", "gyro z", "accl x", "accl y",
+		"accl z", "temp C" };
+	ImuMomentsSummary_t sum;
+	imuMomentsSummary(m, &sum);
+	printf("%s, %llu packets\n", title, (unsigned long long)sum.count);
+	printf("%8s %14s %14s %14s %14s %14s\n", "", "mean", "std", "min", "max", "rms");
+	for (int c = 0; c < IMU_MOMENTS_CHANNELS && sum.count; c++)
+		printf("%8s %14.6f %14.6f %14.6f %14.6f %14.6f\n", names[c], sum.mean[c], sqrt(sum.variance[c]),
+			sum.min[c], sum.max[c], sum.rms[c]);
+}
+
+/**
+ * @brief Prints per-axis statistics of a recording and of its last window.
+ */
+static int cmdMoments(int argc, char **argv) {
+	if (argc < 1) {
+		fprintf(stderr, "Usage: %s\n", commands[10].usage);
+		return 2;
+	}
+	uint64_t window = argc > 1 ? strtoull(argv[1], NULL, 0) : 0;
+
+	ImuRecReader_t reader;
+	ImuRecError_t result = imuRecReaderOpen(&reader, argv[0]);
+	if (result != IMU_REC_OK) {
+		fprintf(stderr, "%s: %s\n", argv[0], imuRecErrorToString(result));
+		return 1;
+	}
+	ImuMomentsWindow_t *win = malloc(sizeof(*win));
+	if (!win || (window && imuMomentsWindowInit(win, window) != 0)) {
+		fprintf(stderr, "Window shorter than %d packets\n", IMU_MOMENTS_BLOCKS);
+		free(win);
+		imuRecReaderClose(&reader);
+		return 2;
+	}
+
+	ImuMoments_t total;
+	imuMomentsInit(&total);
+	ImuRecCursor_t cursor;
+	imuRecSeek(&reader, &cursor, 0);
+	const ImuRecRecord_t *run;
+	size_t n;
+	while ((run = imuRecNextRun(&reader, &cursor, SIZE_MAX, &n)) != NULL) {
+		imuMomentsPush(&total, &run->packet, sizeof(ImuRecRecord_t), n);
+		if (window)
+			imuMomentsWindowPush(win, &run->packet, sizeof(ImuRecRecord_t), n);
+	}
+	momentsPrint("all", &total);
+	if (window) {
+		ImuMoments_t view;
+		imuMomentsWindowView(win, &view);
+		momentsPrint("last window", &view);
+	}
+	free(win);
+	imuRecReaderClose(&reader);
+	return 0;
+}
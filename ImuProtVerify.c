@@ -0,0 +1,252 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ImuProtIsa.h"
+#include "ImuProtVerify.h"
+
+#define VERIFY_HEADER_LO ((uint8_t)(IMU_PROT_HEADER & 0xFF))
+#define VERIFY_HEADER_HI ((uint8_t)(IMU_PROT_HEADER >> 8))
+#define VERIFY_NO_SYNC SIZE_MAX
+
+/**
+ * Scan state carried from one packet to the next.
+ */
+typedef struct {
+	int synced;
+	int firstSeq;
+	int lastSeq;
+} VerifyState_t;
+
+/**
+ * Result of one chunk.
+ */
+typedef struct {
+	size_t end;
+	size_t sync;
+	size_t stop;
+	VerifyState_t state;
+	ImuVerifyStats_t stats;
+} VerifyChunk_t;
+
+/**
+ * Work shared by the pool.
+ */
+typedef struct {
+	const uint8_t *data;
+	size_t len;
+	size_t chunkSize;
+	size_t count;
+	VerifyChunk_t *chunks;
+	_Atomic size_t next;
+} VerifyJob_t;
+
+/**
+ * @brief Scans the packets starting before `limit`, like the deframer.
+ *
+ * @return size_t Position where scanning stopped, at or past `limit`.
+ */
+static size_t verifyScan(const uint8_t *data, size_t len, size_t pos, size_t limit, VerifyState_t *state,
+	ImuVerifyStats_t *stats) {
+	while (pos < limit) {
+		if (pos + sizeof(ImuProt_t) > len) {
+			// Incomplete packet at the end of the capture.
+			stats->frame.discarded += limit - pos;
+			return limit;
+		}
+		const uint8_t *p = data + pos;
+		if (p[0] == VERIFY_HEADER_LO && p[1] == VERIFY_HEADER_HI) {
+			ImuProtError_t error = imuFrameCheck(p);
+			if (error == IMU_PROT_OK) {
+				int seq = p[offsetof(ImuProt_t, sequencer)];
+				if (state->lastSeq < 0) {
+					state->firstSeq = seq;
+				} else if (seq != ((state->lastSeq + 1) & 0xFF)) {
+					stats->gaps++;
+					stats->lost += (unsigned)(seq - state->lastSeq - 1) & 0xFF;
+				}
+				state->lastSeq = seq;
+				stats->frame.packets++;
+				state->synced = 1;
+				pos += sizeof(ImuProt_t);
+				continue;
+			}
+			stats->frame.errors[error]++;
+		} else if (state->synced) {
+			stats->frame.errors[IMU_PROT_BAD_HEADER]++;
+		}
+
+		if (state->synced) {
+			state->synced = 0;
+			stats->frame.resyncs++;
+		}
+		size_t skip = pos + 1 < limit ? pos + 1 + imuFindHeader(p + 1, limit - pos - 1) : limit;
+		stats->frame.discarded += skip - pos;
+		pos = skip;
+	}
+	return pos;
+}
+
+/**
+ * @brief Returns the first valid packet starting in [pos, limit), VERIFY_NO_SYNC if none.
+ */
+static size_t verifySync(const uint8_t *data, size_t len, size_t pos, size_t limit) {
+	while (pos < limit && pos + sizeof(ImuProt_t) <= len) {
+		pos += imuFindHeader(data + pos, limit - pos);
+		if (pos >= limit)
+			break;
+		const uint8_t *p = data + pos;
+		if (pos + sizeof(ImuProt_t) <= len && p[1] == VERIFY_HEADER_HI && imuFrameCheck(p) == IMU_PROT_OK)
+			return pos;
+		pos++;
+	}
+	return VERIFY_NO_SYNC;
+}
+
+static void verifyAdd(ImuVerifyStats_t *to, const ImuVerifyStats_t *from) {
+	to->frame.packets += from->frame.packets;
+	to->frame.discarded += from->frame.discarded;
+	to->frame.resyncs += from->frame.resyncs;
+	for (size_t i = 0; i <= IMU_PROT_BAD_CRC; i++)
+		to->frame.errors[i] += from->frame.errors[i];
+	to->gaps += from->gaps;
+	to->lost += from->lost;
+}
+
+static void *verifyWorker(void *arg) {
+	VerifyJob_t *job = arg;
+	for (;;) {
+		size_t k = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed);
+		if (k >= job->count)
+			return NULL;
+
+		VerifyChunk_t *c = &job->chunks[k];
+		size_t start = k * job->chunkSize;
+		c->end = job->len - start > job->chunkSize ? start + job->chunkSize : job->len;
+		c->state.synced = 0;
+		c->state.firstSeq = -1;
+		c->state.lastSeq = -1;
+		// The first chunk starts where a sequential scan starts.
+		c->sync = k ? verifySync(job->data, job->len, start, c->end) : 0;
+		c->stop = c->sync;
+		if (c->sync != VERIFY_NO_SYNC)
+			c->stop = verifyScan(job->data, job->len, c->sync, c->end, &c->state, &c->stats);
+	}
+}
+
+ImuVerifyError_t imuVerifyBuffer(const uint8_t *data, size_t len, unsigned threads, size_t chunkSize,
+	ImuVerifyStats_t *stats) {
+	memset(stats, 0, sizeof(*stats));
+	stats->frame.bytes = len;
+	if (!len)
+		return IMU_VERIFY_OK;
+	if (!chunkSize)
+		chunkSize = IMU_VERIFY_CHUNK;
+	if (!threads) {
+		long online = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = online > 0 ? (unsigned)online : 1;
+	}
+
+	VerifyJob_t job = { .data = data, .len = len, .chunkSize = chunkSize };
+	job.count = (len - 1) / chunkSize + 1;
+	job.chunks = calloc(job.count, sizeof(VerifyChunk_t));
+	if (!job.chunks)
+		return IMU_VERIFY_NO_MEMORY;
+	atomic_init(&job.next, 0);
+	if (threads > job.count)
+		threads = (unsigned)job.count;
+
+	pthread_t *workers = threads > 1 ? calloc(threads - 1, sizeof(pthread_t)) : NULL;
+	unsigned started = 0;
+	while (workers && started < threads - 1 && !pthread_create(&workers[started], NULL, verifyWorker, &job))
+		started++;
+	verifyWorker(&job);
+	for (unsigned i = 0; i < started; i++)
+		pthread_join(workers[i], NULL);
+	free(workers);
+
+	// Stitch the chunks in order.
+	VerifyState_t state = job.chunks[0].state;
+	size_t pos = job.chunks[0].stop;
+	verifyAdd(stats, &job.chunks[0].stats);
+	for (size_t k = 1; k < job.count; k++) {
+		const VerifyChunk_t *c = &job.chunks[k];
+		if (c->sync != VERIFY_NO_SYNC && pos <= c->sync) {
+			pos = verifyScan(data, len, pos, c->sync, &state, stats);
+			if (pos == c->sync) {
+				if (state.lastSeq >= 0 && c->state.firstSeq != ((state.lastSeq + 1) & 0xFF)) {
+					stats->gaps++;
+					stats->lost += (unsigned)(c->state.firstSeq - state.lastSeq - 1) & 0xFF;
+				}
+				if (state.lastSeq < 0)
+					state.firstSeq = c->state.firstSeq;
+				state.lastSeq = c->state.lastSeq;
+				state.synced = c->state.synced;
+				verifyAdd(stats, &c->stats);
+				pos = c->stop;
+				continue;
+			}
+		}
+		// The worker synchronized inside a packet of the previous chunk.
+		if (c->sync != VERIFY_NO_SYNC)
+			stats->rescans++;
+		if (pos < c->end)
+			pos = verifyScan(data, len, pos, c->end, &state, stats);
+	}
+	stats->chunks = job.count;
+	free(job.chunks);
+	return IMU_VERIFY_OK;
+}
+
+ImuVerifyError_t imuVerifyFile(const char *path, unsigned threads, size_t chunkSize, ImuVerifyStats_t *stats) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return IMU_VERIFY_OPEN_ERROR;
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		int saved = errno;
+		close(fd);
+		errno = saved;
+		return IMU_VERIFY_IO_ERROR;
+	}
+	if (st.st_size == 0) {
+		close(fd);
+		return imuVerifyBuffer(NULL, 0, threads, chunkSize, stats);
+	}
+
+	size_t len = (size_t)st.st_size;
+	void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	int saved = errno;
+	close(fd);
+	if (map == MAP_FAILED) {
+		errno = saved;
+		return IMU_VERIFY_IO_ERROR;
+	}
+	// Every worker reads its chunk front to back.
+	madvise(map, len, MADV_SEQUENTIAL);
+	ImuVerifyError_t result = imuVerifyBuffer(map, len, threads, chunkSize, stats);
+	munmap(map, len);
+	return result;
+}
+
+const char *imuVerifyErrorToString(ImuVerifyError_t error) {
+	switch (error) {
+		case IMU_VERIFY_OK:
+			return "OK.";
+		case IMU_VERIFY_OPEN_ERROR:
+			return "Cannot open capture!";
+		case IMU_VERIFY_IO_ERROR:
+			return "I/O error!";
+		case IMU_VERIFY_NO_MEMORY:
+			return "Out of memory!";
+	}
+	return "Unknown error.";
+}
@@ -0,0 +1,96 @@
+/**
+ * Parallel Offline Verification of Raw Captures.
+ *
+ * Validates a concatenated packet capture (`packets.bin`, raw serial dumps)
+ * on a pool of threads. The capture is split into chunks that the workers
+ * take in turn; each worker resynchronizes on the first valid packet starting
+ * in its chunk and scans on until the first packet start at or past the end
+ * of the chunk, exactly as a single sequential scan would from there.
+ *
+ * The calling thread works as one of the workers; if fewer threads can be
+ * created than requested, the others take over their chunks.
+ *
+ * Packets belong to the chunk they start in. After the workers finish, the
+ * bytes between the point where one chunk stopped and the point where the
+ * next one synchronized are scanned in order; if the two points disagree,
+ * e.g. because the next worker synchronized inside a packet, that chunk is
+ * scanned again sequentially. No packet is lost or counted twice, and the
+ * merged counters equal those of a sequential scan with `imuFramerPush`,
+ * except that the trailing bytes of an incomplete last packet count as
+ * discarded.
+ */
+
+#ifndef ImuProtVerify_h_included__
+#define ImuProtVerify_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProt.h"
+#include "ImuProtFrame.h"
+
+/** Default chunk size in bytes. */
+#define IMU_VERIFY_CHUNK (16u << 20)
+
+/**
+ * @enum ImuVerifyError_t
+ * @brief Error codes of the verifier.
+ */
+typedef enum {
+	IMU_VERIFY_OK = 0,              // Success.
+	IMU_VERIFY_OPEN_ERROR = 1,      // The capture could not be opened.
+	IMU_VERIFY_IO_ERROR = 2,        // The capture could not be mapped.
+	IMU_VERIFY_NO_MEMORY = 3        // Memory allocation failed.
+} ImuVerifyError_t;
+
+/**
+ * Merged verification counters.
+ *
+ * @field frame     Packets, bytes, discarded bytes, resyncs and rejected
+ *                  candidates per error class, as counted by the deframer.
+ * @field gaps      Valid packets whose sequencer does not follow the previous one.
+ * @field lost      Packets missing according to the sequencer, modulo 256 per gap.
+ * @field chunks    Number of chunks.
+ * @field rescans   Chunks scanned again because their boundary did not stitch.
+ */
+typedef struct {
+	ImuFrameStats_t frame;
+	uint64_t gaps;
+	uint64_t lost;
+	uint64_t chunks;
+	uint64_t rescans;
+} ImuVerifyStats_t;
+
+/**
+ * @brief Verifies a capture held in memory.
+ *
+ * @param data      Capture.
+ * @param len       Size of the capture in bytes.
+ * @param threads   Worker threads, 0 for the number of online CPUs.
+ * @param chunkSize Chunk size in bytes, 0 for IMU_VERIFY_CHUNK.
+ * @param stats     Output counters.
+ * @return ImuVerifyError_t IMU_VERIFY_OK on success.
+ */
+ImuVerifyError_t imuVerifyBuffer(const uint8_t *data, size_t len, unsigned threads, size_t chunkSize,
+	ImuVerifyStats_t *stats);
+
+/**
+ * @brief Maps a capture file and verifies it with `imuVerifyBuffer`.
+ *
+ * @param path      Capture file.
+ * @param threads   Worker threads, 0 for the number of online CPUs.
+ * @param chunkSize Chunk size in bytes, 0 for IMU_VERIFY_CHUNK.
+ * @param stats     Output counters.
+ * @return ImuVerifyError_t IMU_VERIFY_OK on success, errno is set on failure.
+ */
+ImuVerifyError_t imuVerifyFile(const char *path, unsigned threads, size_t chunkSize, ImuVerifyStats_t *stats);
+
+/**
+ * @brief Converts an ImuVerifyError_t error code to its string representation.
+ *
+ * @param error The ImuVerifyError_t error code.
+ * @return A string that describes the error.
+ */
+const char *imuVerifyErrorToString(ImuVerifyError_t error);
+
+#endif
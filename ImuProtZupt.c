@@ -0,0 +1,149 @@
+#include <math.h>
+#include <string.h>
+
+#include "ImuProtZupt.h"
+
+int imuZuptInit(ImuZupt_t *z, uint32_t window, double threshold, uint32_t minSamples) {
+	if (!window || window > IMU_ZUPT_MAX_WINDOW || !minSamples || !(threshold > 0.0))
+		return -1;
+	memset(z, 0, sizeof(*z));
+	z->window = window;
+	z->threshold = threshold;
+	z->minSamples = minSamples;
+	z->statistic = INFINITY;
+	imuZuptUnits(z, IMU_GYRO_TO_RAD, IMU_ACCL_TO_MPS2);
+	imuZuptNoise(z, 0.01, 0.1 * IMU_GYRO_TO_RAD, IMU_ZUPT_GRAVITY);
+	return 0;
+}
+
+void imuZuptUnits(ImuZupt_t *z, double gyroScale, double acclScale) {
+	z->gyroScale = gyroScale;
+	z->acclScale = acclScale;
+}
+
+void imuZuptNoise(ImuZupt_t *z, double acclSigma, double gyroSigma, double gravity) {
+	z->acclWeight = 1.0 / (acclSigma * acclSigma);
+	z->gyroWeight = 1.0 / (gyroSigma * gyroSigma);
+	z->gravity = gravity;
+}
+
+/**
+ * @brief Recomputes the window sums from the ring.
+ */
+static void zuptResum(ImuZupt_t *z) {
+	memset(z->sumAccl, 0, sizeof(z->sumAccl));
+	memset(z->sumGyro, 0, sizeof(z->sumGyro));
+	z->sumAcclSq = 0.0;
+	z->sumGyroSq = 0.0;
+	for (uint32_t k = 0; k < z->filled; k++) {
+		const ImuZuptTerm_t *t = &z->ring[k];
+		for (int i = 0; i < 3; i++) {
+			z->sumAccl[i] += t->accl[i];
+			z->sumGyro[i] += t->gyro[i];
+		}
+		z->sumAcclSq += t->acclSq;
+		z->sumGyroSq += t->gyroSq;
+	}
+}
+
+/**
+ * @brief Publishes the mean of the current stationary period as the bias.
+ */
+static void zuptPublish(ImuZupt_t *z) {
+	ImuZuptBias_t *b = &z->bias;
+	for (int i = 0; i < 3; i++) {
+		b->gyro[i] = z->mean[i];
+		b->noise[i] = z->stationarySamples > 1 ? sqrt(z->m2[i] / (double)(z->stationarySamples - 1)) : 0.0;
+	}
+	b->temperature = z->temperature;
+	b->samples = z->stationarySamples;
+	b->updates++;
+	z->lastPublished = z->stationarySamples;
+	z->updated = 1;
+}
+
+/**
+ * @brief Tests the window after adding one sample; returns 1 if it is stationary.
+ */
+static inline int zuptTest(ImuZupt_t *z) {
+	if (z->filled < z->window) {
+		z->statistic = INFINITY;
+		return 0;
+	}
+	const double w = z->window, g = z->gravity;
+	double sa = sqrt(z->sumAccl[0] * z->sumAccl[0] + z->sumAccl[1] * z->sumAccl[1]
+		+ z->sumAccl[2] * z->sumAccl[2]);
+	double accl = z->sumAcclSq - 2.0 * g * sa + w * g * g;
+	double b[3], bb = 0.0, bs = 0.0;
+	for (int i = 0; i < 3; i++) {
+		b[i] = z->bias.gyro[i] * z->gyroScale;
+		bb += b[i] * b[i];
+		bs += b[i] * z->sumGyro[i];
+	}
+	double gyro = z->sumGyroSq - 2.0 * bs + w * bb;
+	z->statistic = (accl * z->acclWeight + gyro * z->gyroWeight) / w;
+	return z->statistic < z->threshold;
+}
+
+size_t imuZuptPush(ImuZupt_t *z, const ImuSample_t *samples, size_t count, uint8_t *stationary) {
+	z->updated = 0;
+	for (size_t n = 0; n < count; n++) {
+		const ImuSample_t *s = &samples[n];
+		ImuZuptTerm_t *t = &z->ring[z->pos];
+		if (z->filled == z->window) {
+			for (int i = 0; i < 3; i++) {
+				z->sumAccl[i] -= t->accl[i];
+				z->sumGyro[i] -= t->gyro[i];
+			}
+			z->sumAcclSq -= t->acclSq;
+			z->sumGyroSq -= t->gyroSq;
+		} else {
+			z->filled++;
+		}
+		t->acclSq = 0.0;
+		t->gyroSq = 0.0;
+		for (int i = 0; i < 3; i++) {
+			t->accl[i] = s->accl[i] * z->acclScale;
+			t->gyro[i] = s->gyro[i] * z->gyroScale;
+			t->acclSq += t->accl[i] * t->accl[i];
+			t->gyroSq += t->gyro[i] * t->gyro[i];
+			z->sumAccl[i] += t->accl[i];
+			z->sumGyro[i] += t->gyro[i];
+		}
+		z->sumAcclSq += t->acclSq;
+		z->sumGyroSq += t->gyroSq;
+		if (++z->pos == z->window) {
+			z->pos = 0;
+			zuptResum(z);
+		}
+
+		z->stationary = zuptTest(z);
+		if (stationary)
+			stationary[n] = (uint8_t)z->stationary;
+		if (z->stationary) {
+			uint64_t k = ++z->stationarySamples;
+			for (int i = 0; i < 3; i++) {
+				double d = s->gyro[i] - z->mean[i];
+				z->mean[i] += d / (double)k;
+				z->m2[i] += d * (s->gyro[i] - z->mean[i]);
+			}
+			z->temperature += (s->temperature - z->temperature) / (double)k;
+			if (k - z->lastPublished >= z->minSamples) {
+				zuptPublish(z);
+				return n + 1;
+			}
+		} else if (z->stationarySamples) {
+			int publish = z->stationarySamples >= z->minSamples && z->stationarySamples != z->lastPublished;
+			if (publish)
+				zuptPublish(z);
+			z->stationarySamples = 0;
+			z->lastPublished = 0;
+			memset(z->mean, 0, sizeof(z->mean));
+			memset(z->m2, 0, sizeof(z->m2));
+			z->temperature = 0.0;
+			if (publish)
+				return n + 1;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,176 @@
+/**
+ * Zero-Velocity Detection and Gyro Bias Estimation.
+ *
+ * Detects stationary periods with the generalized likelihood ratio test of
+ * Skog et al. (SHOE detector) over a sliding window of W samples:
+ *
+ *   T = 1/W * sum( |a_k - g * u|^2 / sigma_a^2 + |w_k - b|^2 / sigma_w^2 )
+ *
+ * where u is the direction of the mean specific force of the window, g the
+ * gravity magnitude and b the current gyro bias estimate. The window is
+ * stationary when T stays below the threshold. With the window sums of a,
+ * |a|^2, w and |w|^2 the terms reduce to
+ *
+ *   sum |a|^2 - 2 g |sum a| + W g^2
+ *   sum |w|^2 - 2 b . sum w + W |b|^2
+ *
+ * so a new bias applies at once and each sample costs a constant number of
+ * operations: the sums are updated as samples enter and leave the window
+ * and recomputed from the window once per wrap, which keeps rounding from
+ * accumulating.
+ *
+ * While the window is stationary the gyro readings of its newest samples
+ * feed a running mean; after every `minSamples` stationary samples, and at
+ * the end of a stationary period that reached that length, the mean is
+ * published as the new bias with its noise and mean temperature. The bias
+ * includes the Earth rate component along the gyro axes.
+ *
+ * Readings are converted with `imuZuptUnits`; the bias is published in the
+ * units of the readings, ready to be subtracted.
+ */
+
+#ifndef ImuProtZupt_h_included__
+#define ImuProtZupt_h_included__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ImuProtSample.h"
+
+/** Longest detector window in samples. */
+#define IMU_ZUPT_MAX_WINDOW (1024)
+
+/** Standard gravity in m/s^2, the default gravity magnitude. */
+#define IMU_ZUPT_GRAVITY (9.80665)
+
+/**
+ * Published gyro bias.
+ *
+ * @field gyro          Bias per axis, in the units of the readings.
+ * @field noise         Standard deviation of the readings it was estimated from.
+ * @field temperature   Mean temperature of those samples in degrees Celsius.
+ * @field samples       Stationary samples averaged.
+ * @field updates       Number of updates published so far.
+ */
+typedef struct {
+	double gyro[3];
+	double noise[3];
+	double temperature;
+	uint64_t samples;
+	uint64_t updates;
+} ImuZuptBias_t;
+
+/**
+ * Window contribution of one sample. Private.
+ */
+typedef struct {
+	double accl[3];
+	double gyro[3];
+	double acclSq;
+	double gyroSq;
+} ImuZuptTerm_t;
+
+/**
+ * Detector and estimator state. All fields are private.
+ */
+typedef struct {
+	ImuZuptTerm_t ring[IMU_ZUPT_MAX_WINDOW];
+	double sumAccl[3];
+	double sumGyro[3];
+	double sumAcclSq;
+	double sumGyroSq;
+	double gyroScale;
+	double acclScale;
+	double gravity;
+	double acclWeight;
+	double gyroWeight;
+	double threshold;
+	double mean[3];
+	double m2[3];
+	double temperature;
+	double statistic;
+	uint64_t lastPublished;
+	uint64_t stationarySamples;
+	ImuZuptBias_t bias;
+	uint32_t window;
+	uint32_t pos;
+	uint32_t filled;
+	uint32_t minSamples;
+	int stationary;
+	int updated;
+} ImuZupt_t;
+
+/**
+ * @brief Initializes the detector with unit conversions IMU_GYRO_TO_RAD and IMU_ACCL_TO_MPS2.
+ *
+ * The default noise levels are 0.01 m/s^2 and 0.1 deg/s per sample.
+ *
+ * @param z             State to initialize.
+ * @param window        Detector window in samples, 1 to IMU_ZUPT_MAX_WINDOW.
+ * @param threshold     Test threshold on T, which averages about 6 on pure
+ *                      noise at the configured levels; 10 to 30 is typical.
+ * @param minSamples    Stationary samples per bias update, at least 1.
+ * @return int 0 on success, -1 if an argument is out of range.
+ */
+int imuZuptInit(ImuZupt_t *z, uint32_t window, double threshold, uint32_t minSamples);
+
+/**
+ * @brief Sets the conversions of the readings to rad/s and m/s^2.
+ */
+void imuZuptUnits(ImuZupt_t *z, double gyroScale, double acclScale);
+
+/**
+ * @brief Sets the noise levels of the test and the gravity magnitude.
+ *
+ * @param z             State.
+ * @param acclSigma     Accelerometer noise per sample in m/s^2.
+ * @param gyroSigma     Gyro noise per sample in rad/s.
+ * @param gravity       Local gravity in m/s^2, e.g. IMU_ZUPT_GRAVITY.
+ */
+void imuZuptNoise(ImuZupt_t *z, double acclSigma, double gyroSigma, double gravity);
+
+/**
+ * @brief Tests consecutive decoded samples, up to the next bias update.
+ *
+ * @param z             State.
+ * @param samples       Samples, e.g. from `imuDecodeSamples`.
+ * @param count         Number of samples.
+ * @param stationary    Optional, receives 1 per sample whose window is stationary, else 0.
+ * @return size_t Number of samples consumed; fewer than `count` only if a
+ *                bias update was published, which `imuZuptUpdated` then reports.
+ */
+size_t imuZuptPush(ImuZupt_t *z, const ImuSample_t *samples, size_t count, uint8_t *stationary);
+
+/**
+ * @brief Returns 1 if the last `imuZuptPush` published a bias update.
+ */
+static inline int imuZuptUpdated(const ImuZupt_t *z)
+{
+	return z->updated;
+}
+
+/**
+ * @brief Returns the last published bias, zero before the first update.
+ */
+static inline const ImuZuptBias_t *imuZuptBias(const ImuZupt_t *z)
+{
+	return &z->bias;
+}
+
+/**
+ * @brief Returns 1 if the window ending at the last sample is stationary.
+ */
+static inline int imuZuptStationary(const ImuZupt_t *z)
+{
+	return z->stationary;
+}
+
+/**
+ * @brief Returns the test statistic T of the window ending at the last sample.
+ */
+static inline double imuZuptStatistic(const ImuZupt_t *z)
+{
+	return z->statistic;
+}
+
+#endif